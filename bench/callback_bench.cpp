@@ -0,0 +1,91 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpr/callback.h"
+#include "cpr/util.h"
+
+/**
+ * Measures the cost of handing a chunk from libcurl to the user callbacks, i.e. of the trampolines in cpr/util.cpp
+ * libcurl calls once per network chunk, and of copying a callback into a Session.
+ * Run it with a chunk size in bytes as optional argument (default 16384).
+ **/
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kIterations = 10000000;
+
+// Keeps the compiler from optimizing away the work of the callbacks
+volatile size_t sink = 0;
+
+template <typename Function>
+void measure(const char* name, Function&& function) {
+    // Warm up caches and branch predictors
+    for (size_t i = 0; i < kIterations / 10; ++i) {
+        function();
+    }
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < kIterations; ++i) {
+        function();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    std::printf("%-48s %8.2f ns\n", name, elapsed.count() / static_cast<double>(kIterations));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t chunk_size = argc > 1 ? std::stoul(argv[1]) : 16384;
+    std::vector<char> chunk(chunk_size, 'x');
+    std::printf("Chunk size: %zu bytes\n", chunk_size);
+
+    const cpr::WriteCallback write{[](std::string_view data, intptr_t /*userdata*/) {
+        sink = sink + data.size();
+        return true;
+    }};
+    measure("WriteCallback (captureless lambda)", [&]() { cpr::util::writeUserFunction(chunk.data(), 1, chunk.size(), &write); });
+
+    // Captures more than fits into the small buffer of std::function
+    const std::shared_ptr<size_t> total = std::make_shared<size_t>(0);
+    const std::string prefix = "prefix";
+    const cpr::WriteCallback capturing_write{[total, prefix](std::string_view data, intptr_t /*userdata*/) {
+        *total += data.size() + prefix.size();
+        return true;
+    }};
+    measure("WriteCallback (lambda capturing 48 bytes)", [&]() { cpr::util::writeUserFunction(chunk.data(), 1, chunk.size(), &capturing_write); });
+    // What Session::SetWriteCallback() does
+    measure("Copy WriteCallback (lambda capturing 48 bytes)", [&]() {
+        const cpr::WriteCallback copy{capturing_write};
+        sink = sink + static_cast<size_t>(copy.userdata);
+    });
+
+    const cpr::HeaderCallback header{[](std::string_view data, intptr_t /*userdata*/) {
+        sink = sink + data.size();
+        return true;
+    }};
+    constexpr std::string_view header_line = "Content-Type: application/json\r\n";
+    std::string header_buffer{header_line};
+    measure("HeaderCallback", [&]() { cpr::util::headerUserFunction(header_buffer.data(), 1, header_buffer.size(), &header); });
+
+    const cpr::ReadCallback read{[](char* /*buffer*/, size_t& size, intptr_t /*userdata*/) {
+        sink = sink + size;
+        return true;
+    }};
+    measure("ReadCallback", [&]() { cpr::util::readUserFunction(chunk.data(), 1, chunk.size(), &read); });
+
+    const cpr::ProgressCallback progress{[](cpr::cpr_pf_arg_t /*downloadTotal*/, cpr::cpr_pf_arg_t downloadNow, cpr::cpr_pf_arg_t /*uploadTotal*/, cpr::cpr_pf_arg_t /*uploadNow*/, intptr_t /*userdata*/) {
+        sink = sink + static_cast<size_t>(downloadNow);
+        return true;
+    }};
+    measure("ProgressCallback", [&]() { cpr::util::progressUserFunction(&progress, 0, static_cast<cpr::cpr_pf_arg_t>(chunk.size()), 0, 0); });
+
+    const cpr::DebugCallback debug{[](cpr::DebugCallback::InfoType /*type*/, std::string_view data, intptr_t /*userdata*/) { sink = sink + data.size(); }};
+    measure("DebugCallback (DATA_IN)", [&]() { cpr::util::debugUserFunction(nullptr, CURLINFO_DATA_IN, chunk.data(), chunk.size(), &debug); });
+    return 0;
+}
@@ -0,0 +1,721 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <curl/curlver.h>
+
+#include "cpr/cpr.h"
+#include "latency_histogram.h"
+
+#if __cplusplus >= 202002L
+#include <coroutine>
+#endif
+
+namespace cpr::bench {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Engine {
+    // One thread per connection making blocking requests
+    SYNC,
+    // Each request runs as a task on the GlobalThreadPool, which starts the next one once it completed
+    ASYNC,
+    // One coroutine per connection awaiting Session::Co*Async()
+    COROUTINE,
+    // Rounds of one transfer per connection on a single MultiPerform
+    MULTI,
+};
+
+enum class Reuse {
+    // One session per connection, reusing its connection
+    SESSION,
+    // A new session per request, all sharing one ConnectionPool
+    POOL,
+    // A new session per request, thus a new connection for each of them
+    NONE,
+};
+
+struct Config {
+    Url url;
+    std::string method{"GET"};
+    Header header;
+    std::optional<std::string> body;
+    size_t connections{10};
+    std::chrono::seconds duration{10};
+    // Requests per second across all connections. Enables the open loop mode in case set.
+    std::optional<double> rate;
+    Engine engine{Engine::SYNC};
+    Reuse reuse{Reuse::SESSION};
+    HttpVersion http_version{HttpVersionCode::VERSION_1_1};
+    std::string http_version_name{"1.1"};
+    std::chrono::milliseconds timeout{0};
+    // Threads of the GlobalThreadPool for the async and coroutine engines, defaults to the number of connections
+    size_t threads{0};
+    bool latency_distribution{true};
+};
+
+struct Stats {
+    LatencyHistogram latency;
+    uint64_t requests{0};
+    uint64_t bytes{0};
+    uint64_t connect_errors{0};
+    uint64_t timeouts{0};
+    uint64_t other_errors{0};
+    uint64_t bad_status{0};
+
+    void Record(const Response& response, std::chrono::microseconds elapsed) {
+        ++requests;
+        latency.Record(elapsed);
+        bytes += static_cast<uint64_t>(std::max<cpr_off_t>(response.downloaded_bytes, 0));
+        switch (response.error.code) {
+            case ErrorCode::OK:
+                if (response.status_code < 200 || response.status_code >= 400) {
+                    ++bad_status;
+                }
+                break;
+            case ErrorCode::COULDNT_CONNECT:
+            case ErrorCode::COULDNT_RESOLVE_HOST:
+                ++connect_errors;
+                break;
+            case ErrorCode::OPERATION_TIMEDOUT:
+                ++timeouts;
+                break;
+            default:
+                ++other_errors;
+                break;
+        }
+    }
+
+    void Merge(const Stats& other) {
+        latency.Merge(other.latency);
+        requests += other.requests;
+        bytes += other.bytes;
+        connect_errors += other.connect_errors;
+        timeouts += other.timeouts;
+        other_errors += other.other_errors;
+        bad_status += other.bad_status;
+    }
+};
+
+/**
+ * Start times of the requests of one connection.
+ *
+ * In the open loop mode each request has an intended start derived from the rate, independent of how long the ones
+ * before took. Latencies get measured from there, so a stalled server delays the following requests without hiding
+ * their latency (coordinated omission). In the closed loop mode each request starts right after the one before.
+ * Requests still due once the test ended get dropped instead of prolonging the test past its duration.
+ **/
+class Schedule {
+  public:
+    Schedule(const Config& config, size_t connection, Clock::time_point start, Clock::time_point end) : start_(start), end_(end) {
+        if (config.rate) {
+            // The connections take turns, so all of them together send at the rate
+            interval_ = std::chrono::duration<double>{static_cast<double>(config.connections) / *config.rate};
+            offset_ = std::chrono::duration<double>{static_cast<double>(connection) / *config.rate};
+        }
+    }
+
+    /**
+     * Returns the intended start of the next request or std::nullopt in case the test ended.
+     **/
+    std::optional<Clock::time_point> Next() {
+        const Clock::time_point now = Clock::now();
+        Clock::time_point intended = std::max(now, start_);
+        if (interval_) {
+            const std::chrono::duration<double> since_start = offset_ + (*interval_ * static_cast<double>(sent_++));
+            intended = start_ + std::chrono::duration_cast<Clock::duration>(since_start);
+        }
+        if (intended >= end_ || now >= end_) {
+            return std::nullopt;
+        }
+        return intended;
+    }
+
+  private:
+    Clock::time_point start_;
+    Clock::time_point end_;
+    std::optional<std::chrono::duration<double>> interval_;
+    std::chrono::duration<double> offset_{0};
+    uint64_t sent_{0};
+};
+
+std::chrono::microseconds since(Clock::time_point intended) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - intended);
+}
+
+/**
+ * Hands out the session for each request of one connection according to the Reuse mode.
+ **/
+class SessionSource {
+  public:
+    SessionSource(const Config& config, const std::optional<ConnectionPool>& pool) : config_(config), pool_(pool) {}
+
+    std::shared_ptr<Session> Get() {
+        if (config_.reuse == Reuse::SESSION && session_) {
+            return session_;
+        }
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(config_.url);
+        session->SetHeader(config_.header);
+        session->SetHttpVersion(config_.http_version);
+        session->SetTimeout(Timeout{config_.timeout});
+        if (config_.body) {
+            session->SetBody(Body{*config_.body});
+        }
+        if (pool_) {
+            session->SetConnectionPool(*pool_);
+        }
+        if (config_.reuse == Reuse::SESSION) {
+            session_ = session;
+        }
+        return session;
+    }
+
+  private:
+    const Config& config_;
+    const std::optional<ConnectionPool>& pool_;
+    std::shared_ptr<Session> session_;
+};
+
+Response perform(Session& session, std::string_view method) {
+    if (method == "POST") {
+        return session.Post();
+    }
+    if (method == "PUT") {
+        return session.Put();
+    }
+    if (method == "PATCH") {
+        return session.Patch();
+    }
+    if (method == "DELETE") {
+        return session.Delete();
+    }
+    if (method == "HEAD") {
+        return session.Head();
+    }
+    if (method == "OPTIONS") {
+        return session.Options();
+    }
+    return session.Get();
+}
+
+std::vector<Response> perform(MultiPerform& multiperform, std::string_view method) {
+    if (method == "POST") {
+        return multiperform.Post();
+    }
+    if (method == "PUT") {
+        return multiperform.Put();
+    }
+    if (method == "PATCH") {
+        return multiperform.Patch();
+    }
+    if (method == "DELETE") {
+        return multiperform.Delete();
+    }
+    if (method == "HEAD") {
+        return multiperform.Head();
+    }
+    if (method == "OPTIONS") {
+        return multiperform.Options();
+    }
+    return multiperform.Get();
+}
+
+/**
+ * Shared state of the engines running their connections on the GlobalThreadPool.
+ **/
+class Runner {
+  public:
+    Runner(const Config& config, Clock::time_point start, Clock::time_point end, const std::optional<ConnectionPool>& pool) : config_(config) {
+        for (size_t i = 0; i < config.connections; ++i) {
+            schedules_.emplace_back(config, i, start, end);
+            sources_.emplace_back(config, pool);
+        }
+        stats_.resize(config.connections);
+        running_ = config.connections;
+    }
+
+    [[nodiscard]] const Config& GetConfig() const {
+        return config_;
+    }
+
+    [[nodiscard]] std::optional<Clock::time_point> Next(size_t connection) {
+        return schedules_[connection].Next();
+    }
+
+    std::shared_ptr<Session> GetSession(size_t connection) {
+        return sources_[connection].Get();
+    }
+
+    void Record(size_t connection, const Response& response, Clock::time_point intended) {
+        stats_[connection].Record(response, since(intended));
+    }
+
+    void Finish() {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (--running_ == 0) {
+            finished_.notify_all();
+        }
+    }
+
+    Stats Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this]() { return running_ == 0; });
+        Stats total;
+        for (const Stats& stats : stats_) {
+            total.Merge(stats);
+        }
+        return total;
+    }
+
+  private:
+    const Config& config_;
+    std::vector<Schedule> schedules_;
+    std::vector<SessionSource> sources_;
+    // One per connection, each connection runs one request at a time
+    std::vector<Stats> stats_;
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    size_t running_{0};
+};
+
+Stats runSync(const Config& config, Clock::time_point start, Clock::time_point end, const std::optional<ConnectionPool>& pool) {
+    std::vector<Stats> stats(config.connections);
+    std::vector<std::thread> threads;
+    threads.reserve(config.connections);
+    for (size_t i = 0; i < config.connections; ++i) {
+        threads.emplace_back([&config, &pool, &stats, i, start, end]() {
+            Schedule schedule{config, i, start, end};
+            SessionSource source{config, pool};
+            for (std::optional<Clock::time_point> intended = schedule.Next(); intended; intended = schedule.Next()) {
+                std::this_thread::sleep_until(*intended);
+                const std::shared_ptr<Session> session = source.Get();
+                const Response response = perform(*session, config.method);
+                stats[i].Record(response, since(*intended));
+            }
+        });
+    }
+    Stats total;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+        total.Merge(stats[i]);
+    }
+    return total;
+}
+
+void scheduleAsyncRequest(Runner& runner, size_t connection) {
+    const std::optional<Clock::time_point> intended = runner.Next(connection);
+    if (!intended) {
+        runner.Finish();
+        return;
+    }
+    const Clock::duration delay = *intended - Clock::now();
+    const auto submit = [&runner, connection, intended = *intended]() {
+        GlobalThreadPool::GetInstance()->CoSubmit([&runner, connection, intended]() {
+            const std::shared_ptr<Session> session = runner.GetSession(connection);
+            const Response response = perform(*session, runner.GetConfig().method);
+            runner.Record(connection, response, intended);
+            scheduleAsyncRequest(runner, connection);
+        });
+    };
+    if (delay > Clock::duration::zero()) {
+        // Waiting for the next start does not occupy a thread of the pool
+        TimerQueue::GetInstance()->ScheduleAfter(delay, submit);
+    } else {
+        submit();
+    }
+}
+
+Stats runAsync(const Config& config, Clock::time_point start, Clock::time_point end, const std::optional<ConnectionPool>& pool) {
+    Runner runner{config, start, end, pool};
+    for (size_t i = 0; i < config.connections; ++i) {
+        scheduleAsyncRequest(runner, i);
+    }
+    return runner.Wait();
+}
+
+#if __cplusplus >= 202002L
+/**
+ * Coroutine starting right away and destroying itself once it completed.
+ **/
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+coroutine::Task<Response> coPerform(const std::shared_ptr<Session>& session, std::string_view method) {
+    if (method == "POST") {
+        return session->CoPostAsync();
+    }
+    if (method == "PUT") {
+        return session->CoPutAsync();
+    }
+    if (method == "PATCH") {
+        return session->CoPatchAsync();
+    }
+    if (method == "DELETE") {
+        return session->CoDeleteAsync();
+    }
+    if (method == "HEAD") {
+        return session->CoHeadAsync();
+    }
+    if (method == "OPTIONS") {
+        return session->CoOptionsAsync();
+    }
+    return session->CoGetAsync();
+}
+
+DetachedTask runCoroutineConnection(Runner& runner, size_t connection) {
+    for (std::optional<Clock::time_point> intended = runner.Next(connection); intended; intended = runner.Next(connection)) {
+        const Clock::duration delay = *intended - Clock::now();
+        if (delay > Clock::duration::zero()) {
+            co_await coroutine::SleepFor(delay);
+        }
+        const std::shared_ptr<Session> session = runner.GetSession(connection);
+        const Response response = co_await coPerform(session, runner.GetConfig().method);
+        runner.Record(connection, response, *intended);
+    }
+    runner.Finish();
+}
+
+Stats runCoroutine(const Config& config, Clock::time_point start, Clock::time_point end, const std::optional<ConnectionPool>& pool) {
+    Runner runner{config, start, end, pool};
+    for (size_t i = 0; i < config.connections; ++i) {
+        runCoroutineConnection(runner, i);
+    }
+    return runner.Wait();
+}
+#endif
+
+Stats runMulti(const Config& config, Clock::time_point start, Clock::time_point end, const std::optional<ConnectionPool>& pool) {
+    Stats stats;
+    std::vector<Schedule> schedules;
+    std::vector<SessionSource> sources;
+    for (size_t i = 0; i < config.connections; ++i) {
+        schedules.emplace_back(config, i, start, end);
+        sources.emplace_back(config, pool);
+    }
+
+    std::unique_ptr<MultiPerform> multiperform;
+    std::vector<Clock::time_point> intended(config.connections);
+    while (true) {
+        bool ended = false;
+        for (size_t i = 0; i < config.connections; ++i) {
+            const std::optional<Clock::time_point> next = schedules[i].Next();
+            ended = ended || !next;
+            intended[i] = next.value_or(end);
+        }
+        if (ended) {
+            break;
+        }
+        // A round starts once its first transfer is due and ends once the last one completed
+        std::this_thread::sleep_until(*std::min_element(intended.begin(), intended.end()));
+        if (!multiperform || config.reuse != Reuse::SESSION) {
+            // The multi handle shares its connections among its transfers, so only a new one starts without any
+            multiperform = std::make_unique<MultiPerform>();
+            for (SessionSource& source : sources) {
+                std::shared_ptr<Session> session = source.Get();
+                multiperform->AddSession(session);
+            }
+        }
+        const Clock::time_point sent = Clock::now();
+        const std::vector<Response> responses = perform(*multiperform, config.method);
+        for (size_t i = 0; i < responses.size(); ++i) {
+            // Each transfer took its own elapsed time after the round got sent
+            const std::chrono::microseconds elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double>{responses[i].elapsed});
+            const std::chrono::microseconds waited = std::chrono::duration_cast<std::chrono::microseconds>(sent - std::min(intended[i], sent));
+            stats.Record(responses[i], waited + elapsed);
+        }
+    }
+    return stats;
+}
+
+std::string formatDuration(double microseconds) {
+    std::array<char, 32> buffer{};
+    if (microseconds >= 1000000) {
+        std::snprintf(buffer.data(), buffer.size(), "%.2fs", microseconds / 1000000);
+    } else if (microseconds >= 1000) {
+        std::snprintf(buffer.data(), buffer.size(), "%.2fms", microseconds / 1000);
+    } else {
+        std::snprintf(buffer.data(), buffer.size(), "%.2fus", microseconds);
+    }
+    return buffer.data();
+}
+
+std::string formatBytes(double bytes) {
+    std::array<char, 32> buffer{};
+    if (bytes >= 1024.0 * 1024 * 1024) {
+        std::snprintf(buffer.data(), buffer.size(), "%.2fGB", bytes / (1024.0 * 1024 * 1024));
+    } else if (bytes >= 1024.0 * 1024) {
+        std::snprintf(buffer.data(), buffer.size(), "%.2fMB", bytes / (1024.0 * 1024));
+    } else if (bytes >= 1024) {
+        std::snprintf(buffer.data(), buffer.size(), "%.2fKB", bytes / 1024);
+    } else {
+        std::snprintf(buffer.data(), buffer.size(), "%.0fB", bytes);
+    }
+    return buffer.data();
+}
+
+std::string_view engineName(Engine engine) {
+    switch (engine) {
+        case Engine::SYNC:
+            return "sync";
+        case Engine::ASYNC:
+            return "async";
+        case Engine::COROUTINE:
+            return "coroutine";
+        case Engine::MULTI:
+            return "multi";
+    }
+    return "";
+}
+
+std::string_view reuseName(Reuse reuse) {
+    switch (reuse) {
+        case Reuse::SESSION:
+            return "session";
+        case Reuse::POOL:
+            return "pool";
+        case Reuse::NONE:
+            return "none";
+    }
+    return "";
+}
+
+void printReport(const Config& config, const Stats& stats, std::chrono::duration<double> elapsed) {
+    const LatencyHistogram& latency = stats.latency;
+    std::printf("  Latency     Avg        Stdev      Min        Max\n");
+    std::printf("              %-10s %-10s %-10s %-10s\n", formatDuration(latency.GetMean()).c_str(), formatDuration(latency.GetStdDev()).c_str(), formatDuration(static_cast<double>(latency.GetMin().count())).c_str(), formatDuration(static_cast<double>(latency.GetMax().count())).c_str());
+    if (config.latency_distribution) {
+        std::printf("  Latency Distribution%s\n", config.rate ? " (corrected for coordinated omission)" : "");
+        for (const double percentile : {50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0}) {
+            std::printf("   %8.3f%%  %s\n", percentile, formatDuration(static_cast<double>(latency.GetPercentile(percentile).count())).c_str());
+        }
+    }
+    std::printf("  %llu requests in %.2fs, %s read\n", static_cast<unsigned long long>(stats.requests), elapsed.count(), formatBytes(static_cast<double>(stats.bytes)).c_str());
+    if (stats.connect_errors > 0 || stats.timeouts > 0 || stats.other_errors > 0) {
+        std::printf("  Errors: connect %llu, timeout %llu, other %llu\n", static_cast<unsigned long long>(stats.connect_errors), static_cast<unsigned long long>(stats.timeouts), static_cast<unsigned long long>(stats.other_errors));
+    }
+    if (stats.bad_status > 0) {
+        std::printf("  Non-2xx or 3xx responses: %llu\n", static_cast<unsigned long long>(stats.bad_status));
+    }
+    std::printf("Requests/sec: %10.2f\n", static_cast<double>(stats.requests) / elapsed.count());
+    std::printf("Transfer/sec: %10s\n", formatBytes(static_cast<double>(stats.bytes) / elapsed.count()).c_str());
+}
+
+void printUsage(std::ostream& out) {
+    out << "Usage: cpr-bench <options> <url>\n"
+           "  Options:\n"
+           "    -c, --connections <N>  Connections to keep open (default 10)\n"
+           "    -d, --duration    <S>  Duration of the test in seconds (default 10)\n"
+           "    -R, --rate        <N>  Requests per second across all connections. Sends at a constant rate (open loop)\n"
+           "                           and measures latencies from the intended start of each request.\n"
+           "                           Without it, each connection sends its next request once the last one completed.\n"
+           "    -e, --engine      <E>  sync (default), async, coroutine or multi\n"
+           "    -t, --threads     <N>  Threads of the pool for the async and coroutine engines (default: connections)\n"
+           "        --http        <V>  HTTP version: 1.1 (default), 2"
+#if LIBCURL_VERSION_NUM >= 0x073100 // 7.49.0
+           ", 2-prior-knowledge"
+#endif
+#if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
+           ", 3"
+#endif
+           "\n"
+           "        --reuse       <R>  session (default): one session per connection, pool: a new session per request\n"
+           "                           sharing a ConnectionPool, none: a new session and connection per request\n"
+           "    -m, --method      <M>  HTTP method (default GET)\n"
+           "    -H, --header      <H>  Add a header to the requests, e.g. \"Accept: application/json\"\n"
+           "    -b, --body        <B>  Body of the requests\n"
+           "        --timeout     <T>  Timeout of each request in milliseconds\n"
+           "        --no-latency       Skip the latency distribution\n"
+           "    -h, --help             Print this help\n";
+}
+
+std::optional<Config> parseArguments(const std::vector<std::string_view>& args) {
+    Config config;
+    std::optional<std::string_view> url;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string_view arg = args[i];
+        const auto value = [&args, &i, arg]() -> std::string {
+            if (i + 1 >= args.size()) {
+                throw std::invalid_argument("Missing value for " + std::string{arg});
+            }
+            return std::string{args[++i]};
+        };
+        if (arg == "-h" || arg == "--help") {
+            return std::nullopt;
+        } else if (arg == "-c" || arg == "--connections") {
+            config.connections = std::stoul(value());
+        } else if (arg == "-d" || arg == "--duration") {
+            config.duration = std::chrono::seconds{std::stoul(value())};
+        } else if (arg == "-R" || arg == "--rate") {
+            config.rate = std::stod(value());
+        } else if (arg == "-t" || arg == "--threads") {
+            config.threads = std::stoul(value());
+        } else if (arg == "-m" || arg == "--method") {
+            config.method = value();
+            std::transform(config.method.begin(), config.method.end(), config.method.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        } else if (arg == "-b" || arg == "--body") {
+            config.body = value();
+        } else if (arg == "--timeout") {
+            config.timeout = std::chrono::milliseconds{std::stoul(value())};
+        } else if (arg == "--no-latency") {
+            config.latency_distribution = false;
+        } else if (arg == "-H" || arg == "--header") {
+            const std::string header = value();
+            const size_t colon = header.find(':');
+            if (colon == std::string::npos) {
+                throw std::invalid_argument("Invalid header: " + header);
+            }
+            const size_t value_start = header.find_first_not_of(' ', colon + 1);
+            config.header[header.substr(0, colon)] = value_start == std::string::npos ? "" : header.substr(value_start);
+        } else if (arg == "-e" || arg == "--engine") {
+            const std::string engine = value();
+            if (engine == "sync") {
+                config.engine = Engine::SYNC;
+            } else if (engine == "async") {
+                config.engine = Engine::ASYNC;
+#if __cplusplus >= 202002L
+            } else if (engine == "coroutine") {
+                config.engine = Engine::COROUTINE;
+#endif
+            } else if (engine == "multi") {
+                config.engine = Engine::MULTI;
+            } else {
+                throw std::invalid_argument("Unknown engine: " + engine);
+            }
+        } else if (arg == "--reuse") {
+            const std::string reuse = value();
+            if (reuse == "session") {
+                config.reuse = Reuse::SESSION;
+            } else if (reuse == "pool") {
+                config.reuse = Reuse::POOL;
+            } else if (reuse == "none") {
+                config.reuse = Reuse::NONE;
+            } else {
+                throw std::invalid_argument("Unknown reuse mode: " + reuse);
+            }
+        } else if (arg == "--http") {
+            config.http_version_name = value();
+            if (config.http_version_name == "1.1") {
+                config.http_version = HttpVersion{HttpVersionCode::VERSION_1_1};
+            } else if (config.http_version_name == "2") {
+                config.http_version = HttpVersion{HttpVersionCode::VERSION_2_0};
+#if LIBCURL_VERSION_NUM >= 0x073100 // 7.49.0
+            } else if (config.http_version_name == "2-prior-knowledge") {
+                config.http_version = HttpVersion{HttpVersionCode::VERSION_2_0_PRIOR_KNOWLEDGE};
+#endif
+#if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
+            } else if (config.http_version_name == "3") {
+                config.http_version = HttpVersion{HttpVersionCode::VERSION_3_0};
+#endif
+            } else {
+                throw std::invalid_argument("Unsupported HTTP version: " + config.http_version_name);
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option: " + std::string{arg});
+        } else if (url) {
+            throw std::invalid_argument("Only one URL is supported");
+        } else {
+            url = arg;
+        }
+    }
+    if (!url) {
+        throw std::invalid_argument("Missing URL");
+    }
+    if (config.connections == 0) {
+        throw std::invalid_argument("At least one connection is required");
+    }
+    if (config.rate && *config.rate <= 0) {
+        throw std::invalid_argument("The rate has to be positive");
+    }
+    config.url = Url{*url};
+    return config;
+}
+
+int run(const Config& config) {
+    std::printf("Running %llds test @ %s\n", static_cast<long long>(config.duration.count()), config.url.c_str());
+    std::printf("  %s engine, %zu connections, HTTP/%s, reuse: %s, ", engineName(config.engine).data(), config.connections, config.http_version_name.c_str(), reuseName(config.reuse).data());
+    if (config.rate) {
+        std::printf("open loop at %.2f requests/sec\n", *config.rate);
+    } else {
+        std::printf("closed loop\n");
+    }
+
+    if (config.engine == Engine::ASYNC || config.engine == Engine::COROUTINE) {
+        const size_t threads = config.threads > 0 ? config.threads : config.connections;
+        GlobalThreadPool::GetInstance()->SetMinThreadNum(threads);
+        GlobalThreadPool::GetInstance()->SetMaxThreadNum(threads);
+    }
+    const std::optional<ConnectionPool> pool = config.reuse == Reuse::POOL ? std::make_optional<ConnectionPool>() : std::nullopt;
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + config.duration;
+    Stats stats;
+    switch (config.engine) {
+        case Engine::SYNC:
+            stats = runSync(config, start, end, pool);
+            break;
+        case Engine::ASYNC:
+            stats = runAsync(config, start, end, pool);
+            break;
+        case Engine::COROUTINE:
+#if __cplusplus >= 202002L
+            stats = runCoroutine(config, start, end, pool);
+#endif
+            break;
+        case Engine::MULTI:
+            stats = runMulti(config, start, end, pool);
+            break;
+    }
+    printReport(config, stats, Clock::now() - start);
+    return 0;
+}
+
+} // namespace
+} // namespace cpr::bench
+
+int main(int argc, char** argv) {
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+    try {
+        const std::optional<cpr::bench::Config> config = cpr::bench::parseArguments(args);
+        if (!config) {
+            cpr::bench::printUsage(std::cout);
+            return 0;
+        }
+        return cpr::bench::run(*config);
+    } catch (const std::exception& e) {
+        std::cerr << "cpr-bench: " << e.what() << "\n\n";
+        cpr::bench::printUsage(std::cerr);
+        return 1;
+    }
+}
@@ -0,0 +1,114 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace cpr::bench {
+
+namespace {
+// Values below get a bucket of their own, the ones above get 64 buckets per power of two
+constexpr uint64_t kLinearLimit = 128;
+constexpr size_t kSubBuckets = 64;
+// Covers latencies of up to 2^40 us (about 12 days)
+constexpr size_t kMaxShift = 34;
+constexpr size_t kBucketCount = kLinearLimit + (kMaxShift * kSubBuckets);
+
+size_t highestBit(uint64_t value) {
+    size_t bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : buckets_(kBucketCount, 0) {}
+
+size_t LatencyHistogram::getBucket(uint64_t value) {
+    if (value < kLinearLimit) {
+        return static_cast<size_t>(value);
+    }
+    // Shift the value so its top bits fall into [64, 128)
+    const size_t shift = highestBit(value) - 6;
+    if (shift > kMaxShift) {
+        return kBucketCount - 1;
+    }
+    return kLinearLimit + ((shift - 1) * kSubBuckets) + static_cast<size_t>((value >> shift) - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::getBucketMax(size_t bucket) {
+    if (bucket < kLinearLimit) {
+        return bucket;
+    }
+    const size_t shift = ((bucket - kLinearLimit) / kSubBuckets) + 1;
+    const uint64_t top_bits = ((bucket - kLinearLimit) % kSubBuckets) + kSubBuckets;
+    return (top_bits << shift) + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds latency) {
+    const uint64_t value = static_cast<uint64_t>(std::max<std::chrono::microseconds::rep>(latency.count(), 0));
+    ++buckets_[getBucket(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    const double value_double = static_cast<double>(value);
+    sum_ += value_double;
+    sum_of_squares_ += value_double * value_double;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+    sum_of_squares_ += other.sum_of_squares_;
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+    return count_;
+}
+
+std::chrono::microseconds LatencyHistogram::GetMin() const {
+    return std::chrono::microseconds{count_ > 0 ? static_cast<std::chrono::microseconds::rep>(min_) : 0};
+}
+
+std::chrono::microseconds LatencyHistogram::GetMax() const {
+    return std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(max_)};
+}
+
+double LatencyHistogram::GetMean() const {
+    return count_ > 0 ? sum_ / static_cast<double>(count_) : 0;
+}
+
+double LatencyHistogram::GetStdDev() const {
+    if (count_ < 2) {
+        return 0;
+    }
+    const double mean = GetMean();
+    const double variance = (sum_of_squares_ / static_cast<double>(count_)) - (mean * mean);
+    return variance > 0 ? std::sqrt(variance) : 0;
+}
+
+std::chrono::microseconds LatencyHistogram::GetPercentile(double percentile) const {
+    if (count_ == 0) {
+        return std::chrono::microseconds::zero();
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            // The bucket may reach above the highest value actually recorded
+            return std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(std::min(getBucketMax(i), max_))};
+        }
+    }
+    return GetMax();
+}
+
+} // namespace cpr::bench
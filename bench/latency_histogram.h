@@ -0,0 +1,49 @@
+#ifndef CPR_BENCH_LATENCY_HISTOGRAM_H
+#define CPR_BENCH_LATENCY_HISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpr::bench {
+
+/**
+ * Log-linear histogram of latencies in microseconds, similar to an HdrHistogram with two significant digits.
+ * Each power of two gets split into 64 buckets, so a recorded value is off by less than 1.6%.
+ *
+ * Not thread safe. Record into one histogram per worker and merge them afterwards.
+ **/
+class LatencyHistogram {
+  public:
+    LatencyHistogram();
+
+    void Record(std::chrono::microseconds latency);
+    void Merge(const LatencyHistogram& other);
+
+    [[nodiscard]] uint64_t GetCount() const;
+    [[nodiscard]] std::chrono::microseconds GetMin() const;
+    [[nodiscard]] std::chrono::microseconds GetMax() const;
+    [[nodiscard]] double GetMean() const;
+    [[nodiscard]] double GetStdDev() const;
+    /**
+     * Returns the highest latency of the bucket containing the given percentile (0 to 100).
+     **/
+    [[nodiscard]] std::chrono::microseconds GetPercentile(double percentile) const;
+
+  private:
+    static size_t getBucket(uint64_t value);
+    static uint64_t getBucketMax(size_t bucket);
+
+    std::vector<uint64_t> buckets_;
+    uint64_t count_{0};
+    uint64_t min_{UINT64_MAX};
+    uint64_t max_{0};
+    // Kept exactly instead of deriving them from the buckets
+    double sum_{0};
+    double sum_of_squares_{0};
+};
+
+} // namespace cpr::bench
+
+#endif
@@ -0,0 +1,256 @@
+#include "cpr/allocation_accounting.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef CPR_ALLOCATION_ACCOUNTING
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <curl/curl.h>
+#endif
+
+namespace cpr {
+
+namespace {
+// Trivially constructible, so accessing them from within operator new never allocates
+thread_local AllocationStats threadStats;
+#ifdef CPR_ALLOCATION_ACCOUNTING
+thread_local AllocationPhase threadPhase{AllocationPhase::OTHER};
+#endif
+} // namespace
+
+const AllocationCounters& AllocationStats::operator[](AllocationPhase phase) const {
+    return phases[static_cast<size_t>(phase)];
+}
+
+AllocationCounters AllocationStats::Total() const {
+    AllocationCounters total;
+    for (const AllocationCounters& counters : phases) {
+        total.allocations += counters.allocations;
+        total.bytes += counters.bytes;
+    }
+    return total;
+}
+
+AllocationRecorder::AllocationRecorder() : start_(threadStats) {}
+
+bool AllocationRecorder::IsEnabled() {
+#ifdef CPR_ALLOCATION_ACCOUNTING
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationStats AllocationRecorder::GetStats() const {
+    AllocationStats stats;
+    for (size_t i = 0; i < kAllocationPhaseCount; ++i) {
+        stats.phases[i].allocations = threadStats.phases[i].allocations - start_.phases[i].allocations;
+        stats.phases[i].bytes = threadStats.phases[i].bytes - start_.phases[i].bytes;
+    }
+    return stats;
+}
+
+void AllocationRecorder::Reset() {
+    start_ = threadStats;
+}
+
+#ifdef CPR_ALLOCATION_ACCOUNTING
+AllocationPhaseScope::AllocationPhaseScope(AllocationPhase phase) : previous_(threadPhase) {
+    threadPhase = phase;
+}
+
+AllocationPhaseScope::~AllocationPhaseScope() {
+    threadPhase = previous_;
+}
+
+namespace {
+void recordAllocation(size_t size) {
+    AllocationCounters& counters = threadStats.phases[static_cast<size_t>(threadPhase)];
+    ++counters.allocations;
+    counters.bytes += size;
+}
+
+void* curlMalloc(size_t size) {
+    recordAllocation(size);
+    return std::malloc(size);
+}
+
+void curlFree(void* ptr) {
+    std::free(ptr);
+}
+
+void* curlRealloc(void* ptr, size_t size) {
+    recordAllocation(size);
+    return std::realloc(ptr, size);
+}
+
+char* curlStrdup(const char* str) {
+    const size_t size = std::strlen(str) + 1;
+    recordAllocation(size);
+    char* copy = static_cast<char*>(std::malloc(size));
+    if (copy) {
+        std::memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+void* curlCalloc(size_t count, size_t size) {
+    recordAllocation(count * size);
+    return std::calloc(count, size);
+}
+
+void* allocate(size_t size) {
+    recordAllocation(size);
+    // malloc(0) may return nullptr, but operator new has to return a unique pointer
+    const size_t actual_size = size == 0 ? 1 : size;
+    void* ptr = std::malloc(actual_size);
+    while (!ptr) {
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+        ptr = std::malloc(actual_size);
+    }
+    return ptr;
+}
+
+void* allocateNoThrow(size_t size) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* allocateAligned(size_t size, std::align_val_t alignment) {
+    recordAllocation(size);
+    const size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc() requires the size to be a multiple of the alignment
+    const size_t actual_size = size == 0 ? align : (size + align - 1) / align * align;
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(actual_size, align);
+#else
+    void* ptr = std::aligned_alloc(align, actual_size);
+#endif
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* allocateAlignedNoThrow(size_t size, std::align_val_t alignment) noexcept {
+    try {
+        return allocateAligned(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocateAligned(void* ptr) noexcept {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+} // namespace
+
+namespace util {
+void installCurlAllocationHooks() {
+    curl_global_init_mem(CURL_GLOBAL_DEFAULT, curlMalloc, curlFree, curlRealloc, curlStrdup, curlCalloc);
+}
+} // namespace util
+#else
+namespace util {
+void installCurlAllocationHooks() {}
+} // namespace util
+#endif
+
+} // namespace cpr
+
+#ifdef CPR_ALLOCATION_ACCOUNTING
+// Replacements of the global allocation functions, counting each allocation for the phase of the calling thread
+void* operator new(std::size_t size) {
+    return cpr::allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return cpr::allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept {
+    return cpr::allocateNoThrow(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept {
+    return cpr::allocateNoThrow(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return cpr::allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return cpr::allocateAligned(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t& /*tag*/) noexcept {
+    return cpr::allocateAlignedNoThrow(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& /*tag*/) noexcept {
+    return cpr::allocateAlignedNoThrow(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept {
+    cpr::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*alignment*/) noexcept {
+    cpr::deallocateAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept {
+    cpr::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept {
+    cpr::deallocateAligned(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/, const std::nothrow_t& /*tag*/) noexcept {
+    cpr::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*alignment*/, const std::nothrow_t& /*tag*/) noexcept {
+    cpr::deallocateAligned(ptr);
+}
+#endif
@@ -1,8 +1,42 @@
 #include "cpr/async.h"
 
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "cpr/executor.h"
+
 namespace cpr {
 
 // NOLINTNEXTLINE (cppcoreguidelines-avoid-non-const-global-variables)
 CPR_SINGLETON_IMPL(GlobalThreadPool)
 
+namespace {
+std::mutex& defaultExecutorMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::shared_ptr<Executor>& defaultExecutor() {
+    static std::shared_ptr<Executor> executor;
+    return executor;
+}
+} // namespace
+
+void SetDefaultExecutor(std::shared_ptr<Executor> executor) {
+    const std::lock_guard<std::mutex> lock(defaultExecutorMutex());
+    defaultExecutor() = std::move(executor);
+}
+
+std::shared_ptr<Executor> GetDefaultExecutor() {
+    {
+        const std::lock_guard<std::mutex> lock(defaultExecutorMutex());
+        if (defaultExecutor()) {
+            return defaultExecutor();
+        }
+    }
+    // Does not own the GlobalThreadPool, it lives until async::cleanup()
+    return std::shared_ptr<Executor>{std::shared_ptr<Executor>{}, GlobalThreadPool::GetInstance()};
+}
+
 } // namespace cpr
@@ -0,0 +1,66 @@
+#include "cpr/async_wrapper.h"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cpr::priv {
+
+void AsyncState::OnComplete(Callback callback) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (!completed_) {
+            continuation_ = std::move(callback);
+            return;
+        }
+    }
+    callback();
+}
+
+void AsyncState::Complete() {
+    Callback continuation;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        completed_ = true;
+        continuation = std::move(continuation_);
+    }
+    // Outside of the lock, the continuation may complete further states
+    if (continuation) {
+        continuation();
+    }
+}
+
+void AsyncState::OnCancel(Callback callback) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (!cancelled_) {
+            cancellations_.push_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+void AsyncState::Cancel() {
+    std::vector<Callback> cancellations;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            return;
+        }
+        cancelled_ = true;
+        cancellations.swap(cancellations_);
+    }
+    for (const Callback& cancellation : cancellations) {
+        cancellation();
+    }
+}
+
+void wait_in_background(std::function<void()> waiter) {
+    // A thread of its own like std::async would use, an executor may not have enough threads to park one per future
+    std::thread{std::move(waiter)}.detach();
+}
+
+} // namespace cpr::priv
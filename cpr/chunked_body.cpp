@@ -0,0 +1,127 @@
+#include "cpr/chunked_body.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace cpr {
+
+ChunkAllocator::ChunkAllocator(size_t chunk_size, size_t max_free_chunks) : state_(std::make_shared<State>()) {
+    state_->chunk_size = std::max<size_t>(chunk_size, 1);
+    state_->max_free_chunks = max_free_chunks;
+}
+
+void ChunkAllocator::State::release(char* chunk) {
+    std::unique_ptr<char[]> owned{chunk};
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (free_chunks.size() < max_free_chunks) {
+        free_chunks.push_back(std::move(owned));
+    }
+}
+
+std::shared_ptr<char> ChunkAllocator::Allocate() const {
+    std::unique_ptr<char[]> chunk;
+    {
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->free_chunks.empty()) {
+            chunk = std::move(state_->free_chunks.back());
+            state_->free_chunks.pop_back();
+        }
+    }
+    if (!chunk) {
+        // NOLINTNEXTLINE (cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+        chunk = std::make_unique_for_overwrite<char[]>(state_->chunk_size);
+    }
+    // The deleter keeps the state alive, so chunks may outlive every ChunkAllocator handle.
+    return std::shared_ptr<char>(chunk.release(), [state = state_](char* ptr) { state->release(ptr); });
+}
+
+size_t ChunkAllocator::GetChunkSize() const {
+    return state_->chunk_size;
+}
+
+size_t ChunkAllocator::GetFreeCount() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->free_chunks.size();
+}
+
+ChunkedBody::ChunkedBody(ChunkAllocator allocator) : allocator_(std::move(allocator)) {}
+
+void ChunkedBody::Append(std::string_view data) {
+    if (!allocator_) {
+        allocator_.emplace();
+    }
+    const size_t chunk_size = allocator_->GetChunkSize();
+    while (!data.empty()) {
+        if (chunks_.empty() || chunks_.back().external || chunks_.back().size == chunk_size) {
+            chunks_.push_back(Chunk{allocator_->Allocate(), 0, false});
+        }
+        Chunk& last = chunks_.back();
+        const size_t count = std::min(data.size(), chunk_size - last.size);
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::memcpy(last.data.get() + last.size, data.data(), count);
+        last.size += count;
+        size_ += count;
+        data.remove_prefix(count);
+    }
+}
+
+void ChunkedBody::AppendExternal(std::shared_ptr<const char> data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    // Only ever read from, since Append() never writes into external chunks
+    chunks_.push_back(Chunk{std::const_pointer_cast<char>(std::move(data)), size, true});
+    size_ += size;
+}
+
+void ChunkedBody::clear() {
+    chunks_.clear();
+    size_ = 0;
+}
+
+size_t ChunkedBody::size() const {
+    return size_;
+}
+
+bool ChunkedBody::empty() const {
+    return size_ == 0;
+}
+
+size_t ChunkedBody::chunk_count() const {
+    return chunks_.size();
+}
+
+std::string_view ChunkedBody::chunk(size_t index) const {
+    const Chunk& c = chunks_.at(index);
+    return {c.data.get(), c.size};
+}
+
+ChunkedBody::const_iterator ChunkedBody::begin() const {
+    return {this, 0};
+}
+
+ChunkedBody::const_iterator ChunkedBody::end() const {
+    return {this, chunks_.size()};
+}
+
+bool ChunkedBody::WriteTo(std::ostream& stream) const {
+    return WriteTo([&stream](std::string_view data) { return static_cast<bool>(stream.write(data.data(), static_cast<std::streamsize>(data.size()))); });
+}
+
+std::string ChunkedBody::Flatten() const {
+    std::string result;
+    result.reserve(size_);
+    for (const Chunk& c : chunks_) {
+        result.append(c.data.get(), c.size);
+    }
+    return result;
+}
+
+} // namespace cpr
@@ -0,0 +1,182 @@
+#include "cpr/circuit_breaker.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "cpr/error.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+namespace {
+int64_t getNow() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+CircuitBreaker::Registry::Registry(CircuitBreakerOptions p_options) : options(p_options) {
+    // Keeps the load factor at or below one half, so probe sequences stay short
+    size_t slot_count = 1;
+    while (slot_count < options.max_hosts * 2) {
+        slot_count *= 2;
+    }
+    slots = std::vector<std::atomic<HostState*>>(slot_count);
+}
+
+CircuitBreaker::Registry::~Registry() {
+    for (std::atomic<HostState*>& slot : slots) {
+        delete slot.load(); // NOLINT(cppcoreguidelines-owning-memory)
+    }
+}
+
+CircuitBreaker::HostState* CircuitBreaker::Registry::Get(std::string_view host, bool insert) {
+    const size_t mask = slots.size() - 1;
+    size_t index = std::hash<std::string_view>{}(host) & mask;
+    for (size_t i = 0; i < slots.size(); ++i, index = (index + 1) & mask) {
+        HostState* host_state = slots[index].load(std::memory_order_acquire);
+        if (host_state == nullptr) {
+            if (!insert) {
+                return nullptr;
+            }
+            HostState* new_host_state = new HostState(host); // NOLINT(cppcoreguidelines-owning-memory)
+            if (slots[index].compare_exchange_strong(host_state, new_host_state, std::memory_order_acq_rel)) {
+                return new_host_state;
+            }
+            // Someone else filled the slot in the meantime, host_state holds their entry now
+            delete new_host_state; // NOLINT(cppcoreguidelines-owning-memory)
+        }
+        if (host_state->host == host) {
+            return host_state;
+        }
+    }
+    return nullptr;
+}
+
+CircuitBreaker::CircuitBreaker(CircuitBreakerOptions options) : registry_(std::make_shared<Registry>(options)) {}
+
+bool CircuitBreaker::Allow(std::string_view host) const {
+    HostState* host_state = registry_->Get(host, true);
+    if (host_state == nullptr) {
+        return true;
+    }
+
+    State state = host_state->state.load(std::memory_order_acquire);
+    if (state == State::CLOSED) {
+        return true;
+    }
+    const int64_t now = getNow();
+    int64_t open_until = host_state->open_until.load(std::memory_order_acquire);
+    if (now < open_until && state == State::OPEN) {
+        return false;
+    }
+    if (now >= open_until) {
+        // Starts a new probe round. Also covers probes which never reported back.
+        if (host_state->open_until.compare_exchange_strong(open_until, now + registry_->options.open_duration.count(), std::memory_order_acq_rel)) {
+            host_state->probes.store(0, std::memory_order_release);
+            host_state->probe_successes.store(0, std::memory_order_release);
+            host_state->state.compare_exchange_strong(state, State::HALF_OPEN, std::memory_order_acq_rel);
+        }
+    }
+    // Checked first, so rejected requests do not keep counting up
+    if (host_state->probes.load(std::memory_order_acquire) >= registry_->options.half_open_probes) {
+        return false;
+    }
+    return host_state->probes.fetch_add(1, std::memory_order_acq_rel) < registry_->options.half_open_probes;
+}
+
+void CircuitBreaker::Record(std::string_view host, const Response& response) const {
+    HostState* host_state = registry_->Get(host, false);
+    if (host_state == nullptr || response.error.code == ErrorCode::CIRCUIT_OPEN) {
+        return;
+    }
+
+    const bool failure = IsFailure(response);
+    const int64_t now = getNow();
+    const CircuitBreakerOptions& options = registry_->options;
+    State state = host_state->state.load(std::memory_order_acquire);
+    if (state == State::HALF_OPEN) {
+        if (failure) {
+            open(*host_state, now);
+        } else if (host_state->probe_successes.fetch_add(1, std::memory_order_acq_rel) + 1 >= options.half_open_probes) {
+            host_state->successes.store(0, std::memory_order_release);
+            host_state->failures.store(0, std::memory_order_release);
+            host_state->window_start.store(now, std::memory_order_release);
+            host_state->state.compare_exchange_strong(state, State::CLOSED, std::memory_order_acq_rel);
+        }
+        return;
+    }
+    if (state == State::OPEN) {
+        // Late completion of a request sent before the circuit opened
+        return;
+    }
+
+    int64_t window_start = host_state->window_start.load(std::memory_order_acquire);
+    if (now - window_start >= options.window.count() && host_state->window_start.compare_exchange_strong(window_start, now, std::memory_order_acq_rel)) {
+        // Outcomes recorded concurrently with the reset may get lost, which does not matter for a rate
+        host_state->successes.store(0, std::memory_order_release);
+        host_state->failures.store(0, std::memory_order_release);
+    }
+    if (!failure) {
+        host_state->successes.fetch_add(1, std::memory_order_acq_rel);
+        return;
+    }
+    const uint32_t failures = host_state->failures.fetch_add(1, std::memory_order_acq_rel) + 1;
+    const uint32_t requests = failures + host_state->successes.load(std::memory_order_acquire);
+    if (requests >= options.minimum_requests && static_cast<double>(failures) >= options.failure_rate_threshold * static_cast<double>(requests)) {
+        open(*host_state, now);
+    }
+}
+
+void CircuitBreaker::open(HostState& host_state, int64_t now) const {
+    host_state.open_until.store(now + registry_->options.open_duration.count(), std::memory_order_release);
+    host_state.state.store(State::OPEN, std::memory_order_release);
+}
+
+CircuitBreaker::State CircuitBreaker::GetState(std::string_view host) const {
+    const HostState* host_state = registry_->Get(host, false);
+    return host_state == nullptr ? State::CLOSED : host_state->state.load(std::memory_order_acquire);
+}
+
+bool CircuitBreaker::IsFailure(const Response& response) {
+    switch (response.error.code) {
+        case ErrorCode::OK:
+            return response.status_code >= 500;
+        case ErrorCode::COULDNT_RESOLVE_HOST:
+        case ErrorCode::COULDNT_CONNECT:
+        case ErrorCode::WEIRD_SERVER_REPLY:
+        case ErrorCode::HTTP2:
+        case ErrorCode::PARTIAL_FILE:
+        case ErrorCode::OPERATION_TIMEDOUT:
+        case ErrorCode::SSL_CONNECT_ERROR:
+        case ErrorCode::GOT_NOTHING:
+        case ErrorCode::SEND_ERROR:
+        case ErrorCode::RECV_ERROR:
+        case ErrorCode::HTTP2_STREAM:
+        case ErrorCode::HTTP3:
+        case ErrorCode::QUIC_CONNECT_ERROR:
+            return true;
+        default:
+            // Errors caused by the client itself (e.g. a malformed URL or an aborted transfer) say nothing about the host
+            return false;
+    }
+}
+
+std::string_view CircuitBreaker::GetHost(std::string_view url) {
+    const size_t scheme_end = url.find("://");
+    if (scheme_end != std::string_view::npos) {
+        url.remove_prefix(scheme_end + 3);
+    }
+    url = url.substr(0, url.find_first_of("/?#"));
+    const size_t userinfo_end = url.rfind('@');
+    if (userinfo_end != std::string_view::npos) {
+        url.remove_prefix(userinfo_end + 1);
+    }
+    return url;
+}
+
+} // namespace cpr
@@ -6,19 +6,21 @@
 namespace cpr {
 ConnectionPool::ConnectionPool() {
     CURLSH* curl_share = curl_share_init();
-    this->connection_mutex_ = std::make_shared<std::mutex>();
+    this->connection_mutex_ = std::make_shared<std::recursive_mutex>();
     
     auto lock_f = +[](CURL* /*handle*/, curl_lock_data /*data*/, curl_lock_access /*access*/, void* userptr) {
-        std::mutex* lock = static_cast<std::mutex*>(userptr);
+        std::recursive_mutex* lock = static_cast<std::recursive_mutex*>(userptr);
         lock->lock(); // cppcheck-suppress localMutex  // False positive: mutex is used as callback for libcurl, not local scope
     };
     
     auto unlock_f = +[](CURL* /*handle*/, curl_lock_data /*data*/, void* userptr) {
-        std::mutex* lock = static_cast<std::mutex*>(userptr);
+        std::recursive_mutex* lock = static_cast<std::recursive_mutex*>(userptr);
         lock->unlock();
     };
     
     curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    // New connections to a host resume the TLS session of an earlier one instead of doing a full handshake
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
     curl_share_setopt(curl_share, CURLSHOPT_USERDATA, this->connection_mutex_.get());
     curl_share_setopt(curl_share, CURLSHOPT_LOCKFUNC, lock_f);
     curl_share_setopt(curl_share, CURLSHOPT_UNLOCKFUNC, unlock_f);
@@ -1,4 +1,5 @@
 #include "cpr/curlholder.h"
+#include "cpr/allocation_accounting.h"
 #include "cpr/secure_string.h"
 #include <cassert>
 #include <curl/curl.h>
@@ -15,6 +16,11 @@ CurlHolder::CurlHolder() {
      * https://curl.haxx.se/libcurl/c/threadsafe.html
      **/
     curl_easy_init_mutex_().lock();
+#ifdef CPR_ALLOCATION_ACCOUNTING
+    // curl takes its memory callbacks only before it got initialized by the first handle
+    static const bool allocationHooksInstalled = (util::installCurlAllocationHooks(), true);
+    static_cast<void>(allocationHooksInstalled);
+#endif
     // NOLINTNEXTLINE (cppcoreguidelines-prefer-member-initializer) since we need it to happen inside the lock
     handle = curl_easy_init();
     curl_easy_init_mutex_().unlock();
@@ -25,6 +31,7 @@ CurlHolder::CurlHolder() {
 CurlHolder::~CurlHolder() {
     curl_slist_free_all(chunk);
     curl_slist_free_all(resolveCurlList);
+    curl_slist_free_all(connectToCurlList);
     curl_mime_free(multipart);
     curl_easy_cleanup(handle);
 }
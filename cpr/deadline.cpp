@@ -0,0 +1,27 @@
+#include "cpr/deadline.h"
+
+#include <chrono>
+#include <optional>
+
+namespace cpr {
+
+std::chrono::milliseconds Deadline::Remaining() const {
+    const Clock::duration remaining = time_point - Clock::now();
+    if (remaining <= Clock::duration::zero()) {
+        return std::chrono::milliseconds::zero();
+    }
+    return std::chrono::ceil<std::chrono::milliseconds>(remaining);
+}
+
+bool Deadline::Expired() const {
+    return Clock::now() >= time_point;
+}
+
+std::optional<Deadline> Deadline::Earliest(const std::optional<Deadline>& first, const std::optional<Deadline>& second) {
+    if (!first || !second) {
+        return first ? first : second;
+    }
+    return first->time_point <= second->time_point ? first : second;
+}
+
+} // namespace cpr
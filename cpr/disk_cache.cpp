@@ -0,0 +1,764 @@
+#include "cpr/disk_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "cpr/cprtypes.h"
+#include "cpr/filesystem.h"
+#include "cpr/http_cache.h"
+#include "cpr/interceptor.h"
+#include "cpr/response.h"
+#include "cpr/session.h"
+#include "cpr/util.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cpr {
+
+namespace {
+bool isSuccessful(const Response& response) {
+    return !response.error && response.status_code >= 200 && response.status_code < 400;
+}
+} // namespace
+
+DiskCacheInterceptor::DiskCacheInterceptor(std::shared_ptr<DiskCache> cache) : cache_(std::move(cache)) {}
+
+Response DiskCacheInterceptor::intercept(Session& session) {
+    const std::string_view method = session.GetHttpMethod();
+    if (session.IsDownload()) {
+        // The body of a download goes to its file, sink or callback, so it can neither be stored nor served from here
+        return proceed(session);
+    }
+    const std::string url = session.GetFullRequestUrl();
+    if (method != "GET" || HttpCache::BypassesCache(session.GetHeader())) {
+        Response response = proceed(session);
+        // RFC 9111 4.4: Successful unsafe requests invalidate the stored responses of the target URL
+        if (method != "HEAD" && method != "OPTIONS" && isSuccessful(response)) {
+            cache_->Invalidate(url);
+        }
+        return response;
+    }
+
+    const Header request_header = session.GetHeader();
+    std::optional<DiskCache::LookupResult> hit = cache_->Lookup(method, url, request_header);
+    if (hit && hit->fresh) {
+        return std::move(hit->response);
+    }
+
+    bool conditional{false};
+    if (hit) {
+        const Header& stored_header = hit->response.header;
+        const Header::const_iterator etag = stored_header.find("ETag");
+        const Header::const_iterator last_modified = stored_header.find("Last-Modified");
+        if (etag != stored_header.end()) {
+            session.GetHeader()["If-None-Match"] = etag->second;
+            conditional = true;
+        }
+        if (last_modified != stored_header.end()) {
+            session.GetHeader()["If-Modified-Since"] = last_modified->second;
+            conditional = true;
+        }
+    }
+    Response response = proceed(session);
+    if (conditional) {
+        // Do not leak the conditional header into following requests of this session
+        session.SetHeader(request_header);
+        if (!response.error && response.status_code == 304) {
+            cache_->Freshen(method, url, response);
+            hit->response.elapsed = response.elapsed;
+            return std::move(hit->response);
+        }
+    }
+    cache_->Store(method, url, request_header, response);
+    return response;
+}
+
+#ifdef _WIN32
+
+struct DiskCache::IndexSlot {};
+struct DiskCache::Segment {};
+
+DiskCache::DiskCache(const fs::path& directory, DiskCacheOptions options) : directory_(directory), options_(options) {
+    throw std::runtime_error("cpr::DiskCache is not supported on Windows.");
+}
+
+DiskCache::~DiskCache() = default;
+
+DiskCache::IndexFile::~IndexFile() = default;
+
+std::optional<DiskCache::LookupResult> DiskCache::Lookup(std::string_view /*method*/, const std::string& /*url*/, const Header& /*request_header*/) {
+    return std::nullopt;
+}
+
+bool DiskCache::Store(std::string_view /*method*/, const std::string& /*url*/, const Header& /*request_header*/, const Response& /*response*/) {
+    return false;
+}
+
+void DiskCache::Freshen(std::string_view /*method*/, const std::string& /*url*/, const Response& /*not_modified*/) {}
+
+void DiskCache::Invalidate(const std::string& /*url*/) {}
+
+void DiskCache::Clear() {}
+
+#else
+
+namespace {
+constexpr uint64_t kIndexMagic = 0x58444e4943525043ULL; // "CPRCINDX"
+constexpr uint32_t kRecordMagic = 0x43455243; // "CREC"
+constexpr uint32_t kFormatVersion = 2;
+// IndexSlot::flags: The record got synced to disk before the slot got published
+constexpr uint32_t kSlotSynced = 1;
+// Number of slots looked at for a fingerprint before the oldest one gets replaced
+constexpr size_t kMaxProbes = 16;
+constexpr std::string_view kSegmentPrefix = "segment-";
+constexpr std::string_view kSegmentSuffix = ".dat";
+
+std::string primaryKey(std::string_view method, const std::string& url) {
+    std::string key{method};
+    key += ' ';
+    key += url;
+    return key;
+}
+
+uint64_t fingerprintOf(const std::string& key) {
+    const uint64_t fingerprint = util::fnv1a(key);
+    // Zero marks an empty index slot
+    return fingerprint == 0 ? 1 : fingerprint;
+}
+
+/**
+ * Time to live of the response, taking DiskCacheOptions::default_ttl into account for responses without explicit freshness.
+ **/
+std::optional<std::chrono::seconds> timeToLive(const Response& response, const DiskCacheOptions& options) {
+    std::optional<std::chrono::seconds> ttl = HttpCache::GetTimeToLive(response);
+    const bool explicit_freshness = response.header.find("Cache-Control") != response.header.end() || response.header.find("Expires") != response.header.end();
+    if (!explicit_freshness && options.default_ttl.count() > 0) {
+        ttl = std::max(ttl.value_or(std::chrono::seconds{0}), options.default_ttl);
+    }
+    return ttl;
+}
+
+struct IndexHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint64_t reserved[6]; // NOLINT (cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+};
+static_assert(sizeof(IndexHeader) == 64);
+
+/**
+ * Precedes every record in a segment file. The record continues with the key, the varying request header fields
+ * ("name: value\r\n" each), the raw header and the body.
+ **/
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;
+    uint64_t body_checksum;
+    uint64_t body_size;
+    int64_t status_code;
+    uint32_t key_size;
+    uint32_t header_size;
+    uint32_t vary_size;
+    uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 56);
+
+/**
+ * Serializes the request header fields the response varies on. std::nullopt in case it must not be stored at all.
+ **/
+std::optional<std::string> serializeVary(const Header& response_header, const Header& request_header) {
+    const std::optional<std::vector<std::string>> fields = HttpCache::GetVaryFields(response_header);
+    if (!fields) {
+        return std::nullopt;
+    }
+    std::string vary;
+    for (const std::string& name : *fields) {
+        const Header::const_iterator value = request_header.find(name);
+        vary += name;
+        vary += ": ";
+        vary += value == request_header.end() ? std::string{} : value->second;
+        vary += "\r\n";
+    }
+    return vary;
+}
+
+bool varyMatches(std::string_view vary, const Header& request_header) {
+    while (!vary.empty()) {
+        const size_t end = vary.find("\r\n");
+        const std::string_view line = vary.substr(0, end);
+        vary = end == std::string_view::npos ? std::string_view{} : vary.substr(end + 2);
+        const size_t colon = line.find(": ");
+        if (colon == std::string_view::npos) {
+            return false;
+        }
+        const Header::const_iterator value = request_header.find(std::string{line.substr(0, colon)});
+        if ((value == request_header.end() ? std::string_view{} : std::string_view{value->second}) != line.substr(colon + 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+fs::path segmentPath(const fs::path& directory, uint32_t id) {
+    std::string name = std::to_string(id);
+    name.insert(0, name.size() < 8 ? 8 - name.size() : 0, '0');
+    return directory / (std::string{kSegmentPrefix} + name + std::string{kSegmentSuffix});
+}
+
+std::optional<uint32_t> parseSegmentId(const std::string& file_name) {
+    if (file_name.size() <= kSegmentPrefix.size() + kSegmentSuffix.size() || file_name.compare(0, kSegmentPrefix.size(), kSegmentPrefix) != 0 || file_name.compare(file_name.size() - kSegmentSuffix.size(), kSegmentSuffix.size(), kSegmentSuffix) != 0) {
+        return std::nullopt;
+    }
+    const std::string_view digits = std::string_view{file_name}.substr(kSegmentPrefix.size(), file_name.size() - kSegmentPrefix.size() - kSegmentSuffix.size());
+    uint32_t id{0};
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::from_chars_result result = std::from_chars(digits.data(), digits.data() + digits.size(), id);
+    if (result.ec != std::errc{} || result.ptr != digits.data() + digits.size()) { // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return std::nullopt;
+    }
+    return id;
+}
+
+bool writeAll(int fd, std::string_view data, uint64_t offset) {
+    while (!data.empty()) {
+        const ssize_t written = ::pwrite(fd, data.data(), data.size(), static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* buffer, size_t size, uint64_t offset) {
+    while (size > 0) {
+        const ssize_t count = ::pread(fd, buffer, size, static_cast<off_t>(offset));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        size -= static_cast<size_t>(count);
+        offset += static_cast<uint64_t>(count);
+    }
+    return true;
+}
+
+bool syncData(int fd) {
+#ifdef __APPLE__
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+/**
+ * Maps the given range of the file read only. The mapping is released once the last reference is gone.
+ **/
+std::shared_ptr<const char> mapRegion(int fd, uint64_t offset, size_t size) {
+    static const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const uint64_t aligned_offset = offset - (offset % page_size);
+    const size_t length = size + static_cast<size_t>(offset - aligned_offset);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(aligned_offset));
+    if (mapping == MAP_FAILED) { // NOLINT (cppcoreguidelines-pro-type-cstyle-cast)
+        return nullptr;
+    }
+    const std::shared_ptr<char> owner(static_cast<char*>(mapping), [length](char* ptr) { munmap(ptr, length); });
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return std::shared_ptr<const char>(owner, owner.get() + (offset - aligned_offset));
+}
+} // namespace
+
+struct DiskCache::IndexSlot {
+    // Zero marks an empty slot
+    uint64_t fingerprint;
+    uint64_t offset;
+    uint64_t size;
+    // Seconds since the epoch
+    int64_t expires;
+    uint32_t segment;
+    uint32_t flags;
+    // Over all fields above. Detects slots torn by a crash while being written.
+    uint32_t checksum;
+    uint32_t reserved;
+
+    [[nodiscard]] uint32_t calculateChecksum() const {
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-type-reinterpret-cast)
+        return static_cast<uint32_t>(util::fnv1a(std::string_view{reinterpret_cast<const char*>(this), offsetof(IndexSlot, checksum)}));
+    }
+};
+
+struct DiskCache::Segment {
+    uint32_t id{0};
+    int fd{-1};
+    // Includes the space reserved for records currently being written
+    size_t size{0};
+    bool removed{false};
+
+    Segment() = default;
+    Segment(const Segment& other) = delete;
+    Segment(Segment&& old) = delete;
+    Segment& operator=(const Segment& other) = delete;
+    Segment& operator=(Segment&& old) = delete;
+    ~Segment() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+DiskCache::DiskCache(const fs::path& directory, DiskCacheOptions options) : directory_(directory), options_(options) {
+    options_.max_size = std::max<size_t>(options_.max_size, 1);
+    // At least two segments fit into the cache, so eviction never has to drop the segment currently written to
+    options_.segment_size = std::clamp<size_t>(options_.segment_size, 1, std::max<size_t>(options_.max_size / 2, 1));
+    slot_count_ = 1;
+    while (slot_count_ < std::max<size_t>(options_.index_slots, kMaxProbes)) {
+        slot_count_ <<= 1;
+    }
+
+    verified_.resize(slot_count_, false);
+
+    fs::create_directories(directory_);
+    openIndex();
+    openSegments();
+}
+
+DiskCache::~DiskCache() = default;
+
+DiskCache::IndexFile::~IndexFile() {
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+    if (fd >= 0) {
+        // Also releases the lock
+        ::close(fd);
+    }
+}
+
+void DiskCache::openIndex() {
+    const fs::path path = directory_ / "index.dat";
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    index_.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (index_.fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to open disk cache index " + path.string());
+    }
+    if (flock(index_.fd, LOCK_EX | LOCK_NB) != 0) {
+        const int error = errno;
+        throw std::system_error(error, std::generic_category(), "Disk cache " + directory_.string() + " is in use");
+    }
+
+    index_.mapping_size = sizeof(IndexHeader) + slot_count_ * sizeof(IndexSlot);
+    struct stat info {};
+    bool valid = fstat(index_.fd, &info) == 0 && static_cast<size_t>(info.st_size) == index_.mapping_size;
+    if (valid) {
+        IndexHeader header{};
+        valid = readAll(index_.fd, reinterpret_cast<char*>(&header), sizeof(header), 0) && header.magic == kIndexMagic && header.version == kFormatVersion && header.slot_count == slot_count_; // NOLINT (cppcoreguidelines-pro-type-reinterpret-cast)
+    }
+    if (!valid) {
+        // New cache, different format or a different number of slots. Start over, since the segments can not be found without the index.
+        for (const fs::directory_entry& entry : fs::directory_iterator(directory_)) {
+            if (parseSegmentId(entry.path().filename().string())) {
+                fs::remove(entry.path());
+            }
+        }
+        const IndexHeader header{kIndexMagic, kFormatVersion, static_cast<uint32_t>(slot_count_), {}};
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-type-reinterpret-cast)
+        if (ftruncate(index_.fd, 0) != 0 || ftruncate(index_.fd, static_cast<off_t>(index_.mapping_size)) != 0 || !writeAll(index_.fd, std::string_view{reinterpret_cast<const char*>(&header), sizeof(header)}, 0)) {
+            throw std::system_error(errno, std::generic_category(), "Failed to initialize disk cache index " + path.string());
+        }
+    }
+
+    index_.mapping = mmap(nullptr, index_.mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_.fd, 0);
+    if (index_.mapping == MAP_FAILED) { // NOLINT (cppcoreguidelines-pro-type-cstyle-cast)
+        index_.mapping = nullptr;
+        throw std::system_error(errno, std::generic_category(), "Failed to map disk cache index " + path.string());
+    }
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    slots_ = reinterpret_cast<IndexSlot*>(static_cast<char*>(index_.mapping) + sizeof(IndexHeader));
+}
+
+void DiskCache::openSegments() {
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory_)) {
+        const std::optional<uint32_t> id = parseSegmentId(entry.path().filename().string());
+        if (!id) {
+            continue;
+        }
+        std::shared_ptr<Segment> segment = std::make_shared<Segment>();
+        segment->id = *id;
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+        segment->fd = ::open(entry.path().c_str(), O_RDWR | O_CLOEXEC);
+        struct stat info {};
+        if (segment->fd < 0 || fstat(segment->fd, &info) != 0) {
+            fs::remove(entry.path());
+            continue;
+        }
+        segment->size = static_cast<size_t>(info.st_size);
+        total_size_ += segment->size;
+        segments_.emplace(segment->id, std::move(segment));
+    }
+
+    // Drop slots torn by a crash or pointing to data which is gone
+    for (size_t i = 0; i < slot_count_; ++i) {
+        IndexSlot& slot = slots_[i]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (slot.fingerprint == 0) {
+            continue;
+        }
+        const auto segment = segments_.find(slot.segment);
+        if (slot.checksum != slot.calculateChecksum() || segment == segments_.end() || slot.offset + slot.size > segment->second->size) {
+            std::memset(&slot, 0, sizeof(IndexSlot));
+            continue;
+        }
+        ++entry_count_;
+    }
+    evict();
+}
+
+std::shared_ptr<DiskCache::Segment> DiskCache::createSegment() {
+    std::shared_ptr<Segment> segment = std::make_shared<Segment>();
+    segment->id = segments_.empty() ? 1 : segments_.rbegin()->first + 1;
+    const fs::path path = segmentPath(directory_, segment->id);
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    segment->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (segment->fd < 0) {
+        return nullptr;
+    }
+    segments_.emplace(segment->id, segment);
+    return segment;
+}
+
+std::optional<size_t> DiskCache::findSlot(uint64_t fingerprint) const {
+    const size_t mask = slot_count_ - 1;
+    for (size_t i = 0; i < kMaxProbes; ++i) {
+        const size_t index = (fingerprint + i) & mask;
+        const IndexSlot& slot = slots_[index]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (slot.fingerprint == fingerprint && slot.checksum == slot.calculateChecksum() && segments_.find(slot.segment) != segments_.end()) {
+            return index;
+        }
+    }
+    return std::nullopt;
+}
+
+void DiskCache::clearSlot(IndexSlot& slot) {
+    if (slot.fingerprint != 0) {
+        std::memset(&slot, 0, sizeof(IndexSlot));
+        --entry_count_;
+    }
+}
+
+void DiskCache::evict() {
+    while (total_size_ > options_.max_size && !segments_.empty()) {
+        removeSegment(segments_.begin()->first);
+    }
+}
+
+void DiskCache::removeSegment(uint32_t id) {
+    const auto it = segments_.find(id);
+    if (it == segments_.end()) {
+        return;
+    }
+    // Responses handed out before keep their mapping, the data is only gone once the last of them is gone
+    it->second->removed = true;
+    ::unlink(segmentPath(directory_, id).c_str());
+    total_size_ -= it->second->size;
+    segments_.erase(it);
+
+    for (size_t i = 0; i < slot_count_; ++i) {
+        IndexSlot& slot = slots_[i]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (slot.fingerprint != 0 && slot.segment == id) {
+            clearSlot(slot);
+        }
+    }
+}
+
+std::optional<DiskCache::LookupResult> DiskCache::Lookup(std::string_view method, const std::string& url, const Header& request_header) {
+    const std::string key = primaryKey(method, url);
+    const uint64_t fingerprint = fingerprintOf(key);
+
+    IndexSlot slot{};
+    size_t slot_index{0};
+    std::shared_ptr<Segment> segment;
+    bool verify{options_.verify_checksums};
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        const std::optional<size_t> index = findSlot(fingerprint);
+        if (!index) {
+            return std::nullopt;
+        }
+        slot_index = *index;
+        slot = slots_[slot_index]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        segment = segments_.at(slot.segment);
+        // Without syncing, the slot may have made it to disk before the body did
+        verify = verify || ((slot.flags & kSlotSynced) == 0 && !verified_[slot_index]);
+    }
+
+    const auto drop = [this, &slot, fingerprint]() -> std::optional<LookupResult> {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        const std::optional<size_t> index = findSlot(fingerprint);
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (index && slots_[*index].segment == slot.segment && slots_[*index].offset == slot.offset) {
+            clearSlot(slots_[*index]); // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        return std::nullopt;
+    };
+
+    RecordHeader record{};
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-reinterpret-cast)
+    if (!readAll(segment->fd, reinterpret_cast<char*>(&record), sizeof(record), slot.offset) || record.magic != kRecordMagic || record.version != kFormatVersion || record.fingerprint != fingerprint) {
+        return drop();
+    }
+    if (sizeof(RecordHeader) + record.key_size + record.vary_size + record.header_size + record.body_size != slot.size) {
+        return drop();
+    }
+    std::string meta(static_cast<size_t>(record.key_size) + record.vary_size + record.header_size, '\0');
+    if (!readAll(segment->fd, meta.data(), meta.size(), slot.offset + sizeof(RecordHeader))) {
+        return drop();
+    }
+    if (std::string_view{meta}.substr(0, record.key_size) != key) {
+        // Fingerprint collision, the slot belongs to another URL
+        return std::nullopt;
+    }
+    if (!varyMatches(std::string_view{meta}.substr(record.key_size, record.vary_size), request_header)) {
+        // Stored for different values of the request header fields the response varies on
+        return std::nullopt;
+    }
+
+    LookupResult result;
+    Response& response = result.response;
+    if (record.body_size > 0) {
+        const uint64_t body_offset = slot.offset + sizeof(RecordHeader) + meta.size();
+        const size_t body_size = static_cast<size_t>(record.body_size);
+        if (options_.map_bodies) {
+            const std::shared_ptr<const char> body = mapRegion(segment->fd, body_offset, body_size);
+            if (!body) {
+                return std::nullopt;
+            }
+            if (verify && util::fnv1a(std::string_view{body.get(), body_size}) != record.body_checksum) {
+                return drop();
+            }
+            response.chunked_body.AppendExternal(body, body_size);
+        } else {
+            response.text.resize(body_size);
+            if (!readAll(segment->fd, response.text.data(), body_size, body_offset)) {
+                return drop();
+            }
+            if (verify && util::fnv1a(response.text) != record.body_checksum) {
+                return drop();
+            }
+        }
+        if (verify) {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            if (slots_[slot_index].fingerprint == fingerprint && slots_[slot_index].segment == slot.segment && slots_[slot_index].offset == slot.offset) {
+                verified_[slot_index] = true;
+            }
+        }
+    }
+    response.status_code = static_cast<long>(record.status_code);
+    response.raw_header = meta.substr(static_cast<size_t>(record.key_size) + record.vary_size);
+    response.header = util::parseHeader(response.raw_header, &response.status_line, &response.reason);
+    response.url = Url{url};
+    response.downloaded_bytes = static_cast<cpr_off_t>(record.body_size);
+    result.fresh = Clock::now() < Clock::from_time_t(static_cast<std::time_t>(slot.expires));
+    return result;
+}
+
+bool DiskCache::Store(std::string_view method, const std::string& url, const Header& request_header, const Response& response) {
+    // Only complete responses to GET requests are stored. Partial content (206) would require range handling.
+    if (method != "GET" || response.error || response.status_code < 200 || response.status_code == 206 || response.status_code == 304) {
+        return false;
+    }
+    if (HttpCache::BypassesCache(request_header)) {
+        return false;
+    }
+    const std::optional<std::string> vary = serializeVary(response.header, request_header);
+    if (!vary) {
+        return false;
+    }
+    const std::optional<std::chrono::seconds> ttl = timeToLive(response, options_);
+    if (!ttl || (ttl->count() == 0 && response.header.find("ETag") == response.header.end() && response.header.find("Last-Modified") == response.header.end())) {
+        return false;
+    }
+
+    const std::string key = primaryKey(method, url);
+    const uint64_t fingerprint = fingerprintOf(key);
+    const bool chunked = response.text.empty() && !response.chunked_body.empty();
+    const size_t body_size = chunked ? response.chunked_body.size() : response.text.size();
+
+    RecordHeader record{};
+    record.magic = kRecordMagic;
+    record.version = kFormatVersion;
+    record.fingerprint = fingerprint;
+    record.body_size = body_size;
+    record.status_code = response.status_code;
+    record.key_size = static_cast<uint32_t>(key.size());
+    record.header_size = static_cast<uint32_t>(response.raw_header.size());
+    record.vary_size = static_cast<uint32_t>(vary->size());
+    if (chunked) {
+        uint64_t checksum = util::fnv1a({});
+        for (const std::string_view chunk : response.chunked_body) {
+            checksum = util::fnv1a(chunk, checksum);
+        }
+        record.body_checksum = checksum;
+    } else {
+        record.body_checksum = util::fnv1a(response.text);
+    }
+    const size_t record_size = sizeof(RecordHeader) + key.size() + vary->size() + response.raw_header.size() + body_size;
+    if (record_size > options_.max_size) {
+        return false;
+    }
+
+    // Reserve the space, so the (potentially large) write happens without holding the lock
+    std::shared_ptr<Segment> segment;
+    uint64_t offset{0};
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        segment = segments_.empty() ? nullptr : segments_.rbegin()->second;
+        if (!segment || (segment->size > 0 && segment->size + record_size > options_.segment_size)) {
+            segment = createSegment();
+            if (!segment) {
+                return false;
+            }
+        }
+        offset = segment->size;
+        segment->size += record_size;
+        total_size_ += record_size;
+    }
+
+    std::string meta;
+    meta.reserve(sizeof(RecordHeader) + key.size() + vary->size() + response.raw_header.size());
+    meta.append(reinterpret_cast<const char*>(&record), sizeof(record)); // NOLINT (cppcoreguidelines-pro-type-reinterpret-cast)
+    meta.append(key);
+    meta.append(*vary);
+    meta.append(response.raw_header);
+    bool written = writeAll(segment->fd, meta, offset);
+    uint64_t body_offset = offset + meta.size();
+    if (chunked) {
+        written = written && response.chunked_body.WriteTo([&segment, &body_offset](std::string_view chunk) {
+            const bool success = writeAll(segment->fd, chunk, body_offset);
+            body_offset += chunk.size();
+            return success;
+        });
+    } else {
+        written = written && writeAll(segment->fd, response.text, body_offset);
+    }
+    if (written && options_.sync_writes) {
+        written = syncData(segment->fd);
+    }
+
+    // Publish the record in the index only after it is completely written
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (!written || segment->removed) {
+        return false;
+    }
+    const size_t mask = slot_count_ - 1;
+    std::optional<size_t> target;
+    std::optional<size_t> oldest;
+    for (size_t i = 0; i < kMaxProbes; ++i) {
+        const size_t index = (fingerprint + i) & mask;
+        const IndexSlot& slot = slots_[index]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (slot.fingerprint == fingerprint) {
+            target = index;
+            break;
+        }
+        if (slot.fingerprint == 0 && !target) {
+            target = index;
+        }
+        if (!oldest || slot.expires < slots_[*oldest].expires) { // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            oldest = index;
+        }
+    }
+    // All probed slots taken by other URLs, replace the one expiring first
+    const size_t slot_index = target ? *target : *oldest;
+    IndexSlot& slot = slots_[slot_index]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (slot.fingerprint == 0) {
+        ++entry_count_;
+    }
+    slot.fingerprint = fingerprint;
+    slot.offset = offset;
+    slot.size = record_size;
+    slot.expires = static_cast<int64_t>(Clock::to_time_t(Clock::now() + *ttl));
+    slot.segment = segment->id;
+    slot.flags = options_.sync_writes ? kSlotSynced : 0;
+    slot.checksum = slot.calculateChecksum();
+    // Served from the page cache by this instance, which holds the body even if it did not reach the disk yet
+    verified_[slot_index] = true;
+    evict();
+    return true;
+}
+
+void DiskCache::Freshen(std::string_view method, const std::string& url, const Response& not_modified) {
+    const std::optional<std::chrono::seconds> ttl = timeToLive(not_modified, options_);
+    const uint64_t fingerprint = fingerprintOf(primaryKey(method, url));
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const std::optional<size_t> index = findSlot(fingerprint);
+    if (!index) {
+        return;
+    }
+    IndexSlot& slot = slots_[*index]; // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    slot.expires = static_cast<int64_t>(Clock::to_time_t(Clock::now() + ttl.value_or(std::chrono::seconds{0})));
+    slot.checksum = slot.calculateChecksum();
+}
+
+void DiskCache::Invalidate(const std::string& url) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (const char* method : {"GET", "HEAD"}) {
+        const std::optional<size_t> index = findSlot(fingerprintOf(primaryKey(method, url)));
+        if (index) {
+            clearSlot(slots_[*index]); // NOLINT (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+    }
+}
+
+void DiskCache::Clear() {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    while (!segments_.empty()) {
+        removeSegment(segments_.begin()->first);
+    }
+    std::memset(static_cast<void*>(slots_), 0, slot_count_ * sizeof(IndexSlot));
+    entry_count_ = 0;
+}
+
+#endif
+
+size_t DiskCache::GetSize() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return total_size_;
+}
+
+size_t DiskCache::GetEntryCount() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return entry_count_;
+}
+
+size_t DiskCache::GetMaxSize() const {
+    return options_.max_size;
+}
+
+} // namespace cpr
@@ -0,0 +1,220 @@
+#include "cpr/dns_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <curl/curl.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#include "cpr/async.h"
+
+namespace cpr {
+namespace {
+bool isNumericHost(const std::string& host) {
+    if (!host.empty() && host.front() == '[') {
+        // IPv6 literal as it appears inside URLs
+        return true;
+    }
+    unsigned char buffer[sizeof(struct in6_addr)];
+    return inet_pton(AF_INET, host.c_str(), buffer) == 1 || inet_pton(AF_INET6, host.c_str(), buffer) == 1;
+}
+
+std::string joinAddresses(const std::vector<std::string>& addresses) {
+    std::string result;
+    for (const std::string& address : addresses) {
+        if (!result.empty()) {
+            result += ',';
+        }
+        // CURLOPT_RESOLVE expects IPv6 addresses in brackets
+        if (address.find(':') != std::string::npos) {
+            result += '[' + address + ']';
+        } else {
+            result += address;
+        }
+    }
+    return result;
+}
+} // namespace
+
+DnsCache::DnsCache(DnsCacheOptions options, Resolver resolver) : state_(std::make_shared<State>()) {
+    state_->options = options;
+    state_->resolver = resolver ? std::move(resolver) : Resolver{&DnsCache::SystemResolve};
+}
+
+std::optional<std::vector<std::string>> DnsCache::Resolve(const std::string& host) const {
+    {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        const auto it = state_->entries.find(host);
+        const Clock::time_point now = Clock::now();
+        if (it != state_->entries.end() && now < it->second.expire_time) {
+            ++state_->metrics.hits;
+            std::vector<std::string> addresses = it->second.addresses;
+            if (now >= it->second.refresh_time && !it->second.refreshing) {
+                it->second.refreshing = true;
+                ++state_->metrics.refreshes;
+                lock.unlock();
+                refreshInBackground(state_, host);
+            }
+            return addresses;
+        }
+        ++state_->metrics.misses;
+    }
+
+    std::optional<std::vector<std::string>> addresses = state_->refresh(host);
+    if (addresses) {
+        return addresses;
+    }
+
+    // Fall back to the expired record in case it is not too old
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    const auto it = state_->entries.find(host);
+    if (it != state_->entries.end() && !it->second.addresses.empty() && Clock::now() < it->second.expire_time + state_->options.max_stale) {
+        ++state_->metrics.stale_hits;
+        return it->second.addresses;
+    }
+    return std::nullopt;
+}
+
+void DnsCache::Prefetch(const std::string& host) const {
+    {
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        Entry& entry = state_->entries[host];
+        if (entry.refreshing) {
+            return;
+        }
+        entry.refreshing = true;
+        ++state_->metrics.refreshes;
+    }
+    refreshInBackground(state_, host);
+}
+
+std::optional<std::string> DnsCache::GetResolveEntry(const std::string& url) const {
+#if LIBCURL_VERSION_NUM >= 0x073E00 // 7.62.0
+    CURLU* handle = curl_url();
+    if (handle == nullptr) {
+        return std::nullopt;
+    }
+    std::optional<std::string> entry;
+    char* host = nullptr;
+    char* port = nullptr;
+    if (curl_url_set(handle, CURLUPART_URL, url.c_str(), CURLU_NON_SUPPORT_SCHEME) == CURLUE_OK && curl_url_get(handle, CURLUPART_HOST, &host, 0) == CURLUE_OK && curl_url_get(handle, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+        const std::string host_name{host};
+        if (!isNumericHost(host_name)) {
+            const std::optional<std::vector<std::string>> addresses = Resolve(host_name);
+            if (addresses && !addresses->empty()) {
+                entry = host_name + ':' + port + ':' + joinAddresses(*addresses);
+            }
+        }
+    }
+    curl_free(host);
+    curl_free(port);
+    curl_url_cleanup(handle);
+    return entry;
+#else
+    return std::nullopt;
+#endif
+}
+
+void DnsCache::Invalidate(const std::string& host) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    const auto it = state_->entries.find(host);
+    // Keep entries a refresh is running for, the refresh would recreate them anyway
+    if (it != state_->entries.end() && !it->second.refreshing) {
+        state_->entries.erase(it);
+    }
+}
+
+void DnsCache::Clear() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    for (auto it = state_->entries.begin(); it != state_->entries.end();) {
+        it = it->second.refreshing ? std::next(it) : state_->entries.erase(it);
+    }
+}
+
+size_t DnsCache::GetEntryCount() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return static_cast<size_t>(std::count_if(state_->entries.begin(), state_->entries.end(), [](const auto& item) { return !item.second.addresses.empty(); }));
+}
+
+DnsCache::Metrics DnsCache::GetMetrics() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->metrics;
+}
+
+std::optional<DnsRecord> DnsCache::SystemResolve(const std::string& host) {
+    struct addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0) {
+        return std::nullopt;
+    }
+
+    DnsRecord record;
+    char buffer[INET6_ADDRSTRLEN];
+    for (const struct addrinfo* info = result; info != nullptr; info = info->ai_next) {
+        const char* address = nullptr;
+        if (info->ai_family == AF_INET) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            address = inet_ntop(AF_INET, &reinterpret_cast<const struct sockaddr_in*>(info->ai_addr)->sin_addr, buffer, sizeof(buffer));
+        } else if (info->ai_family == AF_INET6) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            address = inet_ntop(AF_INET6, &reinterpret_cast<const struct sockaddr_in6*>(info->ai_addr)->sin6_addr, buffer, sizeof(buffer));
+        }
+        if (address != nullptr && std::find(record.addresses.begin(), record.addresses.end(), address) == record.addresses.end()) {
+            record.addresses.emplace_back(address);
+        }
+    }
+    freeaddrinfo(result);
+
+    if (record.addresses.empty()) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+std::optional<std::vector<std::string>> DnsCache::State::refresh(const std::string& host) {
+    // The resolver may take a while, so it gets called without holding the lock
+    const std::optional<DnsRecord> record = resolver(host);
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries[host];
+    entry.refreshing = false;
+    if (!record || record->addresses.empty()) {
+        ++metrics.failures;
+        if (entry.addresses.empty()) {
+            // Do not keep placeholders for hosts which never resolved
+            entries.erase(host);
+        }
+        return std::nullopt;
+    }
+
+    const std::chrono::seconds ttl = std::clamp(record->ttl.count() > 0 ? record->ttl : options.default_ttl, options.min_ttl, options.max_ttl);
+    const Clock::time_point now = Clock::now();
+    entry.addresses = record->addresses;
+    entry.expire_time = now + ttl;
+    entry.refresh_time = now + std::chrono::duration_cast<Clock::duration>(ttl * std::clamp(options.refresh_ratio, 0.0, 1.0));
+    return entry.addresses;
+}
+
+void DnsCache::refreshInBackground(const std::shared_ptr<State>& state, const std::string& host) {
+    GetDefaultExecutor()->Submit([state, host]() { state->refresh(host); });
+}
+
+} // namespace cpr
@@ -0,0 +1,191 @@
+#include "cpr/endpoint_group.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cpr/circuit_breaker.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+namespace {
+// Cost of an endpoint without latency samples once it has a request in flight. Prefers endpoints with known latencies.
+constexpr double kUnknownLatencyPenalty = 1e6;
+
+std::optional<std::string> getConnectTo(std::string_view endpoint) {
+    if (endpoint.find("://") != std::string_view::npos) {
+        return std::nullopt;
+    }
+    // "HOST:PORT:CONNECT-TO-HOST:CONNECT-TO-PORT", leaving out the first two applies it to all requests
+    const bool has_port = endpoint.front() == '[' ? endpoint.find("]:") != std::string_view::npos : endpoint.find(':') != std::string_view::npos;
+    return "::" + std::string{endpoint} + (has_port ? "" : ":");
+}
+} // namespace
+
+EndpointGroup::EndpointGroup(const std::vector<std::string>& endpoints, EndpointGroupOptions options) : state_(std::make_shared<State>()) {
+    if (endpoints.empty()) {
+        throw std::invalid_argument{"EndpointGroup requires at least one endpoint!"};
+    }
+    state_->options = options;
+    state_->endpoints.reserve(endpoints.size());
+    for (const std::string& endpoint : endpoints) {
+        if (endpoint.empty()) {
+            throw std::invalid_argument{"EndpointGroup endpoints must not be empty!"};
+        }
+        Endpoint& entry = state_->endpoints.emplace_back();
+        entry.connect_to = getConnectTo(endpoint);
+        // Base URLs get joined with the path of the request, which starts with a slash itself
+        entry.endpoint = (!entry.connect_to && endpoint.back() == '/') ? endpoint.substr(0, endpoint.size() - 1) : endpoint;
+    }
+}
+
+bool EndpointGroup::State::IsAvailable(const Endpoint& endpoint, Clock::time_point now) const {
+    return !endpoint.ejected || (!endpoint.probing && now >= endpoint.ejected_until);
+}
+
+double EndpointGroup::State::GetCost(const Endpoint& endpoint) const {
+    const double outstanding = static_cast<double>(endpoint.outstanding);
+    if (options.policy == LoadBalancingPolicy::PEAK_EWMA) {
+        if (endpoint.ewma <= 0) {
+            return endpoint.outstanding == 0 ? 0 : kUnknownLatencyPenalty + outstanding;
+        }
+        return endpoint.ewma * (outstanding + 1);
+    }
+    return outstanding;
+}
+
+size_t EndpointGroup::Acquire() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    std::vector<Endpoint>& endpoints = state_->endpoints;
+    const size_t count = endpoints.size();
+    const Clock::time_point now = Clock::now();
+
+    std::optional<size_t> chosen;
+    bool any_available{false};
+    for (size_t i = 0; i < count; ++i) {
+        const Endpoint& endpoint = endpoints[i];
+        if (!state_->IsAvailable(endpoint, now)) {
+            continue;
+        }
+        any_available = true;
+        if (endpoint.ejected) {
+            // Ejection passed, the probe gets sent before anything else
+            chosen = i;
+            break;
+        }
+    }
+
+    if (!chosen) {
+        // Starting at a rotating index spreads the requests across endpoints of equal cost
+        double min_cost = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < count; ++i) {
+            const size_t index = (state_->next + i) % count;
+            const Endpoint& endpoint = endpoints[index];
+            // In case all endpoints are ejected, any of them is better than failing right away
+            if (any_available && !state_->IsAvailable(endpoint, now)) {
+                continue;
+            }
+            if (state_->options.policy == LoadBalancingPolicy::ROUND_ROBIN) {
+                chosen = index;
+                break;
+            }
+            const double cost = state_->GetCost(endpoint);
+            if (cost < min_cost) {
+                min_cost = cost;
+                chosen = index;
+            }
+        }
+        state_->next = (*chosen + 1) % count;
+    }
+
+    Endpoint& endpoint = endpoints[*chosen];
+    if (endpoint.ejected && now >= endpoint.ejected_until) {
+        endpoint.probing = true;
+    }
+    ++endpoint.outstanding;
+    ++endpoint.requests;
+    return *chosen;
+}
+
+void EndpointGroup::Record(size_t index, const Response& response) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    Endpoint& endpoint = state_->endpoints.at(index);
+    const EndpointGroupOptions& options = state_->options;
+    const Clock::time_point now = Clock::now();
+    if (endpoint.outstanding > 0) {
+        --endpoint.outstanding;
+    }
+
+    if (CircuitBreaker::IsFailure(response)) {
+        ++endpoint.failures;
+        ++endpoint.consecutive_failures;
+        if (endpoint.probing || (!endpoint.ejected && options.max_consecutive_failures > 0 && endpoint.consecutive_failures >= options.max_consecutive_failures)) {
+            endpoint.ejected = true;
+            endpoint.probing = false;
+            endpoint.ejected_until = now + options.ejection_duration;
+        }
+        return;
+    }
+
+    endpoint.consecutive_failures = 0;
+    endpoint.ejected = false;
+    endpoint.probing = false;
+    const double latency = response.elapsed;
+    if (endpoint.ewma <= 0 || latency > endpoint.ewma) {
+        // Peaks are taken over right away, so a slowing endpoint loses traffic before the average catches up
+        endpoint.ewma = latency;
+    } else {
+        const double decay_time = std::chrono::duration<double>(options.decay_time).count();
+        const double elapsed = std::chrono::duration<double>(now - endpoint.last_sample).count();
+        const double weight = decay_time > 0 ? std::exp(-elapsed / decay_time) : 0;
+        endpoint.ewma = endpoint.ewma * weight + latency * (1 - weight);
+    }
+    endpoint.last_sample = now;
+}
+
+void EndpointGroup::Release(size_t index) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    Endpoint& endpoint = state_->endpoints.at(index);
+    if (endpoint.outstanding > 0) {
+        --endpoint.outstanding;
+    }
+    // Lets the next request probe instead
+    endpoint.probing = false;
+}
+
+std::string EndpointGroup::GetUrl(size_t index, std::string_view url) const {
+    // Endpoints never change after construction, so no lock is needed
+    const Endpoint& endpoint = state_->endpoints.at(index);
+    if (endpoint.connect_to) {
+        return std::string{url};
+    }
+    const size_t scheme_end = url.find("://");
+    const size_t authority_end = url.find_first_of("/?#", scheme_end == std::string_view::npos ? 0 : scheme_end + 3);
+    return endpoint.endpoint + (authority_end == std::string_view::npos ? std::string{} : std::string{url.substr(authority_end)});
+}
+
+const std::optional<std::string>& EndpointGroup::GetConnectTo(size_t index) const {
+    return state_->endpoints.at(index).connect_to;
+}
+
+std::vector<EndpointGroup::EndpointStatus> EndpointGroup::GetStatus() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    std::vector<EndpointStatus> status;
+    status.reserve(state_->endpoints.size());
+    for (const Endpoint& endpoint : state_->endpoints) {
+        status.push_back(EndpointStatus{endpoint.endpoint, endpoint.ejected, endpoint.outstanding, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double>(endpoint.ewma)), endpoint.requests, endpoint.failures});
+    }
+    return status;
+}
+
+} // namespace cpr
@@ -0,0 +1,18 @@
+#include "cpr/executor.h"
+
+#include <functional>
+#include <utility>
+
+namespace cpr {
+
+void InlineExecutor::Execute(Task task) {
+    task();
+}
+
+FunctionExecutor::FunctionExecutor(std::function<void(Task task)> execute) : execute_(std::move(execute)) {}
+
+void FunctionExecutor::Execute(Task task) {
+    execute_(std::move(task));
+}
+
+} // namespace cpr
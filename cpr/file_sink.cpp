@@ -0,0 +1,277 @@
+#include "cpr/file_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <system_error>
+
+#include <curl/curl.h>
+
+#include "cpr/cprtypes.h"
+#include "cpr/filesystem.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cpr {
+
+namespace {
+// Alignment required for O_DIRECT buffers, offsets and sizes on basically every Linux file system.
+constexpr size_t kSinkAlignment = 4096;
+
+char* allocateAligned(size_t size) {
+#ifdef _WIN32
+    return static_cast<char*>(_aligned_malloc(size, kSinkAlignment));
+#else
+    void* ptr{nullptr};
+    if (posix_memalign(&ptr, kSinkAlignment, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<char*>(ptr);
+#endif
+}
+
+void freeAligned(char* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    // NOLINTNEXTLINE (cppcoreguidelines-no-malloc, hicpp-no-malloc)
+    free(ptr);
+#endif
+}
+
+int openFile(const fs::path& path) {
+#ifdef _WIN32
+    int fd{-1};
+    _wsopen_s(&fd, path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+    return fd;
+#else
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+}
+
+cpr_off_t currentOffset(int fd) {
+#ifdef _WIN32
+    const cpr_off_t offset = _lseeki64(fd, 0, SEEK_CUR);
+#else
+    const cpr_off_t offset = lseek(fd, 0, SEEK_CUR);
+#endif
+    // E.g. pipes and sockets have no offset
+    return offset < 0 ? 0 : offset;
+}
+} // namespace
+
+FileSink::FileSink(const fs::path& path, FileSinkOptions options) : options_(options), fd_(openFile(path)), owns_fd_(true) {
+    if (fd_ < 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to open download file " + path.string());
+    }
+    buffer_size_ = ((options_.buffer_size + kSinkAlignment - 1) / kSinkAlignment) * kSinkAlignment;
+    if (buffer_size_ == 0) {
+        buffer_size_ = kSinkAlignment;
+    }
+    buffer_ = allocateAligned(buffer_size_);
+    if (!buffer_) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+        throw std::bad_alloc();
+    }
+}
+
+FileSink::FileSink(int fd, FileSinkOptions options) : options_(options), fd_(fd), start_offset_(currentOffset(fd)) {
+    buffer_size_ = ((options_.buffer_size + kSinkAlignment - 1) / kSinkAlignment) * kSinkAlignment;
+    if (buffer_size_ == 0) {
+        buffer_size_ = kSinkAlignment;
+    }
+    buffer_ = allocateAligned(buffer_size_);
+    if (!buffer_) {
+        throw std::bad_alloc();
+    }
+}
+
+FileSink::~FileSink() {
+    Flush();
+    if (owns_fd_ && fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+    }
+    freeAligned(buffer_);
+}
+
+void FileSink::begin(CURL* handle) {
+    handle_ = handle;
+    first_chunk_ = true;
+    failed_ = false;
+}
+
+void FileSink::onFirstChunk() {
+    first_chunk_ = false;
+    if (!handle_ || (!options_.preallocate && !options_.direct_io)) {
+        return;
+    }
+
+    // Once the first chunk of the body arrives all headers have been received, so the Content-Length is known by now.
+    cpr_off_t content_length{-1};
+    curl_easy_getinfo(handle_, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+    if (content_length <= 0) {
+        return;
+    }
+
+    if (options_.preallocate) {
+        Preallocate(content_length);
+    }
+    if (options_.direct_io && content_length >= options_.direct_io_threshold) {
+        setDirectIo(true);
+    }
+}
+
+bool FileSink::setDirectIo(bool enable) {
+#if defined(__linux__) && defined(O_DIRECT)
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    const int flags = fcntl(fd_, F_GETFL);
+    if (flags < 0) {
+        return false;
+    }
+    // O_DIRECT requires aligned file offsets. Stay buffered in case we are in the middle of an unaligned offset.
+    if (enable && ((start_offset_ + bytes_written_) % static_cast<cpr_off_t>(kSinkAlignment)) != 0) {
+        return false;
+    }
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+    if (fcntl(fd_, F_SETFL, enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT)) != 0) {
+        // E.g. tmpfs does not support O_DIRECT. Simply keep on using buffered I/O.
+        return false;
+    }
+    direct_io_ = enable;
+    return true;
+#else
+    static_cast<void>(enable);
+    return false;
+#endif
+}
+
+bool FileSink::Preallocate(cpr_off_t length) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    // FALLOC_FL_KEEP_SIZE reserves the blocks without changing the file size, so an aborted download does not leave zeros behind.
+    return fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(start_offset_ + bytes_written_), static_cast<off_t>(length)) == 0;
+#else
+    static_cast<void>(length);
+    return false;
+#endif
+}
+
+bool FileSink::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        const int written = _write(fd_, data, static_cast<unsigned int>(size));
+#else
+        const ssize_t written = ::write(fd_, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed_ = true;
+            return false;
+        }
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        data += written;
+        size -= static_cast<size_t>(written);
+        bytes_written_ += static_cast<cpr_off_t>(written);
+    }
+    return true;
+}
+
+bool FileSink::Write(std::string_view data) {
+    if (failed_ || fd_ < 0) {
+        return false;
+    }
+    if (first_chunk_) {
+        onFirstChunk();
+    }
+
+    while (!data.empty()) {
+        const size_t count = std::min(data.size(), buffer_size_ - buffered_);
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::memcpy(buffer_ + buffered_, data.data(), count);
+        buffered_ += count;
+        data.remove_prefix(count);
+
+        if (buffered_ == buffer_size_) {
+            if (!writeAll(buffer_, buffered_)) {
+                return false;
+            }
+            buffered_ = 0;
+        }
+    }
+    return true;
+}
+
+bool FileSink::Flush() {
+    if (failed_ || fd_ < 0) {
+        return false;
+    }
+    if (buffered_ == 0) {
+        return true;
+    }
+    // The tail is not a multiple of the sector size, which O_DIRECT can not handle.
+    if (direct_io_ && (buffered_ % kSinkAlignment) != 0) {
+        setDirectIo(false);
+    }
+    if (!writeAll(buffer_, buffered_)) {
+        return false;
+    }
+    buffered_ = 0;
+    return true;
+}
+
+bool FileSink::Finish() {
+    first_chunk_ = true;
+    handle_ = nullptr;
+    if (!Flush()) {
+        return false;
+    }
+    if (options_.sync_on_finish) {
+#ifdef _WIN32
+        return _commit(fd_) == 0;
+#elif defined(__APPLE__)
+        return fsync(fd_) == 0;
+#else
+        return fdatasync(fd_) == 0;
+#endif
+    }
+    return true;
+}
+
+bool FileSink::IsOpen() const {
+    return fd_ >= 0;
+}
+
+int FileSink::GetFd() const {
+    return fd_;
+}
+
+cpr_off_t FileSink::GetBytesWritten() const {
+    return bytes_written_ + static_cast<cpr_off_t>(buffered_);
+}
+
+bool FileSink::IsDirectIo() const {
+    return direct_io_;
+}
+
+} // namespace cpr
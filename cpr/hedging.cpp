@@ -0,0 +1,140 @@
+#include "cpr/hedging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpr/resolve.h"
+
+namespace cpr {
+
+HedgePolicy::HedgePolicy(HedgeOptions options) : state_(std::make_shared<State>()) {
+    state_->options = std::move(options);
+    state_->latencies.reserve(std::min<size_t>(state_->options.max_samples, 1024));
+}
+
+std::chrono::milliseconds HedgePolicy::GetDelay() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    const HedgeOptions& options = state_->options;
+    if (options.delay.count() > 0) {
+        return options.delay;
+    }
+    if (state_->latencies.empty() || state_->latencies.size() < options.min_samples) {
+        return options.initial_delay;
+    }
+    return *state_->percentile_latency;
+}
+
+void HedgePolicy::RecordRequest() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    ++state_->metrics.requests;
+}
+
+bool HedgePolicy::TryAcquireHedge() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    Metrics& metrics = state_->metrics;
+    if (static_cast<double>(metrics.hedges + 1) > state_->options.max_extra_load * static_cast<double>(metrics.requests)) {
+        ++metrics.budget_exhausted;
+        return false;
+    }
+    ++metrics.hedges;
+    return true;
+}
+
+void HedgePolicy::RecordLatency(std::chrono::milliseconds latency, bool hedge_won) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    if (hedge_won) {
+        ++state_->metrics.hedge_wins;
+    }
+    const size_t max_samples = state_->options.max_samples;
+    if (max_samples == 0) {
+        return;
+    }
+    if (state_->latencies.size() < max_samples) {
+        state_->latencies.push_back(latency);
+        state_->InsertLatency(latency);
+        return;
+    }
+    state_->EraseLatency(state_->latencies[state_->next_latency]);
+    state_->latencies[state_->next_latency] = latency;
+    state_->InsertLatency(latency);
+    state_->next_latency = (state_->next_latency + 1) % max_samples;
+}
+
+void HedgePolicy::State::InsertLatency(std::chrono::milliseconds latency) {
+    if (sorted_latencies.empty()) {
+        percentile_latency = sorted_latencies.insert(latency);
+        percentile_index = 0;
+        return;
+    }
+    // Equal latencies get inserted behind the existing ones, so only smaller ones move the percentile back
+    if (latency < *percentile_latency) {
+        ++percentile_index;
+    }
+    sorted_latencies.insert(latency);
+    SeekPercentile();
+}
+
+void HedgePolicy::State::EraseLatency(std::chrono::milliseconds latency) {
+    if (latency == *percentile_latency) {
+        // Its successor takes over the index
+        percentile_latency = sorted_latencies.erase(percentile_latency);
+    } else {
+        if (latency < *percentile_latency) {
+            --percentile_index;
+        }
+        sorted_latencies.erase(sorted_latencies.find(latency));
+    }
+    if (sorted_latencies.empty()) {
+        percentile_latency = sorted_latencies.end();
+        percentile_index = 0;
+        return;
+    }
+    if (percentile_latency == sorted_latencies.end()) {
+        --percentile_latency;
+        --percentile_index;
+    }
+    SeekPercentile();
+}
+
+void HedgePolicy::State::SeekPercentile() {
+    const double percentile = std::clamp(options.percentile, 0.0, 1.0);
+    const size_t target = std::min(sorted_latencies.size() - 1, static_cast<size_t>(percentile * static_cast<double>(sorted_latencies.size())));
+    while (percentile_index < target) {
+        ++percentile_latency;
+        ++percentile_index;
+    }
+    while (percentile_index > target) {
+        --percentile_latency;
+        --percentile_index;
+    }
+}
+
+std::vector<std::string> HedgePolicy::GetNextConnectTo() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    const std::vector<Resolve>& targets = state_->options.targets;
+    std::vector<std::string> connect_to;
+    if (targets.empty()) {
+        return connect_to;
+    }
+    const Resolve& target = targets[state_->next_target++ % targets.size()];
+    // IPv6 addresses have to be enclosed in brackets
+    const std::string addr = target.addr.find(':') == std::string::npos ? target.addr : "[" + target.addr + "]";
+    for (const uint16_t port : target.ports) {
+        connect_to.push_back(target.host + ":" + std::to_string(port) + ":" + addr + ":" + std::to_string(port));
+    }
+    return connect_to;
+}
+
+HedgePolicy::Metrics HedgePolicy::GetMetrics() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->metrics;
+}
+
+} // namespace cpr
@@ -0,0 +1,593 @@
+#include "cpr/http_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "cpr/async.h"
+#include "cpr/cprtypes.h"
+#include "cpr/interceptor.h"
+#include "cpr/multiperform.h"
+#include "cpr/response.h"
+#include "cpr/session.h"
+
+namespace cpr {
+
+namespace {
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+std::string toLower(std::string_view s) {
+    std::string result{s};
+    std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string getHeader(const Header& header, const std::string& name) {
+    const Header::const_iterator it = header.find(name);
+    return it == header.end() ? std::string{} : it->second;
+}
+
+std::optional<std::chrono::seconds> parseSeconds(std::string_view value) {
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+    }
+    long long seconds{0};
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::from_chars_result result = std::from_chars(value.data(), value.data() + value.size(), seconds);
+    if (result.ec != std::errc{} || seconds < 0) {
+        return std::nullopt;
+    }
+    return std::chrono::seconds{seconds};
+}
+
+std::optional<HttpCache::Clock::time_point> parseDate(const std::string& value) {
+    if (value.empty()) {
+        return std::nullopt;
+    }
+    // libcurl already knows all three date formats allowed by RFC 9110
+    const std::time_t time = curl_getdate(value.c_str(), nullptr);
+    if (time < 0) {
+        return std::nullopt;
+    }
+    return HttpCache::Clock::from_time_t(time);
+}
+
+struct CacheControl {
+    bool no_store{false};
+    bool no_cache{false};
+    bool must_revalidate{false};
+    std::optional<std::chrono::seconds> max_age;
+    std::chrono::seconds stale_while_revalidate{0};
+};
+
+CacheControl parseCacheControl(const Header& header) {
+    CacheControl cc;
+    const std::string value = getHeader(header, "Cache-Control");
+    std::string_view rest{value};
+    while (!rest.empty()) {
+        const size_t comma = rest.find(',');
+        const std::string_view directive = trim(rest.substr(0, comma));
+        rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+
+        const size_t equals = directive.find('=');
+        const std::string name = toLower(trim(directive.substr(0, equals)));
+        const std::string_view argument = equals == std::string_view::npos ? std::string_view{} : trim(directive.substr(equals + 1));
+        if (name == "no-store") {
+            cc.no_store = true;
+        } else if (name == "no-cache") {
+            cc.no_cache = true;
+        } else if (name == "must-revalidate" || name == "proxy-revalidate") {
+            cc.must_revalidate = true;
+        } else if (name == "max-age") {
+            // An invalid max-age makes the response stale
+            cc.max_age = parseSeconds(argument).value_or(std::chrono::seconds{0});
+        } else if (name == "stale-while-revalidate") {
+            cc.stale_while_revalidate = parseSeconds(argument).value_or(std::chrono::seconds{0});
+        }
+    }
+    if (getHeader(header, "Cache-Control").empty() && toLower(getHeader(header, "Pragma")).find("no-cache") != std::string::npos) {
+        cc.no_cache = true;
+    }
+    return cc;
+}
+
+std::string primaryKey(std::string_view method, const std::string& url) {
+    std::string key{method};
+    key += ' ';
+    key += url;
+    return key;
+}
+
+bool isHeuristicallyCacheable(long status_code) {
+    switch (status_code) {
+        case 200:
+        case 203:
+        case 204:
+        case 300:
+        case 301:
+        case 308:
+        case 404:
+        case 405:
+        case 410:
+        case 414:
+        case 501:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Calculates freshness lifetime and stale-while-revalidate window based on the response header.
+ * Returns false in case the response has neither explicit nor heuristic freshness.
+ **/
+bool calculateFreshness(HttpCache::Entry& entry, const Header& header, long status_code, HttpCache::Clock::time_point now) {
+    const CacheControl cc = parseCacheControl(header);
+    const HttpCache::Clock::time_point date = parseDate(getHeader(header, "Date")).value_or(now);
+
+    entry.initial_age = parseSeconds(getHeader(header, "Age")).value_or(std::chrono::seconds{0});
+    entry.stale_while_revalidate = cc.must_revalidate ? std::chrono::seconds{0} : cc.stale_while_revalidate;
+    entry.etag = getHeader(header, "ETag");
+    entry.last_modified = getHeader(header, "Last-Modified");
+
+    bool explicit_freshness{true};
+    if (cc.no_cache) {
+        entry.freshness_lifetime = std::chrono::seconds{0};
+    } else if (cc.max_age) {
+        entry.freshness_lifetime = *cc.max_age;
+    } else if (header.find("Expires") != header.end()) {
+        const std::optional<HttpCache::Clock::time_point> expires = parseDate(getHeader(header, "Expires"));
+        entry.freshness_lifetime = expires && *expires > date ? std::chrono::duration_cast<std::chrono::seconds>(*expires - date) : std::chrono::seconds{0};
+    } else {
+        explicit_freshness = false;
+        entry.freshness_lifetime = std::chrono::seconds{0};
+        const std::optional<HttpCache::Clock::time_point> last_modified = parseDate(entry.last_modified);
+        if (last_modified && *last_modified < date && isHeuristicallyCacheable(status_code)) {
+            entry.freshness_lifetime = std::chrono::duration_cast<std::chrono::seconds>(date - *last_modified) / 10;
+        }
+    }
+    return explicit_freshness || entry.freshness_lifetime.count() > 0 || entry.HasValidators();
+}
+
+/**
+ * Copy of the parts of a response a cache hit needs. Leaves out the handle of the session that received it,
+ * which would otherwise be kept alive (including its connections and buffers) as long as the entry is stored.
+ **/
+Response detachResponse(const Response& response) {
+    Response detached;
+    detached.status_code = response.status_code;
+    detached.text = response.text;
+    detached.chunked_body = response.chunked_body;
+    detached.header = response.header;
+    detached.url = response.url;
+    detached.elapsed = response.elapsed;
+    detached.raw_header = response.raw_header;
+    detached.status_line = response.status_line;
+    detached.reason = response.reason;
+    detached.downloaded_bytes = response.downloaded_bytes;
+    return detached;
+}
+
+size_t estimateSize(const HttpCache::Entry& entry) {
+    size_t size = sizeof(HttpCache::Entry) + entry.key.size() + entry.etag.size() + entry.last_modified.size();
+    size += entry.response.text.size() + entry.response.chunked_body.size() + entry.response.raw_header.size() + entry.response.url.str().size();
+    for (const std::pair<const std::string, std::string>& field : entry.response.header) {
+        size += field.first.size() + field.second.size();
+    }
+    for (const std::pair<std::string, std::string>& field : entry.vary) {
+        size += field.first.size() + field.second.size();
+    }
+    return size;
+}
+
+bool varyMatches(const HttpCache::Entry& entry, const Header& request_header) {
+    return std::all_of(entry.vary.begin(), entry.vary.end(), [&request_header](const std::pair<std::string, std::string>& field) { return getHeader(request_header, field.first) == field.second; });
+}
+
+bool isUnsafeMethod(std::string_view method) {
+    return method != "GET" && method != "HEAD" && method != "OPTIONS";
+}
+
+void revalidateInBackground(const std::shared_ptr<HttpCache>& cache, const CacheInterceptor::SessionFactory& session_factory, const std::shared_ptr<const HttpCache::Entry>& entry, const std::string& url, const Header& request_header) {
+    bool expected{false};
+    if (!entry->revalidating.compare_exchange_strong(expected, true)) {
+        // Somebody else is already on it
+        return;
+    }
+    GetDefaultExecutor()->Execute([cache, session_factory, entry, url, request_header]() {
+        const std::shared_ptr<Session> session = session_factory ? session_factory() : std::make_shared<Session>();
+        Header header = request_header;
+        HttpCache::AddConditionalHeader(header, *entry);
+        session->SetUrl(Url{url});
+        session->SetHeader(header);
+        cache->HandleResponse("GET", url, request_header, entry, session->Get());
+        entry->revalidating = false;
+    });
+}
+} // namespace
+
+HttpCache::Freshness HttpCache::Entry::GetFreshness(Clock::time_point now) const {
+    const std::chrono::seconds age = initial_age + std::chrono::duration_cast<std::chrono::seconds>(now - response_time);
+    if (age < freshness_lifetime) {
+        return Freshness::FRESH;
+    }
+    if (age < freshness_lifetime + stale_while_revalidate) {
+        return Freshness::STALE_WHILE_REVALIDATE;
+    }
+    return Freshness::STALE;
+}
+
+bool HttpCache::Entry::HasValidators() const {
+    return !etag.empty() || !last_modified.empty();
+}
+
+HttpCache::HttpCache(size_t max_bytes, size_t shard_count) : max_bytes_(max_bytes) {
+    shard_count = std::max<size_t>(shard_count, 1);
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+HttpCache::Shard& HttpCache::getShard(const std::string& key) {
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+std::optional<HttpCache::LookupResult> HttpCache::Lookup(std::string_view method, const std::string& url, const Header& request_header) {
+    const std::string key = primaryKey(method, url);
+    Shard& shard = getShard(key);
+
+    std::shared_ptr<const Entry> entry;
+    {
+        const std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return std::nullopt;
+        }
+        for (const std::list<std::shared_ptr<Entry>>::iterator& variant : it->second) {
+            if (varyMatches(**variant, request_header)) {
+                // Mark as most recently used
+                shard.lru.splice(shard.lru.begin(), shard.lru, variant);
+                entry = *variant;
+                break;
+            }
+        }
+    }
+    if (!entry) {
+        return std::nullopt;
+    }
+
+    const CacheControl request_cc = parseCacheControl(request_header);
+    if (request_cc.no_cache || (request_cc.max_age && request_cc.max_age->count() == 0)) {
+        return LookupResult{entry, Freshness::STALE};
+    }
+    return LookupResult{entry, entry->GetFreshness(Clock::now())};
+}
+
+bool HttpCache::Store(std::string_view method, const std::string& url, const Header& request_header, const Response& response) {
+    // Only complete responses to GET requests are stored. Partial content (206) would require range handling.
+    if (method != "GET" || response.error || response.status_code < 200 || response.status_code == 206 || response.status_code == 304) {
+        return false;
+    }
+    if (parseCacheControl(request_header).no_store || parseCacheControl(response.header).no_store) {
+        return false;
+    }
+
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->key = primaryKey(method, url);
+    const std::optional<std::vector<std::string>> vary = GetVaryFields(response.header);
+    if (!vary) {
+        return false;
+    }
+    for (const std::string& name : *vary) {
+        entry->vary.emplace_back(name, getHeader(request_header, name));
+    }
+
+    entry->response = detachResponse(response);
+    entry->response_time = Clock::now();
+    if (!calculateFreshness(*entry, entry->response.header, entry->response.status_code, entry->response_time)) {
+        return false;
+    }
+    entry->size = estimateSize(*entry);
+    if (entry->size > max_bytes_ / shards_.size()) {
+        return false;
+    }
+    insert(std::move(entry));
+    return true;
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::Freshen(const std::shared_ptr<const Entry>& entry, const Response& not_modified) {
+    std::shared_ptr<Entry> fresh = std::make_shared<Entry>();
+    fresh->key = entry->key;
+    fresh->vary = entry->vary;
+    fresh->response = entry->response;
+    // RFC 9111 4.3.4: Update the stored header with the fields of the 304 response
+    for (const std::pair<const std::string, std::string>& field : not_modified.header) {
+        const std::string name = toLower(field.first);
+        if (name != "content-length" && name != "content-encoding" && name != "transfer-encoding" && name != "content-range") {
+            fresh->response.header[field.first] = field.second;
+        }
+    }
+    fresh->response.elapsed = not_modified.elapsed;
+    fresh->response_time = Clock::now();
+    calculateFreshness(*fresh, fresh->response.header, fresh->response.status_code, fresh->response_time);
+    fresh->size = estimateSize(*fresh);
+
+    std::shared_ptr<const Entry> result = fresh;
+    if (fresh->size <= max_bytes_ / shards_.size()) {
+        insert(std::move(fresh));
+    }
+    return result;
+}
+
+void HttpCache::insert(std::shared_ptr<Entry> entry) {
+    Shard& shard = getShard(entry->key);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+
+    std::vector<std::list<std::shared_ptr<Entry>>::iterator>& variants = shard.index[entry->key];
+    // Replace the variant with the same Vary values
+    for (auto it = variants.begin(); it != variants.end(); ++it) {
+        if ((**it)->vary == entry->vary) {
+            shard.size -= (**it)->size;
+            shard.lru.erase(*it);
+            variants.erase(it);
+            break;
+        }
+    }
+
+    shard.size += entry->size;
+    shard.lru.push_front(std::move(entry));
+    variants.push_back(shard.lru.begin());
+    evict(shard, max_bytes_ / shards_.size());
+}
+
+void HttpCache::evict(Shard& shard, size_t max_shard_size) {
+    while (shard.size > max_shard_size && !shard.lru.empty()) {
+        const std::list<std::shared_ptr<Entry>>::iterator victim = std::prev(shard.lru.end());
+        const auto index_it = shard.index.find((*victim)->key);
+        if (index_it != shard.index.end()) {
+            std::vector<std::list<std::shared_ptr<Entry>>::iterator>& variants = index_it->second;
+            variants.erase(std::remove(variants.begin(), variants.end(), victim), variants.end());
+            if (variants.empty()) {
+                shard.index.erase(index_it);
+            }
+        }
+        shard.size -= (*victim)->size;
+        shard.lru.erase(victim);
+    }
+}
+
+void HttpCache::Invalidate(const std::string& url) {
+    for (const char* method : {"GET", "HEAD"}) {
+        const std::string key = primaryKey(method, url);
+        Shard& shard = getShard(key);
+        const std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            continue;
+        }
+        for (const std::list<std::shared_ptr<Entry>>::iterator& variant : it->second) {
+            shard.size -= (*variant)->size;
+            shard.lru.erase(variant);
+        }
+        shard.index.erase(it);
+    }
+}
+
+void HttpCache::Clear() {
+    for (const std::unique_ptr<Shard>& shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+        shard->size = 0;
+    }
+}
+
+size_t HttpCache::GetSize() const {
+    size_t size{0};
+    for (const std::unique_ptr<Shard>& shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard->mutex);
+        size += shard->size;
+    }
+    return size;
+}
+
+size_t HttpCache::GetEntryCount() const {
+    size_t count{0};
+    for (const std::unique_ptr<Shard>& shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->lru.size();
+    }
+    return count;
+}
+
+size_t HttpCache::GetMaxSize() const {
+    return max_bytes_;
+}
+
+void HttpCache::AddConditionalHeader(Header& header, const Entry& entry) {
+    if (!entry.etag.empty()) {
+        header["If-None-Match"] = entry.etag;
+    }
+    if (!entry.last_modified.empty()) {
+        header["If-Modified-Since"] = entry.last_modified;
+    }
+}
+
+bool HttpCache::BypassesCache(const Header& request_header) {
+    return parseCacheControl(request_header).no_store;
+}
+
+std::optional<std::chrono::seconds> HttpCache::GetTimeToLive(const Response& response) {
+    if (parseCacheControl(response.header).no_store) {
+        return std::nullopt;
+    }
+    Entry entry;
+    if (!calculateFreshness(entry, response.header, response.status_code, Clock::now())) {
+        return std::nullopt;
+    }
+    return std::max(entry.freshness_lifetime - entry.initial_age, std::chrono::seconds{0});
+}
+
+std::optional<std::vector<std::string>> HttpCache::GetVaryFields(const Header& response_header) {
+    std::vector<std::string> fields;
+    const std::string vary = getHeader(response_header, "Vary");
+    std::string_view rest{vary};
+    while (!rest.empty()) {
+        const size_t comma = rest.find(',');
+        std::string name = toLower(trim(rest.substr(0, comma)));
+        rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+        if (name == "*") {
+            return std::nullopt;
+        }
+        if (!name.empty()) {
+            fields.push_back(std::move(name));
+        }
+    }
+    return fields;
+}
+
+Response HttpCache::HandleResponse(std::string_view method, const std::string& url, const Header& request_header, const std::shared_ptr<const Entry>& stale_entry, Response response) {
+    if (stale_entry && !response.error && response.status_code == 304) {
+        return Freshen(stale_entry, response)->response;
+    }
+    Store(method, url, request_header, response);
+    return response;
+}
+
+CacheInterceptor::CacheInterceptor(std::shared_ptr<HttpCache> cache, SessionFactory session_factory) : cache_(std::move(cache)), session_factory_(std::move(session_factory)) {}
+
+Response CacheInterceptor::intercept(Session& session) {
+    const std::string_view method = session.GetHttpMethod();
+    const std::string url = session.GetFullRequestUrl();
+    // The body of a download goes to its file, sink or callback, so it can neither be stored nor served from here
+    if (method != "GET" || session.IsDownload() || HttpCache::BypassesCache(session.GetHeader())) {
+        Response response = proceed(session);
+        // RFC 9111 4.4: Successful unsafe requests invalidate the stored responses of the target URL
+        if (isUnsafeMethod(method) && !response.error && response.status_code >= 200 && response.status_code < 400) {
+            cache_->Invalidate(url);
+        }
+        return response;
+    }
+
+    const Header request_header = session.GetHeader();
+    const std::optional<HttpCache::LookupResult> hit = cache_->Lookup(method, url, request_header);
+    if (hit && hit->freshness == HttpCache::Freshness::FRESH) {
+        return hit->entry->response;
+    }
+    if (hit && hit->freshness == HttpCache::Freshness::STALE_WHILE_REVALIDATE) {
+        revalidateInBackground(cache_, session_factory_, hit->entry, url, request_header);
+        return hit->entry->response;
+    }
+
+    std::shared_ptr<const HttpCache::Entry> stale_entry;
+    if (hit && hit->entry->HasValidators()) {
+        stale_entry = hit->entry;
+        HttpCache::AddConditionalHeader(session.GetHeader(), *stale_entry);
+    }
+    Response response = proceed(session);
+    if (stale_entry) {
+        // Do not leak the conditional header into following requests of this session
+        session.SetHeader(request_header);
+    }
+    return cache_->HandleResponse(method, url, request_header, stale_entry, std::move(response));
+}
+
+CacheInterceptorMulti::CacheInterceptorMulti(std::shared_ptr<HttpCache> cache, CacheInterceptor::SessionFactory session_factory) : cache_(std::move(cache)), session_factory_(std::move(session_factory)) {}
+
+std::vector<Response> CacheInterceptorMulti::intercept(MultiPerform& multi) {
+    struct Request {
+        std::string_view method;
+        std::string url;
+        Header header;
+        std::shared_ptr<const HttpCache::Entry> stale_entry;
+    };
+
+    std::vector<std::pair<std::shared_ptr<Session>, MultiPerform::HttpMethod>>& sessions = multi.GetSessions();
+    const std::vector<std::pair<std::shared_ptr<Session>, MultiPerform::HttpMethod>> all_sessions = sessions;
+    std::vector<std::optional<Response>> cached(all_sessions.size());
+    std::vector<Request> requests(all_sessions.size());
+    std::vector<std::pair<std::shared_ptr<Session>, MultiPerform::HttpMethod>> network_sessions;
+
+    for (size_t i = 0; i < all_sessions.size(); ++i) {
+        const auto& [session, method] = all_sessions[i];
+        Request& request = requests[i];
+        request.method = session->GetHttpMethod();
+        request.url = session->GetFullRequestUrl();
+        request.header = session->GetHeader();
+
+        if (method == MultiPerform::HttpMethod::GET_REQUEST && !HttpCache::BypassesCache(request.header)) {
+            const std::optional<HttpCache::LookupResult> hit = cache_->Lookup(request.method, request.url, request.header);
+            if (hit && hit->freshness == HttpCache::Freshness::FRESH) {
+                cached[i] = hit->entry->response;
+                continue;
+            }
+            if (hit && hit->freshness == HttpCache::Freshness::STALE_WHILE_REVALIDATE) {
+                revalidateInBackground(cache_, session_factory_, hit->entry, request.url, request.header);
+                cached[i] = hit->entry->response;
+                continue;
+            }
+            if (hit && hit->entry->HasValidators()) {
+                request.stale_entry = hit->entry;
+                HttpCache::AddConditionalHeader(session->GetHeader(), *request.stale_entry);
+            }
+        }
+        network_sessions.push_back(all_sessions[i]);
+    }
+
+    // Only the sessions missing the cache take part in the actual transfer
+    std::vector<Response> network_responses;
+    if (!network_sessions.empty()) {
+        sessions = network_sessions;
+        network_responses = proceed(multi);
+        sessions = all_sessions;
+    }
+
+    std::vector<Response> responses;
+    responses.reserve(all_sessions.size());
+    size_t network_index{0};
+    for (size_t i = 0; i < all_sessions.size(); ++i) {
+        if (cached[i]) {
+            responses.push_back(std::move(*cached[i]));
+            continue;
+        }
+        Request& request = requests[i];
+        if (request.stale_entry) {
+            all_sessions[i].first->SetHeader(request.header);
+        }
+        Response response = network_index < network_responses.size() ? std::move(network_responses[network_index]) : Response{};
+        ++network_index;
+        if (all_sessions[i].second == MultiPerform::HttpMethod::GET_REQUEST) {
+            response = cache_->HandleResponse(request.method, request.url, request.header, request.stale_entry, std::move(response));
+        } else if (isUnsafeMethod(request.method) && !response.error && response.status_code >= 200 && response.status_code < 400) {
+            cache_->Invalidate(request.url);
+        }
+        responses.push_back(std::move(response));
+    }
+    return responses;
+}
+
+} // namespace cpr
@@ -1,5 +1,6 @@
 #include "cpr/interceptor.h"
 #include "cpr/callback.h"
+#include "cpr/file_sink.h"
 #include "cpr/multiperform.h"
 #include "cpr/response.h"
 #include "cpr/session.h"
@@ -49,6 +50,13 @@ Response Interceptor::proceed(Session& session, ProceedHttpMethod httpMethod, co
     throw std::invalid_argument{"WriteCallback argument is only valid for ProceedHttpMethod::DOWNLOAD_CALLBACK!"};
 }
 
+Response Interceptor::proceed(Session& session, ProceedHttpMethod httpMethod, FileSink& sink) {
+    if (httpMethod == ProceedHttpMethod::DOWNLOAD_FILE_REQUEST) {
+        return session.Download(sink);
+    }
+    throw std::invalid_argument{"FileSink argument is only valid for ProceedHttpMethod::DOWNLOAD_FILE!"};
+}
+
 std::vector<Response> InterceptorMulti::proceed(MultiPerform& multi) {
     return multi.proceed();
 }
@@ -1,13 +1,20 @@
 #include "cpr/multiperform.h"
+#include "cpr/allocation_accounting.h"
 
 #include "cpr/callback.h"
 #include "cpr/curlmultiholder.h"
+#include "cpr/deadline.h"
+#include "cpr/file_sink.h"
 #include "cpr/interceptor.h"
+#include "cpr/rate_limiter.h"
 #include "cpr/response.h"
+#include "cpr/retry.h"
 #include "cpr/session.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <curl/curl.h>
 #include <curl/curlver.h>
 #include <curl/multi.h>
@@ -101,43 +108,128 @@ const std::vector<std::pair<std::shared_ptr<Session>, MultiPerform::HttpMethod>>
     return sessions_;
 }
 
-void MultiPerform::DoMultiPerform() {
-    // Do multi perform until every handle has finished
-    int still_running{0};
-    for (const auto& [session, _] : sessions_) {
-        const CURLMcode error_code = curl_multi_add_handle(multicurl_->handle, session->curl_->handle);
+void MultiPerform::SetRetryPolicy(const RetryPolicy& retry_policy) {
+    retry_policy_ = retry_policy;
+}
+
+void MultiPerform::SetRateLimiter(const RateLimiter& rate_limiter) {
+    rate_limiter_ = rate_limiter;
+}
+
+void MultiPerform::SetDeadline(const Deadline& deadline) {
+    deadline_ = deadline;
+}
+
+bool MultiPerform::PrepareDeadline(Session& session, Transfer& transfer) {
+    if (session.prepareDeadline(Deadline::Earliest(session.deadline_, deadline_))) {
+        return true;
+    }
+    transfer.response = session.makeDeadlineExceededResponse();
+    transfer.response->retry_count = transfer.retries;
+    transfer.start_time.reset();
+    return false;
+}
+
+RateLimiter::Clock::duration MultiPerform::ReserveRateLimit(Session& session) {
+    // The limiter of the session takes precedence over the one of the multi perform
+    if (session.rate_limiter_) {
+        return session.reserveRateLimit();
+    }
+    if (rate_limiter_) {
+        const RateLimiter::Clock::duration delay = rate_limiter_->Reserve(rate_limiter_->GetKey(session.http_method_, session.GetFullRequestUrl()));
+        if (delay > RateLimiter::Clock::duration::zero()) {
+            session.markTraceQueued();
+        }
+        return delay;
+    }
+    return RateLimiter::Clock::duration::zero();
+}
+
+std::vector<Response> MultiPerform::DoMultiPerform(const std::function<Response(Session&, CURLcode)>& complete_function) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<Transfer> transfers(sessions_.size());
+    for (size_t i = 0; i < sessions_.size(); ++i) {
+        Session& session = *sessions_[i].first;
+        if (!PrepareDeadline(session, transfers[i])) {
+            continue;
+        }
+        const RateLimiter::Clock::duration rate_limit_delay = ReserveRateLimit(session);
+        if (rate_limit_delay > RateLimiter::Clock::duration::zero()) {
+            // Gets added once its token may be used
+            transfers[i].start_time = start + rate_limit_delay;
+            continue;
+        }
+        const CURLMcode error_code = curl_multi_add_handle(multicurl_->handle, session.curl_->handle);
         if (error_code && error_code != CURLM_ADDED_ALREADY) {
             std::cerr << "curl_multi_add_handle() failed, code " << static_cast<int>(error_code) << '\n';
         }
+        transfers[i].started = true;
     }
-    do {
+
+    // Do multi perform until every handle has finished and none waits for its first or next attempt
+    int still_running{0};
+    while (true) {
+        // Completing and restarting transfers within the loop account for their own phases
+        const AllocationPhaseScope allocation_phase{AllocationPhase::TRANSFER};
         CURLMcode error_code = curl_multi_perform(multicurl_->handle, &still_running);
         if (error_code) {
             std::cerr << "curl_multi_perform() failed, code " << static_cast<int>(error_code) << '\n';
             break;
         }
 
-        if (still_running) {
-            const int timeout_ms{250};
+        ReadMultiInfo(complete_function, transfers, start);
+        if (StartDueTransfers(transfers) > 0) {
+            // Let curl pick up the started transfers right away
+            continue;
+        }
+
+        // Wake up in time for the next start, the waiting transfers do not block the others
+        int timeout_ms{250};
+        bool start_pending{false};
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (const Transfer& transfer : transfers) {
+            if (transfer.start_time) {
+                start_pending = true;
+                const std::chrono::milliseconds remaining = std::chrono::ceil<std::chrono::milliseconds>(*transfer.start_time - now);
+                timeout_ms = static_cast<int>(std::clamp<int64_t>(remaining.count(), 0, timeout_ms));
+            }
+        }
+        if (!still_running && !start_pending) {
+            break;
+        }
+
 #if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
-            error_code = curl_multi_poll(multicurl_->handle, nullptr, 0, timeout_ms, nullptr);
-            if (error_code) {
-                std::cerr << "curl_multi_poll() failed, code " << static_cast<int>(error_code) << '\n';
+        error_code = curl_multi_poll(multicurl_->handle, nullptr, 0, timeout_ms, nullptr);
+        if (error_code) {
+            std::cerr << "curl_multi_poll() failed, code " << static_cast<int>(error_code) << '\n';
 #else
-            error_code = curl_multi_wait(multicurl_->handle, nullptr, 0, timeout_ms, nullptr);
-            if (error_code) {
-                std::cerr << "curl_multi_wait() failed, code " << static_cast<int>(error_code) << '\n';
+        error_code = curl_multi_wait(multicurl_->handle, nullptr, 0, timeout_ms, nullptr);
+        if (error_code) {
+            std::cerr << "curl_multi_wait() failed, code " << static_cast<int>(error_code) << '\n';
 
 #endif
-                break;
-            }
+            break;
         }
-    } while (still_running);
+    }
+
+    for (const auto& [session, _] : sessions_) {
+        const CURLMcode error_code = curl_multi_remove_handle(multicurl_->handle, session->curl_->handle);
+        if (error_code) {
+            std::cerr << "curl_multi_remove_handle() failed, code " << static_cast<int>(error_code) << '\n';
+        }
+    }
+
+    // Response objects in the order of the added sessions
+    std::vector<Response> responses;
+    responses.reserve(transfers.size());
+    for (Transfer& transfer : transfers) {
+        responses.push_back(transfer.response ? std::move(*transfer.response) : Response{});
+    }
+    return responses;
 }
 
-std::vector<Response> MultiPerform::ReadMultiInfo(const std::function<Response(Session&, CURLcode)>& complete_function) {
+void MultiPerform::ReadMultiInfo(const std::function<Response(Session&, CURLcode)>& complete_function, std::vector<Transfer>& transfers, std::chrono::steady_clock::time_point start) {
     // Get infos and create Response objects
-    std::vector<Response> responses;
     struct CURLMsg* info{nullptr};
     do {
         int msgq = 0;
@@ -152,32 +244,69 @@ std::vector<Response> MultiPerform::ReadMultiInfo(const std::function<Response(S
                 std::cerr << "Failed to find current session!" << '\n';
                 break;
             }
-            const std::shared_ptr<Session> current_session = (*it).first;
+            Session& current_session = *(*it).first;
+            Transfer& transfer = transfers[static_cast<size_t>(it - sessions_.begin())];
 
-            // Add response object
             // NOLINTNEXTLINE (cppcoreguidelines-pro-type-union-access)
-            responses.push_back(complete_function(*current_session, info->data.result));
+            transfer.response = complete_function(current_session, info->data.result);
+            transfer.response->retry_count = transfer.retries;
+
+            // The policy of the session takes precedence over the one of the multi perform
+            const std::optional<RetryPolicy>& retry_policy = current_session.retry_policy_ ? current_session.retry_policy_ : retry_policy_;
+            if (retry_policy && !is_download_multi_perform) {
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                const std::optional<std::chrono::milliseconds> delay = retry_policy->GetRetryDelay(current_session.http_method_, current_session.header_, *transfer.response, transfer.retries + 1, std::chrono::duration_cast<std::chrono::milliseconds>(now - start));
+                const std::optional<Deadline> deadline = Deadline::Earliest(current_session.deadline_, deadline_);
+                if (delay && (!deadline || now + *delay < deadline->time_point)) {
+                    transfer.start_time = now + *delay;
+                    current_session.markTraceQueued();
+                }
+            }
         }
     } while (info);
+}
 
-    for (const auto& [session, _] : sessions_) {
-        const CURLMcode error_code = curl_multi_remove_handle(multicurl_->handle, session->curl_->handle);
+size_t MultiPerform::StartDueTransfers(std::vector<Transfer>& transfers) {
+    size_t started{0};
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < transfers.size(); ++i) {
+        Transfer& transfer = transfers[i];
+        if (!transfer.start_time || *transfer.start_time > now) {
+            continue;
+        }
+        const auto& [session, method] = sessions_[i];
+        if (transfer.started) {
+            // Finished handles have to be removed and added again to start over
+            curl_multi_remove_handle(multicurl_->handle, session->curl_->handle);
+            if (!PrepareSession(*session, method)) {
+                // Keep the last response
+                transfer.start_time.reset();
+                continue;
+            }
+            // Retries wait for a token of their own
+            const RateLimiter::Clock::duration rate_limit_delay = ReserveRateLimit(*session);
+            if (rate_limit_delay > RateLimiter::Clock::duration::zero()) {
+                transfer.start_time = now + rate_limit_delay;
+                transfer.started = false;
+                ++transfer.retries;
+                continue;
+            }
+            ++transfer.retries;
+        }
+        // Waiting for the start took some of the budget
+        if (!PrepareDeadline(*session, transfer)) {
+            continue;
+        }
+        session->endTraceQueued();
+        const CURLMcode error_code = curl_multi_add_handle(multicurl_->handle, session->curl_->handle);
         if (error_code) {
-            std::cerr << "curl_multi_remove_handle() failed, code " << static_cast<int>(error_code) << '\n';
+            std::cerr << "curl_multi_add_handle() failed, code " << static_cast<int>(error_code) << '\n';
         }
+        transfer.start_time.reset();
+        transfer.started = true;
+        ++started;
     }
-
-    // Sort response objects to match order of added sessions
-    std::vector<Response> sorted_responses;
-    for (const auto& [session, _] : sessions_) {
-        Session& current_session = *session;
-        auto it = std::find_if(responses.begin(), responses.end(), [&current_session](const Response& response) { return current_session.curl_->handle == response.curl_->handle; });
-        const Response current_response = *it; // NOLINT (performance-unnecessary-copy-initialization) False positive
-        // Erase response from original vector to increase future search speed
-        responses.erase(it);
-        sorted_responses.push_back(current_response);
-    }
-    return sorted_responses;
+    return started;
 }
 
 std::vector<Response> MultiPerform::MakeRequest() {
@@ -186,8 +315,7 @@ std::vector<Response> MultiPerform::MakeRequest() {
         return r.value();
     }
 
-    DoMultiPerform();
-    return ReadMultiInfo([](Session& session, CURLcode curl_error) -> Response { return session.Complete(curl_error); });
+    return DoMultiPerform([](Session& session, CURLcode curl_error) -> Response { return session.Complete(curl_error); });
 }
 
 std::vector<Response> MultiPerform::MakeDownloadRequest() {
@@ -196,41 +324,47 @@ std::vector<Response> MultiPerform::MakeDownloadRequest() {
         return r.value();
     }
 
-    DoMultiPerform();
-    return ReadMultiInfo([](Session& session, CURLcode curl_error) -> Response { return session.CompleteDownload(curl_error); });
+    return DoMultiPerform([](Session& session, CURLcode curl_error) -> Response { return session.CompleteDownload(curl_error); });
 }
 
 void MultiPerform::PrepareSessions() {
     for (const auto& [session, method] : sessions_) {
-        switch (method) {
-            case HttpMethod::GET_REQUEST:
-                session->PrepareGet();
-                break;
-            case HttpMethod::POST_REQUEST:
-                session->PreparePost();
-                break;
-            case HttpMethod::PUT_REQUEST:
-                session->PreparePut();
-                break;
-            case HttpMethod::DELETE_REQUEST:
-                session->PrepareDelete();
-                break;
-            case HttpMethod::PATCH_REQUEST:
-                session->PreparePatch();
-                break;
-            case HttpMethod::HEAD_REQUEST:
-                session->PrepareHead();
-                break;
-            case HttpMethod::OPTIONS_REQUEST:
-                session->PrepareOptions();
-                break;
-            default:
-                std::cerr << "PrepareSessions failed: Undefined HttpMethod or download without arguments!" << '\n';
-                return;
+        if (!PrepareSession(*session, method)) {
+            return;
         }
     }
 }
 
+bool MultiPerform::PrepareSession(Session& session, HttpMethod method) {
+    switch (method) {
+        case HttpMethod::GET_REQUEST:
+            session.PrepareGet();
+            break;
+        case HttpMethod::POST_REQUEST:
+            session.PreparePost();
+            break;
+        case HttpMethod::PUT_REQUEST:
+            session.PreparePut();
+            break;
+        case HttpMethod::DELETE_REQUEST:
+            session.PrepareDelete();
+            break;
+        case HttpMethod::PATCH_REQUEST:
+            session.PreparePatch();
+            break;
+        case HttpMethod::HEAD_REQUEST:
+            session.PrepareHead();
+            break;
+        case HttpMethod::OPTIONS_REQUEST:
+            session.PrepareOptions();
+            break;
+        default:
+            std::cerr << "PrepareSessions failed: Undefined HttpMethod or download without arguments!" << '\n';
+            return false;
+    }
+    return true;
+}
+
 void MultiPerform::PrepareDownloadSession(size_t sessions_index, const WriteCallback& write) {
     const auto& [session, method] = sessions_[sessions_index];
     switch (method) {
@@ -255,6 +389,18 @@ void MultiPerform::PrepareDownloadSession(size_t sessions_index, std::ofstream&
     }
 }
 
+void MultiPerform::PrepareDownloadSession(size_t sessions_index, FileSink& sink) {
+    const auto& [session, method] = sessions_[sessions_index];
+    switch (method) {
+        case HttpMethod::DOWNLOAD_REQUEST:
+            session->PrepareDownload(sink);
+            break;
+        default:
+            std::cerr << "PrepareSessions failed: Undefined HttpMethod or non download method with arguments!" << '\n';
+            return;
+    }
+}
+
 void MultiPerform::SetHttpMethod(HttpMethod method) {
     for (auto& [_, session_method] : sessions_) {
         session_method = method;
@@ -354,7 +500,9 @@ std::vector<Response> MultiPerform::proceed() {
 }
 
 const std::optional<std::vector<Response>> MultiPerform::intercept() {
-    if (current_interceptor_ == interceptors_.end()) {
+    // Interceptors may answer without proceeding the chain. Start over with the next request in that case.
+    const bool outermost = current_interceptor_ == interceptors_.end();
+    if (outermost) {
         current_interceptor_ = first_interceptor_;
     } else {
         current_interceptor_++;
@@ -369,6 +517,9 @@ const std::optional<std::vector<Response>> MultiPerform::intercept() {
         const std::optional<std::vector<Response>> r = (*current_interceptor_)->intercept(*this);
 
         first_interceptor_ = icpt;
+        if (outermost) {
+            current_interceptor_ = interceptors_.end();
+        }
 
         return r;
     }
@@ -0,0 +1,115 @@
+#include "cpr/rate_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "cpr/circuit_breaker.h"
+
+namespace cpr {
+
+namespace {
+// Buckets held before idle ones get evicted for the first time
+constexpr size_t kMinEvictionThreshold = 64;
+} // namespace
+
+RateLimiter::RateLimiter(RateLimit default_limit, KeyFunction key_function) : state_(std::make_shared<State>()) {
+    state_->default_limit = default_limit;
+    state_->key_function = std::move(key_function);
+}
+
+void RateLimiter::SetLimit(const std::string& key, RateLimit limit) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->limits[key] = limit;
+    // Gets created again with the new limit on next use
+    state_->buckets.erase(key);
+}
+
+std::string RateLimiter::GetKey(std::string_view method, std::string_view url) const {
+    if (state_->key_function) {
+        return state_->key_function(method, url);
+    }
+    return std::string{CircuitBreaker::GetHost(url)};
+}
+
+RateLimiter::Bucket& RateLimiter::State::GetBucket(const std::string& key, Clock::time_point now) {
+    auto it = buckets.find(key);
+    if (it == buckets.end()) {
+        if (buckets.size() >= eviction_threshold) {
+            EvictIdle(now);
+        }
+        const auto limit_it = limits.find(key);
+        const RateLimit limit = limit_it == limits.end() ? default_limit : limit_it->second;
+        // Buckets start full
+        it = buckets.emplace(key, Bucket{limit, limit.burst, now}).first;
+        return it->second;
+    }
+    Bucket& bucket = it->second;
+    const double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+    bucket.tokens = std::min(bucket.limit.burst, bucket.tokens + elapsed * bucket.limit.requests_per_second);
+    bucket.last_refill = now;
+    return bucket;
+}
+
+void RateLimiter::State::EvictIdle(Clock::time_point now) {
+    for (auto it = buckets.begin(); it != buckets.end();) {
+        const Bucket& bucket = it->second;
+        const double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+        if (bucket.limit.requests_per_second <= 0 || bucket.tokens + elapsed * bucket.limit.requests_per_second >= bucket.limit.burst) {
+            it = buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Amortizes the sweep over the buckets created until the next one
+    eviction_threshold = std::max(kMinEvictionThreshold, buckets.size() * 2);
+}
+
+RateLimiter::Clock::duration RateLimiter::Reserve(const std::string& key) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    ++state_->metrics.requests;
+    Bucket& bucket = state_->GetBucket(key, Clock::now());
+    if (bucket.limit.requests_per_second <= 0) {
+        return Clock::duration::zero();
+    }
+    bucket.tokens -= 1;
+    if (bucket.tokens >= 0) {
+        return Clock::duration::zero();
+    }
+    ++state_->metrics.delayed;
+    return std::chrono::ceil<Clock::duration>(std::chrono::duration<double>(-bucket.tokens / bucket.limit.requests_per_second));
+}
+
+bool RateLimiter::TryAcquire(const std::string& key) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    Bucket& bucket = state_->GetBucket(key, Clock::now());
+    if (bucket.limit.requests_per_second > 0) {
+        if (bucket.tokens < 1) {
+            return false;
+        }
+        bucket.tokens -= 1;
+    }
+    ++state_->metrics.requests;
+    return true;
+}
+
+void RateLimiter::Acquire(const std::string& key) const {
+    const Clock::duration delay = Reserve(key);
+    if (delay > Clock::duration::zero()) {
+        std::this_thread::sleep_for(delay);
+    }
+}
+
+RateLimiter::Metrics RateLimiter::GetMetrics() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    Metrics metrics = state_->metrics;
+    metrics.buckets = state_->buckets.size();
+    return metrics;
+}
+
+} // namespace cpr
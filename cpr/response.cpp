@@ -52,7 +52,10 @@ Response::Response(std::shared_ptr<CurlHolder> curl, std::string&& p_text, std::
 }
 
 std::vector<CertInfo> Response::GetCertInfos() const {
-    assert(curl_);
+    if (!curl_) {
+        // Not received by a session, e.g. served from a cache
+        return {};
+    }
     assert(curl_->handle);
     curl_certinfo* ci{nullptr};
     curl_easy_getinfo(curl_->handle, CURLINFO_CERTINFO, &ci);
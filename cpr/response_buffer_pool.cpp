@@ -0,0 +1,50 @@
+#include "cpr/response_buffer_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace cpr {
+
+ResponseBufferPool::ResponseBufferPool(size_t max_buffers, size_t max_buffer_capacity) : state_(std::make_shared<State>()) {
+    state_->max_buffers = max_buffers;
+    state_->max_buffer_capacity = max_buffer_capacity;
+    state_->buffers.reserve(max_buffers);
+}
+
+std::string ResponseBufferPool::Acquire() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->buffers.empty()) {
+        return {};
+    }
+    std::string buffer = std::move(state_->buffers.back());
+    state_->buffers.pop_back();
+    return buffer;
+}
+
+void ResponseBufferPool::Release(std::string&& buffer) const {
+    // Nothing worth keeping:
+    if (!HasHeapBuffer(buffer) || buffer.capacity() > state_->max_buffer_capacity) {
+        return;
+    }
+    buffer.clear();
+
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->buffers.size() < state_->max_buffers) {
+        state_->buffers.push_back(std::move(buffer));
+    }
+}
+
+size_t ResponseBufferPool::GetIdleCount() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->buffers.size();
+}
+
+bool ResponseBufferPool::HasHeapBuffer(const std::string& buffer) {
+    static const size_t sso_capacity = std::string{}.capacity();
+    return buffer.capacity() > sso_capacity;
+}
+
+} // namespace cpr
@@ -0,0 +1,263 @@
+#include "cpr/response_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "cpr/curlmultiholder.h"
+#include "cpr/response.h"
+#include "cpr/session.h"
+
+namespace cpr {
+
+ResponseStream::iterator::iterator(ResponseStream* stream) : stream_(stream), current_(stream->Read()) {}
+
+ResponseStream::iterator& ResponseStream::iterator::operator++() {
+    current_ = stream_->Read();
+    return *this;
+}
+
+ResponseStream::ResponseStream(std::shared_ptr<Session> session, size_t max_buffered_bytes) : session_(std::move(session)), multicurl_(std::make_unique<CurlMultiHolder>()), state_(std::make_unique<State>()) {
+    state_->max_buffered_bytes = std::max<size_t>(max_buffered_bytes, 1);
+
+    CURL* handle = session_->curl_->handle;
+    // The body never ends up in the response string, so do not reserve memory for it
+    session_->response_string_reserve_data_.body = nullptr;
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeFunction);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, state_.get());
+
+    const CURLMcode error_code = curl_multi_add_handle(multicurl_->handle, handle);
+    if (error_code) {
+        std::cerr << "curl_multi_add_handle() failed, code " << static_cast<int>(error_code) << '\n';
+        state_->transfer_done = true;
+        state_->result = CURLE_FAILED_INIT;
+    }
+}
+
+ResponseStream::~ResponseStream() {
+    release();
+}
+
+ResponseStream& ResponseStream::operator=(ResponseStream&& old) noexcept {
+    if (this != &old) {
+        // The session of this stream must not be left with a write function pointing to the state freed below
+        release();
+        session_ = std::move(old.session_);
+        multicurl_ = std::move(old.multicurl_);
+        state_ = std::move(old.state_);
+        response_ = std::move(old.response_);
+    }
+    return *this;
+}
+
+size_t ResponseStream::writeFunction(char* ptr, size_t size, size_t nmemb, State* state) {
+    if (state->buffered_bytes >= state->max_buffered_bytes) {
+        // libcurl keeps the data and hands it to us again once the transfer got resumed
+        state->paused = true;
+        return CURL_WRITEFUNC_PAUSE;
+    }
+    size *= nmemb;
+    state->chunks.emplace_back(ptr, size);
+    state->buffered_bytes += size;
+    return size;
+}
+
+namespace {
+// Upper bound for waiting on the transfer in between two calls of curl_multi_perform()
+constexpr std::chrono::milliseconds WAIT_TIMEOUT{250};
+} // namespace
+
+void ResponseStream::step() {
+    if (state_->paused && state_->buffered_bytes < state_->max_buffered_bytes) {
+        // Only resumed once the consumer asks for more, so the transfer stays paused while it holds on to the chunks
+        state_->paused = false;
+        // Might directly call writeFunction with the data held back while being paused
+        curl_easy_pause(session_->curl_->handle, CURLPAUSE_CONT);
+        if (!state_->chunks.empty()) {
+            return;
+        }
+    }
+
+    int still_running{0};
+    CURLMcode error_code = curl_multi_perform(multicurl_->handle, &still_running);
+    if (error_code) {
+        std::cerr << "curl_multi_perform() failed, code " << static_cast<int>(error_code) << '\n';
+        state_->transfer_done = true;
+        state_->result = CURLE_RECV_ERROR;
+        return;
+    }
+
+    int msgq{0};
+    const CURLMsg* info = curl_multi_info_read(multicurl_->handle, &msgq);
+    if (info && info->msg == CURLMSG_DONE) {
+        state_->transfer_done = true;
+        // NOLINTNEXTLINE (cppcoreguidelines-pro-type-union-access)
+        state_->result = info->data.result;
+    }
+}
+
+void ResponseStream::perform() {
+    step();
+    if (state_->chunks.empty() && !state_->transfer_done) {
+        const int timeout_ms{static_cast<int>(WAIT_TIMEOUT.count())};
+        CURLMcode error_code{CURLM_OK};
+#if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
+        error_code = curl_multi_poll(multicurl_->handle, nullptr, 0, timeout_ms, nullptr);
+#else
+        error_code = curl_multi_wait(multicurl_->handle, nullptr, 0, timeout_ms, nullptr);
+#endif
+        if (error_code) {
+            std::cerr << "curl_multi_poll() failed, code " << static_cast<int>(error_code) << '\n';
+            state_->transfer_done = true;
+            state_->result = CURLE_RECV_ERROR;
+        }
+    }
+}
+
+std::optional<std::string> ResponseStream::Read() {
+    if (!state_) {
+        return std::nullopt;
+    }
+    while (state_->chunks.empty() && !state_->transfer_done) {
+        perform();
+    }
+    if (state_->chunks.empty()) {
+        return std::nullopt;
+    }
+
+    std::string chunk = std::move(state_->chunks.front());
+    state_->chunks.pop_front();
+    state_->buffered_bytes -= chunk.size();
+    return chunk;
+}
+
+bool ResponseStream::Poll() {
+    if (!state_) {
+        return true;
+    }
+    if (state_->chunks.empty() && !state_->transfer_done) {
+        step();
+    }
+    return !state_->chunks.empty() || state_->transfer_done;
+}
+
+std::vector<curl_waitfd> ResponseStream::GetWaitFds() const {
+    std::vector<curl_waitfd> fds;
+    if (!multicurl_) {
+        return fds;
+    }
+    fd_set read_fds;
+    fd_set write_fds;
+    fd_set exc_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    FD_ZERO(&exc_fds);
+    int max_fd{-1};
+    if (curl_multi_fdset(multicurl_->handle, &read_fds, &write_fds, &exc_fds, &max_fd) != CURLM_OK) {
+        return fds;
+    }
+    auto add = [&fds, &read_fds, &write_fds](curl_socket_t socket) {
+        short events{0};
+        if (FD_ISSET(socket, &read_fds)) {
+            events |= CURL_WAIT_POLLIN;
+        }
+        if (FD_ISSET(socket, &write_fds)) {
+            events |= CURL_WAIT_POLLOUT;
+        }
+        if (events != 0) {
+            fds.push_back(curl_waitfd{socket, events, 0});
+        }
+    };
+#ifdef _WIN32
+    // A Windows fd_set is a list of sockets instead of a bit set indexed by them
+    for (u_int i = 0; i < read_fds.fd_count; ++i) {
+        add(read_fds.fd_array[i]);
+    }
+    for (u_int i = 0; i < write_fds.fd_count; ++i) {
+        if (!FD_ISSET(write_fds.fd_array[i], &read_fds)) {
+            add(write_fds.fd_array[i]);
+        }
+    }
+#else
+    for (int socket = 0; socket <= max_fd; ++socket) {
+        add(socket);
+    }
+#endif
+    return fds;
+}
+
+std::chrono::milliseconds ResponseStream::GetWaitTimeout() const {
+    long timeout_ms{-1};
+    if (!multicurl_ || curl_multi_timeout(multicurl_->handle, &timeout_ms) != CURLM_OK || timeout_ms < 0) {
+        return WAIT_TIMEOUT;
+    }
+    return std::min(std::chrono::milliseconds{timeout_ms}, WAIT_TIMEOUT);
+}
+
+Response ResponseStream::Finish() {
+    if (response_) {
+        return *response_;
+    }
+    if (!state_) {
+        return Response{};
+    }
+    const CURLcode result = state_->transfer_done ? state_->result : CURLE_ABORTED_BY_CALLBACK;
+    release();
+    response_ = session_->Complete(result);
+    return *response_;
+}
+
+void ResponseStream::release() {
+    if (!multicurl_ || !session_) {
+        return;
+    }
+    if (state_->paused) {
+        // Do not leave a paused handle behind for the next request of the session
+        state_->paused = false;
+        state_->max_buffered_bytes = SIZE_MAX;
+        curl_easy_pause(session_->curl_->handle, CURLPAUSE_CONT);
+    }
+    const CURLMcode error_code = curl_multi_remove_handle(multicurl_->handle, session_->curl_->handle);
+    if (error_code) {
+        std::cerr << "curl_multi_remove_handle() failed, code " << static_cast<int>(error_code) << '\n';
+    }
+    multicurl_.reset();
+    if (!state_->transfer_done) {
+        state_->transfer_done = true;
+        state_->result = CURLE_ABORTED_BY_CALLBACK;
+    }
+    state_->chunks.clear();
+    state_->buffered_bytes = 0;
+    session_->restoreWriteFunction();
+}
+
+ResponseStream::iterator ResponseStream::begin() {
+    return iterator{this};
+}
+
+ResponseStream::iterator ResponseStream::end() {
+    return {};
+}
+
+bool ResponseStream::IsDone() const {
+    return !state_ || (state_->transfer_done && state_->chunks.empty());
+}
+
+bool ResponseStream::IsPaused() const {
+    return state_ && state_->paused;
+}
+
+size_t ResponseStream::GetBufferedBytes() const {
+    return state_ ? state_->buffered_bytes : 0;
+}
+
+} // namespace cpr
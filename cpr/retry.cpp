@@ -0,0 +1,96 @@
+#include "cpr/retry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <curl/curl.h>
+
+#include "cpr/cprtypes.h"
+#include "cpr/error.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+namespace {
+bool isIdempotent(std::string_view method, const Header& request_header) {
+    return method == "GET" || method == "HEAD" || method == "OPTIONS" || method == "PUT" || method == "DELETE" || method == "TRACE" || request_header.find("Idempotency-Key") != request_header.end();
+}
+
+bool neverReachedServer(ErrorCode code) {
+    return code == ErrorCode::COULDNT_RESOLVE_HOST || code == ErrorCode::COULDNT_RESOLVE_PROXY || code == ErrorCode::COULDNT_CONNECT;
+}
+
+std::chrono::milliseconds getJitteredBackoff(std::chrono::milliseconds base_delay, std::chrono::milliseconds max_delay, uint32_t retry) {
+    // Doubling stops long before overflowing, max_delay is reached way earlier anyway
+    const int64_t cap = std::min<int64_t>(max_delay.count(), base_delay.count() << std::min<uint32_t>(retry, 30));
+    if (cap <= 0) {
+        return std::chrono::milliseconds{0};
+    }
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    return std::chrono::milliseconds{std::uniform_int_distribution<int64_t>{0, cap}(generator)};
+}
+} // namespace
+
+std::optional<std::chrono::milliseconds> RetryPolicy::GetRetryDelay(std::string_view method, const Header& request_header, const Response& response, uint32_t attempts, std::chrono::milliseconds elapsed) const {
+    if (attempts >= max_attempts) {
+        return std::nullopt;
+    }
+
+    const ErrorCode code = response.error.code;
+    if (code != ErrorCode::OK) {
+        if (retry_error_codes.count(code) == 0) {
+            return std::nullopt;
+        }
+        if (!neverReachedServer(code) && !retry_non_idempotent && !isIdempotent(method, request_header)) {
+            return std::nullopt;
+        }
+    } else if (retry_status_codes.count(response.status_code) == 0 || (!retry_non_idempotent && !isIdempotent(method, request_header))) {
+        return std::nullopt;
+    }
+
+    std::chrono::milliseconds delay = getJitteredBackoff(base_delay, max_delay, attempts - 1);
+    if (respect_retry_after && code == ErrorCode::OK && (response.status_code == 429 || response.status_code == 503)) {
+        const std::optional<std::chrono::milliseconds> retry_after = ParseRetryAfter(response.header);
+        if (retry_after) {
+            if (*retry_after > max_retry_after) {
+                return std::nullopt;
+            }
+            delay = *retry_after;
+        }
+    }
+
+    if (max_total_time.count() > 0 && elapsed + delay > max_total_time) {
+        return std::nullopt;
+    }
+    return delay;
+}
+
+std::optional<std::chrono::milliseconds> RetryPolicy::ParseRetryAfter(const Header& response_header) {
+    const Header::const_iterator it = response_header.find("Retry-After");
+    if (it == response_header.end() || it->second.empty()) {
+        return std::nullopt;
+    }
+    const std::string& value = it->second;
+    if (std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        // Values this large make no sense anyway and would only overflow
+        if (value.size() > 9) {
+            return std::chrono::milliseconds::max();
+        }
+        return std::chrono::seconds{std::stoll(value)};
+    }
+
+    const time_t date = curl_getdate(value.c_str(), nullptr);
+    if (date < 0) {
+        return std::nullopt;
+    }
+    const time_t now = std::time(nullptr);
+    return std::chrono::seconds{date > now ? static_cast<int64_t>(date - now) : 0};
+}
+
+} // namespace cpr
@@ -1,18 +1,22 @@
 #include "cpr/session.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -24,19 +28,27 @@
 #include <curl/system.h>
 
 #include "cpr/accept_encoding.h"
+#include "cpr/allocation_accounting.h"
 #include "cpr/async.h"
 #include "cpr/auth.h"
 #include "cpr/bearer.h"
 #include "cpr/body.h"
 #include "cpr/body_view.h"
 #include "cpr/callback.h"
+#include "cpr/circuit_breaker.h"
 #include "cpr/connect_timeout.h"
 #include "cpr/connection_pool.h"
 #include "cpr/cookies.h"
 #include "cpr/cprtypes.h"
 #include "cpr/curlholder.h"
+#include "cpr/curlmultiholder.h"
+#include "cpr/deadline.h"
+#include "cpr/dns_cache.h"
+#include "cpr/endpoint_group.h"
 #include "cpr/error.h"
 #include "cpr/file.h"
+#include "cpr/file_sink.h"
+#include "cpr/hedging.h"
 #include "cpr/filesystem.h" // IWYU pragma: keep
 #include "cpr/http_version.h"
 #include "cpr/interceptor.h"
@@ -51,16 +63,25 @@
 #include "cpr/proxies.h"
 #include "cpr/proxyauth.h"
 #include "cpr/range.h"
+#include "cpr/rate_limiter.h"
 #include "cpr/redirect.h"
 #include "cpr/reserve_size.h"
 #include "cpr/resolve.h"
 #include "cpr/response.h"
+#include "cpr/retry.h"
+#include "cpr/single_flight.h"
+#include "cpr/sse.h"
 #include "cpr/ssl_options.h"
 #include "cpr/timeout.h"
+#include "cpr/timer_queue.h"
+#include "cpr/tls_session_store.h"
+#include "cpr/tracing.h"
 #include "cpr/unix_socket.h"
 #include "cpr/user_agent.h"
 #include "cpr/util.h"
 #include "cpr/verbose.h"
+#include "cpr/coroutine/async_generator.h"
+#include "cpr/coroutine/sleep.h"
 
 #if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
 #include "cpr/ssl_ctx.h"
@@ -76,6 +97,7 @@ constexpr long ON = 1L;
 constexpr long OFF = 0L;
 
 CURLcode Session::DoEasyPerform() {
+    const AllocationPhaseScope allocation_phase{AllocationPhase::TRANSFER};
     if (isUsedInMultiPerform) {
         std::cerr << "curl_easy_perform cannot be executed if the CURL handle is used in a MultiPerform.\n";
         return CURLcode::CURLE_FAILED_INIT;
@@ -83,6 +105,247 @@ CURLcode Session::DoEasyPerform() {
     return curl_easy_perform(curl_->handle);
 }
 
+CURLcode Session::DoPerform() {
+    const AllocationPhaseScope allocation_phase{AllocationPhase::TRANSFER};
+    return canHedge() ? DoHedgedPerform() : DoEasyPerform();
+}
+
+bool Session::canHedge() const {
+    if (!hedge_policy_ || isUsedInMultiPerform) {
+        return false;
+    }
+    // Both transfers write into buffers of their own, which does not work for callbacks
+    if (cbs_->writecb_.callback || cbs_->ssecb_.callback || cbs_->headercb_.callback || chunk_allocator_) {
+        return false;
+    }
+    const std::string_view method{http_method_};
+    return method == "GET" || method == "HEAD" || method == "OPTIONS";
+}
+
+namespace {
+bool isSuccessfulTransfer(CURL* handle, CURLcode result) {
+    // NOLINTNEXTLINE(google-runtime-int)
+    long status_code{0};
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status_code);
+    return result == CURLE_OK && status_code < 500;
+}
+
+// Copies the cookies received so far, curl_easy_duphandle() only enables the cookie engine of the new handle
+void copyCookies(CURL* source, CURL* target) {
+    curl_slist* cookies{nullptr};
+    curl_easy_getinfo(source, CURLINFO_COOKIELIST, &cookies);
+    for (const curl_slist* cookie = cookies; cookie != nullptr; cookie = cookie->next) {
+        curl_easy_setopt(target, CURLOPT_COOKIELIST, cookie->data);
+    }
+    curl_slist_free_all(cookies);
+}
+
+// Covers everything deciding whom a TLS connection trusts and how it authenticates itself
+uint64_t hashTlsOptions(const SslOptions& options, uint64_t hash) {
+    auto add = [&hash](std::string_view value) {
+        hash = util::fnv1a(value, hash);
+        // Keeps e.g. {"ab", ""} and {"a", "b"} apart
+        hash = util::fnv1a(std::string_view{"\0", 1}, hash);
+    };
+    add(options.cert_file);
+#if SUPPORT_CURLOPT_SSLCERT_BLOB
+    add(std::string_view{options.cert_blob.data(), options.cert_blob.size()});
+#endif
+    add(options.key_file);
+    add(options.pinned_public_key);
+    add(options.verify_host ? "1" : "0");
+    add(options.verify_peer ? "1" : "0");
+    add(options.verify_status ? "1" : "0");
+    add(std::to_string(options.ssl_version));
+#if SUPPORT_MAX_TLS_VERSION
+    add(std::to_string(options.max_version));
+#endif
+#if SUPPORT_SSL_NO_REVOKE
+    add(options.ssl_no_revoke ? "1" : "0");
+#endif
+    add(options.ca_info);
+#if SUPPORT_CURLOPT_CAINFO_BLOB
+    add(options.ca_info_blob);
+#endif
+    add(options.ca_path);
+#if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
+    add(options.ca_buffer);
+#endif
+    add(options.crl_file);
+    add(options.ciphers);
+#if SUPPORT_TLSv13_CIPHERS
+    add(options.tls13_ciphers);
+#endif
+    return hash;
+}
+
+// Applies options to the ones in effect the way SetSslOptions() does, i.e. empty values keep the previous one
+void mergeTlsOptions(SslOptions& current, const SslOptions& options) {
+    auto merge = [](auto& value, const auto& update) {
+        if (!update.empty()) {
+            value = update;
+        }
+    };
+    merge(current.cert_file, options.cert_file);
+#if SUPPORT_CURLOPT_SSLCERT_BLOB
+    merge(current.cert_blob, options.cert_blob);
+#endif
+    merge(current.key_file, options.key_file);
+    merge(current.pinned_public_key, options.pinned_public_key);
+    current.verify_host = options.verify_host;
+    current.verify_peer = options.verify_peer;
+    current.verify_status = options.verify_status;
+    current.ssl_version = options.ssl_version;
+#if SUPPORT_MAX_TLS_VERSION
+    current.max_version = options.max_version;
+#endif
+#if SUPPORT_SSL_NO_REVOKE
+    current.ssl_no_revoke = options.ssl_no_revoke;
+#endif
+    merge(current.ca_info, options.ca_info);
+#if SUPPORT_CURLOPT_CAINFO_BLOB
+    if (!options.ca_info_blob.empty()) {
+        current.ca_info_blob = std::to_string(util::fnv1a(options.ca_info_blob));
+    }
+#endif
+    merge(current.ca_path, options.ca_path);
+#if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
+    if (!options.ca_buffer.empty()) {
+        current.ca_buffer = std::to_string(util::fnv1a(options.ca_buffer));
+    }
+#endif
+    merge(current.crl_file, options.crl_file);
+    merge(current.ciphers, options.ciphers);
+#if SUPPORT_TLSv13_CIPHERS
+    merge(current.tls13_ciphers, options.tls13_ciphers);
+#endif
+}
+} // namespace
+
+CURLcode Session::DoHedgedPerform() {
+    if (!hedge_multi_) {
+        hedge_multi_ = std::make_unique<CurlMultiHolder>();
+    }
+    CURLM* multi = hedge_multi_->handle;
+    const HedgePolicy& hedge_policy = *hedge_policy_;
+    hedge_policy.RecordRequest();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point hedge_time = start + hedge_policy.GetDelay();
+
+    // The hedge writes into buffers of its own. They replace the ones of the session in case it wins.
+    CURL* hedge{nullptr};
+    std::string hedge_body;
+    std::string hedge_header;
+    util::ResponseStringReserveData hedge_reserve_data{&hedge_header, &hedge_body, response_string_reserve_data_.max_reserve};
+    std::array<char, CURL_ERROR_SIZE> hedge_error{};
+    curl_slist* hedge_connect_to{nullptr};
+
+    CURLMcode error_code = curl_multi_add_handle(multi, curl_->handle);
+    if (error_code) {
+        std::cerr << "curl_multi_add_handle() failed, code " << static_cast<int>(error_code) << '\n';
+        return CURLE_FAILED_INIT;
+    }
+
+    std::optional<CURLcode> primary_result;
+    std::optional<CURLcode> hedge_result;
+    CURL* winner{nullptr};
+    while (!winner) {
+        int still_running{0};
+        error_code = curl_multi_perform(multi, &still_running);
+        if (error_code) {
+            std::cerr << "curl_multi_perform() failed, code " << static_cast<int>(error_code) << '\n';
+            primary_result = CURLE_FAILED_INIT;
+            winner = curl_->handle;
+            break;
+        }
+
+        int msgq{0};
+        while (const CURLMsg* info = curl_multi_info_read(multi, &msgq)) {
+            if (info->msg == CURLMSG_DONE) {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-union-access)
+                (info->easy_handle == curl_->handle ? primary_result : hedge_result) = info->data.result;
+            }
+        }
+
+        // The first successful transfer wins. In case both fail, the primary one gets reported.
+        if (primary_result && (isSuccessfulTransfer(curl_->handle, *primary_result) || !hedge || hedge_result)) {
+            winner = curl_->handle;
+        } else if (hedge_result && (isSuccessfulTransfer(hedge, *hedge_result) || primary_result)) {
+            winner = hedge;
+        }
+        if (winner) {
+            break;
+        }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (!hedge && now >= hedge_time) {
+            if (hedge_policy.TryAcquireHedge()) {
+                hedge = curl_easy_duphandle(curl_->handle);
+            }
+            // Only one attempt per request
+            hedge_time = std::chrono::steady_clock::time_point::max();
+            if (hedge) {
+                // Neither gets copied by curl_easy_duphandle(). The hedge may replace the handle of the session.
+                if (connection_pool_) {
+                    connection_pool_->SetupHandler(hedge);
+                }
+                copyCookies(curl_->handle, hedge);
+                curl_easy_setopt(hedge, CURLOPT_WRITEDATA, &hedge_body);
+                curl_easy_setopt(hedge, CURLOPT_HEADERDATA, &hedge_reserve_data);
+                curl_easy_setopt(hedge, CURLOPT_ERRORBUFFER, hedge_error.data());
+                for (const std::string& entry : hedge_policy.GetNextConnectTo()) {
+                    hedge_connect_to = curl_slist_append(hedge_connect_to, entry.c_str());
+                }
+                if (hedge_connect_to) {
+                    // Otherwise the hedge keeps the target of the request, e.g. the one of its endpoint group
+                    curl_easy_setopt(hedge, CURLOPT_CONNECT_TO, hedge_connect_to);
+                }
+                curl_multi_add_handle(multi, hedge);
+                continue;
+            }
+        }
+
+        int timeout_ms{1000};
+        if (hedge_time != std::chrono::steady_clock::time_point::max()) {
+            timeout_ms = static_cast<int>(std::clamp<int64_t>(std::chrono::ceil<std::chrono::milliseconds>(hedge_time - now).count(), 0, timeout_ms));
+        }
+#if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
+        error_code = curl_multi_poll(multi, nullptr, 0, timeout_ms, nullptr);
+#else
+        error_code = curl_multi_wait(multi, nullptr, 0, timeout_ms, nullptr);
+#endif
+        if (error_code) {
+            std::cerr << "curl_multi_poll() failed, code " << static_cast<int>(error_code) << '\n';
+            primary_result = CURLE_FAILED_INIT;
+            winner = curl_->handle;
+        }
+    }
+
+    // Removing the other transfer cancels it
+    curl_multi_remove_handle(multi, curl_->handle);
+    const bool hedge_won = hedge && winner == hedge;
+    if (hedge) {
+        curl_multi_remove_handle(multi, hedge);
+        if (hedge_won) {
+            curl_easy_cleanup(curl_->handle);
+            curl_->handle = hedge;
+            response_string_ = std::move(hedge_body);
+            header_string_ = std::move(hedge_header);
+            curl_->error = hedge_error;
+            curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &response_string_);
+            curl_easy_setopt(curl_->handle, CURLOPT_HEADERDATA, &response_string_reserve_data_);
+            curl_easy_setopt(curl_->handle, CURLOPT_ERRORBUFFER, curl_->error.data());
+            curl_easy_setopt(curl_->handle, CURLOPT_CONNECT_TO, curl_->connectToCurlList);
+        } else {
+            curl_easy_cleanup(hedge);
+        }
+        curl_slist_free_all(hedge_connect_to);
+    }
+
+    hedge_policy.RecordLatency(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start), hedge_won);
+    return hedge_won ? *hedge_result : *primary_result;
+}
+
 void Session::prepareHeader() {
     curl_slist* chunk = nullptr;
     for (const std::pair<const std::string, std::string>& item : header_) {
@@ -114,6 +377,14 @@ void Session::prepareHeader() {
         chunk = temp;
     }
 
+    // Let the server join the trace, unless the request continues one of its own
+    if (trace_ && tracer_->Propagates() && header_.find("traceparent") == header_.end()) {
+        temp = curl_slist_append(chunk, ("traceparent: " + trace_->context.ToTraceparent()).c_str());
+        if (temp) {
+            chunk = temp;
+        }
+    }
+
     curl_easy_setopt(curl_->handle, CURLOPT_HTTPHEADER, chunk);
 
     curl_slist_free_all(curl_->chunk);
@@ -122,13 +393,17 @@ void Session::prepareHeader() {
 
 void Session::prepareProxy() {
     const std::string protocol = url_.str().substr(0, url_.str().find(':'));
+    std::string proxy;
     if (proxies_.has(protocol)) {
-        curl_easy_setopt(curl_->handle, CURLOPT_PROXY, proxies_[protocol].c_str());
+        proxy = proxies_[protocol];
+        curl_easy_setopt(curl_->handle, CURLOPT_PROXY, proxy.c_str());
         if (proxyAuth_.has(protocol)) {
             curl_easy_setopt(curl_->handle, CURLOPT_PROXYUSERNAME, proxyAuth_.GetUsernameUnderlying(protocol).c_str());
             curl_easy_setopt(curl_->handle, CURLOPT_PROXYPASSWORD, proxyAuth_.GetPasswordUnderlying(protocol).c_str());
         }
     }
+    // A TLS session only gets offered to connections going the same way with the same options
+    ssl_ctx_data_.session_context = tls_options_hash_ == 0 && proxy.empty() ? 0 : util::fnv1a(proxy, tls_options_hash_);
 }
 
 // Only supported with libcurl >= 7.61.0.
@@ -141,7 +416,9 @@ void Session::SetBearer(const Bearer& token) {
 }
 #endif
 
-Session::Session() : curl_(new CurlHolder()) {
+Session::Session() {
+    const AllocationPhaseScope allocation_phase{AllocationPhase::SESSION};
+    curl_ = std::make_shared<CurlHolder>();
     // Set up some sensible defaults
     curl_version_info_data* version_info = curl_version_info(CURLVERSION_NOW);
     const std::string version = "curl/" + std::string{version_info->version};
@@ -161,32 +438,347 @@ Session::Session() : curl_(new CurlHolder()) {
     first_interceptor_ = interceptors_.end();
 }
 
+Session::~Session() {
+    if (endpoint_) {
+        endpoint_group_->Release(*endpoint_);
+    }
+}
+
 Response Session::makeDownloadRequest() {
+    const EndpointReleaseScope endpoint_release{*this};
+    endTraceQueued();
     const std::optional<Response> r = intercept();
     if (r.has_value()) {
         return r.value();
     }
+    waitForRateLimit();
+
+    if (!prepareDeadline(deadline_)) {
+        return makeDeadlineExceededResponse();
+    }
+
+    if (circuit_breaker_) {
+        const std::string_view host = CircuitBreaker::GetHost(url_.str());
+        if (!circuit_breaker_->Allow(host)) {
+            return makeCircuitOpenResponse(host);
+        }
+        Response response = CompleteDownload(DoEasyPerform());
+        circuit_breaker_->Record(host, response);
+        return response;
+    }
 
     const CURLcode curl_error = DoEasyPerform();
 
     return CompleteDownload(curl_error);
 }
 
+Response Session::makeCircuitOpenResponse(std::string_view host) {
+    Response response;
+    response.url = url_;
+    response.error.code = ErrorCode::CIRCUIT_OPEN;
+    response.error.message = "Circuit breaker open for " + std::string{host};
+    if (trace_) {
+        endTrace(response, false);
+    }
+    return response;
+}
+
+Response Session::makeDeadlineExceededResponse() {
+    Response response;
+    response.url = url_;
+    response.error.code = ErrorCode::OPERATION_TIMEDOUT;
+    response.error.message = "Deadline exceeded before the request was sent";
+    if (trace_) {
+        endTrace(response, false);
+    }
+    return response;
+}
+
+bool Session::prepareDeadline(const std::optional<Deadline>& deadline) {
+    if (!deadline) {
+        // Undoes a timeout shortened for an earlier deadline, e.g. the one of a MultiPerform
+        curl_easy_setopt(curl_->handle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout_.count()));
+        return true;
+    }
+    const std::chrono::milliseconds remaining = deadline->Remaining();
+    if (remaining <= std::chrono::milliseconds::zero()) {
+        return false;
+    }
+    const std::chrono::milliseconds timeout = timeout_ > std::chrono::milliseconds::zero() ? std::min(timeout_, remaining) : remaining;
+    curl_easy_setopt(curl_->handle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+    return true;
+}
+
+Response Session::makeRetriedRequest(PrepareFunction prepare) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    (this->*prepare)();
+    Response response = makeRequest();
+    if (!retry_policy_) {
+        return response;
+    }
+
+    uint32_t retries = 0;
+    for (std::optional<std::chrono::milliseconds> delay = getRetryDelay(response, retries, start); delay; delay = getRetryDelay(response, retries, start)) {
+        markTraceQueued();
+        std::this_thread::sleep_for(*delay);
+        (this->*prepare)();
+        response = makeRequest();
+        response.retry_count = ++retries;
+    }
+    return response;
+}
+
+AsyncResponse Session::makeRetriedRequestAsync(PrepareFunction prepare) {
+    std::shared_ptr<Session> shared_this = GetSharedPtrFromThis();
+    markTraceQueued();
+    if (!retry_policy_ && !rate_limiter_) {
+        return async(*GetExecutor(), priority_, [shared_this, prepare]() { return shared_this->makeRetriedRequest(prepare); });
+    }
+
+    std::shared_ptr<priv::AsyncPromise<Response>> promise = std::make_shared<priv::AsyncPromise<Response>>();
+    AsyncResponse result{promise->get_future(), promise->GetState()};
+    GetExecutor()->ExecuteWithPriority([shared_this, promise, prepare, start = std::chrono::steady_clock::now()]() { shared_this->runRetriedRequestAsync(promise, prepare, 0, start, false); }, priority_);
+    return result;
+}
+
+void Session::runRetriedRequestAsync(const std::shared_ptr<priv::AsyncPromise<Response>>& promise, PrepareFunction prepare, uint32_t retries, std::chrono::steady_clock::time_point start, bool rate_limited) {
+    try {
+        (this->*prepare)();
+        if (!rate_limited) {
+            const RateLimiter::Clock::duration rate_limit_delay = reserveRateLimitAhead();
+            if (rate_limit_delay > RateLimiter::Clock::duration::zero()) {
+                // Only the timer thread waits until the token may be used
+                TimerQueue::GetInstance()->ScheduleAfter(rate_limit_delay, [shared_this = shared_from_this(), promise, prepare, retries, start]() {
+                    shared_this->GetExecutor()->ExecuteWithPriority([shared_this, promise, prepare, retries, start]() { shared_this->runRetriedRequestAsync(promise, prepare, retries, start, true); }, shared_this->priority_);
+                });
+                return;
+            }
+        }
+        Response response = makeRequest();
+        response.retry_count = retries;
+        const std::optional<std::chrono::milliseconds> delay = getRetryDelay(response, retries, start);
+        if (!delay) {
+            promise->set_value(std::move(response));
+            return;
+        }
+        // Only the timer thread waits, the next attempt gets handed back to the pool once it is due
+        markTraceQueued();
+        TimerQueue::GetInstance()->ScheduleAfter(*delay, [shared_this = shared_from_this(), promise, prepare, retries, start]() {
+            shared_this->GetExecutor()->ExecuteWithPriority([shared_this, promise, prepare, retries, start]() { shared_this->runRetriedRequestAsync(promise, prepare, retries + 1, start, false); }, shared_this->priority_);
+        });
+    } catch (...) {
+        promise->set_exception(std::current_exception());
+    }
+}
+
+coroutine::Task<Response> Session::coMakeRetriedRequest(PrepareFunction prepare) {
+    // Keeps the session alive while the coroutine is suspended
+    const std::shared_ptr<Session> shared_this = GetSharedPtrFromThis();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    (shared_this.get()->*prepare)();
+    co_await coroutine::SleepFor(shared_this->reserveRateLimitAhead());
+    Response response = shared_this->makeRequest();
+    if (!shared_this->retry_policy_) {
+        co_return response;
+    }
+
+    uint32_t retries = 0;
+    for (std::optional<std::chrono::milliseconds> delay = shared_this->getRetryDelay(response, retries, start); delay; delay = shared_this->getRetryDelay(response, retries, start)) {
+        shared_this->markTraceQueued();
+        co_await coroutine::SleepFor(*delay);
+        (shared_this.get()->*prepare)();
+        co_await coroutine::SleepFor(shared_this->reserveRateLimitAhead());
+        response = shared_this->makeRequest();
+        response.retry_count = ++retries;
+    }
+    co_return response;
+}
+
+std::optional<std::chrono::milliseconds> Session::getRetryDelay(const Response& response, uint32_t retries, std::chrono::steady_clock::time_point start) const {
+    if (!retry_policy_) {
+        return std::nullopt;
+    }
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
+    std::optional<std::chrono::milliseconds> delay = retry_policy_->GetRetryDelay(http_method_, header_, response, retries + 1, elapsed);
+    if (delay && deadline_ && now + *delay >= deadline_->time_point) {
+        // The attempt would not get sent anyway
+        return std::nullopt;
+    }
+    return delay;
+}
+
+RateLimiter::Clock::duration Session::reserveRateLimit() {
+    if (!rate_limiter_) {
+        return RateLimiter::Clock::duration::zero();
+    }
+    const RateLimiter::Clock::duration delay = rate_limiter_->Reserve(rate_limiter_->GetKey(http_method_, GetFullRequestUrl()));
+    if (delay > RateLimiter::Clock::duration::zero()) {
+        markTraceQueued();
+    }
+    return delay;
+}
+
+RateLimiter::Clock::duration Session::reserveRateLimitAhead() {
+    if (!interceptors_.empty()) {
+        // An interceptor may answer without the network (e.g. a cache hit), so makeRequest() takes the token later on
+        return RateLimiter::Clock::duration::zero();
+    }
+    rate_limit_reserved_ = true;
+    return reserveRateLimit();
+}
+
+void Session::waitForRateLimit() {
+    if (std::exchange(rate_limit_reserved_, false)) {
+        return;
+    }
+    const RateLimiter::Clock::duration delay = reserveRateLimit();
+    if (delay > RateLimiter::Clock::duration::zero()) {
+        std::this_thread::sleep_for(delay);
+        endTraceQueued();
+    }
+}
+
+std::string Session::prepareEndpoint(const std::string& url) {
+    if (endpoint_) {
+        // Prepared before without making the request
+        endpoint_group_->Release(*endpoint_);
+    }
+    endpoint_ = endpoint_group_->Acquire();
+
+    curl_slist_free_all(curl_->connectToCurlList);
+    curl_->connectToCurlList = nullptr;
+    const std::optional<std::string>& connect_to = endpoint_group_->GetConnectTo(*endpoint_);
+    if (connect_to) {
+        curl_->connectToCurlList = curl_slist_append(curl_->connectToCurlList, connect_to->c_str());
+    }
+    curl_easy_setopt(curl_->handle, CURLOPT_CONNECT_TO, curl_->connectToCurlList);
+    return endpoint_group_->GetUrl(*endpoint_, url);
+}
+
+void Session::recordEndpoint(const Response& response) {
+    if (endpoint_) {
+        endpoint_group_->Record(*endpoint_, response);
+        endpoint_.reset();
+    }
+}
+
+Session::EndpointReleaseScope::~EndpointReleaseScope() {
+    if (session_.endpoint_) {
+        // Otherwise a half open endpoint would wait for the outcome of its probe forever
+        session_.endpoint_group_->Release(*session_.endpoint_);
+        session_.endpoint_.reset();
+    }
+}
+
+void Session::beginTrace() {
+    const std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    if (!trace_) {
+        trace_ = TraceState{TraceContext::Generate(tracer_->GetParent()), trace_queued_since_.value_or(now), now};
+    } else {
+        trace_->prepare_start = now;
+    }
+    endTraceQueued();
+}
+
+void Session::endTrace(const Response& response, bool transferred) {
+    const std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
+    const TraceState trace = *trace_;
+    trace_.reset();
+    trace_queued_since_.reset();
+    if (transferred) {
+        // All timings are in seconds since the transfer started
+        double namelookup{0};
+        double connect{0};
+        double appconnect{0};
+        double pretransfer{0};
+        double starttransfer{0};
+        double total{0};
+        curl_easy_getinfo(curl_->handle, CURLINFO_NAMELOOKUP_TIME, &namelookup);
+        curl_easy_getinfo(curl_->handle, CURLINFO_CONNECT_TIME, &connect);
+        curl_easy_getinfo(curl_->handle, CURLINFO_APPCONNECT_TIME, &appconnect);
+        curl_easy_getinfo(curl_->handle, CURLINFO_PRETRANSFER_TIME, &pretransfer);
+        curl_easy_getinfo(curl_->handle, CURLINFO_STARTTRANSFER_TIME, &starttransfer);
+        curl_easy_getinfo(curl_->handle, CURLINFO_TOTAL_TIME, &total);
+        const auto at = [transfer_start = end - std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>{total})](double seconds) { return transfer_start + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>{seconds}); };
+        if (namelookup > 0) {
+            emitTraceSpan(SpanKind::DNS, trace.context, at(0), at(namelookup));
+        }
+        if (connect > namelookup) {
+            emitTraceSpan(SpanKind::CONNECT, trace.context, at(namelookup), at(connect));
+        }
+        if (appconnect > connect) {
+            emitTraceSpan(SpanKind::TLS, trace.context, at(connect), at(appconnect));
+        }
+        if (starttransfer > 0) {
+            emitTraceSpan(SpanKind::FIRST_BYTE, trace.context, at(pretransfer), at(starttransfer));
+            emitTraceSpan(SpanKind::COMPLETE, trace.context, at(starttransfer), end);
+        }
+    }
+
+    Span span;
+    span.kind = SpanKind::REQUEST;
+    span.context = trace.context;
+    if (tracer_->GetParent()) {
+        span.parent_span_id = tracer_->GetParent()->span_id;
+    }
+    span.start = trace.start;
+    span.end = end;
+    span.method = http_method_;
+    span.response = &response;
+    tracer_->Emit(span);
+}
+
+void Session::markTraceQueued() {
+    if (tracer_) {
+        trace_queued_since_ = std::chrono::system_clock::now();
+    }
+}
+
+void Session::endTraceQueued() {
+    if (trace_ && trace_queued_since_) {
+        emitTraceSpan(SpanKind::QUEUED, trace_->context, *trace_queued_since_, std::chrono::system_clock::now());
+        trace_queued_since_.reset();
+    }
+}
+
+void Session::emitTraceSpan(SpanKind kind, const TraceContext& parent, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end) const {
+    Span span;
+    span.kind = kind;
+    span.context = TraceContext::Generate(parent);
+    span.parent_span_id = parent.span_id;
+    span.start = start;
+    span.end = end;
+    tracer_->Emit(span);
+}
+
 void Session::prepareCommonShared() {
     assert(curl_->handle);
 
+    if (tracer_) {
+        beginTrace();
+    }
+
     // Set Header:
     prepareHeader();
 
     // URL parameter:
     const std::string parametersContent = parameters_.GetContent(*curl_);
-    if (!parametersContent.empty()) {
+    if (endpoint_group_) {
+        const std::string endpoint_url = prepareEndpoint(parametersContent.empty() ? url_.str() : url_.str() + "?" + parametersContent);
+        curl_easy_setopt(curl_->handle, CURLOPT_URL, endpoint_url.c_str());
+    } else if (!parametersContent.empty()) {
         const Url new_url{url_ + "?" + parametersContent};
         curl_easy_setopt(curl_->handle, CURLOPT_URL, new_url.c_str());
     } else {
         curl_easy_setopt(curl_->handle, CURLOPT_URL, url_.c_str());
     }
 
+    // DNS cache:
+    if (dns_cache_) {
+        prepareResolve();
+    }
+
     // Proxy:
     prepareProxy();
 
@@ -216,6 +808,10 @@ void Session::prepareCommonShared() {
 
     // Clear the response
     response_string_.clear();
+    if (response_buffer_pool_ && !ResponseBufferPool::HasHeapBuffer(response_string_)) {
+        // The previous response string has been moved out. Draw a new one from the pool instead of growing it from scratch.
+        response_string_ = response_buffer_pool_->Acquire();
+    }
     if (response_string_reserve_size_ > 0) {
         response_string_.reserve(response_string_reserve_size_);
     }
@@ -226,6 +822,8 @@ void Session::prepareCommonShared() {
 
 void Session::prepareCommon() {
     assert(curl_->handle);
+    const AllocationPhaseScope allocation_phase{AllocationPhase::PREPARE};
+    download_ = false;
 
     // Everything else:
     prepareCommonShared();
@@ -233,20 +831,33 @@ void Session::prepareCommon() {
     // Set Content:
     prepareBodyPayloadOrMultipart();
 
-    if (!cbs_->writecb_.callback && !cbs_->ssecb_.callback) {
+    const bool write_to_response = !cbs_->writecb_.callback && !cbs_->ssecb_.callback;
+    if (write_to_response && chunk_allocator_) {
+        chunked_body_ = ChunkedBody{*chunk_allocator_};
+        curl_easy_setopt(curl_->handle, CURLOPT_WRITEFUNCTION, cpr::util::writeChunkedBodyFunction);
+        curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &chunked_body_);
+    } else if (write_to_response) {
         curl_easy_setopt(curl_->handle, CURLOPT_WRITEFUNCTION, cpr::util::writeFunction);
         curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &response_string_);
     }
 
     header_string_.clear();
     if (!cbs_->headercb_.callback) {
-        curl_easy_setopt(curl_->handle, CURLOPT_HEADERFUNCTION, cpr::util::writeFunction);
-        curl_easy_setopt(curl_->handle, CURLOPT_HEADERDATA, &header_string_);
+        // Chunks never get reallocated, so there is nothing to reserve for them
+        response_string_reserve_data_.body = (write_to_response && !chunk_allocator_) ? &response_string_ : nullptr;
+        curl_easy_setopt(curl_->handle, CURLOPT_HEADERFUNCTION, cpr::util::writeHeaderReserveFunction);
+        curl_easy_setopt(curl_->handle, CURLOPT_HEADERDATA, &response_string_reserve_data_);
+    }
+
+    if (trace_) {
+        emitTraceSpan(SpanKind::PREPARE, trace_->context, trace_->prepare_start, std::chrono::system_clock::now());
     }
 }
 
 void Session::prepareCommonDownload() {
     assert(curl_->handle);
+    const AllocationPhaseScope allocation_phase{AllocationPhase::PREPARE};
+    download_ = true;
 
     // Everything else:
     prepareCommonShared();
@@ -259,15 +870,54 @@ void Session::prepareCommonDownload() {
         curl_easy_setopt(curl_->handle, CURLOPT_HEADERFUNCTION, cpr::util::writeFunction);
         curl_easy_setopt(curl_->handle, CURLOPT_HEADERDATA, &header_string_);
     }
+
+    if (trace_) {
+        emitTraceSpan(SpanKind::PREPARE, trace_->context, trace_->prepare_start, std::chrono::system_clock::now());
+    }
 }
 
 Response Session::makeRequest() {
+    const EndpointReleaseScope endpoint_release{*this};
+    endTraceQueued();
     const std::optional<Response> r = intercept();
     if (r.has_value()) {
         return r.value();
     }
+    // Only requests passing all interceptors take a token
+    waitForRateLimit();
 
-    const CURLcode curl_error = DoEasyPerform();
+    if (!prepareDeadline(deadline_)) {
+        return makeDeadlineExceededResponse();
+    }
+
+    if (circuit_breaker_) {
+        const std::string_view host = CircuitBreaker::GetHost(url_.str());
+        if (!circuit_breaker_->Allow(host)) {
+            return makeCircuitOpenResponse(host);
+        }
+        Response response = makeTransfer();
+        circuit_breaker_->Record(host, response);
+        return response;
+    }
+    return makeTransfer();
+}
+
+Response Session::makeTransfer() {
+    if (single_flight_) {
+        const std::string_view method{http_method_};
+        // Only responses ending up completely inside the Response can be handed to other waiters
+        const bool write_to_response = !cbs_->writecb_.callback && !cbs_->ssecb_.callback;
+        if (write_to_response && (method == "GET" || method == "HEAD" || method == "OPTIONS")) {
+            Response response = single_flight_->Do(single_flight_->GetKey(method, GetFullRequestUrl(), header_), [this]() { return Complete(DoPerform()); });
+            if (trace_) {
+                // Got the response of another request in flight
+                endTrace(response, false);
+            }
+            return response;
+        }
+    }
+
+    const CURLcode curl_error = DoPerform();
 
     return Complete(curl_error);
 }
@@ -328,6 +978,16 @@ void Session::SetServerSentEventCallback(const ServerSentEventCallback& sse) {
     curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &cbs_->ssecb_);
 }
 
+void Session::restoreWriteFunction() {
+    if (cbs_->writecb_.callback) {
+        curl_easy_setopt(curl_->handle, CURLOPT_WRITEFUNCTION, cpr::util::writeUserFunction);
+        curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &cbs_->writecb_);
+    } else if (cbs_->ssecb_.callback) {
+        curl_easy_setopt(curl_->handle, CURLOPT_WRITEFUNCTION, cpr::util::writeSSEFunction);
+        curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &cbs_->ssecb_);
+    }
+}
+
 void Session::SetProgressCallback(const ProgressCallback& progress) {
     cbs_->progresscb_ = progress;
     if (isCancellable) {
@@ -360,13 +1020,91 @@ void Session::SetResolve(const Resolve& resolve) {
 }
 
 void Session::SetResolves(const std::vector<Resolve>& resolves) {
+    resolves_ = resolves;
+    prepareResolve();
+}
+
+void Session::SetDnsCache(const DnsCache& dns_cache) {
+    dns_cache_ = dns_cache;
+}
+
+void Session::SetRetryPolicy(const RetryPolicy& retry_policy) {
+    retry_policy_ = retry_policy;
+}
+
+void Session::SetCircuitBreaker(const CircuitBreaker& circuit_breaker) {
+    circuit_breaker_ = circuit_breaker;
+}
+
+void Session::SetRateLimiter(const RateLimiter& rate_limiter) {
+    rate_limiter_ = rate_limiter;
+}
+
+void Session::SetEndpointGroup(const EndpointGroup& endpoint_group) {
+    if (endpoint_) {
+        endpoint_group_->Release(*endpoint_);
+        endpoint_.reset();
+    }
+    endpoint_group_ = endpoint_group;
+}
+
+void Session::SetTracer(const Tracer& tracer) {
+    tracer_ = tracer;
+}
+
+void Session::SetExecutor(const std::shared_ptr<Executor>& executor) {
+    executor_ = executor;
+}
+
+std::shared_ptr<Executor> Session::GetExecutor() const {
+    return executor_ ? executor_ : GetDefaultExecutor();
+}
+
+void Session::SetPriority(Priority priority) {
+    priority_ = priority;
+}
+
+Priority Session::GetPriority() const {
+    return priority_;
+}
+
+void Session::SetHedgePolicy(const HedgePolicy& hedge_policy) {
+    hedge_policy_ = hedge_policy;
+}
+
+void Session::SetTlsSessionStore(const TlsSessionStore& store) {
+    tls_session_store_ = store;
+    ssl_ctx_data_.session_store = &*tls_session_store_;
+    prepareSslCtx();
+}
+
+void Session::prepareSslCtx() {
+#if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
+#ifdef OPENSSL_BACKEND_USED
+    curl_easy_setopt(curl_->handle, CURLOPT_SSL_CTX_FUNCTION, sslctx_function);
+    curl_easy_setopt(curl_->handle, CURLOPT_SSL_CTX_DATA, &ssl_ctx_data_);
+#endif
+#endif
+}
+
+void Session::prepareResolve() {
     curl_slist_free_all(curl_->resolveCurlList);
     curl_->resolveCurlList = nullptr;
-    for (const Resolve& resolve : resolves) {
+    for (const Resolve& resolve : resolves_) {
         for (const uint16_t port : resolve.ports) {
             curl_->resolveCurlList = curl_slist_append(curl_->resolveCurlList, (resolve.host + ":" + std::to_string(port) + ":" + resolve.addr).c_str());
         }
     }
+    if (dns_cache_) {
+        const std::optional<std::string> entry = dns_cache_->GetResolveEntry(url_.str());
+        if (entry) {
+            // Explicit resolve entries take precedence
+            const std::string host = entry->substr(0, entry->find(':'));
+            if (std::none_of(resolves_.begin(), resolves_.end(), [&host](const Resolve& resolve) { return resolve.host == host; })) {
+                curl_->resolveCurlList = curl_slist_append(curl_->resolveCurlList, entry->c_str());
+            }
+        }
+    }
     curl_easy_setopt(curl_->handle, CURLOPT_RESOLVE, curl_->resolveCurlList);
 }
 
@@ -397,6 +1135,7 @@ const Header& Session::GetHeader() const {
 }
 
 void Session::SetTimeout(const Timeout& timeout) {
+    timeout_ = timeout.ms;
     curl_easy_setopt(curl_->handle, CURLOPT_TIMEOUT_MS, timeout.Milliseconds());
 }
 
@@ -404,9 +1143,14 @@ void Session::SetConnectTimeout(const ConnectTimeout& timeout) {
     curl_easy_setopt(curl_->handle, CURLOPT_CONNECTTIMEOUT_MS, timeout.Milliseconds());
 }
 
+void Session::SetDeadline(const Deadline& deadline) {
+    deadline_ = deadline;
+}
+
 void Session::SetConnectionPool(const ConnectionPool& pool) {
     CURL* curl = curl_->handle;
     pool.SetupHandler(curl);
+    connection_pool_.emplace(pool);
 }
 
 void Session::SetAuth(const Authentication& auth) {
@@ -521,6 +1265,16 @@ void Session::SetLowSpeed(const LowSpeed& low_speed) {
 void Session::SetVerifySsl(const VerifySsl& verify) {
     curl_easy_setopt(curl_->handle, CURLOPT_SSL_VERIFYPEER, verify ? ON : OFF);
     curl_easy_setopt(curl_->handle, CURLOPT_SSL_VERIFYHOST, verify ? 2L : 0L);
+    // Sessions of unverified connections must not be offered to verifying ones
+    tls_options_.verify_peer = static_cast<bool>(verify);
+    tls_options_.verify_host = static_cast<bool>(verify);
+    updateTlsOptionsHash();
+}
+
+void Session::updateTlsOptionsHash() {
+    static const uint64_t default_hash = hashTlsOptions(SslOptions{}, util::fnv1a({}));
+    const uint64_t hash = hashTlsOptions(tls_options_, util::fnv1a({}));
+    tls_options_hash_ = hash == default_hash ? 0 : hash;
 }
 
 void Session::SetUnixSocket(const UnixSocket& unix_socket) {
@@ -528,6 +1282,8 @@ void Session::SetUnixSocket(const UnixSocket& unix_socket) {
 }
 
 void Session::SetSslOptions(const SslOptions& options) {
+    mergeTlsOptions(tls_options_, options);
+    updateTlsOptionsHash();
     if (!options.cert_file.empty()) {
         curl_easy_setopt(curl_->handle, CURLOPT_SSLCERT, options.cert_file.c_str());
         if (!options.cert_type.empty()) {
@@ -630,8 +1386,9 @@ void Session::SetSslOptions(const SslOptions& options) {
 #if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
 #ifdef OPENSSL_BACKEND_USED
     if (!options.ca_buffer.empty()) {
-        curl_easy_setopt(curl_->handle, CURLOPT_SSL_CTX_FUNCTION, sslctx_function_load_ca_cert_from_buffer);
-        curl_easy_setopt(curl_->handle, CURLOPT_SSL_CTX_DATA, options.ca_buffer.c_str());
+        // Parsed once and shared with all other sessions using the same buffer
+        ssl_ctx_data_.ca_certificates = CaCertificates::Get(options.ca_buffer);
+        prepareSslCtx();
     }
 #endif
 #endif
@@ -733,6 +1490,22 @@ void Session::SetReserveSize(const ReserveSize& reserve_size) {
     ResponseStringReserve(reserve_size.size);
 }
 
+void Session::SetAutoReserveSize(const AutoReserveSize& auto_reserve_size) {
+    ResponseStringAutoReserve(auto_reserve_size.max_size);
+}
+
+void Session::SetResponseBufferPool(const ResponseBufferPool& pool) {
+    response_buffer_pool_ = pool;
+}
+
+void Session::SetChunkAllocator(const ChunkAllocator& allocator) {
+    chunk_allocator_ = allocator;
+}
+
+void Session::SetSingleFlight(const SingleFlight& single_flight) {
+    single_flight_ = single_flight;
+}
+
 void Session::SetAcceptEncoding(const AcceptEncoding& accept_encoding) {
     acceptEncoding_ = accept_encoding;
 }
@@ -764,9 +1537,12 @@ void Session::ResponseStringReserve(size_t size) {
     response_string_reserve_size_ = size;
 }
 
+void Session::ResponseStringAutoReserve(size_t max_size) {
+    response_string_reserve_data_.max_reserve = max_size;
+}
+
 Response Session::Delete() {
-    PrepareDelete();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PrepareDelete);
 }
 
 Response Session::Download(const WriteCallback& write) {
@@ -779,34 +1555,33 @@ Response Session::Download(std::ofstream& file) {
     return makeDownloadRequest();
 }
 
+Response Session::Download(FileSink& sink) {
+    PrepareDownload(sink);
+    return makeDownloadRequest();
+}
+
 Response Session::Get() {
-    PrepareGet();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PrepareGet);
 }
 
 Response Session::Head() {
-    PrepareHead();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PrepareHead);
 }
 
 Response Session::Options() {
-    PrepareOptions();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PrepareOptions);
 }
 
 Response Session::Patch() {
-    PreparePatch();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PreparePatch);
 }
 
 Response Session::Post() {
-    PreparePost();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PreparePost);
 }
 
 Response Session::Put() {
-    PreparePut();
-    return makeRequest();
+    return makeRetriedRequest(&Session::PreparePut);
 }
 
 std::shared_ptr<Session> Session::GetSharedPtrFromThis() {
@@ -817,52 +1592,104 @@ std::shared_ptr<Session> Session::GetSharedPtrFromThis() {
     }
 }
 
+ResponseStream Session::GetStream(size_t max_buffered_bytes) {
+    std::shared_ptr<Session> shared_this = GetSharedPtrFromThis();
+    PrepareGet();
+    return ResponseStream{std::move(shared_this), max_buffered_bytes};
+}
+
+coroutine::AsyncGenerator<std::string> Session::CoGetStream(size_t max_buffered_bytes, Response* response)
+{
+    ResponseStream stream = GetStream(max_buffered_bytes);
+    // Suspended at co_yield the stream does not get read, so the transfer pauses once its buffer is full
+    while (true) {
+        // Waits on the SocketWatcher instead of blocking a thread of the executor inside Read()
+        co_await coroutine::StreamReady{ stream };
+        std::optional<std::string> chunk = stream.Read();
+        if (!chunk) {
+            break;
+        }
+        co_yield std::move(*chunk);
+    }
+    if (response) {
+        *response = stream.Finish();
+    }
+}
+
+coroutine::AsyncGenerator<ServerSentEvent> Session::CoGetEventStream(size_t max_buffered_bytes, Response* response)
+{
+    ResponseStream stream = GetStream(max_buffered_bytes);
+    ServerSentEventParser parser;
+    std::vector<ServerSentEvent> events;
+    while (true) {
+        co_await coroutine::StreamReady{ stream };
+        std::optional<std::string> chunk = stream.Read();
+        if (!chunk) {
+            break;
+        }
+        parser.parse(*chunk, [&events](ServerSentEvent&& event) {
+            events.push_back(std::move(event));
+            return true;
+        });
+        for (ServerSentEvent& event : events) {
+            co_yield std::move(event);
+        }
+        events.clear();
+    }
+    if (response) {
+        *response = stream.Finish();
+    }
+}
+
 AsyncResponse Session::GetAsync() {
-    auto shared_this = shared_from_this();
-    return async([shared_this]() { return shared_this->Get(); });
+    return makeRetriedRequestAsync(&Session::PrepareGet);
 }
 
 AsyncResponse Session::DeleteAsync() {
-    return async([shared_this = GetSharedPtrFromThis()]() { return shared_this->Delete(); });
+    return makeRetriedRequestAsync(&Session::PrepareDelete);
 }
 
 AsyncResponse Session::DownloadAsync(const WriteCallback& write) {
-    return async([shared_this = GetSharedPtrFromThis(), write]() { return shared_this->Download(write); });
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis(), write]() { return shared_this->Download(write); });
 }
 
 AsyncResponse Session::DownloadAsync(std::ofstream& file) {
-    return async([shared_this = GetSharedPtrFromThis(), &file]() { return shared_this->Download(file); });
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis(), &file]() { return shared_this->Download(file); });
+}
+
+AsyncResponse Session::DownloadAsync(FileSink& sink) {
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis(), &sink]() { return shared_this->Download(sink); });
 }
 
 AsyncResponse Session::HeadAsync() {
-    return async([shared_this = GetSharedPtrFromThis()]() { return shared_this->Head(); });
+    return makeRetriedRequestAsync(&Session::PrepareHead);
 }
 
 AsyncResponse Session::OptionsAsync() {
-    return async([shared_this = GetSharedPtrFromThis()]() { return shared_this->Options(); });
+    return makeRetriedRequestAsync(&Session::PrepareOptions);
 }
 
 AsyncResponse Session::PatchAsync() {
-    return async([shared_this = GetSharedPtrFromThis()]() { return shared_this->Patch(); });
+    return makeRetriedRequestAsync(&Session::PreparePatch);
 }
 
 AsyncResponse Session::PostAsync() {
-    return async([shared_this = GetSharedPtrFromThis()]() { return shared_this->Post(); });
+    return makeRetriedRequestAsync(&Session::PreparePost);
 }
 
 AsyncResponse Session::PutAsync() {
-    return async([shared_this = GetSharedPtrFromThis()]() { return shared_this->Put(); });
+    return makeRetriedRequestAsync(&Session::PreparePut);
 }
 
 // Functions with coroutines.
 coroutine::Task<cpr::Response> Session::CoGetAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Get(); })();
+    return coMakeRetriedRequest(&Session::PrepareGet);
 }
 
 coroutine::Task<cpr::Response> Session::CoDeleteAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Delete(); })();
+    return coMakeRetriedRequest(&Session::PrepareDelete);
 }
 
 coroutine::Task<cpr::Response> Session::CoDownloadAsync(const WriteCallback& write)
@@ -875,41 +1702,55 @@ coroutine::Task<cpr::Response> Session::CoDownloadAsync(std::ofstream& file)
     co_return ([shared_this = GetSharedPtrFromThis(), &file]() { return shared_this->Download(file); })();
 }
 
+coroutine::Task<cpr::Response> Session::CoDownloadAsync(FileSink& sink)
+{
+    co_return ([shared_this = GetSharedPtrFromThis(), &sink]() { return shared_this->Download(sink); })();
+}
+
 coroutine::Task<cpr::Response> Session::CoPostAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Post(); })();
+    return coMakeRetriedRequest(&Session::PreparePost);
 }
 
 coroutine::Task<cpr::Response> Session::CoHeadAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Head(); })();
+    return coMakeRetriedRequest(&Session::PrepareHead);
 }
 
 coroutine::Task<cpr::Response> Session::CoOptionsAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Options(); })();
+    return coMakeRetriedRequest(&Session::PrepareOptions);
 }
 
 coroutine::Task<cpr::Response> Session::CoPatchAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Patch(); })();
+    return coMakeRetriedRequest(&Session::PreparePatch);
 }
 
 coroutine::Task<cpr::Response> Session::CoPutAsync()
 {
-    co_return ([shared_this = GetSharedPtrFromThis()]() { return shared_this->Put(); })();
+    return coMakeRetriedRequest(&Session::PreparePut);
 }
 
 std::shared_ptr<CurlHolder> Session::GetCurlHolder() {
     return curl_;
 }
 
+std::string_view Session::GetHttpMethod() const {
+    return http_method_;
+}
+
+bool Session::IsDownload() const {
+    return download_;
+}
+
 std::string Session::GetFullRequestUrl() {
     const std::string parametersContent = parameters_.GetContent(*curl_);
     return url_.str() + (parametersContent.empty() ? "" : "?") + parametersContent;
 }
 
 void Session::PrepareDelete() {
+    http_method_ = "DELETE";
     curl_easy_setopt(curl_->handle, CURLOPT_HTTPGET, 0L);
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
     curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, "DELETE");
@@ -917,6 +1758,7 @@ void Session::PrepareDelete() {
 }
 
 void Session::PrepareGet() {
+    http_method_ = "GET";
     // In case there is a body or payload for this request, we create a custom GET-Request since a
     // GET-Request with body is based on the HTTP RFC **not** a leagal request.
     if (hasBodyOrPayload()) {
@@ -931,24 +1773,30 @@ void Session::PrepareGet() {
 }
 
 void Session::PrepareHead() {
+    http_method_ = "HEAD";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, nullptr);
     prepareCommon();
+    // HEAD responses announce the Content-Length of a body that never arrives
+    response_string_reserve_data_.body = nullptr;
 }
 
 void Session::PrepareOptions() {
+    http_method_ = "OPTIONS";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
     curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, "OPTIONS");
     prepareCommon();
 }
 
 void Session::PreparePatch() {
+    http_method_ = "PATCH";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
     curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, "PATCH");
     prepareCommon();
 }
 
 void Session::PreparePost() {
+    http_method_ = "POST";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
 
     // In case there is no body or payload set it to an empty post:
@@ -962,6 +1810,7 @@ void Session::PreparePost() {
 }
 
 void Session::PreparePut() {
+    http_method_ = "PUT";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
     if (!hasBodyOrPayload() && cbs_->readcb_.callback) {
         /**
@@ -977,19 +1826,36 @@ void Session::PreparePut() {
 }
 
 void Session::PrepareDownload(std::ofstream& file) {
+    http_method_ = "GET";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
     curl_easy_setopt(curl_->handle, CURLOPT_HTTPGET, 1);
     curl_easy_setopt(curl_->handle, CURLOPT_WRITEFUNCTION, cpr::util::writeFileFunction);
     curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &file);
     curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, nullptr);
+    file_sink_ = nullptr;
+
+    prepareCommonDownload();
+}
+
+void Session::PrepareDownload(FileSink& sink) {
+    http_method_ = "GET";
+    curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(curl_->handle, CURLOPT_HTTPGET, 1);
+    curl_easy_setopt(curl_->handle, CURLOPT_WRITEFUNCTION, cpr::util::writeFileSinkFunction);
+    curl_easy_setopt(curl_->handle, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, nullptr);
+    sink.begin(curl_->handle);
+    file_sink_ = &sink;
 
     prepareCommonDownload();
 }
 
 void Session::PrepareDownload(const WriteCallback& write) {
+    http_method_ = "GET";
     curl_easy_setopt(curl_->handle, CURLOPT_NOBODY, 0L);
     curl_easy_setopt(curl_->handle, CURLOPT_HTTPGET, 1);
     curl_easy_setopt(curl_->handle, CURLOPT_CUSTOMREQUEST, nullptr);
+    file_sink_ = nullptr;
 
     SetWriteCallback(write);
 
@@ -997,16 +1863,27 @@ void Session::PrepareDownload(const WriteCallback& write) {
 }
 
 Response Session::Complete(CURLcode curl_error) {
+    const AllocationPhaseScope allocation_phase{AllocationPhase::COMPLETE};
     curl_slist* raw_cookies{nullptr};
     curl_easy_getinfo(curl_->handle, CURLINFO_COOKIELIST, &raw_cookies);
     Cookies cookies = util::parseCookies(raw_cookies);
     curl_slist_free_all(raw_cookies);
 
     std::string errorMsg = curl_->error.data();
-    return Response(curl_, std::move(response_string_), std::move(header_string_), std::move(cookies), Error(curl_error, std::move(errorMsg)));
+    Response response(curl_, std::move(response_string_), std::move(header_string_), std::move(cookies), Error(curl_error, std::move(errorMsg)));
+    if (chunk_allocator_) {
+        response.chunked_body = std::move(chunked_body_);
+        chunked_body_ = ChunkedBody{};
+    }
+    recordEndpoint(response);
+    if (trace_) {
+        endTrace(response, true);
+    }
+    return response;
 }
 
 Response Session::CompleteDownload(CURLcode curl_error) {
+    const AllocationPhaseScope allocation_phase{AllocationPhase::COMPLETE};
     if (!cbs_->headercb_.callback) {
         curl_easy_setopt(curl_->handle, CURLOPT_HEADERFUNCTION, nullptr);
         curl_easy_setopt(curl_->handle, CURLOPT_HEADERDATA, 0);
@@ -1018,7 +1895,22 @@ Response Session::CompleteDownload(CURLcode curl_error) {
     curl_slist_free_all(raw_cookies);
     std::string errorMsg = curl_->error.data();
 
-    return Response(curl_, "", std::move(header_string_), std::move(cookies), Error(curl_error, std::move(errorMsg)));
+    if (file_sink_) {
+        // Write out whatever is still buffered inside the sink and sync it if requested:
+        const bool sink_finished = file_sink_->Finish();
+        file_sink_ = nullptr;
+        if (!sink_finished && curl_error == CURLE_OK) {
+            curl_error = CURLE_WRITE_ERROR;
+            errorMsg = "Failed writing the downloaded data to the file sink";
+        }
+    }
+
+    Response response(curl_, "", std::move(header_string_), std::move(cookies), Error(curl_error, std::move(errorMsg)));
+    recordEndpoint(response);
+    if (trace_) {
+        endTrace(response, true);
+    }
+    return response;
 }
 
 void Session::AddInterceptor(const std::shared_ptr<Interceptor>& pinterceptor) {
@@ -1029,12 +1921,19 @@ void Session::AddInterceptor(const std::shared_ptr<Interceptor>& pinterceptor) {
 }
 
 Response Session::proceed() {
+    if (download_) {
+        // Keeps writing to the target of the download instead of the response string
+        prepareCommonDownload();
+        return makeDownloadRequest();
+    }
     prepareCommon();
     return makeRequest();
 }
 
 const std::optional<Response> Session::intercept() {
-    if (current_interceptor_ == interceptors_.end()) {
+    // Interceptors may answer without proceeding the chain. Start over with the next request in that case.
+    const bool outermost = current_interceptor_ == interceptors_.end();
+    if (outermost) {
         current_interceptor_ = first_interceptor_;
     } else {
         ++current_interceptor_;
@@ -1046,9 +1945,23 @@ const std::optional<Response> Session::intercept() {
         first_interceptor_ = current_interceptor_;
         ++first_interceptor_;
 
+        // The interceptor may complete the attempt and start the next one, so its span belongs to the current attempt
+        const std::optional<TraceContext> trace_parent = trace_ ? std::make_optional(trace_->context) : std::nullopt;
+        const std::chrono::system_clock::time_point trace_start = trace_parent ? std::chrono::system_clock::now() : std::chrono::system_clock::time_point{};
+
         const std::optional<Response> r = (*current_interceptor_)->intercept(*this);
 
+        if (trace_parent) {
+            emitTraceSpan(SpanKind::INTERCEPTOR, *trace_parent, trace_start, std::chrono::system_clock::now());
+        }
         first_interceptor_ = icpt;
+        if (outermost) {
+            current_interceptor_ = interceptors_.end();
+            if (r && trace_) {
+                // Answered without proceeding
+                endTrace(*r, false);
+            }
+        }
 
         return r;
     }
@@ -1126,6 +2039,14 @@ void Session::prepareBodyPayloadOrMultipart() const {
 // clang-format off
 void Session::SetOption(const Resolve& resolve) { SetResolve(resolve); }
 void Session::SetOption(const std::vector<Resolve>& resolves) { SetResolves(resolves); }
+void Session::SetOption(const DnsCache& dns_cache) { SetDnsCache(dns_cache); }
+void Session::SetOption(const TlsSessionStore& store) { SetTlsSessionStore(store); }
+void Session::SetOption(const RetryPolicy& retry_policy) { SetRetryPolicy(retry_policy); }
+void Session::SetOption(const HedgePolicy& hedge_policy) { SetHedgePolicy(hedge_policy); }
+void Session::SetOption(const CircuitBreaker& circuit_breaker) { SetCircuitBreaker(circuit_breaker); }
+void Session::SetOption(const RateLimiter& rate_limiter) { SetRateLimiter(rate_limiter); }
+void Session::SetOption(const EndpointGroup& endpoint_group) { SetEndpointGroup(endpoint_group); }
+void Session::SetOption(const Tracer& tracer) { SetTracer(tracer); }
 void Session::SetOption(const ReadCallback& read) { SetReadCallback(read); }
 void Session::SetOption(const HeaderCallback& header) { SetHeaderCallback(header); }
 void Session::SetOption(const WriteCallback& write) { SetWriteCallback(write); }
@@ -1138,6 +2059,7 @@ void Session::SetOption(Parameters&& parameters) { SetParameters(std::move(param
 void Session::SetOption(const Header& header) { SetHeader(header); }
 void Session::SetOption(const Timeout& timeout) { SetTimeout(timeout); }
 void Session::SetOption(const ConnectTimeout& timeout) { SetConnectTimeout(timeout); }
+void Session::SetOption(const Deadline& deadline) { SetDeadline(deadline); }
 void Session::SetOption(const Authentication& auth) { SetAuth(auth); }
 void Session::SetOption(const LimitRate& limit_rate) { SetLimitRate(limit_rate); }
 // Only supported with libcurl >= 7.61.0.
@@ -1172,6 +2094,10 @@ void Session::SetOption(const HttpVersion& version) { SetHttpVersion(version); }
 void Session::SetOption(const Range& range) { SetRange(range); }
 void Session::SetOption(const MultiRange& multi_range) { SetMultiRange(multi_range); }
 void Session::SetOption(const ReserveSize& reserve_size) { SetReserveSize(reserve_size.size); }
+void Session::SetOption(const AutoReserveSize& auto_reserve_size) { SetAutoReserveSize(auto_reserve_size); }
+void Session::SetOption(const ResponseBufferPool& pool) { SetResponseBufferPool(pool); }
+void Session::SetOption(const ChunkAllocator& allocator) { SetChunkAllocator(allocator); }
+void Session::SetOption(const SingleFlight& single_flight) { SetSingleFlight(single_flight); }
 void Session::SetOption(const AcceptEncoding& accept_encoding) { SetAcceptEncoding(accept_encoding); }
 void Session::SetOption(AcceptEncoding&& accept_encoding) { SetAcceptEncoding(std::move(accept_encoding)); }
 void Session::SetOption(const ConnectionPool& pool) { SetConnectionPool(pool); }
@@ -0,0 +1,84 @@
+#include "cpr/single_flight.h"
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cpr/cprtypes.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+SingleFlight::SingleFlight(std::vector<std::string> key_header_fields) : state_(std::make_shared<State>()) {
+    state_->key_header_fields = std::move(key_header_fields);
+}
+
+std::string SingleFlight::GetKey(std::string_view method, const std::string& url, const Header& header) const {
+    std::string key{method};
+    key += ' ';
+    key += url;
+    for (const std::string& name : state_->key_header_fields) {
+        const Header::const_iterator it = header.find(name);
+        key += '\n';
+        // Distinguish a missing field from an empty one
+        if (it == header.end()) {
+            key += '!';
+            key += name;
+        } else {
+            key += name;
+            key += ':';
+            key += it->second;
+        }
+    }
+    return key;
+}
+
+Response SingleFlight::Do(const std::string& key, const std::function<Response()>& transfer) const {
+    std::promise<Response> promise;
+    std::shared_future<Response> pending;
+    {
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        const auto it = state_->calls.find(key);
+        if (it != state_->calls.end()) {
+            ++state_->metrics.coalesced;
+            pending = it->second;
+        } else {
+            state_->calls.emplace(key, promise.get_future().share());
+            ++state_->metrics.transfers;
+            ++state_->metrics.in_flight;
+        }
+    }
+    if (pending.valid()) {
+        return pending.get();
+    }
+
+    const auto finish = [this, &key]() {
+        // Requests arriving from now on start a new transfer
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->calls.erase(key);
+        --state_->metrics.in_flight;
+    };
+    try {
+        Response response = transfer();
+        finish();
+        promise.set_value(response);
+        return response;
+    } catch (...) {
+        finish();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+SingleFlight::Metrics SingleFlight::GetMetrics() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->metrics;
+}
+
+} // namespace cpr
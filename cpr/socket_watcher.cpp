@@ -0,0 +1,120 @@
+#include "cpr/socket_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <curl/curl.h>
+
+namespace cpr {
+
+namespace {
+#if LIBCURL_VERSION_NUM < 0x074400 // 7.68.0
+// Without curl_multi_wakeup() new watchers only get picked up once the current wait times out
+constexpr std::chrono::milliseconds MAX_WAIT{10};
+#endif
+} // namespace
+
+CPR_SINGLETON_IMPL(SocketWatcher)
+
+SocketWatcher::SocketWatcher() : thread_([this]() { run(); }) {}
+
+SocketWatcher::~SocketWatcher() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    wakeup();
+    thread_.join();
+}
+
+void SocketWatcher::Watch(std::vector<curl_waitfd> fds, std::chrono::milliseconds timeout, std::function<void()> task) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        watchers_.push_back(Watcher{std::move(fds), Clock::now() + timeout, std::move(task)});
+    }
+    cond_.notify_one();
+    wakeup();
+}
+
+void SocketWatcher::wakeup() {
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+    // Interrupts a running curl_multi_poll(), else makes the next one return right away
+    curl_multi_wakeup(multicurl_.handle);
+#endif
+}
+
+void SocketWatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (watchers_.empty()) {
+            cond_.wait(lock);
+            continue;
+        }
+
+        // Watchers only get removed by this thread, so the first ones still match the polled sockets afterwards
+        const size_t watched = watchers_.size();
+        std::vector<curl_waitfd> fds;
+        Clock::time_point due_time = Clock::time_point::max();
+        for (const Watcher& watcher : watchers_) {
+            fds.insert(fds.end(), watcher.fds.begin(), watcher.fds.end());
+            due_time = std::min(due_time, watcher.due_time);
+        }
+        lock.unlock();
+
+        std::chrono::milliseconds timeout = std::max(std::chrono::ceil<std::chrono::milliseconds>(due_time - Clock::now()), std::chrono::milliseconds{0});
+#if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
+#if LIBCURL_VERSION_NUM < 0x074400  // 7.68.0
+        timeout = std::min(timeout, MAX_WAIT);
+#endif
+        const CURLMcode error_code = curl_multi_poll(multicurl_.handle, fds.data(), static_cast<unsigned int>(fds.size()), static_cast<int>(timeout.count()), nullptr);
+#else
+        timeout = std::min(timeout, MAX_WAIT);
+        CURLMcode error_code{CURLM_OK};
+        if (fds.empty()) {
+            // curl_multi_wait() returns right away without anything to wait for
+            std::this_thread::sleep_for(timeout);
+        } else {
+            error_code = curl_multi_wait(multicurl_.handle, fds.data(), static_cast<unsigned int>(fds.size()), static_cast<int>(timeout.count()), nullptr);
+        }
+#endif
+        if (error_code) {
+            // Fires all watchers below, so their owners poll the transfer themselves and run into the error
+            std::cerr << "curl_multi_poll() failed, code " << static_cast<int>(error_code) << '\n';
+        }
+
+        lock.lock();
+        const Clock::time_point now = Clock::now();
+        std::vector<Watcher> pending;
+        std::vector<std::function<void()>> ready;
+        size_t offset{0};
+        for (size_t i = 0; i < watchers_.size(); ++i) {
+            Watcher& watcher = watchers_[i];
+            bool fired = error_code != CURLM_OK || now >= watcher.due_time;
+            if (i < watched) {
+                fired = fired || std::any_of(fds.begin() + static_cast<std::ptrdiff_t>(offset), fds.begin() + static_cast<std::ptrdiff_t>(offset + watcher.fds.size()), [](const curl_waitfd& fd) { return fd.revents != 0; });
+                offset += watcher.fds.size();
+            }
+            if (fired) {
+                ready.push_back(std::move(watcher.task));
+            } else {
+                pending.push_back(std::move(watcher));
+            }
+        }
+        watchers_ = std::move(pending);
+        lock.unlock();
+        for (const std::function<void()>& task : ready) {
+            task();
+        }
+        lock.lock();
+    }
+}
+
+} // namespace cpr
@@ -1,10 +1,23 @@
 
 #include "cpr/ssl_ctx.h"
 #include "cpr/ssl_options.h"
+#include "cpr/tls_session_store.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <curl/curl.h>
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 #if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
 
@@ -58,26 +71,31 @@ using custom_unique_ptr = std::unique_ptr<T, deleter_from_fn<fn>>;
 using x509_ptr = custom_unique_ptr<X509, X509_free>;
 using bio_ptr = custom_unique_ptr<BIO, BIO_free>;
 
-CURLcode sslctx_function_load_ca_cert_from_buffer(CURL* /*curl*/, void* sslctx, void* raw_cert_buf) {
-    // Check arguments
-    if (raw_cert_buf == nullptr || sslctx == nullptr) {
-        std::cerr << "Invalid callback arguments!\n";
-        return CURLE_ABORTED_BY_CALLBACK;
+CaCertificates::~CaCertificates() {
+    for (X509* cert : certificates_) {
+        X509_free(cert);
     }
+}
 
-    // Create a memory BIO using the data of cert_buf
-    // Note: It is assumed, that cert_buf is nul terminated and its length is determined by strlen
-    char* cert_buf = static_cast<char*>(raw_cert_buf);
-    BIO* bio = BIO_new_mem_buf(cert_buf, -1);
+std::shared_ptr<const CaCertificates> CaCertificates::Get(const std::string& buffer) {
+    // Parsed buffers stay cached as long as a session uses them
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const CaCertificates>> cache;
 
-    // Get a pointer to the current certificate verification storage
-    X509_STORE* store = SSL_CTX_get_cert_store(static_cast<SSL_CTX*>(sslctx));
-    if (store == nullptr) {
-        std::cerr << "SSL_CTX_get_cert_store failed!\n";
-        ERR_print_errors_fp(stderr);
-        BIO_free(bio);
-        return CURLE_ABORTED_BY_CALLBACK;
+    const std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto it = cache.begin(); it != cache.end();) {
+        it = it->second.expired() ? cache.erase(it) : std::next(it);
     }
+    const auto it = cache.find(buffer);
+    if (it != cache.end()) {
+        if (std::shared_ptr<const CaCertificates> certificates = it->second.lock()) {
+            return certificates;
+        }
+    }
+
+    std::shared_ptr<CaCertificates> certificates = std::make_shared<CaCertificates>();
+    // Create a memory BIO using the data of the buffer
+    const bio_ptr bio{BIO_new_mem_buf(buffer.data(), static_cast<int>(buffer.size()))};
 
     // Load the PEM formatted certicifate into an X509 structure which OpenSSL can use
     // PEM_read_bio_X509 can read multiple certificates from the same buffer in a loop.
@@ -96,43 +114,256 @@ CURLcode sslctx_function_load_ca_cert_from_buffer(CURL* /*curl*/, void* sslctx,
     //    ... base64 data ...
     //    -----END CERTIFICATE-----
     //
-    size_t certs_loaded = 0;
     X509* cert = nullptr;
-    while ((cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) != nullptr) {
-        const int status = X509_STORE_add_cert(store, cert);
-        // Fail if any loaded cert is invalid
-        if (status == 0) {
-            std::cerr << "[CPR] while adding certificate to store\n";
-            ERR_print_errors_fp(stderr);
-            BIO_free(bio);
-            return CURLE_ABORTED_BY_CALLBACK;
-        }
-        certs_loaded++;
-        // Free cert so we can load another one
-        X509_free(cert);
-        cert = nullptr;
+    while ((cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) != nullptr) {
+        certificates->certificates_.push_back(cert);
     }
 
     // NOLINTNEXTLINE(google-runtime-int) Ignored here since it is an API return value
     const unsigned long err = ERR_peek_last_error();
-    if (certs_loaded == 0 && err != 0) {
+    if (err != 0) {
         // Check if the error is just EOF or an actual parsing error
         if (ERR_GET_LIB(err) == ERR_LIB_PEM && ERR_GET_REASON(err) == PEM_R_NO_START_LINE) {
-            // This is expected if the buffer was empty or contains no valid
-            // PEM certs
-            std::cerr << "No PEM certificates found or end of stream\n";
+            if (certificates->certificates_.empty()) {
+                // This is expected if the buffer was empty or contains no valid
+                // PEM certs
+                std::cerr << "No PEM certificates found or end of stream\n";
+            }
         } else {
-            std::cerr << "PEM_read_bio_X509 failed after loading " << certs_loaded << " certificates\n";
+            // A malformed certificate stops reading, so the ones following it would be missing silently
+            std::cerr << "PEM_read_bio_X509 failed after loading " << certificates->certificates_.size() << " certificates\n";
+            ERR_print_errors_fp(stderr);
+            certificates->valid_ = false;
+        }
+    }
+    // Reading until the end of the buffer always leaves an error behind
+    ERR_clear_error();
+
+    cache[buffer] = certificates;
+    return certificates;
+}
+
+CURLcode CaCertificates::AddTo(void* sslctx) const {
+    if (!valid_) {
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+
+    // Get a pointer to the current certificate verification storage
+    X509_STORE* store = SSL_CTX_get_cert_store(static_cast<SSL_CTX*>(sslctx));
+    if (store == nullptr) {
+        std::cerr << "SSL_CTX_get_cert_store failed!\n";
+        ERR_print_errors_fp(stderr);
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+
+    for (X509* cert : certificates_) {
+        // Only takes a reference, the certificate does not get copied
+        const int status = X509_STORE_add_cert(store, cert);
+        // Fail if any loaded cert is invalid
+        if (status == 0) {
+            std::cerr << "[CPR] while adding certificate to store\n";
             ERR_print_errors_fp(stderr);
-            BIO_free(bio);
             return CURLE_ABORTED_BY_CALLBACK;
         }
     }
 
-    // Free the entire bio chain
-    BIO_free(bio);
+    // The CA certificates were added successfully to the verification storage
+    return CURLE_OK;
+}
+
+namespace {
+// Number of buffers the legacy callback keeps parsed in between handshakes
+constexpr size_t kRetainedLegacyCaCertificates = 16;
+
+/**
+ * The legacy callback has nothing owning the certificates it parsed, so they would expire from the cache of
+ * CaCertificates::Get() right after each handshake. Keeps the ones of the most recently used buffers alive.
+ **/
+std::shared_ptr<const CaCertificates> retainLegacyCaCertificates(std::shared_ptr<const CaCertificates> certificates) {
+    static std::mutex retained_mutex;
+    static std::deque<std::shared_ptr<const CaCertificates>> retained;
 
-    // The CA certificate was loaded successfully into the verification storage
+    const std::lock_guard<std::mutex> lock(retained_mutex);
+    const auto it = std::find(retained.begin(), retained.end(), certificates);
+    if (it != retained.end()) {
+        retained.erase(it);
+    }
+    retained.push_front(std::move(certificates));
+    if (retained.size() > kRetainedLegacyCaCertificates) {
+        retained.pop_back();
+    }
+    return retained.front();
+}
+} // namespace
+
+CURLcode sslctx_function_load_ca_cert_from_buffer(CURL* /*curl*/, void* sslctx, void* raw_cert_buf) {
+    // Check arguments
+    if (raw_cert_buf == nullptr || sslctx == nullptr) {
+        std::cerr << "Invalid callback arguments!\n";
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+
+    // Note: It is assumed, that cert_buf is nul terminated and its length is determined by strlen
+    const char* cert_buf = static_cast<const char*>(raw_cert_buf);
+    return retainLegacyCaCertificates(CaCertificates::Get(cert_buf))->AddTo(sslctx);
+}
+
+namespace {
+using new_session_cb_t = int (*)(SSL*, SSL_SESSION*);
+
+/**
+ * Attached to the SSL_CTX of each connection using a TlsSessionStore.
+ **/
+struct SessionStoreCtxData {
+    TlsSessionStore store;
+    // "host:port#context" the connection goes to, see SslCtxCallbackData::session_context
+    std::string key;
+};
+
+// State of a single handshake, attached to the SSL object
+enum class HandshakeState : intptr_t { STARTED = 1, OFFERED = 2, DONE = 3 };
+
+// The new session callback libcurl installed for its own session cache. Called after storing the session.
+std::atomic<new_session_cb_t> curl_new_session_cb{nullptr};
+
+void freeSessionStoreCtxData(void* /*parent*/, void* ptr, CRYPTO_EX_DATA* /*ad*/, int /*idx*/, long /*argl*/, void* /*argp*/) { // NOLINT(google-runtime-int) Defined by OpenSSL
+    delete static_cast<SessionStoreCtxData*>(ptr);
+}
+
+int getCtxDataIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, freeSessionStoreCtxData);
+    return index;
+}
+
+int getHandshakeStateIndex() {
+    static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+SessionStoreCtxData* getSessionStoreCtxData(const SSL* ssl) {
+    return static_cast<SessionStoreCtxData*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), getCtxDataIndex()));
+}
+
+std::optional<std::string> getSessionKey(CURL* curl, uint64_t context) {
+#if LIBCURL_VERSION_NUM >= 0x073E00 // 7.62.0
+    char* url = nullptr;
+    if (curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url) != CURLE_OK || url == nullptr) {
+        return std::nullopt;
+    }
+    CURLU* handle = curl_url();
+    if (handle == nullptr) {
+        return std::nullopt;
+    }
+    std::optional<std::string> key;
+    char* host = nullptr;
+    char* port = nullptr;
+    if (curl_url_set(handle, CURLUPART_URL, url, 0) == CURLUE_OK && curl_url_get(handle, CURLUPART_HOST, &host, 0) == CURLUE_OK && curl_url_get(handle, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+        std::array<char, 17> hex{};
+        std::snprintf(hex.data(), hex.size(), "%016" PRIx64, context);
+        key = std::string{host} + ':' + port + '#' + hex.data();
+    }
+    curl_free(host);
+    curl_free(port);
+    curl_url_cleanup(handle);
+    return key;
+#else
+    return std::nullopt;
+#endif
+}
+
+int storeNewSession(SSL* ssl, SSL_SESSION* session) {
+    const SessionStoreCtxData* data = getSessionStoreCtxData(ssl);
+    if (data != nullptr) {
+        const int size = i2d_SSL_SESSION(session, nullptr);
+        if (size > 0) {
+            std::string der(static_cast<size_t>(size), '\0');
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            unsigned char* out = reinterpret_cast<unsigned char*>(der.data());
+            i2d_SSL_SESSION(session, &out);
+            const std::chrono::seconds expire_time{static_cast<int64_t>(SSL_SESSION_get_time(session)) + static_cast<int64_t>(SSL_SESSION_get_timeout(session))};
+            data->store.Put(data->key, std::move(der), TlsSessionStore::Clock::time_point{expire_time});
+        }
+    }
+    // Returning 1 means the callback took over the reference, which only libcurl's callback does
+    const new_session_cb_t next = curl_new_session_cb.load();
+    return next != nullptr ? next(ssl, session) : 0;
+}
+
+void sessionStoreInfoCallback(const SSL* ssl, int where, int /*ret*/) {
+    const SessionStoreCtxData* data = getSessionStoreCtxData(ssl);
+    if (data == nullptr) {
+        return;
+    }
+    // The info callback only gets a const SSL, but the SSL object is owned by libcurl and not const at all
+    SSL* mutable_ssl = const_cast<SSL*>(ssl); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    const int state_index = getHandshakeStateIndex();
+    if ((where & SSL_CB_HANDSHAKE_START) != 0 && SSL_get_ex_data(ssl, state_index) == nullptr) {
+        HandshakeState state = HandshakeState::STARTED;
+        // libcurl may already have set a session from its own cache. This is still early enough to offer one in the ClientHello.
+        if (SSL_get_session(ssl) == nullptr) {
+            const std::optional<std::string> der = data->store.Get(data->key);
+            if (der) {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                const unsigned char* in = reinterpret_cast<const unsigned char*>(der->data());
+                SSL_SESSION* session = d2i_SSL_SESSION(nullptr, &in, static_cast<long>(der->size())); // NOLINT(google-runtime-int) Defined by OpenSSL
+                if (session != nullptr) {
+                    if (SSL_set_session(mutable_ssl, session) == 1) {
+                        state = HandshakeState::OFFERED;
+                    }
+                    SSL_SESSION_free(session);
+                }
+            }
+        }
+        SSL_set_ex_data(mutable_ssl, state_index, reinterpret_cast<void*>(state)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+    } else if ((where & SSL_CB_HANDSHAKE_DONE) != 0) {
+        // With TLS 1.3 this also fires for every session ticket received after the handshake
+        const auto state = static_cast<HandshakeState>(reinterpret_cast<intptr_t>(SSL_get_ex_data(ssl, state_index))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        if (state == HandshakeState::STARTED || state == HandshakeState::OFFERED) {
+            data->store.RecordHandshake(state == HandshakeState::OFFERED, SSL_session_reused(mutable_ssl) == 1);
+            SSL_set_ex_data(mutable_ssl, state_index, reinterpret_cast<void*>(HandshakeState::DONE)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+        }
+    }
+}
+
+CURLcode setupSessionStore(CURL* curl, SSL_CTX* ctx, const TlsSessionStore& store, uint64_t context) {
+    const std::optional<std::string> key = getSessionKey(curl, context);
+    if (!key) {
+        // Without knowing where the connection goes, sessions could end up being offered to the wrong server
+        return CURLE_OK;
+    }
+    const new_session_cb_t current = SSL_CTX_sess_get_new_cb(ctx);
+    if (current != storeNewSession) {
+        if (current != nullptr) {
+            curl_new_session_cb.store(current);
+        }
+        SSL_CTX_set_session_cache_mode(ctx, SSL_CTX_get_session_cache_mode(ctx) | SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(ctx, storeNewSession);
+    }
+    const int index = getCtxDataIndex();
+    delete static_cast<SessionStoreCtxData*>(SSL_CTX_get_ex_data(ctx, index));
+    if (SSL_CTX_set_ex_data(ctx, index, new SessionStoreCtxData{store, *key}) != 1) {
+        return CURLE_OUT_OF_MEMORY;
+    }
+    SSL_CTX_set_info_callback(ctx, sessionStoreInfoCallback);
+    return CURLE_OK;
+}
+} // namespace
+
+CURLcode sslctx_function(CURL* curl, void* sslctx, void* data) {
+    if (sslctx == nullptr || data == nullptr) {
+        std::cerr << "Invalid callback arguments!\n";
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+    const SslCtxCallbackData* ctx_data = static_cast<const SslCtxCallbackData*>(data);
+    if (ctx_data->ca_certificates) {
+        const CURLcode result = ctx_data->ca_certificates->AddTo(sslctx);
+        if (result != CURLE_OK) {
+            return result;
+        }
+    }
+    if (ctx_data->session_store != nullptr) {
+        return setupSessionStore(curl, static_cast<SSL_CTX*>(sslctx), *ctx_data->session_store, ctx_data->session_context);
+    }
     return CURLE_OK;
 }
 
@@ -141,3 +372,10 @@ CURLcode sslctx_function_load_ca_cert_from_buffer(CURL* /*curl*/, void* sslctx,
 #endif // OPENSSL_BACKEND_USED
 
 #endif // SUPPORT_CURLOPT_SSL_CTX_FUNCTION
+
+#if !SUPPORT_CURLOPT_SSL_CTX_FUNCTION || !defined(OPENSSL_BACKEND_USED)
+namespace cpr {
+// Without OpenSSL there are never any certificates to free
+CaCertificates::~CaCertificates() = default;
+} // namespace cpr
+#endif
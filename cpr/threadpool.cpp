@@ -4,9 +4,12 @@
 #include <cstddef>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include <utility>
 
+#include "cpr/executor.h"
+
 namespace cpr {
 
 ThreadPool::ThreadPool(size_t min_threads, size_t max_threads, std::chrono::milliseconds max_idle_ms) : min_thread_num(min_threads), max_thread_num(max_threads), max_idle_time(max_idle_ms) {}
@@ -15,6 +18,58 @@ ThreadPool::~ThreadPool() {
     Stop();
 }
 
+void ThreadPool::Execute(Task task) {
+    CoSubmit(std::move(task));
+}
+
+void ThreadPool::ExecuteWithPriority(Task task, Priority priority) {
+    CoSubmit(std::move(task), priority);
+}
+
+void ThreadPool::SetMaxQueueDelay(std::chrono::milliseconds ms) {
+    const std::lock_guard<std::mutex> locker(task_mutex);
+    max_queue_delay = ms;
+}
+
+void ThreadPool::SetMaxRunning(Priority priority, size_t max_running) {
+    {
+        const std::lock_guard<std::mutex> locker(task_mutex);
+        lanes[static_cast<size_t>(priority)].max_running = std::max<size_t>(max_running, 1);
+    }
+    // Raising the limit may allow queued tasks to run
+    task_cond.notify_all();
+}
+
+size_t ThreadPool::GetQueuedTaskNum(Priority priority) {
+    const std::lock_guard<std::mutex> locker(task_mutex);
+    return lanes[static_cast<size_t>(priority)].tasks.size();
+}
+
+std::optional<size_t> ThreadPool::NextLane() const {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::optional<size_t> next;
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        const Lane& lane = lanes[i];
+        if (lane.tasks.empty() || lane.running >= lane.max_running) {
+            continue;
+        }
+        if (!next) {
+            next = i;
+            continue;
+        }
+        // Starvation protection: a lower priority task waiting for too long overtakes the younger ones
+        const std::chrono::steady_clock::time_point queued_at = lane.tasks.front().queued_at;
+        if (now - queued_at > max_queue_delay && queued_at < lanes[*next].tasks.front().queued_at) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+bool ThreadPool::HasQueuedTasks() const {
+    return std::any_of(lanes.begin(), lanes.end(), [](const Lane& lane) { return !lane.tasks.empty(); });
+}
+
 int ThreadPool::Start(size_t start_threads) {
     if (status != STOP) {
         return -1;
@@ -22,7 +77,7 @@ int ThreadPool::Start(size_t start_threads) {
     status = RUNNING;
     start_threads = std::clamp(start_threads, min_thread_num, max_thread_num);
     for (size_t i = 0; i < start_threads; ++i) {
-        CreateThread();
+        CreateThread(true);
     }
     return 0;
 }
@@ -67,7 +122,7 @@ int ThreadPool::Resume() {
 
 int ThreadPool::Wait() const {
     while (true) {
-        if (status == STOP || (tasks.empty() && idle_thread_num == cur_thread_num)) {
+        if (status == STOP || (!HasQueuedTasks() && idle_thread_num == cur_thread_num)) {
             break;
         }
         std::this_thread::yield();
@@ -75,12 +130,15 @@ int ThreadPool::Wait() const {
     return 0;
 }
 
-bool ThreadPool::CreateThread() {
+bool ThreadPool::CreateThread(bool idle) {
     if (cur_thread_num >= max_thread_num) {
         return false;
     }
-    auto thread = std::make_shared<std::thread>([this] {
-        bool initialRun = true;
+    if (idle) {
+        ++idle_thread_num;
+    }
+    auto thread = std::make_shared<std::thread>([this, idle] {
+        bool initialRun = !idle;
         while (status != STOP) {
             {
                 std::unique_lock status_lock(status_wait_mutex);
@@ -88,13 +146,20 @@ bool ThreadPool::CreateThread() {
             }
 
             Task task;
+            Lane* lane{nullptr};
             {
                 std::unique_lock<std::mutex> locker(task_mutex);
-                task_cond.wait_for(locker, std::chrono::milliseconds(max_idle_time), [this]() { return status == STOP || !tasks.empty(); });
+                task_cond.wait_for(locker, std::chrono::milliseconds(max_idle_time), [this]() { return status == STOP || NextLane().has_value(); });
                 if (status == STOP) {
                     return;
                 }
-                if (tasks.empty()) {
+                const std::optional<size_t> next = NextLane();
+                if (!next) {
+                    if (initialRun) {
+                        // Created for a task another thread took or one of a lane at its limit, idle from now on
+                        ++idle_thread_num;
+                        initialRun = false;
+                    }
                     if (cur_thread_num > min_thread_num) {
                         DelThread(std::this_thread::get_id());
                         return;
@@ -104,14 +169,21 @@ bool ThreadPool::CreateThread() {
                 if (!initialRun) {
                     --idle_thread_num;
                 }
-                task = std::move(tasks.front());
-                tasks.pop();
+                lane = &lanes[*next];
+                task = std::move(lane->tasks.front().task);
+                lane->tasks.pop();
+                ++lane->running;
             }
             if (task) {
                 task();
                 ++idle_thread_num;
                 initialRun = false;
             }
+            {
+                // Frees the slot of the lane, NextLane() runs under the same lock
+                const std::lock_guard<std::mutex> locker(task_mutex);
+                --lane->running;
+            }
         }
     });
     AddThread(thread);
@@ -0,0 +1,53 @@
+#include "cpr/timer_queue.h"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace cpr {
+
+CPR_SINGLETON_IMPL(TimerQueue)
+
+TimerQueue::TimerQueue() : thread_([this]() { run(); }) {}
+
+TimerQueue::~TimerQueue() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void TimerQueue::Schedule(Clock::time_point due_time, std::function<void()> task) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        timers_.push(Timer{due_time, next_sequence_++, std::move(task)});
+    }
+    cond_.notify_one();
+}
+
+void TimerQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (timers_.empty()) {
+            cond_.wait(lock);
+            continue;
+        }
+        const Clock::time_point due_time = timers_.top().due_time;
+        if (Clock::now() < due_time) {
+            // Wakes up early in case an earlier timer gets scheduled in the meantime
+            cond_.wait_until(lock, due_time);
+            continue;
+        }
+        // priority_queue::top() is const, the task gets moved out anyway since the timer is popped right after
+        std::function<void()> task = std::move(const_cast<Timer&>(timers_.top()).task); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        timers_.pop();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+} // namespace cpr
@@ -0,0 +1,209 @@
+#include "cpr/tls_session_store.h"
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "cpr/filesystem.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cpr {
+
+namespace {
+constexpr std::array<char, 8> kStoreMagic{'C', 'P', 'R', 'T', 'L', 'S', '0', '1'};
+// Keys and sessions are tiny. Anything larger means the file is not a session file.
+constexpr uint32_t kMaxFieldSize = 64 * 1024;
+
+void writeUint(std::string& data, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+bool readUint(std::ifstream& file, uint64_t& value, size_t bytes) {
+    value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        const int c = file.get();
+        if (c == std::ifstream::traits_type::eof()) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(c)) << (8 * i);
+    }
+    return true;
+}
+
+void writeField(std::string& data, const std::string& field) {
+    writeUint(data, field.size(), sizeof(uint32_t));
+    data += field;
+}
+
+bool readField(std::ifstream& file, std::string& field) {
+    uint64_t size{0};
+    if (!readUint(file, size, sizeof(uint32_t)) || size > kMaxFieldSize) {
+        return false;
+    }
+    field.resize(static_cast<size_t>(size));
+    return static_cast<bool>(file.read(field.data(), static_cast<std::streamsize>(size)));
+}
+
+// Creates a new file only the owner may read and write, and syncs the data to disk before closing it
+bool writePrivateFile(const fs::path& path, const std::string& data) {
+#ifdef _WIN32
+    int fd{-1};
+    _wsopen_s(&fd, path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _SH_DENYRW, _S_IREAD | _S_IWRITE);
+#else
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+#endif
+    if (fd < 0) {
+        return false;
+    }
+    bool success{true};
+    size_t written{0};
+    while (success && written < data.size()) {
+#ifdef _WIN32
+        const int result = _write(fd, data.data() + written, static_cast<unsigned int>(data.size() - written));
+#else
+        const ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+#endif
+        if (result < 0) {
+            success = errno == EINTR;
+            continue;
+        }
+        written += static_cast<size_t>(result);
+    }
+#ifdef _WIN32
+    success = success && _commit(fd) == 0;
+    success = _close(fd) == 0 && success;
+#else
+    success = success && fsync(fd) == 0;
+    success = ::close(fd) == 0 && success;
+#endif
+    return success;
+}
+} // namespace
+
+TlsSessionStore::TlsSessionStore() : state_(std::make_shared<State>()) {}
+
+void TlsSessionStore::Put(const std::string& key, std::string session, Clock::time_point expire_time) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->entries[key] = Entry{std::move(session), expire_time};
+    ++state_->metrics.stored;
+}
+
+std::optional<std::string> TlsSessionStore::Get(const std::string& key) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    const auto it = state_->entries.find(key);
+    if (it == state_->entries.end()) {
+        return std::nullopt;
+    }
+    if (it->second.expire_time <= Clock::now()) {
+        state_->entries.erase(it);
+        return std::nullopt;
+    }
+    return it->second.session;
+}
+
+bool TlsSessionStore::Save(const fs::path& path) const {
+    // Write to a temporary file first, so a crash never leaves a truncated store behind
+    std::string data{kStoreMagic.data(), kStoreMagic.size()};
+    {
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        const Clock::time_point now = Clock::now();
+        for (const auto& [key, entry] : state_->entries) {
+            if (entry.expire_time <= now) {
+                continue;
+            }
+            writeField(data, key);
+            writeField(data, entry.session);
+            writeUint(data, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(entry.expire_time.time_since_epoch()).count()), sizeof(uint64_t));
+        }
+    }
+
+    fs::path tmp_path{path};
+    tmp_path += ".tmp";
+    std::error_code error;
+    // Left behind by a crash during an earlier Save()
+    fs::remove(tmp_path, error);
+    if (!writePrivateFile(tmp_path, data)) {
+        fs::remove(tmp_path, error);
+        return false;
+    }
+    fs::rename(tmp_path, path, error);
+    if (error) {
+        fs::remove(tmp_path, error);
+        return false;
+    }
+    return true;
+}
+
+bool TlsSessionStore::Load(const fs::path& path) const {
+    std::ifstream file{path, std::ios::binary};
+    std::array<char, kStoreMagic.size()> magic{};
+    if (!file.read(magic.data(), magic.size()) || magic != kStoreMagic) {
+        return false;
+    }
+
+    const Clock::time_point now = Clock::now();
+    std::string key;
+    std::string session;
+    uint64_t expire_seconds{0};
+    while (file.peek() != std::ifstream::traits_type::eof()) {
+        if (!readField(file, key) || !readField(file, session) || !readUint(file, expire_seconds, sizeof(uint64_t))) {
+            return false;
+        }
+        const Clock::time_point expire_time{std::chrono::seconds{static_cast<int64_t>(expire_seconds)}};
+        if (expire_time <= now) {
+            continue;
+        }
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        // Sessions received in the meantime are newer than the saved ones
+        state_->entries.try_emplace(key, Entry{session, expire_time});
+    }
+    return true;
+}
+
+void TlsSessionStore::Clear() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->entries.clear();
+}
+
+size_t TlsSessionStore::GetEntryCount() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->entries.size();
+}
+
+TlsSessionStore::Metrics TlsSessionStore::GetMetrics() const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->metrics;
+}
+
+void TlsSessionStore::RecordHandshake(bool offered, bool resumed) const {
+    const std::lock_guard<std::mutex> lock(state_->mutex);
+    ++state_->metrics.handshakes;
+    if (offered) {
+        ++state_->metrics.offered;
+    }
+    if (resumed) {
+        ++state_->metrics.resumed;
+    }
+}
+
+} // namespace cpr
@@ -0,0 +1,123 @@
+#include "cpr/tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace cpr {
+
+namespace {
+constexpr std::string_view kHexDigits{"0123456789abcdef"};
+
+template <size_t Size>
+void appendHex(std::string& out, const std::array<uint8_t, Size>& bytes) {
+    for (const uint8_t byte : bytes) {
+        out += kHexDigits[byte >> 4];
+        out += kHexDigits[byte & 0x0F];
+    }
+}
+
+int parseHexDigit(char c) {
+    const size_t pos = kHexDigits.find(c);
+    return pos == std::string_view::npos ? -1 : static_cast<int>(pos);
+}
+
+template <size_t Size>
+bool parseHex(std::string_view hex, std::array<uint8_t, Size>& bytes) {
+    if (hex.size() != Size * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < Size; ++i) {
+        const int high = parseHexDigit(hex[i * 2]);
+        const int low = parseHexDigit(hex[(i * 2) + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        bytes[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    // All zero ids are invalid
+    return std::any_of(bytes.begin(), bytes.end(), [](uint8_t byte) { return byte != 0; });
+}
+
+template <size_t Size>
+void fillRandom(std::array<uint8_t, Size>& bytes) {
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    for (size_t i = 0; i < Size; i += sizeof(uint64_t)) {
+        uint64_t value = generator();
+        for (size_t j = i; j < std::min(Size, i + sizeof(uint64_t)); ++j) {
+            bytes[j] = static_cast<uint8_t>(value);
+            value >>= 8;
+        }
+    }
+}
+} // namespace
+
+std::string TraceContext::ToTraceparent() const {
+    std::string traceparent{"00-"};
+    traceparent.reserve(55);
+    appendHex(traceparent, trace_id);
+    traceparent += '-';
+    appendHex(traceparent, span_id);
+    traceparent += '-';
+    appendHex(traceparent, std::array<uint8_t, 1>{flags});
+    return traceparent;
+}
+
+std::optional<TraceContext> TraceContext::FromTraceparent(std::string_view traceparent) {
+    // version "-" trace-id "-" parent-id "-" trace-flags. Later versions may append further fields.
+    if (traceparent.size() < 55 || traceparent[2] != '-' || traceparent[35] != '-' || traceparent[52] != '-' || (traceparent.size() > 55 && traceparent[55] != '-')) {
+        return std::nullopt;
+    }
+    std::array<uint8_t, 1> version{};
+    std::array<uint8_t, 1> flags{};
+    TraceContext context;
+    // parseHex() rejects all zero values, thus version 00 and flags 00 get checked on their own
+    const std::string_view version_hex = traceparent.substr(0, 2);
+    const bool version_valid = version_hex == "00" ? traceparent.size() == 55 : (parseHex(version_hex, version) && version[0] != 0xFF);
+    if (!version_valid || !parseHex(traceparent.substr(3, 32), context.trace_id) || !parseHex(traceparent.substr(36, 16), context.span_id)) {
+        return std::nullopt;
+    }
+    const std::string_view flags_hex = traceparent.substr(53, 2);
+    if (flags_hex != "00" && !parseHex(flags_hex, flags)) {
+        return std::nullopt;
+    }
+    context.flags = flags[0];
+    return context;
+}
+
+TraceContext TraceContext::Generate(const std::optional<TraceContext>& parent) {
+    TraceContext context;
+    if (parent) {
+        context.trace_id = parent->trace_id;
+        context.flags = parent->flags;
+    } else {
+        fillRandom(context.trace_id);
+    }
+    fillRandom(context.span_id);
+    return context;
+}
+
+Tracer::Tracer(std::shared_ptr<TraceSink> sink, std::optional<TraceContext> parent, bool propagate) : sink_(std::move(sink)), parent_(parent), propagate_(propagate) {}
+
+const std::optional<TraceContext>& Tracer::GetParent() const {
+    return parent_;
+}
+
+bool Tracer::Propagates() const {
+    return propagate_;
+}
+
+void Tracer::Emit(const Span& span) const {
+    if (sink_) {
+        sink_->OnSpan(span);
+    }
+}
+
+} // namespace cpr
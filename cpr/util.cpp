@@ -1,12 +1,15 @@
 #include "cpr/util.h"
 #include "cpr/callback.h"
+#include "cpr/chunked_body.h"
 #include "cpr/cookies.h"
 #include "cpr/cprtypes.h"
 #include "cpr/curlholder.h"
+#include "cpr/file_sink.h"
 #include "cpr/secure_string.h"
 #include "cpr/sse.h"
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <chrono>
 #include <cstdint>
 #include <ctime>
@@ -15,6 +18,8 @@
 #include <ios>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <type_traits>
 #include <vector>
 
@@ -142,12 +147,50 @@ size_t writeFunction(char* ptr, size_t size, size_t nmemb, void* data) {
     return size;
 }
 
+size_t writeHeaderReserveFunction(char* ptr, size_t size, size_t nmemb, ResponseStringReserveData* data) {
+    size *= nmemb;
+    data->header->append(ptr, size);
+
+    if (data->body == nullptr || data->max_reserve == 0) {
+        return size;
+    }
+    constexpr std::string_view content_length{"content-length:"};
+    const std::string_view line{ptr, size};
+    if (line.size() <= content_length.size() || !std::equal(content_length.begin(), content_length.end(), line.begin(), [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) {
+        return size;
+    }
+
+    std::string_view value = line.substr(content_length.size());
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    // In case of a compressed body this is only the encoded size. Still a good lower bound to start with.
+    size_t length{0};
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::from_chars_result result = std::from_chars(value.data(), value.data() + value.size(), length);
+    if (result.ec == std::errc{} && length > 0) {
+        data->body->reserve(std::min(length, data->max_reserve));
+    }
+    return size;
+}
+
+size_t writeChunkedBodyFunction(char* ptr, size_t size, size_t nmemb, ChunkedBody* body) {
+    size *= nmemb;
+    body->Append({ptr, size});
+    return size;
+}
+
 size_t writeFileFunction(char* ptr, size_t size, size_t nmemb, std::ofstream* file) {
     size *= nmemb;
     file->write(ptr, static_cast<std::streamsize>(size));
     return size;
 }
 
+size_t writeFileSinkFunction(char* ptr, size_t size, size_t nmemb, FileSink* sink) {
+    size *= nmemb;
+    return sink->Write({ptr, size}) ? size : 0;
+}
+
 size_t writeUserFunction(char* ptr, size_t size, size_t nmemb, const WriteCallback* write) {
     size *= nmemb;
     return (*write)({ptr, size}) ? size : 0;
@@ -159,7 +202,7 @@ size_t writeSSEFunction(char* ptr, size_t size, size_t nmemb, ServerSentEventCal
 }
 
 int debugUserFunction(CURL* /*handle*/, curl_infotype type, char* data, size_t size, const DebugCallback* debug) {
-    (*debug)(static_cast<DebugCallback::InfoType>(type), std::string(data, size));
+    (*debug)(static_cast<DebugCallback::InfoType>(type), std::string_view{data, size});
     return 0;
 }
 
@@ -218,4 +261,12 @@ time_t sTimestampToT(const std::string& st) {
     return static_cast<time_t>(std::stoll(st));
 }
 
+uint64_t fnv1a(std::string_view data, uint64_t hash) {
+    for (const char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 } // namespace cpr::util
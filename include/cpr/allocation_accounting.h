@@ -0,0 +1,103 @@
+#ifndef CPR_ALLOCATION_ACCOUNTING_H
+#define CPR_ALLOCATION_ACCOUNTING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace cpr {
+
+/**
+ * Phase of a request the allocations of a thread get attributed to.
+ **/
+enum class AllocationPhase : uint8_t {
+    // Everything outside of the phases below, e.g. setting options or copying responses
+    OTHER,
+    // Constructing the session and its curl handle
+    SESSION,
+    // Setting up the curl handle for the request, e.g. the header list and the encoded parameters
+    PREPARE,
+    // Running the transfer, including the write and header callbacks
+    TRANSFER,
+    // Building the Response, e.g. parsing the header and the cookies
+    COMPLETE,
+};
+
+constexpr size_t kAllocationPhaseCount = static_cast<size_t>(AllocationPhase::COMPLETE) + 1;
+
+struct AllocationCounters {
+    uint64_t allocations{0};
+    // Bytes requested, frees are not subtracted
+    uint64_t bytes{0};
+};
+
+struct AllocationStats {
+    std::array<AllocationCounters, kAllocationPhaseCount> phases{};
+
+    [[nodiscard]] const AllocationCounters& operator[](AllocationPhase phase) const;
+    [[nodiscard]] AllocationCounters Total() const;
+};
+
+/**
+ * Counts the heap allocations of the calling thread and attributes them to the AllocationPhase it is in.
+ *
+ * Only counts in case cpr got built with CPR_ALLOCATION_ACCOUNTING. That build replaces the global operator new and
+ * delete and installs counting memory callbacks for libcurl (curl_global_init_mem()), so curl allocations get counted
+ * as well, unless curl got initialized before the first cpr session was created.
+ * Otherwise IsEnabled() returns false, the recorder stays at zero and the phase scopes compile to nothing.
+ *
+ * Example:
+ * cpr::AllocationRecorder recorder;
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/hello.html"});
+ * uint64_t prepare_allocations = recorder.GetStats()[cpr::AllocationPhase::PREPARE].allocations;
+ **/
+class AllocationRecorder {
+  public:
+    AllocationRecorder();
+
+    [[nodiscard]] static bool IsEnabled();
+    /**
+     * Allocations of the calling thread since the recorder got constructed or reset.
+     * Has to be called on the thread that constructed the recorder.
+     **/
+    [[nodiscard]] AllocationStats GetStats() const;
+    void Reset();
+
+  private:
+    AllocationStats start_;
+};
+
+/**
+ * Attributes the allocations of the calling thread to the phase until it goes out of scope.
+ **/
+class AllocationPhaseScope {
+  public:
+#ifdef CPR_ALLOCATION_ACCOUNTING
+    explicit AllocationPhaseScope(AllocationPhase phase);
+    ~AllocationPhaseScope();
+#else
+    explicit AllocationPhaseScope(AllocationPhase /*phase*/) {}
+    ~AllocationPhaseScope() = default;
+#endif
+    AllocationPhaseScope(const AllocationPhaseScope&) = delete;
+    AllocationPhaseScope(AllocationPhaseScope&&) = delete;
+    AllocationPhaseScope& operator=(const AllocationPhaseScope&) = delete;
+    AllocationPhaseScope& operator=(AllocationPhaseScope&&) = delete;
+
+#ifdef CPR_ALLOCATION_ACCOUNTING
+  private:
+    AllocationPhase previous_;
+#endif
+};
+
+namespace util {
+/**
+ * Installs the counting memory callbacks for libcurl. Has to be called before curl gets initialized.
+ * Does nothing without CPR_ALLOCATION_ACCOUNTING.
+ **/
+void installCurlAllocationHooks();
+} // namespace util
+
+} // namespace cpr
+
+#endif
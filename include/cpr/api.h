@@ -100,7 +100,9 @@ void setup_multiasync(std::vector<AsyncWrapper<Response, true>>& responses, T&&
         apply_set_option(s, std::forward<T>(params));
         return std::invoke(SessionAction, s);
     }};
-    responses.emplace_back(GlobalThreadPool::GetInstance()->Submit(std::move(execFn), std::forward<T>(parameters)), std::move(cancellation_state));
+    std::shared_ptr<AsyncState> state = std::make_shared<AsyncState>();
+    std::future<Response> future = submit(*GetDefaultExecutor(), Priority::Normal, state, std::move(execFn), std::forward<T>(parameters));
+    responses.emplace_back(std::move(future), std::move(cancellation_state), std::move(state));
 }
 
 template <session_action_t SessionAction, typename T, typename... Ts>
@@ -268,6 +270,14 @@ Response Download(std::ofstream& file, Ts&&... ts) {
     return session.Download(file);
 }
 
+// Download into a file sink
+template <typename... Ts>
+Response Download(FileSink& sink, Ts&&... ts) {
+    Session session;
+    priv::set_option(session, std::forward<Ts>(ts)...);
+    return session.Download(sink);
+}
+
 // Download async method
 template <typename... Ts>
 AsyncResponse DownloadAsync(fs::path local_path, Ts... ts) {
@@ -280,6 +290,18 @@ AsyncResponse DownloadAsync(fs::path local_path, Ts... ts) {
             std::move(local_path), std::move(ts)...)};
 }
 
+// Download async method writing through a FileSink created for the given path
+template <typename... Ts>
+AsyncResponse DownloadAsync(fs::path local_path, FileSinkOptions options, Ts... ts) {
+    return AsyncWrapper{std::async(
+            std::launch::async,
+            [](fs::path local_path_, FileSinkOptions options_, Ts... ts_) {
+                FileSink sink(local_path_, options_);
+                return Download(sink, std::move(ts_)...);
+            },
+            std::move(local_path), options, std::move(ts)...)};
+}
+
 // Download with user callback
 template <typename... Ts>
 Response Download(const WriteCallback& write, Ts&&... ts) {
@@ -1,7 +1,14 @@
 #ifndef CPR_ASYNC_H
 #define CPR_ASYNC_H
 
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
 #include "async_wrapper.h"
+#include "executor.h"
 #include "singleton.h"
 #include "threadpool.h"
 
@@ -16,21 +23,79 @@ class GlobalThreadPool : public ThreadPool {
     ~GlobalThreadPool() override = default;
 };
 
+/**
+ * Sets the executor running the asynchronous work of everything without an executor of its own, e.g. cpr::GetAsync()
+ * or sessions without Session::SetExecutor(). nullptr restores the GlobalThreadPool.
+ **/
+void SetDefaultExecutor(std::shared_ptr<Executor> executor);
+/**
+ * Returns the executor set via SetDefaultExecutor() or the GlobalThreadPool.
+ **/
+std::shared_ptr<Executor> GetDefaultExecutor();
+
+namespace priv {
+/**
+ * Same as Executor::Submit(), but completes the state right after the future got ready, which runs the continuation
+ * registered via AsyncWrapper::then(), when_all() or when_any() on the executor thread.
+ **/
+template <class Fn, class... Args>
+auto submit(Executor& executor, Priority priority, std::shared_ptr<AsyncState> state, Fn&& fn, Args&&... args) {
+  using RetType = decltype(fn(args...));
+  auto task = std::make_shared<std::packaged_task<RetType()>>([fn = std::forward<Fn>(fn), args...]() mutable { return std::invoke(fn, args...); });
+  std::future<RetType> future = task->get_future();
+  executor.ExecuteWithPriority(
+      [task, state = std::move(state)] {
+        (*task)();
+        state->Complete();
+      },
+      priority);
+  return future;
+}
+} // namespace priv
+
+/**
+ * Same as async(fn, args...), but runs fn on the given executor with the given priority (see ThreadPool).
+ **/
+template <bool isCancellable = false, class Fn, class... Args>
+auto async(Executor& executor, Priority priority, Fn&& fn, Args&&... args) {
+  std::shared_ptr<priv::AsyncState> state = std::make_shared<priv::AsyncState>();
+  std::future future = priv::submit(executor, priority, state, std::forward<Fn>(fn), std::forward<Args>(args)...);
+  using async_wrapper_t = AsyncWrapper<decltype(future.get()), isCancellable>;
+  if constexpr (isCancellable) {
+    return async_wrapper_t{std::move(future), std::make_shared<std::atomic_bool>(false), std::move(state)};
+  } else {
+    return async_wrapper_t{std::move(future), std::move(state)};
+  }
+}
+
+/**
+ * Same as async(fn, args...), but runs fn on the given executor.
+ **/
+template <bool isCancellable = false, class Fn, class... Args>
+  requires(!std::is_same_v<std::remove_cvref_t<Fn>, Priority>)
+auto async(Executor& executor, Fn&& fn, Args&&... args) {
+  return async<isCancellable>(executor, Priority::Normal, std::forward<Fn>(fn), std::forward<Args>(args)...);
+}
+
 /**
  * Return a wrapper for a future, calling future.get() will wait until the task is done and return RetType.
+ * Runs fn on the default executor (see SetDefaultExecutor()).
  * async(fn, args...)
  * async(std::bind(&Class::mem_fn, &obj))
  * async(std::mem_fn(&Class::mem_fn, &obj))
  **/
 template <bool isCancellable = false, class Fn, class... Args>
+  requires(!std::is_base_of_v<Executor, std::remove_cvref_t<Fn>> && !std::is_same_v<std::remove_cvref_t<Fn>, Priority>)
 auto async(Fn&& fn, Args&&... args) {
-  std::future future = GlobalThreadPool::GetInstance()->Submit(std::forward<Fn>(fn), std::forward<Args>(args)...);
-  using async_wrapper_t = AsyncWrapper<decltype(future.get()), isCancellable>;
-  if constexpr (isCancellable) {
-    return async_wrapper_t{std::move(future), std::make_shared<std::atomic_bool>(false)};
-  } else {
-    return async_wrapper_t{std::move(future)};
-  }
+  return async<isCancellable>(*GetDefaultExecutor(), Priority::Normal, std::forward<Fn>(fn), std::forward<Args>(args)...);
+}
+
+/**
+ * Same as async(fn, args...), but runs fn with the given priority (see ThreadPool).
+ **/
+template <bool isCancellable = false, class Fn, class... Args>
+auto async(Priority priority, Fn&& fn, Args&&... args) {
+  return async<isCancellable>(*GetDefaultExecutor(), priority, std::forward<Fn>(fn), std::forward<Args>(args)...);
 }
 
 class async {
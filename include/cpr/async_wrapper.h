@@ -2,12 +2,115 @@
 #define CPR_ASYNC_WRAPPER_H
 
 #include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace cpr {
 enum class [[nodiscard]] CancellationResult : uint8_t { failure, success, invalid_operation };
 
+template <typename T, bool isCancellable>
+class AsyncWrapper;
+
+namespace priv {
+
+/**
+ * State shared by the producer of an AsyncWrapper and the wrapper.
+ * The producer calls Complete() right after making the future ready, which runs the continuation registered by
+ * AsyncWrapper::then(), when_all() or when_any() on the producing thread. No thread has to wait in get() for it.
+ **/
+class AsyncState {
+  public:
+    using Callback = std::function<void()>;
+
+    /**
+     * Runs the callback once Complete() got called, right away on the calling thread in case it already was.
+     * Holds a single continuation, since continuing an AsyncWrapper consumes it.
+     **/
+    void OnComplete(Callback callback);
+    void Complete();
+
+    /**
+     * Runs the callback on Cancel(), right away in case the state already got cancelled.
+     * Continuations register the cancellation of the wrappers they wait on, so cancelling walks up the chain.
+     **/
+    void OnCancel(Callback callback);
+    void Cancel();
+
+  private:
+    std::mutex mutex_;
+    bool completed_{false};
+    bool cancelled_{false};
+    Callback continuation_;
+    std::vector<Callback> cancellations_;
+};
+
+/**
+ * Runs the waiter on a detached thread.
+ * Fallback for continuing wrappers of a plain std::future, which have no AsyncState telling about their completion.
+ **/
+void wait_in_background(std::function<void()> waiter);
+
+/**
+ * std::promise completing its AsyncState once the value or exception is set.
+ **/
+template <typename T>
+class AsyncPromise {
+  public:
+    std::future<T> get_future() {
+        return promise_.get_future();
+    }
+
+    [[nodiscard]] const std::shared_ptr<AsyncState>& GetState() const {
+        return state_;
+    }
+
+    template <typename... Value>
+    void set_value(Value&&... value) {
+        promise_.set_value(std::forward<Value>(value)...);
+        state_->Complete();
+    }
+
+    void set_exception(std::exception_ptr exception) {
+        promise_.set_exception(std::move(exception));
+        state_->Complete();
+    }
+
+    /**
+     * Sets the result of fn() or the exception it throws.
+     **/
+    template <typename Fn>
+    void set_from(Fn&& fn) {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                std::forward<Fn>(fn)();
+                promise_.set_value();
+            } else {
+                promise_.set_value(std::forward<Fn>(fn)());
+            }
+        } catch (...) {
+            promise_.set_exception(std::current_exception());
+        }
+        state_->Complete();
+    }
+
+  private:
+    std::promise<T> promise_;
+    std::shared_ptr<AsyncState> state_{std::make_shared<AsyncState>()};
+};
+
+struct AsyncWrapperAccess;
+
+} // namespace priv
+
 /**
  * A class template intended to wrap results of async operations (instances of std::future<T>)
  * and also provide extended capablilities relaed to these requests, for example cancellation.
@@ -17,11 +120,22 @@ enum class [[nodiscard]] CancellationResult : uint8_t { failure, success, invali
 template <typename T, bool isCancellable = false>
 class AsyncWrapper;
 
+/**
+ * Result of when_any(): the index of the first wrapper that completed and its value.
+ **/
+template <typename T>
+struct WhenAnyResult {
+    size_t index;
+    T value;
+};
+
 template <typename T>
 class AsyncWrapper<T, false> {
   private:
     friend class AsyncWrapper<T, true>;
+    friend struct priv::AsyncWrapperAccess;
     std::future<T> future;
+    std::shared_ptr<priv::AsyncState> state;
 
     void throw_if_invalid(const char* error) const {
         if (!future.valid()) {
@@ -33,6 +147,7 @@ class AsyncWrapper<T, false> {
     // Constructors
     AsyncWrapper() = default;
     explicit AsyncWrapper(std::future<T>&& f) : future{std::move(f)} {}
+    AsyncWrapper(std::future<T>&& f, std::shared_ptr<priv::AsyncState> s) : future{std::move(f)}, state{std::move(s)} {}
 
     // Copy Semantics
     AsyncWrapper(const AsyncWrapper&) = delete;
@@ -75,11 +190,26 @@ class AsyncWrapper<T, false> {
     std::shared_future<T> share() noexcept {
         return future.share();
     }
+
+    /**
+     * Returns a wrapper for the result of fn(get()), or fn() for a void T.
+     * fn runs on the thread completing this wrapper, e.g. the executor thread that finished the request, or right away
+     * on the calling thread in case this already completed. No thread waits for it in between.
+     * In case fn returns an AsyncWrapper itself, the returned wrapper completes once that one does.
+     * An exception of this wrapper gets passed on without calling fn.
+     *
+     * Consumes this wrapper, so valid() is false afterwards.
+     * Example:
+     * cpr::GetAsync(url).then([](cpr::Response response) { return cpr::PostAsync(other_url, cpr::Body{response.text}); });
+     **/
+    template <typename Fn>
+    auto then(Fn&& fn);
 };
 
 template <typename T>
 class AsyncWrapper<T, true> : public AsyncWrapper<T, false> {
   private:
+    friend struct priv::AsyncWrapperAccess;
     using base = AsyncWrapper<T, false>;
     std::shared_ptr<std::atomic_bool> is_cancelled;
 
@@ -92,6 +222,7 @@ class AsyncWrapper<T, true> : public AsyncWrapper<T, false> {
   public:
     // Constructors
     AsyncWrapper(std::future<T>&& f, std::shared_ptr<std::atomic_bool>&& cancelledState) : base{std::move(f)}, is_cancelled{std::move(cancelledState)} {}
+    AsyncWrapper(std::future<T>&& f, std::shared_ptr<std::atomic_bool>&& cancelledState, std::shared_ptr<priv::AsyncState> s) : base{std::move(f), std::move(s)}, is_cancelled{std::move(cancelledState)} {}
 
     // Copy Semantics
     AsyncWrapper(const AsyncWrapper&) = delete;
@@ -105,6 +236,9 @@ class AsyncWrapper<T, true> : public AsyncWrapper<T, false> {
     ~AsyncWrapper() {
         if (is_cancelled) {
             is_cancelled->store(true);
+            if (base::state) {
+                base::state->Cancel();
+            }
         }
     }
 
@@ -140,12 +274,23 @@ class AsyncWrapper<T, true> : public AsyncWrapper<T, false> {
             return CancellationResult::invalid_operation;
         }
         is_cancelled->store(true);
+        // Cancels what a continuation waits on as well, e.g. the request it continues
+        if (base::state) {
+            base::state->Cancel();
+        }
         return CancellationResult::success;
     }
 
     [[nodiscard]] bool IsCancelled() const {
         return is_cancelled->load();
     }
+
+    /**
+     * Same as AsyncWrapper<T, false>::then(), but returns a cancellable wrapper.
+     * Cancelling it cancels this wrapper as well and fn does not get called anymore.
+     **/
+    template <typename Fn>
+    auto then(Fn&& fn);
 };
 
 // Deduction guides
@@ -155,6 +300,284 @@ AsyncWrapper(std::future<T>&&) -> AsyncWrapper<T, false>;
 template <typename T>
 AsyncWrapper(std::future<T>&&, std::shared_ptr<std::atomic_bool>&&) -> AsyncWrapper<T, true>;
 
+namespace priv {
+
+template <typename T>
+struct is_async_wrapper : std::false_type {};
+template <typename T, bool isCancellable>
+struct is_async_wrapper<AsyncWrapper<T, isCancellable>> : std::true_type {
+    using value_type = T;
+};
+
+template <typename T, typename Fn>
+struct continuation_result {
+    using type = std::invoke_result_t<std::decay_t<Fn>&, T>;
+};
+template <typename Fn>
+struct continuation_result<void, Fn> {
+    using type = std::invoke_result_t<std::decay_t<Fn>&>;
+};
+
+// The value type of the wrapper then() returns, unwrapping a returned AsyncWrapper
+template <typename Result>
+struct continuation_value {
+    using type = Result;
+};
+template <typename T, bool isCancellable>
+struct continuation_value<AsyncWrapper<T, isCancellable>> {
+    using type = T;
+};
+
+/**
+ * Implements the continuations of AsyncWrapper on its private members.
+ * Continuations only keep the future and the cancellation flag of the wrappers they wait on, never their AsyncState,
+ * so a continuation that never runs (e.g. because its executor dropped the task) does not keep itself alive.
+ **/
+struct AsyncWrapperAccess {
+    template <typename T>
+    struct Parts {
+        std::shared_ptr<std::future<T>> future;
+        std::shared_ptr<AsyncState> state;
+        std::shared_ptr<std::atomic_bool> cancelled;
+    };
+
+    // Takes the parts out of the wrapper, leaving it invalid without cancelling it
+    template <typename T, bool isCancellable>
+    static Parts<T> release(AsyncWrapper<T, isCancellable>& wrapper) {
+        AsyncWrapper<T, false>& base = wrapper;
+        base.throw_if_invalid("Continuing an AsyncWrapper when the associated future is invalid!");
+        Parts<T> parts{std::make_shared<std::future<T>>(std::move(base.future)), std::move(base.state), nullptr};
+        if constexpr (isCancellable) {
+            parts.cancelled = std::move(wrapper.is_cancelled);
+        }
+        return parts;
+    }
+
+    template <typename T>
+    static void on_ready(const Parts<T>& parts, AsyncState::Callback callback) {
+        if (parts.state) {
+            parts.state->OnComplete(std::move(callback));
+            return;
+        }
+        wait_in_background([future = parts.future, callback = std::move(callback)]() {
+            future->wait();
+            callback();
+        });
+    }
+
+    template <typename T>
+    static AsyncState::Callback canceller(const Parts<T>& parts) {
+        return [cancelled = parts.cancelled, state = std::weak_ptr<AsyncState>{parts.state}]() {
+            if (cancelled) {
+                cancelled->store(true);
+            }
+            if (const std::shared_ptr<AsyncState> locked = state.lock()) {
+                locked->Cancel();
+            }
+        };
+    }
+
+    template <bool isCancellable, typename T>
+    static AsyncWrapper<T, isCancellable> make_wrapper(AsyncPromise<T>& promise, std::shared_ptr<std::atomic_bool> cancelled) {
+        if constexpr (isCancellable) {
+            return AsyncWrapper<T, true>{promise.get_future(), std::move(cancelled), promise.GetState()};
+        } else {
+            return AsyncWrapper<T, false>{promise.get_future(), promise.GetState()};
+        }
+    }
+
+    static std::exception_ptr cancelled_error() {
+        return std::make_exception_ptr(std::logic_error{"The AsyncWrapper got cancelled before its continuation ran!"});
+    }
+
+    // Completes the promise with the result of the wrapper a continuation returned
+    template <typename T, bool isCancellable>
+    static void forward(AsyncWrapper<T, isCancellable>& wrapper, const std::shared_ptr<AsyncPromise<T>>& promise) {
+        Parts<T> parts = release(wrapper);
+        promise->GetState()->OnCancel(canceller(parts));
+        on_ready(parts, [future = parts.future, cancelled = parts.cancelled, promise]() {
+            if (cancelled && cancelled->load()) {
+                promise->set_exception(cancelled_error());
+                return;
+            }
+            promise->set_from([&future]() { return future->get(); });
+        });
+    }
+
+    template <bool isCancellable, typename T, typename Fn>
+    static auto then(AsyncWrapper<T, isCancellable>& wrapper, Fn&& fn) {
+        using Result = typename continuation_result<T, Fn>::type;
+        using Value = typename continuation_value<Result>::type;
+        Parts<T> parts = release(wrapper);
+        std::shared_ptr<AsyncPromise<Value>> promise = std::make_shared<AsyncPromise<Value>>();
+        std::shared_ptr<std::atomic_bool> cancelled;
+        if constexpr (isCancellable) {
+            cancelled = std::make_shared<std::atomic_bool>(false);
+            promise->GetState()->OnCancel(canceller(parts));
+        }
+        AsyncWrapper<Value, isCancellable> result = make_wrapper<isCancellable>(*promise, cancelled);
+        // Shared, since std::function requires a copyable callable and fn may be move-only
+        std::shared_ptr<std::decay_t<Fn>> shared_fn = std::make_shared<std::decay_t<Fn>>(std::forward<Fn>(fn));
+        on_ready(parts, [future = parts.future, promise, cancelled, shared_fn]() {
+            if (cancelled && cancelled->load()) {
+                promise->set_exception(cancelled_error());
+                return;
+            }
+            const auto invoke = [&future, &shared_fn]() -> Result {
+                if constexpr (std::is_void_v<T>) {
+                    future->get();
+                    return std::invoke(*shared_fn);
+                } else {
+                    return std::invoke(*shared_fn, future->get());
+                }
+            };
+            if constexpr (is_async_wrapper<Result>::value) {
+                std::optional<Result> inner;
+                try {
+                    inner.emplace(invoke());
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                    return;
+                }
+                forward(*inner, promise);
+            } else {
+                promise->set_from(invoke);
+            }
+        });
+        return result;
+    }
+
+    template <typename T, bool isCancellable>
+    static AsyncWrapper<std::vector<T>, isCancellable> when_all(std::vector<AsyncWrapper<T, isCancellable>>& wrappers) {
+        std::vector<Parts<T>> parts;
+        parts.reserve(wrappers.size());
+        for (AsyncWrapper<T, isCancellable>& wrapper : wrappers) {
+            parts.push_back(release(wrapper));
+        }
+        std::shared_ptr<AsyncPromise<std::vector<T>>> promise = std::make_shared<AsyncPromise<std::vector<T>>>();
+        std::shared_ptr<std::atomic_bool> cancelled;
+        if constexpr (isCancellable) {
+            cancelled = std::make_shared<std::atomic_bool>(false);
+            for (const Parts<T>& part : parts) {
+                promise->GetState()->OnCancel(canceller(part));
+            }
+        }
+        AsyncWrapper<std::vector<T>, isCancellable> result = make_wrapper<isCancellable>(*promise, cancelled);
+        if (parts.empty()) {
+            promise->set_value(std::vector<T>{});
+            return result;
+        }
+
+        std::shared_ptr<std::vector<std::shared_ptr<std::future<T>>>> futures = std::make_shared<std::vector<std::shared_ptr<std::future<T>>>>();
+        futures->reserve(parts.size());
+        for (const Parts<T>& part : parts) {
+            futures->push_back(part.future);
+        }
+        std::shared_ptr<std::atomic_size_t> pending = std::make_shared<std::atomic_size_t>(parts.size());
+        for (const Parts<T>& part : parts) {
+            on_ready(part, [futures, pending, promise, cancelled]() {
+                // The last one to complete collects the values of all futures, which are ready by now
+                if (pending->fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                    return;
+                }
+                if (cancelled && cancelled->load()) {
+                    promise->set_exception(cancelled_error());
+                    return;
+                }
+                promise->set_from([&futures]() {
+                    std::vector<T> values;
+                    values.reserve(futures->size());
+                    for (const std::shared_ptr<std::future<T>>& future : *futures) {
+                        values.push_back(future->get());
+                    }
+                    return values;
+                });
+            });
+        }
+        return result;
+    }
+
+    template <typename T, bool isCancellable>
+    static AsyncWrapper<WhenAnyResult<T>, isCancellable> when_any(std::vector<AsyncWrapper<T, isCancellable>>& wrappers) {
+        if (wrappers.empty()) {
+            throw std::logic_error{"Calling when_any without any AsyncWrapper!"};
+        }
+        std::vector<Parts<T>> parts;
+        parts.reserve(wrappers.size());
+        for (AsyncWrapper<T, isCancellable>& wrapper : wrappers) {
+            parts.push_back(release(wrapper));
+        }
+        std::shared_ptr<AsyncPromise<WhenAnyResult<T>>> promise = std::make_shared<AsyncPromise<WhenAnyResult<T>>>();
+        std::shared_ptr<std::atomic_bool> cancelled;
+        std::shared_ptr<std::vector<AsyncState::Callback>> cancellers = std::make_shared<std::vector<AsyncState::Callback>>();
+        if constexpr (isCancellable) {
+            cancelled = std::make_shared<std::atomic_bool>(false);
+            for (const Parts<T>& part : parts) {
+                cancellers->push_back(canceller(part));
+                promise->GetState()->OnCancel(cancellers->back());
+            }
+        }
+        AsyncWrapper<WhenAnyResult<T>, isCancellable> result = make_wrapper<isCancellable>(*promise, cancelled);
+
+        std::shared_ptr<std::atomic_bool> done = std::make_shared<std::atomic_bool>(false);
+        for (size_t index = 0; index < parts.size(); ++index) {
+            on_ready(parts[index], [future = parts[index].future, index, done, cancellers, promise, cancelled]() {
+                if (done->exchange(true)) {
+                    return;
+                }
+                // Nobody waits for the others anymore, just like for abandoned cancellable wrappers
+                for (size_t other = 0; other < cancellers->size(); ++other) {
+                    if (other != index) {
+                        (*cancellers)[other]();
+                    }
+                }
+                if (cancelled && cancelled->load()) {
+                    promise->set_exception(cancelled_error());
+                    return;
+                }
+                promise->set_from([&future, index]() { return WhenAnyResult<T>{index, future->get()}; });
+            });
+        }
+        return result;
+    }
+};
+
+} // namespace priv
+
+template <typename T>
+template <typename Fn>
+auto AsyncWrapper<T, false>::then(Fn&& fn) {
+    return priv::AsyncWrapperAccess::then<false>(*this, std::forward<Fn>(fn));
+}
+
+template <typename T>
+template <typename Fn>
+auto AsyncWrapper<T, true>::then(Fn&& fn) {
+    return priv::AsyncWrapperAccess::then<true>(*this, std::forward<Fn>(fn));
+}
+
+/**
+ * Returns a wrapper for the values of all wrappers, in the same order, once the last of them completed.
+ * Gets triggered by the completion of the last wrapper without a thread waiting for them.
+ * In case any of them failed, the returned wrapper holds the exception of the first failed one.
+ * Cancelling a cancellable result cancels all wrappers.
+ **/
+template <typename T, bool isCancellable>
+AsyncWrapper<std::vector<T>, isCancellable> when_all(std::vector<AsyncWrapper<T, isCancellable>> wrappers) {
+    return priv::AsyncWrapperAccess::when_all(wrappers);
+}
+
+/**
+ * Returns a wrapper for the index and value of the first wrapper that completes.
+ * The other cancellable wrappers get cancelled once the first one completes, since nobody waits for them anymore.
+ * Cancelling a cancellable result cancels all wrappers.
+ * Throws std::logic_error for an empty vector.
+ **/
+template <typename T, bool isCancellable>
+AsyncWrapper<WhenAnyResult<T>, isCancellable> when_any(std::vector<AsyncWrapper<T, isCancellable>> wrappers) {
+    return priv::AsyncWrapperAccess::when_any(wrappers);
+}
+
 } // namespace cpr
 
 
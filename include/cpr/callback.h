@@ -2,11 +2,14 @@
 #define CPR_CALLBACK_H
 
 #include "cprtypes.h"
+#include "inline_function.h"
 
 #include <atomic>
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 
 namespace cpr {
@@ -14,9 +17,13 @@ namespace cpr {
 class ReadCallback {
   public:
     ReadCallback() = default;
+    template <typename Callback>
+        requires std::is_invocable_r_v<bool, Callback&, char*, size_t&, intptr_t>
     // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
-    ReadCallback(std::function<bool(char* buffer, size_t& size, intptr_t userdata)> p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), size{-1}, callback{std::move(p_callback)} {}
-    ReadCallback(cpr_off_t p_size, std::function<bool(char* buffer, size_t& size, intptr_t userdata)> p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), size{p_size}, callback{std::move(p_callback)} {}
+    ReadCallback(Callback p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), size{-1}, callback{std::move(p_callback)} {}
+    template <typename Callback>
+        requires std::is_invocable_r_v<bool, Callback&, char*, size_t&, intptr_t>
+    ReadCallback(cpr_off_t p_size, Callback p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), size{p_size}, callback{std::move(p_callback)} {}
     bool operator()(char* buffer, size_t& buffer_size) const {
         if(!callback)
         {
@@ -27,14 +34,16 @@ class ReadCallback {
 
     intptr_t userdata{};
     cpr_off_t size{};
-    std::function<bool(char* buffer, size_t& size, intptr_t userdata)> callback;
+    InlineFunction<bool(char* buffer, size_t& size, intptr_t userdata)> callback;
 };
 
 class HeaderCallback {
   public:
     HeaderCallback() = default;
+    template <typename Callback>
+        requires std::is_invocable_r_v<bool, Callback&, std::string_view, intptr_t>
     // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
-    HeaderCallback(std::function<bool(std::string_view header, intptr_t userdata)> p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
+    HeaderCallback(Callback p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
     bool operator()(std::string_view header) const {
         if(!callback)
         {
@@ -44,14 +53,16 @@ class HeaderCallback {
     }
 
     intptr_t userdata{};
-    std::function<bool(std::string_view header, intptr_t userdata)> callback;
+    InlineFunction<bool(std::string_view header, intptr_t userdata)> callback;
 };
 
 class WriteCallback {
   public:
     WriteCallback() = default;
+    template <typename Callback>
+        requires std::is_invocable_r_v<bool, Callback&, std::string_view, intptr_t>
     // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
-    WriteCallback(std::function<bool(std::string_view data, intptr_t userdata)> p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
+    WriteCallback(Callback p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
     bool operator()(std::string_view data) const {
         if(!callback)
         {
@@ -61,14 +72,16 @@ class WriteCallback {
     }
 
     intptr_t userdata{};
-    std::function<bool(std::string_view data, intptr_t userdata)> callback;
+    InlineFunction<bool(std::string_view data, intptr_t userdata)> callback;
 };
 
 class ProgressCallback {
   public:
     ProgressCallback() = default;
+    template <typename Callback>
+        requires std::is_invocable_r_v<bool, Callback&, cpr_pf_arg_t, cpr_pf_arg_t, cpr_pf_arg_t, cpr_pf_arg_t, intptr_t>
     // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
-    ProgressCallback(std::function<bool(cpr_pf_arg_t downloadTotal, cpr_pf_arg_t downloadNow, cpr_pf_arg_t uploadTotal, cpr_pf_arg_t uploadNow, intptr_t userdata)> p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
+    ProgressCallback(Callback p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
     bool operator()(cpr_pf_arg_t downloadTotal, cpr_pf_arg_t downloadNow, cpr_pf_arg_t uploadTotal, cpr_pf_arg_t uploadNow) const {
         if(!callback)
         {
@@ -78,7 +91,7 @@ class ProgressCallback {
     }
 
     intptr_t userdata{};
-    std::function<bool(cpr_pf_arg_t downloadTotal, cpr_pf_arg_t downloadNow, cpr_pf_arg_t uploadTotal, cpr_pf_arg_t uploadNow, intptr_t userdata)> callback;
+    InlineFunction<bool(cpr_pf_arg_t downloadTotal, cpr_pf_arg_t downloadNow, cpr_pf_arg_t uploadTotal, cpr_pf_arg_t uploadNow, intptr_t userdata)> callback;
 };
 
 class DebugCallback {
@@ -93,8 +106,10 @@ class DebugCallback {
         SSL_DATA_OUT = 6,
     };
     DebugCallback() = default;
+    template <typename Callback>
+        requires std::is_invocable_v<Callback&, InfoType, std::string_view, intptr_t>
     // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
-    DebugCallback(std::function<void(InfoType type, std::string_view data, intptr_t userdata)> p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
+    DebugCallback(Callback p_callback, intptr_t p_userdata = 0) : userdata(p_userdata), callback(std::move(p_callback)) {}
     void operator()(InfoType type, std::string_view data) const {
         if(!callback)
         {
@@ -104,7 +119,7 @@ class DebugCallback {
     }
 
     intptr_t userdata{};
-    std::function<void(InfoType type, std::string_view data, intptr_t userdata)> callback;
+    InlineFunction<void(InfoType type, std::string_view data, intptr_t userdata)> callback;
 };
 
 /**
@@ -0,0 +1,187 @@
+#ifndef CPR_CHUNKED_BODY_H
+#define CPR_CHUNKED_BODY_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace cpr {
+
+constexpr size_t CPR_DEFAULT_CHUNK_SIZE = static_cast<size_t>(256) * 1024;
+constexpr size_t CPR_DEFAULT_MAX_FREE_CHUNKS = 64;
+
+/**
+ * Slab allocator handing out fixed size chunks for ChunkedBody.
+ * Released chunks are kept on a free list (up to max_free_chunks) and handed out again, so a steady stream of
+ * large responses does not hit malloc for every chunk.
+ *
+ * Copies of a ChunkAllocator share the same free list. The allocator is thread safe and chunks may outlive it.
+ **/
+class ChunkAllocator {
+  public:
+    explicit ChunkAllocator(size_t chunk_size = CPR_DEFAULT_CHUNK_SIZE, size_t max_free_chunks = CPR_DEFAULT_MAX_FREE_CHUNKS);
+    ChunkAllocator(const ChunkAllocator&) = default;
+    ChunkAllocator(ChunkAllocator&&) noexcept = default;
+    ~ChunkAllocator() = default;
+
+    ChunkAllocator& operator=(const ChunkAllocator&) = default;
+    ChunkAllocator& operator=(ChunkAllocator&&) noexcept = default;
+
+    /**
+     * Returns a chunk of GetChunkSize() bytes. It returns to the free list once the last reference is gone.
+     **/
+    [[nodiscard]] std::shared_ptr<char> Allocate() const;
+
+    [[nodiscard]] size_t GetChunkSize() const;
+    /**
+     * Number of chunks currently waiting on the free list.
+     **/
+    [[nodiscard]] size_t GetFreeCount() const;
+
+  private:
+    struct State {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<char[]>> free_chunks;
+        size_t chunk_size{0};
+        size_t max_free_chunks{0};
+
+        void release(char* chunk);
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * Response body stored as a chain of fixed size chunks instead of one contiguous std::string.
+ * Growing the body never moves already received data, so a body of several hundred MB neither gets copied over and
+ * over again nor needs twice its size while growing.
+ *
+ * Iterating yields one std::string_view per chunk. Copies of a ChunkedBody share the underlying chunk memory.
+ *
+ * Example:
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/big.bin"}, cpr::ChunkAllocator{});
+ * for (std::string_view chunk : r.chunked_body) {
+ *     ...
+ * }
+ * r.chunked_body.WriteTo(file); // Zero copy handoff
+ * std::string flat = r.chunked_body.Flatten(); // Explicit copy into contiguous memory
+ **/
+class ChunkedBody {
+  public:
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        const_iterator() = default;
+        const_iterator(const ChunkedBody* body, size_t index) : body_(body), index_(index) {}
+
+        std::string_view operator*() const {
+            return body_->chunk(index_);
+        }
+        const_iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++index_;
+            return tmp;
+        }
+        bool operator==(const const_iterator& other) const {
+            return body_ == other.body_ && index_ == other.index_;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+      private:
+        const ChunkedBody* body_{nullptr};
+        size_t index_{0};
+    };
+
+    ChunkedBody() = default;
+    explicit ChunkedBody(ChunkAllocator allocator);
+    ChunkedBody(const ChunkedBody& other) = default;
+    ChunkedBody(ChunkedBody&& old) noexcept = default;
+    ~ChunkedBody() = default;
+
+    ChunkedBody& operator=(const ChunkedBody& other) = default;
+    ChunkedBody& operator=(ChunkedBody&& old) noexcept = default;
+
+    /**
+     * Copies the data into the last chunk, allocating new chunks as required.
+     **/
+    void Append(std::string_view data);
+    /**
+     * Adds memory owned by somebody else (e.g. a memory mapped file) as a chunk of its own without copying it.
+     * The memory is never written to. Following Append() calls start a new chunk.
+     **/
+    void AppendExternal(std::shared_ptr<const char> data, size_t size);
+    /**
+     * Drops all chunks. The allocator is kept.
+     **/
+    void clear();
+
+    /**
+     * Total number of bytes over all chunks.
+     **/
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] size_t chunk_count() const;
+    [[nodiscard]] std::string_view chunk(size_t index) const;
+
+    [[nodiscard]] const_iterator begin() const;
+    [[nodiscard]] const_iterator end() const;
+
+    /**
+     * Hands every chunk to the writer without copying it.
+     * The writer gets called with a std::string_view per chunk and returns false to stop early.
+     * Returns false in case the writer stopped early.
+     **/
+    template <typename Writer>
+        requires std::is_invocable_r_v<bool, Writer, std::string_view>
+    bool WriteTo(Writer&& writer) const {
+        for (const Chunk& c : chunks_) {
+            if (!writer(std::string_view{c.data.get(), c.size})) {
+                return false;
+            }
+        }
+        return true;
+    }
+    /**
+     * Writes all chunks to the given stream. Returns false in case the stream failed.
+     **/
+    bool WriteTo(std::ostream& stream) const;
+
+    /**
+     * Copies all chunks into one contiguous string.
+     **/
+    [[nodiscard]] std::string Flatten() const;
+
+  private:
+    struct Chunk {
+        std::shared_ptr<char> data;
+        size_t size{0};
+        bool external{false};
+    };
+
+    // Created on first use so an unused ChunkedBody (e.g. in every Response) does not allocate.
+    std::optional<ChunkAllocator> allocator_;
+    std::vector<Chunk> chunks_;
+    size_t size_{0};
+};
+
+} // namespace cpr
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef CPR_CIRCUIT_BREAKER_H
+#define CPR_CIRCUIT_BREAKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpr/response.h"
+
+namespace cpr {
+
+struct CircuitBreakerOptions {
+    /**
+     * Share of failed requests within a window which opens the circuit.
+     **/
+    double failure_rate_threshold{0.5};
+    /**
+     * Requests needed within a window before the failure rate gets considered.
+     **/
+    uint32_t minimum_requests{20};
+    /**
+     * Length of the (tumbling) window failures are counted in.
+     **/
+    std::chrono::milliseconds window{10000};
+    /**
+     * How long requests fail fast once the circuit opened, before probes get let through.
+     **/
+    std::chrono::milliseconds open_duration{30000};
+    /**
+     * Probes let through while half-open. The circuit closes again once all of them succeeded.
+     * Any failed probe opens it again.
+     **/
+    uint32_t half_open_probes{3};
+    /**
+     * Upper bound for the number of hosts tracked. Requests to further hosts pass unchecked.
+     **/
+    size_t max_hosts{1024};
+};
+
+/**
+ * Circuit breakers keyed by host (the authority of the URL, e.g. "example.com:8080").
+ * Tracks the failure rate of the completed requests per host. Once it exceeds the threshold, the circuit opens and
+ * requests to the host fail right away with ErrorCode::CIRCUIT_OPEN instead of waiting for timeouts. After
+ * open_duration, the circuit is half-open and lets a limited number of probes through, which decide whether it
+ * closes or opens again.
+ *
+ * A request counts as failed in case it did not get a response (connection errors, timeouts, ...) or the status code
+ * is 5xx. Hosts get registered on first use and are kept until the last copy of the CircuitBreaker is gone.
+ * Allow() and Record() are lock-free.
+ *
+ * Like the ConnectionPool, copies of a CircuitBreaker share the same state and it is thread safe.
+ *
+ * Example:
+ * cpr::CircuitBreaker circuit_breaker;
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/api"}, circuit_breaker);
+ * if (r.error.code == cpr::ErrorCode::CIRCUIT_OPEN) {
+ *     // The host failed too often recently
+ * }
+ **/
+class CircuitBreaker {
+  public:
+    enum class State : uint8_t { CLOSED, OPEN, HALF_OPEN };
+
+    explicit CircuitBreaker(CircuitBreakerOptions options = {});
+    CircuitBreaker(const CircuitBreaker&) = default;
+    CircuitBreaker(CircuitBreaker&&) noexcept = default;
+    ~CircuitBreaker() = default;
+
+    CircuitBreaker& operator=(const CircuitBreaker&) = default;
+    CircuitBreaker& operator=(CircuitBreaker&&) noexcept = default;
+
+    /**
+     * Returns whether a request to the host may be sent. False while the circuit is open or all probes are taken.
+     **/
+    [[nodiscard]] bool Allow(std::string_view host) const;
+    /**
+     * Records the outcome of a completed request to the host.
+     **/
+    void Record(std::string_view host, const Response& response) const;
+
+    [[nodiscard]] State GetState(std::string_view host) const;
+
+    /**
+     * Returns whether the response counts as a failure of the host.
+     **/
+    [[nodiscard]] static bool IsFailure(const Response& response);
+    /**
+     * Returns the host key of the URL, e.g. "example.com:8080" for "https://user@example.com:8080/path".
+     **/
+    [[nodiscard]] static std::string_view GetHost(std::string_view url);
+
+  private:
+    struct HostState {
+        const std::string host;
+        std::atomic<State> state{State::CLOSED};
+        // Milliseconds of the steady clock
+        std::atomic<int64_t> window_start{0};
+        std::atomic<uint32_t> successes{0};
+        std::atomic<uint32_t> failures{0};
+        // End of the open phase, or end of the current probe round while half-open
+        std::atomic<int64_t> open_until{0};
+        std::atomic<uint32_t> probes{0};
+        std::atomic<uint32_t> probe_successes{0};
+
+        explicit HostState(std::string_view p_host) : host(p_host) {}
+    };
+
+    struct Registry {
+        CircuitBreakerOptions options;
+        // Open addressing hash table. Slots get filled once and never change afterwards.
+        std::vector<std::atomic<HostState*>> slots;
+
+        explicit Registry(CircuitBreakerOptions p_options);
+        Registry(const Registry&) = delete;
+        Registry(Registry&&) = delete;
+        ~Registry();
+
+        Registry& operator=(const Registry&) = delete;
+        Registry& operator=(Registry&&) = delete;
+
+        /**
+         * Returns the state of the host, registering it if needed. Returns nullptr in case the table is full.
+         **/
+        HostState* Get(std::string_view host, bool insert);
+    };
+
+    void open(HostState& host_state, int64_t now) const;
+
+    std::shared_ptr<Registry> registry_;
+};
+
+} // namespace cpr
+
+#endif
@@ -13,6 +13,8 @@ namespace cpr {
  * which can significantly improve performance by avoiding the overhead of establishing new
  * connections for each request. It uses libcurl's CURLSH (share) interface to manage
  * connection sharing in a thread-safe manner.
+ * TLS sessions are shared as well, so new connections to a host already connected to resume the
+ * existing TLS session. Use a TlsSessionStore to keep them across processes.
  *
  * Example:
  * ```cpp
@@ -63,8 +65,9 @@ class ConnectionPool {
      * This mutex is passed to libcurl's locking callbacks to ensure thread safety
      * when multiple threads access the same connection pool. It's declared first
      * to ensure it's destroyed last, after the CURLSH handle that references it.
+     * Recursive, since libcurl may lock the TLS session cache while holding the lock for the connection cache.
      **/
-    std::shared_ptr<std::mutex> connection_mutex_;
+    std::shared_ptr<std::recursive_mutex> connection_mutex_;
     
     /**
      * Shared CURL handle (CURLSH) that manages the actual connection sharing.
@@ -0,0 +1,192 @@
+#ifndef CPR_COROUTINE_ASYNC_GENERATOR_H
+#define CPR_COROUTINE_ASYNC_GENERATOR_H
+
+#if __cplusplus >= 202002L
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "cpr/async.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/executor.h"
+
+namespace cpr::coroutine {
+
+/**
+ * Lazily running coroutine yielding a sequence of T via co_yield, which may co_await in between.
+ *
+ * Awaiting next() runs the generator until it yields the next value or returns. The generator runs on the same executor
+ * a Task would (see Task), and the awaiting coroutine continues on the thread the generator yielded on.
+ * In between two calls of next() the generator stays suspended, so a slow consumer holds back the producer, e.g. the
+ * transfer of Session::CoGetStream() gets paused, without buffering any further values.
+ * Do not destroy a generator while awaiting its next() value.
+ *
+ * Example:
+ * cpr::coroutine::AsyncGenerator<std::string> chunks = session->CoGetStream();
+ * while (std::optional<std::string> chunk = co_await chunks.next()) {
+ *     ...
+ * }
+ **/
+template <typename T>
+class [[nodiscard]] AsyncGenerator {
+    static_assert(!std::is_void_v<T> && !std::is_reference_v<T>, "AsyncGenerator requires a value type!");
+
+public:
+    class promise_type {
+    public:
+        promise_type() = default;
+
+        template <HasExecutor Owner, typename... Args>
+        explicit promise_type(Owner& owner, Args&... /*args*/)
+            : m_executor{ owner.GetExecutor() }
+        {
+        }
+
+        AsyncGenerator get_return_object() noexcept
+        {
+            return AsyncGenerator{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        struct yield_awaiter {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coro) noexcept
+            {
+                return coro.promise().m_continuation;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        yield_awaiter final_suspend() const noexcept { return {}; }
+
+        yield_awaiter yield_value(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            m_value.emplace(std::move(value));
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception()
+        {
+            m_exception = std::current_exception();
+        }
+
+        void set_continuation(std::coroutine_handle<> continuation) noexcept
+        {
+            m_continuation = continuation;
+        }
+
+        std::shared_ptr<Executor> GetExecutor() const
+        {
+            return m_executor ? m_executor : GetDefaultExecutor();
+        }
+
+        std::optional<T> result()
+        {
+            if (m_exception) {
+                std::rethrow_exception(std::exchange(m_exception, nullptr));
+            }
+            return std::exchange(m_value, std::nullopt);
+        }
+
+    private:
+        std::optional<T> m_value;
+        std::exception_ptr m_exception;
+        std::coroutine_handle<> m_continuation{ std::noop_coroutine() };
+        std::shared_ptr<Executor> m_executor;
+
+    }; // AsyncGenerator::promise_type
+
+    struct NextAwaiter {
+        bool await_ready() const noexcept { return !m_coro || m_coro.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting_coroutine)
+        {
+            m_coro.promise().set_continuation(awaiting_coroutine);
+            const std::shared_ptr<Executor> executor = m_coro.promise().GetExecutor();
+            // Already on a thread of the executor, so continue the generator right here by symmetric transfer
+            if (detail::RunsOn(*executor)) {
+                return m_coro;
+            }
+            detail::ResumeOn(*executor, m_coro);
+            return std::noop_coroutine();
+        }
+
+        /**
+         * The next value, std::nullopt once the generator returned.
+         * Rethrows the exception the generator ended with.
+         **/
+        std::optional<T> await_resume()
+        {
+            if (!m_coro) {
+                return std::nullopt;
+            }
+            return m_coro.promise().result();
+        }
+
+        std::coroutine_handle<promise_type> m_coro;
+    };
+
+    explicit AsyncGenerator(std::coroutine_handle<promise_type> handle)
+        : m_handle{ handle }
+    {
+    }
+
+    AsyncGenerator(const AsyncGenerator&) = delete;
+    AsyncGenerator(AsyncGenerator&& other) noexcept
+        : m_handle{ std::exchange(other.m_handle, nullptr) }
+    {
+    }
+
+    AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+    AsyncGenerator& operator=(AsyncGenerator&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~AsyncGenerator()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    /**
+     * Resumes the generator for the next value. Only one next() may be awaited at a time.
+     **/
+    NextAwaiter next() noexcept
+    {
+        return NextAwaiter{ m_handle };
+    }
+
+    /**
+     * True once the generator returned or threw.
+     **/
+    [[nodiscard]] bool IsDone() const noexcept
+    {
+        return !m_handle || m_handle.done();
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_ASYNC_GENERATOR_H
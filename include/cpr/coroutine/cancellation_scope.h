@@ -0,0 +1,120 @@
+#ifndef CPR_COROUTINE_CANCELLATION_SCOPE_H
+#define CPR_COROUTINE_CANCELLATION_SCOPE_H
+
+#if __cplusplus >= 202002L
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace cpr::coroutine {
+
+/**
+ * Thrown by CancellationScope::ThrowIfCancelled().
+ **/
+class OperationCancelled : public std::runtime_error {
+public:
+    OperationCancelled()
+        : std::runtime_error{ "The operation got cancelled!" }
+    {
+    }
+};
+
+/**
+ * Scope the coroutines of a group of requests get cancelled through.
+ * Copies share the same scope. Cancelling a scope cancels all of its child scopes as well.
+ *
+ * Coroutines check IsCancelled() or call ThrowIfCancelled() between their steps. Transfers of a session bound to the
+ * scope via session.SetCancellationParam(scope.GetFlag()) get aborted right away.
+ *
+ * Example:
+ * cpr::coroutine::CancellationScope scope;
+ * session->SetCancellationParam(scope.GetFlag());
+ * ...
+ * scope.Cancel();
+ **/
+class CancellationScope {
+public:
+    CancellationScope()
+        : m_state{ std::make_shared<State>() }
+    {
+    }
+
+    /**
+     * Returns a new scope that gets cancelled together with this one, but may be cancelled on its own as well.
+     **/
+    [[nodiscard]] CancellationScope CreateChild() const
+    {
+        CancellationScope child;
+        {
+            const std::lock_guard<std::mutex> lock(m_state->mutex);
+            if (!m_state->flag->load()) {
+                std::erase_if(m_state->children, [](const std::weak_ptr<State>& existing) { return existing.expired(); });
+                m_state->children.push_back(child.m_state);
+                return child;
+            }
+        }
+        child.Cancel();
+        return child;
+    }
+
+    void Cancel() const
+    {
+        std::vector<std::weak_ptr<State>> children;
+        {
+            const std::lock_guard<std::mutex> lock(m_state->mutex);
+            if (m_state->flag->exchange(true)) {
+                return;
+            }
+            children.swap(m_state->children);
+        }
+        for (const std::weak_ptr<State>& weak_child : children) {
+            if (std::shared_ptr<State> child = weak_child.lock()) {
+                CancellationScope{ std::move(child) }.Cancel();
+            }
+        }
+    }
+
+    [[nodiscard]] bool IsCancelled() const
+    {
+        return m_state->flag->load();
+    }
+
+    void ThrowIfCancelled() const
+    {
+        if (IsCancelled()) {
+            throw OperationCancelled{};
+        }
+    }
+
+    /**
+     * The flag set on Cancel(), to be passed to Session::SetCancellationParam().
+     **/
+    [[nodiscard]] const std::shared_ptr<std::atomic_bool>& GetFlag() const
+    {
+        return m_state->flag;
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::shared_ptr<std::atomic_bool> flag{ std::make_shared<std::atomic_bool>(false) };
+        // Weak, so child scopes nobody uses anymore get dropped from long living parents
+        std::vector<std::weak_ptr<State>> children;
+    };
+
+    explicit CancellationScope(std::shared_ptr<State> state)
+        : m_state{ std::move(state) }
+    {
+    }
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_CANCELLATION_SCOPE_H
@@ -99,6 +99,13 @@ auto CoDownloadAsync(fs::path local_path, Ts... ts) -> Task<cpr::Response>
     co_return cpr::Download(f, std::move(ts)...);
 }
 
+template <typename... Ts>
+auto CoDownloadAsync(fs::path local_path, FileSinkOptions options, Ts... ts) -> Task<cpr::Response>
+{
+    FileSink sink{ local_path, options };
+    co_return cpr::Download(sink, std::move(ts)...);
+}
+
 } // namespace cpr::coroutine
 
 #endif // __cplusplus >= 202002L
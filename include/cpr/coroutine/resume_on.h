@@ -0,0 +1,83 @@
+#ifndef CPR_COROUTINE_RESUME_ON_H
+#define CPR_COROUTINE_RESUME_ON_H
+
+#if __cplusplus >= 202002L
+
+#include <coroutine>
+#include <exception>
+
+#include "cpr/executor.h"
+
+namespace cpr::coroutine::detail {
+
+// The executor a coroutine got resumed on by ResumeOn() on this thread, nullptr outside of such a resumption
+inline thread_local const Executor* t_current_executor{ nullptr };
+
+/**
+ * Marks the calling thread as running a task of the given executor until destroyed.
+ **/
+class ExecutorScope {
+public:
+    explicit ExecutorScope(const Executor* executor) noexcept
+        : m_previous{ t_current_executor }
+    {
+        t_current_executor = executor;
+    }
+
+    ExecutorScope(const ExecutorScope&) = delete;
+    ExecutorScope& operator=(const ExecutorScope&) = delete;
+
+    ~ExecutorScope()
+    {
+        t_current_executor = m_previous;
+    }
+
+private:
+    const Executor* m_previous;
+};
+
+/**
+ * Returns true in case the calling thread runs a coroutine the executor resumed.
+ * Resuming another coroutine of that executor right here instead of handing it over is safe then, since the executor
+ * would only run it on one of its threads as well.
+ **/
+inline bool RunsOn(const Executor& executor) noexcept
+{
+    return t_current_executor == &executor;
+}
+
+/**
+ * Resumes the coroutine on the executor.
+ **/
+inline void ResumeOn(Executor& executor, std::coroutine_handle<> coro)
+{
+    // Only used for comparing, so the executor does not need to be kept alive
+    const Executor* const raw_executor = &executor;
+    executor.Execute(
+        [raw_executor, coro]() {
+            const ExecutorScope scope{ raw_executor };
+            coro.resume();
+        }
+    );
+}
+
+/**
+ * Coroutine starting right away and destroying itself once done.
+ * Runs the children of the combinators and task groups, which keep their state in a shared_ptr.
+ **/
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        // The children catch everything they run
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace cpr::coroutine::detail
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_RESUME_ON_H
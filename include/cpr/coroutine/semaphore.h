@@ -0,0 +1,186 @@
+#ifndef CPR_COROUTINE_SEMAPHORE_H
+#define CPR_COROUTINE_SEMAPHORE_H
+
+#if __cplusplus >= 202002L
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "cpr/async.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/executor.h"
+
+namespace cpr::coroutine {
+
+class Semaphore;
+
+/**
+ * Releases the unit of a Semaphore it holds once destroyed.
+ **/
+class SemaphoreGuard {
+public:
+    explicit SemaphoreGuard(Semaphore& semaphore) noexcept
+        : m_semaphore{ &semaphore }
+    {
+    }
+
+    SemaphoreGuard(const SemaphoreGuard&) = delete;
+    SemaphoreGuard(SemaphoreGuard&& other) noexcept
+        : m_semaphore{ std::exchange(other.m_semaphore, nullptr) }
+    {
+    }
+
+    SemaphoreGuard& operator=(const SemaphoreGuard&) = delete;
+    SemaphoreGuard& operator=(SemaphoreGuard&& other) noexcept;
+
+    ~SemaphoreGuard();
+
+private:
+    Semaphore* m_semaphore;
+};
+
+/**
+ * Counting semaphore for coroutines, e.g. for limiting how many requests of a large fan-out run at the same time.
+ * Waiting for a unit suspends the awaiting coroutine instead of blocking its thread. Release() hands the unit over to
+ * the longest waiting coroutine, which gets resumed on its executor (see Task).
+ *
+ * Example:
+ * cpr::coroutine::Semaphore semaphore{ 8 };
+ * ...
+ * const cpr::coroutine::SemaphoreGuard guard = co_await semaphore.ScopedAcquire();
+ * cpr::Response response = co_await session->CoGetAsync();
+ **/
+class Semaphore {
+public:
+    explicit Semaphore(size_t count) noexcept
+        : m_available{ count }
+    {
+    }
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    class AcquireAwaiter {
+    public:
+        explicit AcquireAwaiter(Semaphore& semaphore) noexcept
+            : m_semaphore{ semaphore }
+        {
+        }
+
+        bool await_ready() noexcept { return m_semaphore.TryAcquire(); }
+
+        template <typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> awaiting_coroutine)
+        {
+            std::shared_ptr<Executor> executor;
+            if constexpr (HasExecutor<Promise>) {
+                executor = awaiting_coroutine.promise().GetExecutor();
+            } else {
+                executor = GetDefaultExecutor();
+            }
+            const std::lock_guard<std::mutex> lock(m_semaphore.m_mutex);
+            // Released in between
+            if (m_semaphore.m_available > 0) {
+                --m_semaphore.m_available;
+                return false;
+            }
+            m_semaphore.m_waiters.push_back(Waiter{ awaiting_coroutine, std::move(executor) });
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+
+    protected:
+        Semaphore& m_semaphore;
+    };
+
+    class ScopedAcquireAwaiter : public AcquireAwaiter {
+    public:
+        using AcquireAwaiter::AcquireAwaiter;
+
+        [[nodiscard]] SemaphoreGuard await_resume() const noexcept { return SemaphoreGuard{ m_semaphore }; }
+    };
+
+    /**
+     * Waits for a unit, which has to be given back via Release().
+     **/
+    [[nodiscard]] AcquireAwaiter Acquire() noexcept { return AcquireAwaiter{ *this }; }
+
+    /**
+     * Waits for a unit and returns a guard giving it back once destroyed.
+     **/
+    [[nodiscard]] ScopedAcquireAwaiter ScopedAcquire() noexcept { return ScopedAcquireAwaiter{ *this }; }
+
+    /**
+     * Takes a unit in case one is available right away.
+     **/
+    bool TryAcquire()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_available == 0) {
+            return false;
+        }
+        --m_available;
+        return true;
+    }
+
+    void Release()
+    {
+        Waiter waiter;
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_waiters.empty()) {
+                ++m_available;
+                return;
+            }
+            // The unit goes to the waiter right away, so nobody can take it in between
+            waiter = std::move(m_waiters.front());
+            m_waiters.pop_front();
+        }
+        detail::ResumeOn(*waiter.executor, waiter.coro);
+    }
+
+    [[nodiscard]] size_t GetAvailable()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_available;
+    }
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> coro;
+        std::shared_ptr<Executor> executor;
+    };
+
+    std::mutex m_mutex;
+    size_t m_available;
+    std::deque<Waiter> m_waiters;
+};
+
+inline SemaphoreGuard& SemaphoreGuard::operator=(SemaphoreGuard&& other) noexcept
+{
+    if (this != &other) {
+        if (m_semaphore) {
+            m_semaphore->Release();
+        }
+        m_semaphore = std::exchange(other.m_semaphore, nullptr);
+    }
+    return *this;
+}
+
+inline SemaphoreGuard::~SemaphoreGuard()
+{
+    if (m_semaphore) {
+        m_semaphore->Release();
+    }
+}
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_SEMAPHORE_H
@@ -0,0 +1,59 @@
+#ifndef CPR_COROUTINE_SLEEP_H
+#define CPR_COROUTINE_SLEEP_H
+
+#if __cplusplus >= 202002L
+
+#include <chrono>
+#include <coroutine>
+#include <memory>
+#include <utility>
+
+#include "cpr/async.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/executor.h"
+#include "cpr/timer_queue.h"
+
+namespace cpr::coroutine {
+
+/**
+ * Suspends the awaiting coroutine for the given delay without blocking a thread.
+ * The coroutine gets resumed on its executor once the TimerQueue fires, e.g. the one of the Session for
+ * Session::Co*Async() (see Task), else on the default executor.
+ *
+ * Example:
+ * co_await cpr::coroutine::SleepFor(std::chrono::milliseconds{100});
+ **/
+class SleepFor {
+public:
+    explicit SleepFor(TimerQueue::Clock::duration delay) noexcept
+        : m_delay{ delay }
+    {
+    }
+
+    bool await_ready() const noexcept { return m_delay.count() <= 0; }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> awaiting_coroutine) const
+    {
+        std::shared_ptr<Executor> executor;
+        if constexpr (HasExecutor<Promise>) {
+            executor = awaiting_coroutine.promise().GetExecutor();
+        } else {
+            executor = GetDefaultExecutor();
+        }
+        TimerQueue::GetInstance()->ScheduleAfter(m_delay, [awaiting_coroutine, executor = std::move(executor)]() {
+            detail::ResumeOn(*executor, awaiting_coroutine);
+        });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    TimerQueue::Clock::duration m_delay;
+};
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_SLEEP_H
@@ -0,0 +1,74 @@
+#ifndef CPR_COROUTINE_STREAM_READY_H
+#define CPR_COROUTINE_STREAM_READY_H
+
+#if __cplusplus >= 202002L
+
+#include <coroutine>
+#include <memory>
+#include <utility>
+
+#include "cpr/async.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/executor.h"
+#include "cpr/response_stream.h"
+#include "cpr/socket_watcher.h"
+
+namespace cpr::coroutine {
+
+/**
+ * Suspends the awaiting coroutine until ResponseStream::Read() returns without blocking.
+ * In between the sockets of the transfer get watched by the SocketWatcher, so no thread of the executor is blocked
+ * while waiting for the server. The transfer itself only makes progress on the executor of the coroutine.
+ * The stream must not be used otherwise while being awaited.
+ *
+ * Example:
+ * co_await cpr::coroutine::StreamReady{ stream };
+ * std::optional<std::string> chunk = stream.Read();
+ **/
+class StreamReady {
+public:
+    explicit StreamReady(ResponseStream& stream) noexcept
+        : m_stream{ stream }
+    {
+    }
+
+    bool await_ready() { return m_stream.Poll(); }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> awaiting_coroutine)
+    {
+        std::shared_ptr<Executor> executor;
+        if constexpr (HasExecutor<Promise>) {
+            executor = awaiting_coroutine.promise().GetExecutor();
+        } else {
+            executor = GetDefaultExecutor();
+        }
+        watch(awaiting_coroutine, std::move(executor));
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    void watch(std::coroutine_handle<> coro, std::shared_ptr<Executor> executor)
+    {
+        // Lives in the frame of the suspended coroutine, so this stays valid until it got resumed
+        SocketWatcher::GetInstance()->Watch(m_stream.GetWaitFds(), m_stream.GetWaitTimeout(), [this, coro, executor]() {
+            executor->Execute([this, coro, executor]() {
+                if (!m_stream.Poll()) {
+                    watch(coro, executor);
+                    return;
+                }
+                const detail::ExecutorScope scope{ executor.get() };
+                coro.resume();
+            });
+        });
+    }
+
+    ResponseStream& m_stream;
+};
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_STREAM_READY_H
@@ -5,17 +5,37 @@
 
 #include <coroutine>
 #include <exception>
+#include <memory>
+#include <utility>
 #include <variant>
 
 #include "cpr/async.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/executor.h"
 
 namespace cpr::coroutine {
 
+/**
+ * Lazily started coroutine returning a T.
+ *
+ * Awaiting it starts the coroutine on an executor: the one of the object in case it is a member coroutine of an object
+ * having an executor (see cpr::HasExecutor), e.g. the one of a Session for Session::Co*Async(), else the default executor
+ * (see SetDefaultExecutor()).
+ * In case the awaiting coroutine already runs on a thread of that executor, the task starts right away on the same thread
+ * instead of being handed over. Once done, the awaiting coroutine continues on the thread that finished the task.
+ **/
 template <typename T>
 class [[nodiscard]] Task {
 public:
     class promise_type {
     public:
+        promise_type() = default;
+
+        template <HasExecutor Owner, typename... Args>
+        explicit promise_type(Owner& owner, Args&... /*args*/)
+            : m_executor{ owner.GetExecutor() }
+        {
+        }
 
         Task get_return_object() noexcept
         {
@@ -54,6 +74,11 @@ public:
         {
             m_continuation = continuation;
         }
+
+        std::shared_ptr<Executor> GetExecutor() const
+        {
+            return m_executor ? m_executor : GetDefaultExecutor();
+        }
         
         T result()
         {
@@ -69,23 +94,27 @@ public:
     private:
         std::variant<std::monostate, T, std::exception_ptr> m_result;
         std::coroutine_handle<> m_continuation{ std::noop_coroutine() };
+        std::shared_ptr<Executor> m_executor;
 
     }; // Task::promise_type
     
     struct Awaiter {
         bool await_ready() const noexcept { return !m_coro || m_coro.done(); }
 
-        void await_suspend(std::coroutine_handle<> awaiting_coroutine) noexcept
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting_coroutine)
         {
             m_coro.promise().set_continuation(awaiting_coroutine);
-            GlobalThreadPool::GetInstance()->CoSubmit(
-                [this]() {
-                    m_coro.resume();
-                }
-            );
+            const std::shared_ptr<Executor> executor = m_coro.promise().GetExecutor();
+            // Already on a thread of the executor, so start the task right here by symmetric transfer
+            if (detail::RunsOn(*executor)) {
+                return m_coro;
+            }
+            // Only touches the handle, since an inline executor may complete the awaiting coroutine right away
+            detail::ResumeOn(*executor, m_coro);
+            return std::noop_coroutine();
         }
 
-        T await_resume() noexcept
+        T await_resume()
         {
             return m_coro.promise().result();
         }
@@ -101,7 +130,25 @@ public:
         : m_handle{ handle }
     {
     }
-    
+
+    Task(const Task&) = delete;
+    Task(Task&& other) noexcept
+        : m_handle{ std::exchange(other.m_handle, nullptr) }
+    {
+    }
+
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
     ~Task()
     {
         if (m_handle) {
@@ -118,6 +165,14 @@ class Task<void> {
 public:
     class promise_type {
     public:
+        promise_type() = default;
+
+        template <HasExecutor Owner, typename... Args>
+        explicit promise_type(Owner& owner, Args&... /*args*/)
+            : m_executor{ owner.GetExecutor() }
+        {
+        }
+
         Task get_return_object() noexcept
         {
             return Task{ std::coroutine_handle<promise_type>::from_promise(*this) };
@@ -152,6 +207,11 @@ public:
         {
             m_continuation = continuation;
         }
+
+        std::shared_ptr<Executor> GetExecutor() const
+        {
+            return m_executor ? m_executor : GetDefaultExecutor();
+        }
         
         void result()
         {
@@ -163,23 +223,27 @@ public:
     private:
         std::exception_ptr m_exception;
         std::coroutine_handle<> m_continuation{ std::noop_coroutine() };
+        std::shared_ptr<Executor> m_executor;
 
     }; // Task::promise_type
     
     struct Awaiter {
         bool await_ready() const noexcept { return !m_coro || m_coro.done(); }
 
-        void await_suspend(std::coroutine_handle<> awaiting_coroutine) noexcept
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting_coroutine)
         {
             m_coro.promise().set_continuation(awaiting_coroutine);
-            GlobalThreadPool::GetInstance()->CoSubmit(
-                [this]() {
-                    m_coro.resume();
-                }
-            );
+            const std::shared_ptr<Executor> executor = m_coro.promise().GetExecutor();
+            // Already on a thread of the executor, so start the task right here by symmetric transfer
+            if (detail::RunsOn(*executor)) {
+                return m_coro;
+            }
+            // Only touches the handle, since an inline executor may complete the awaiting coroutine right away
+            detail::ResumeOn(*executor, m_coro);
+            return std::noop_coroutine();
         }
 
-        void await_resume() noexcept
+        void await_resume()
         {
             m_coro.promise().result();
         }
@@ -195,7 +259,25 @@ public:
         : m_handle{ handle }
     {
     }
-    
+
+    Task(const Task&) = delete;
+    Task(Task&& other) noexcept
+        : m_handle{ std::exchange(other.m_handle, nullptr) }
+    {
+    }
+
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
     ~Task()
     {
         if (m_handle) {
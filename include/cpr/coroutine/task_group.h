@@ -0,0 +1,175 @@
+#ifndef CPR_COROUTINE_TASK_GROUP_H
+#define CPR_COROUTINE_TASK_GROUP_H
+
+#if __cplusplus >= 202002L
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "cpr/coroutine/cancellation_scope.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/coroutine/task.h"
+
+namespace cpr::coroutine {
+
+/**
+ * Group of tasks running concurrently within a cancellation scope, for structured concurrency.
+ *
+ * Spawn() starts each task right away on its executor. Awaiting Join() resumes the awaiting coroutine once all of them
+ * completed and rethrows the exception of the first one that failed. The first failure cancels the scope of the group,
+ * so the remaining tasks can stop early: they check the scope (see GetScope()) or bind their sessions to it.
+ * Await Join() before destroying the group. The destructor cancels the scope of tasks still running, their state stays
+ * alive until they completed.
+ *
+ * Example:
+ * cpr::coroutine::TaskGroup group;
+ * for (const cpr::Url& url : urls) {
+ *     group.Spawn(Fetch(url, group.GetScope()));
+ * }
+ * co_await group.Join();
+ **/
+class TaskGroup {
+private:
+    struct State;
+
+public:
+    TaskGroup()
+        : m_state{ std::make_shared<State>(CancellationScope{}) }
+    {
+    }
+
+    /**
+     * Creates a group getting cancelled together with the given scope.
+     **/
+    explicit TaskGroup(const CancellationScope& parent)
+        : m_state{ std::make_shared<State>(parent.CreateChild()) }
+    {
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup()
+    {
+        if (!m_state->joined) {
+            m_state->scope.Cancel();
+        }
+    }
+
+    /**
+     * Starts the task on its executor. Tasks spawned after the group got cancelled get dropped without running.
+     **/
+    template <typename T>
+    void Spawn(Task<T> task)
+    {
+        if (m_state->joined) {
+            throw std::logic_error{ "Calling TaskGroup::Spawn after the group got joined!" };
+        }
+        if (m_state->scope.IsCancelled()) {
+            return;
+        }
+        m_state->pending.fetch_add(1, std::memory_order_relaxed);
+        // Handed over to its executor, so spawning does not run the task until its first suspension
+        const detail::ExecutorScope scope{ nullptr };
+        RunChild(std::move(task), m_state);
+    }
+
+    void Cancel() const
+    {
+        m_state->scope.Cancel();
+    }
+
+    [[nodiscard]] const CancellationScope& GetScope() const noexcept
+    {
+        return m_state->scope;
+    }
+
+    class JoinAwaiter {
+    public:
+        explicit JoinAwaiter(std::shared_ptr<TaskGroup::State> state) noexcept
+            : m_state{ std::move(state) }
+        {
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> awaiting_coroutine) noexcept
+        {
+            m_state->continuation = awaiting_coroutine;
+            // Gives up the reference of the group, suspends unless all tasks completed already
+            return m_state->pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+
+        void await_resume() const
+        {
+            if (m_state->error) {
+                std::rethrow_exception(m_state->error);
+            }
+        }
+
+    private:
+        std::shared_ptr<TaskGroup::State> m_state;
+    };
+
+    /**
+     * Waits for all spawned tasks. May be awaited once.
+     **/
+    [[nodiscard]] JoinAwaiter Join()
+    {
+        if (m_state->joined.exchange(true)) {
+            throw std::logic_error{ "Calling TaskGroup::Join more than once!" };
+        }
+        return JoinAwaiter{ m_state };
+    }
+
+private:
+    struct State {
+        explicit State(CancellationScope p_scope)
+            : scope{ std::move(p_scope) }
+        {
+        }
+
+        CancellationScope scope;
+        // One for each running task and one for the group until it gets joined
+        std::atomic_size_t pending{ 1 };
+        std::atomic_bool joined{ false };
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+    };
+
+    template <typename T>
+    static detail::DetachedTask RunChild(Task<T> task, std::shared_ptr<State> state)
+    {
+        try {
+            co_await task;
+        } catch (...) {
+            {
+                const std::lock_guard<std::mutex> lock(state->error_mutex);
+                if (!state->error) {
+                    state->error = std::current_exception();
+                }
+            }
+            // Lets the others stop early
+            state->scope.Cancel();
+        }
+        // Only reaches zero once the group got joined
+        if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            state->continuation.resume();
+        }
+    }
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_TASK_GROUP_H
@@ -0,0 +1,219 @@
+#ifndef CPR_COROUTINE_WHEN_ALL_H
+#define CPR_COROUTINE_WHEN_ALL_H
+
+#if __cplusplus >= 202002L
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "cpr/async_wrapper.h"
+#include "cpr/coroutine/cancellation_scope.h"
+#include "cpr/coroutine/resume_on.h"
+#include "cpr/coroutine/task.h"
+
+namespace cpr::coroutine {
+
+namespace detail {
+
+template <typename T>
+struct WhenAllState {
+    explicit WhenAllState(size_t count)
+        : results(count), errors(count), pending{ count + 1 }
+    {
+    }
+
+    // Unused for void tasks
+    std::vector<std::optional<std::conditional_t<std::is_void_v<T>, std::monostate, T>>> results;
+    std::vector<std::exception_ptr> errors;
+    // One for each task and one for the awaiter, so the awaiting coroutine does not get resumed before it suspended
+    std::atomic_size_t pending;
+    std::coroutine_handle<> continuation;
+};
+
+template <typename T>
+DetachedTask RunWhenAllChild(Task<T> task, std::shared_ptr<WhenAllState<T>> state, size_t index)
+{
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+        } else {
+            state->results[index].emplace(co_await task);
+        }
+    } catch (...) {
+        state->errors[index] = std::current_exception();
+    }
+    if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        state->continuation.resume();
+    }
+}
+
+template <typename T>
+class WhenAllAwaiter {
+public:
+    explicit WhenAllAwaiter(std::vector<Task<T>> tasks)
+        : m_tasks{ std::move(tasks) }, m_state{ std::make_shared<WhenAllState<T>>(m_tasks.size()) }
+    {
+    }
+
+    bool await_ready() const noexcept { return m_tasks.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> awaiting_coroutine)
+    {
+        m_state->continuation = awaiting_coroutine;
+        {
+            // Hands each task over to its executor, starting them inline would run them one after another
+            const ExecutorScope scope{ nullptr };
+            for (size_t index = 0; index < m_tasks.size(); ++index) {
+                RunWhenAllChild(std::move(m_tasks[index]), m_state, index);
+            }
+        }
+        // Suspends unless all tasks completed already
+        return m_state->pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    auto await_resume()
+    {
+        for (const std::exception_ptr& error : m_state->errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        if constexpr (!std::is_void_v<T>) {
+            std::vector<T> values;
+            values.reserve(m_state->results.size());
+            for (std::optional<T>& result : m_state->results) {
+                values.push_back(std::move(*result));
+            }
+            return values;
+        }
+    }
+
+private:
+    std::vector<Task<T>> m_tasks;
+    std::shared_ptr<WhenAllState<T>> m_state;
+};
+
+template <typename T>
+struct WhenAnyState {
+    // Set by the first task to complete
+    std::atomic_bool done{ false };
+    std::optional<WhenAnyResult<T>> result;
+    std::exception_ptr error;
+    // One for the first task to complete and one for the awaiter
+    std::atomic_size_t pending{ 2 };
+    std::coroutine_handle<> continuation;
+    std::optional<CancellationScope> scope;
+};
+
+template <typename T>
+DetachedTask RunWhenAnyChild(Task<T> task, std::shared_ptr<WhenAnyState<T>> state, size_t index)
+{
+    std::optional<T> value;
+    std::exception_ptr error;
+    try {
+        value.emplace(co_await task);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    if (state->done.exchange(true, std::memory_order_acq_rel)) {
+        co_return;
+    }
+    if (error) {
+        state->error = std::move(error);
+    } else {
+        state->result.emplace(WhenAnyResult<T>{ index, std::move(*value) });
+    }
+    if (state->scope) {
+        state->scope->Cancel();
+    }
+    if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        state->continuation.resume();
+    }
+}
+
+template <typename T>
+class WhenAnyAwaiter {
+public:
+    WhenAnyAwaiter(std::vector<Task<T>> tasks, std::optional<CancellationScope> scope)
+        : m_tasks{ std::move(tasks) }, m_state{ std::make_shared<WhenAnyState<T>>() }
+    {
+        m_state->scope = std::move(scope);
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> awaiting_coroutine)
+    {
+        m_state->continuation = awaiting_coroutine;
+        {
+            const ExecutorScope scope{ nullptr };
+            for (size_t index = 0; index < m_tasks.size(); ++index) {
+                RunWhenAnyChild(std::move(m_tasks[index]), m_state, index);
+            }
+        }
+        return m_state->pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    WhenAnyResult<T> await_resume()
+    {
+        if (m_state->error) {
+            std::rethrow_exception(m_state->error);
+        }
+        return std::move(*m_state->result);
+    }
+
+private:
+    std::vector<Task<T>> m_tasks;
+    std::shared_ptr<WhenAnyState<T>> m_state;
+};
+
+} // namespace detail
+
+/**
+ * Runs all tasks concurrently, each on its executor, and returns their results in the same order once all completed.
+ * The last task to complete resumes the awaiting coroutine, no thread waits for them in between.
+ * In case any of them failed, rethrows the exception of the first failed one.
+ *
+ * Example:
+ * std::vector<cpr::coroutine::Task<cpr::Response>> tasks;
+ * for (const cpr::Url& url : urls) {
+ *     tasks.push_back(cpr::coroutine::CoGetAsync(url));
+ * }
+ * std::vector<cpr::Response> responses = co_await cpr::coroutine::when_all(std::move(tasks));
+ **/
+template <typename T>
+auto when_all(std::vector<Task<T>> tasks) -> Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>>
+{
+    co_return co_await detail::WhenAllAwaiter<T>{ std::move(tasks) };
+}
+
+/**
+ * Runs all tasks concurrently and returns the index and result of the first one to complete, or rethrows its exception.
+ * The other tasks keep on running to completion, their results get dropped. Pass the scope they are bound to for
+ * cancelling them once the first one completed.
+ * Awaiting it throws std::logic_error for an empty vector.
+ **/
+template <typename T>
+    requires(!std::is_void_v<T>)
+auto when_any(std::vector<Task<T>> tasks, std::optional<CancellationScope> scope = std::nullopt) -> Task<WhenAnyResult<T>>
+{
+    if (tasks.empty()) {
+        throw std::logic_error{ "Calling when_any without any Task!" };
+    }
+    co_return co_await detail::WhenAnyAwaiter<T>{ std::move(tasks), std::move(scope) };
+}
+
+} // namespace cpr::coroutine
+
+#endif // __cplusplus >= 202002L
+
+#endif // CPR_COROUTINE_WHEN_ALL_H
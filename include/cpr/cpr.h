@@ -1,11 +1,14 @@
 #ifndef CPR_CPR_H
 #define CPR_CPR_H
 
+#include "cpr/allocation_accounting.h"
 #include "cpr/api.h"
 #include "cpr/auth.h"
 #include "cpr/bearer.h"
 #include "cpr/callback.h"
 #include "cpr/cert_info.h"
+#include "cpr/chunked_body.h"
+#include "cpr/circuit_breaker.h"
 #include "cpr/connect_timeout.h"
 #include "cpr/connection_pool.h"
 #include "cpr/cookies.h"
@@ -13,8 +16,17 @@
 #include "cpr/cprver.h"
 #include "cpr/curl_container.h"
 #include "cpr/curlholder.h"
+#include "cpr/deadline.h"
+#include "cpr/disk_cache.h"
+#include "cpr/dns_cache.h"
+#include "cpr/endpoint_group.h"
 #include "cpr/error.h"
+#include "cpr/executor.h"
+#include "cpr/file_sink.h"
+#include "cpr/hedging.h"
+#include "cpr/http_cache.h"
 #include "cpr/http_version.h"
+#include "cpr/inline_function.h"
 #include "cpr/interceptor.h"
 #include "cpr/interface.h"
 #include "cpr/limit_rate.h"
@@ -28,25 +40,40 @@
 #include "cpr/proxies.h"
 #include "cpr/proxyauth.h"
 #include "cpr/range.h"
+#include "cpr/rate_limiter.h"
 #include "cpr/redirect.h"
 #include "cpr/reserve_size.h"
 #include "cpr/resolve.h"
+#include "cpr/response_buffer_pool.h"
+#include "cpr/response_stream.h"
 #include "cpr/response.h"
+#include "cpr/retry.h"
 #include "cpr/session.h"
+#include "cpr/single_flight.h"
+#include "cpr/socket_watcher.h"
 #include "cpr/sse.h"
 #include "cpr/ssl_ctx.h"
 #include "cpr/ssl_options.h"
 #include "cpr/status_codes.h"
 #include "cpr/timeout.h"
+#include "cpr/timer_queue.h"
+#include "cpr/tls_session_store.h"
+#include "cpr/tracing.h"
 #include "cpr/unix_socket.h"
 #include "cpr/user_agent.h"
 #include "cpr/util.h"
 #include "cpr/verbose.h"
 #include "cpr/coroutine/coroutine.h"
-#include "cpr/coroutine/fire_once_event.h"
 #include "cpr/coroutine/sync_wait.h"
 #include "cpr/coroutine/task.h"
+#include "cpr/coroutine/sleep.h"
 #include "cpr/coroutine/awaiter_traits.h"
+#include "cpr/coroutine/async_generator.h"
+#include "cpr/coroutine/stream_ready.h"
+#include "cpr/coroutine/cancellation_scope.h"
+#include "cpr/coroutine/semaphore.h"
+#include "cpr/coroutine/task_group.h"
+#include "cpr/coroutine/when_all.h"
 
 #define CPR_LIBCURL_VERSION_NUM LIBCURL_VERSION_NUM
 
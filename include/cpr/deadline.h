@@ -0,0 +1,45 @@
+#ifndef CPR_DEADLINE_H
+#define CPR_DEADLINE_H
+
+#include <chrono>
+#include <optional>
+
+namespace cpr {
+
+/**
+ * Absolute point in time by which a request has to be done, including all of its redirects, retries and the time
+ * spent waiting in between. Unlike Timeout, which applies to each transfer on its own, each attempt only gets the
+ * budget that is left. Requests whose deadline passed fail with ErrorCode::OPERATION_TIMEDOUT before sending anything.
+ *
+ * Example:
+ * // 500ms from now, no matter how many attempts it takes
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/api"}, cpr::Deadline{std::chrono::milliseconds{500}}, retry_policy);
+ **/
+class Deadline {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Deadline(Clock::time_point p_time_point) : time_point{p_time_point} {}
+    /**
+     * Deadline the given budget from now on.
+     **/
+    template <typename Rep, typename Period>
+    explicit Deadline(const std::chrono::duration<Rep, Period>& budget) : time_point{Clock::now() + std::chrono::duration_cast<Clock::duration>(budget)} {}
+
+    /**
+     * Returns the budget left, rounded up to full milliseconds. Zero once the deadline passed.
+     **/
+    [[nodiscard]] std::chrono::milliseconds Remaining() const;
+    [[nodiscard]] bool Expired() const;
+
+    /**
+     * Returns the earlier one of both deadlines, or the one which is set.
+     **/
+    [[nodiscard]] static std::optional<Deadline> Earliest(const std::optional<Deadline>& first, const std::optional<Deadline>& second);
+
+    Clock::time_point time_point;
+};
+
+} // namespace cpr
+
+#endif
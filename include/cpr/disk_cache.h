@@ -0,0 +1,211 @@
+#ifndef CPR_DISK_CACHE_H
+#define CPR_DISK_CACHE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpr/cprtypes.h"
+#include "cpr/filesystem.h"
+#include "cpr/interceptor.h"
+#include "cpr/response.h"
+#include "cpr/session.h"
+
+namespace cpr {
+
+constexpr size_t CPR_DEFAULT_DISK_CACHE_SIZE = static_cast<size_t>(1024) * 1024 * 1024;
+constexpr size_t CPR_DEFAULT_DISK_CACHE_SEGMENT_SIZE = static_cast<size_t>(64) * 1024 * 1024;
+constexpr size_t CPR_DEFAULT_DISK_CACHE_INDEX_SLOTS = static_cast<size_t>(64) * 1024;
+
+struct DiskCacheOptions {
+    /**
+     * Upper bound for the total size of all segment files.
+     * Once exceeded, the oldest segment gets deleted together with all responses stored in it.
+     **/
+    size_t max_size{CPR_DEFAULT_DISK_CACHE_SIZE};
+
+    /**
+     * A new segment file gets started once the current one reached this size.
+     * Smaller segments make eviction more fine grained, larger ones mean fewer files.
+     **/
+    size_t segment_size{CPR_DEFAULT_DISK_CACHE_SEGMENT_SIZE};
+
+    /**
+     * Number of slots of the index. Rounded up to a power of two. Changing it discards an existing cache.
+     **/
+    size_t index_slots{CPR_DEFAULT_DISK_CACHE_INDEX_SLOTS};
+
+    /**
+     * Time to live for responses without explicit freshness information (Cache-Control/Expires).
+     * By default such responses are only stored in case they carry validators (ETag/Last-Modified) and get revalidated before every use.
+     **/
+    std::chrono::seconds default_ttl{0};
+
+    /**
+     * Call fdatasync on the segment file before a new response becomes visible in the index.
+     * Without it, a power loss may leave index slots pointing to data which never made it to disk. Therefore the body
+     * of a response stored without it gets its checksum verified the first time a DiskCache opened later serves it.
+     **/
+    bool sync_writes{false};
+
+    /**
+     * Verify the checksum of the whole body on every hit. Detects bodies which got corrupted on disk later on,
+     * at the cost of reading the entire body every time.
+     **/
+    bool verify_checksums{false};
+
+    /**
+     * Hand out the bodies of hits memory mapped via Response::chunked_body instead of reading them into
+     * Response::text. Avoids copying large bodies, but callers have to look at chunked_body for hits, while responses
+     * coming from the network keep using Response::text.
+     **/
+    bool map_bodies{false};
+};
+
+/**
+ * Persistent HTTP cache surviving process restarts.
+ * - Responses are appended to segment files (segment-XXXXXXXX.dat) and never modified afterwards.
+ * - A memory mapped hash index (index.dat) maps the fingerprint of method and URL to the location of the record.
+ *   Lookups are a few memory accesses without any read(2) on the index.
+ * - Writes are crash safe: A record becomes visible only after it got written completely and every index slot
+ *   carries its own checksum. Torn or dangling slots found after a crash are treated as misses, so are bodies which
+ *   did not make it to disk (see DiskCacheOptions::sync_writes).
+ * - The cache is bounded by DiskCacheOptions::max_size. Eviction deletes whole segments, oldest first.
+ * - Bodies of hits end up in Response::text like for any other response. With DiskCacheOptions::map_bodies they get
+ *   memory mapped instead and handed out via Response::chunked_body, loaded lazily by the kernel and shared between
+ *   processes.
+ *
+ * Freshness follows the same rules as the in memory HttpCache. Responses varying on request header fields (Vary)
+ * are only served to requests carrying the same values for them. Since the index is keyed by method and URL, only
+ * the variant stored last is kept per URL. Responses with "Vary: *" are never stored.
+ *
+ * A cache directory can only be used by one DiskCache at a time. A second instance (in this or another process)
+ * fails with std::system_error. Not supported on Windows, where the constructor throws std::runtime_error.
+ *
+ * Use it through a DiskCacheInterceptor.
+ **/
+class DiskCache {
+  public:
+    using Clock = std::chrono::system_clock;
+
+    struct LookupResult {
+        Response response;
+        // False in case the response has to be revalidated before use
+        bool fresh{false};
+    };
+
+    /**
+     * Opens (or creates) the cache in the given directory.
+     * Throws std::system_error in case the directory can not be used.
+     **/
+    explicit DiskCache(const fs::path& directory, DiskCacheOptions options = {});
+    DiskCache(const DiskCache& other) = delete;
+    DiskCache(DiskCache&& old) = delete;
+    ~DiskCache();
+
+    DiskCache& operator=(const DiskCache& other) = delete;
+    DiskCache& operator=(DiskCache&& old) = delete;
+
+    /**
+     * Returns the stored response for the request, if any and the request header matches the fields it varies on.
+     **/
+    [[nodiscard]] std::optional<LookupResult> Lookup(std::string_view method, const std::string& url, const Header& request_header = Header{});
+
+    /**
+     * Stores the response in case it is cacheable. Returns true if it got stored.
+     * The body is taken from Response::text or, in case that is empty, from Response::chunked_body.
+     **/
+    bool Store(std::string_view method, const std::string& url, const Header& request_header, const Response& response);
+
+    /**
+     * Extends the lifetime of the stored response based on the header of a "304 Not Modified" response.
+     **/
+    void Freshen(std::string_view method, const std::string& url, const Response& not_modified);
+
+    /**
+     * Removes all responses stored for the URL (e.g. after a successful unsafe request to it).
+     **/
+    void Invalidate(const std::string& url);
+    /**
+     * Removes all responses and deletes all segment files.
+     **/
+    void Clear();
+
+    /**
+     * Total size of all segment files in bytes.
+     **/
+    [[nodiscard]] size_t GetSize() const;
+    [[nodiscard]] size_t GetEntryCount() const;
+    [[nodiscard]] size_t GetMaxSize() const;
+
+  private:
+    struct IndexSlot;
+    struct Segment;
+
+    /**
+     * Owns the locked index file and its mapping, so both get released as well in case the constructor throws.
+     **/
+    struct IndexFile {
+        int fd{-1};
+        size_t mapping_size{0};
+        void* mapping{nullptr};
+
+        IndexFile() = default;
+        IndexFile(const IndexFile& other) = delete;
+        IndexFile(IndexFile&& old) = delete;
+        IndexFile& operator=(const IndexFile& other) = delete;
+        IndexFile& operator=(IndexFile&& old) = delete;
+        ~IndexFile();
+    };
+
+    [[nodiscard]] std::optional<size_t> findSlot(uint64_t fingerprint) const;
+    void openIndex();
+    void openSegments();
+    std::shared_ptr<Segment> createSegment();
+    void evict();
+    void removeSegment(uint32_t id);
+    void clearSlot(IndexSlot& slot);
+
+    fs::path directory_;
+    DiskCacheOptions options_;
+    mutable std::mutex mutex_;
+    IndexFile index_;
+    IndexSlot* slots_{nullptr};
+    size_t slot_count_{0};
+    size_t entry_count_{0};
+    // Per slot, true once the body is known to be on disk: written or verified by this instance
+    std::vector<bool> verified_;
+    // Ordered by id, so the first one is the oldest
+    std::map<uint32_t, std::shared_ptr<Segment>> segments_;
+    size_t total_size_{0};
+};
+
+/**
+ * Serves requests of a Session from a DiskCache.
+ *
+ * Example:
+ * auto cache = std::make_shared<cpr::DiskCache>("/var/cache/my_worker");
+ * cpr::Session session;
+ * session.AddInterceptor(std::make_shared<cpr::DiskCacheInterceptor>(cache));
+ * cpr::Response r = session.Get();
+ **/
+class DiskCacheInterceptor : public Interceptor {
+  public:
+    explicit DiskCacheInterceptor(std::shared_ptr<DiskCache> cache);
+
+    Response intercept(Session& session) override;
+
+  private:
+    std::shared_ptr<DiskCache> cache_;
+};
+
+} // namespace cpr
+
+#endif
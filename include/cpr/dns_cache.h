@@ -0,0 +1,151 @@
+#ifndef CPR_DNS_CACHE_H
+#define CPR_DNS_CACHE_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cpr {
+
+struct DnsRecord {
+    // Numeric IPv4 or IPv6 addresses, e.g. "127.0.0.1" or "::1"
+    std::vector<std::string> addresses;
+    // Time to live reported by the resolver. Zero in case it is unknown (e.g. getaddrinfo), DnsCacheOptions::default_ttl is used then.
+    std::chrono::seconds ttl{0};
+};
+
+struct DnsCacheOptions {
+    /**
+     * Time to live for records where the resolver does not know it.
+     **/
+    std::chrono::seconds default_ttl{60};
+    /**
+     * Bounds applied to every time to live.
+     **/
+    std::chrono::seconds min_ttl{1};
+    std::chrono::seconds max_ttl{3600};
+    /**
+     * Share of the time to live after which a record gets refreshed in the background when it is used.
+     * Records in use therefore get replaced before they expire and lookups never wait for the resolver.
+     **/
+    double refresh_ratio{0.75};
+    /**
+     * How long an expired record keeps being served in case resolving the host again fails.
+     **/
+    std::chrono::seconds max_stale{300};
+};
+
+/**
+ * Process wide DNS cache shared by all sessions using it.
+ * In contrast to the DNS cache of libcurl, which lives inside each handle (or share) and simply forgets entries after
+ * 60 seconds, the DnsCache
+ * - honours the time to live of the records,
+ * - refreshes records in use in the background before they expire,
+ * - keeps serving expired records in case the resolver fails (e.g. a DNS server hiccup).
+ *
+ * Sessions get the addresses handed to libcurl via CURLOPT_RESOLVE before each request, so libcurl does not resolve
+ * the host itself. Resolve entries set explicitly on the session (cpr::Resolve) take precedence.
+ *
+ * Like the ConnectionPool, copies of a DnsCache share the same state and it is thread safe.
+ *
+ * Example:
+ * cpr::DnsCache dns_cache;
+ * dns_cache.Prefetch("example.com");
+ * cpr::Response r = cpr::Get(cpr::Url{"http://example.com"}, dns_cache);
+ **/
+class DnsCache {
+  public:
+    using Clock = std::chrono::steady_clock;
+    /**
+     * Resolves the given host name. Returns std::nullopt in case resolving failed.
+     * Gets called from the thread requesting the lookup or from the default executor for background refreshes.
+     **/
+    using Resolver = std::function<std::optional<DnsRecord>(const std::string& host)>;
+
+    struct Metrics {
+        // Lookups answered from the cache without waiting for the resolver
+        size_t hits{0};
+        // Lookups which had to wait for the resolver
+        size_t misses{0};
+        // Background refreshes started
+        size_t refreshes{0};
+        // Lookups answered with an expired record since the resolver failed
+        size_t stale_hits{0};
+        // Failed resolver calls
+        size_t failures{0};
+    };
+
+    /**
+     * @param resolver Resolver used to look up host names. Defaults to SystemResolve (getaddrinfo).
+     **/
+    explicit DnsCache(DnsCacheOptions options = {}, Resolver resolver = nullptr);
+    DnsCache(const DnsCache&) = default;
+    DnsCache(DnsCache&&) noexcept = default;
+    ~DnsCache() = default;
+
+    DnsCache& operator=(const DnsCache&) = default;
+    DnsCache& operator=(DnsCache&&) noexcept = default;
+
+    /**
+     * Returns the addresses of the host. Only blocks in case the host is not cached yet or its record expired.
+     * Returns std::nullopt in case the host can not be resolved and there is no stale record to fall back to.
+     **/
+    [[nodiscard]] std::optional<std::vector<std::string>> Resolve(const std::string& host) const;
+
+    /**
+     * Resolves the host in the background, so following lookups do not have to wait.
+     **/
+    void Prefetch(const std::string& host) const;
+
+    /**
+     * Returns a CURLOPT_RESOLVE entry ("host:port:address,...") for the host of the given URL.
+     * Returns std::nullopt for URLs containing a numeric address and for hosts which can not be resolved.
+     **/
+    [[nodiscard]] std::optional<std::string> GetResolveEntry(const std::string& url) const;
+
+    void Invalidate(const std::string& host) const;
+    void Clear() const;
+
+    [[nodiscard]] size_t GetEntryCount() const;
+    [[nodiscard]] Metrics GetMetrics() const;
+
+    /**
+     * Resolves the host via getaddrinfo. The time to live is not known this way.
+     **/
+    [[nodiscard]] static std::optional<DnsRecord> SystemResolve(const std::string& host);
+
+  private:
+    struct Entry {
+        std::vector<std::string> addresses;
+        Clock::time_point refresh_time;
+        Clock::time_point expire_time;
+        bool refreshing{false};
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        DnsCacheOptions options;
+        Resolver resolver;
+        Metrics metrics;
+
+        /**
+         * Calls the resolver and updates the entry. Returns the new addresses or std::nullopt on failure.
+         **/
+        std::optional<std::vector<std::string>> refresh(const std::string& host);
+    };
+
+    static void refreshInBackground(const std::shared_ptr<State>& state, const std::string& host);
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
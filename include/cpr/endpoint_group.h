@@ -0,0 +1,145 @@
+#ifndef CPR_ENDPOINT_GROUP_H
+#define CPR_ENDPOINT_GROUP_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpr/response.h"
+
+namespace cpr {
+
+enum class LoadBalancingPolicy : uint8_t {
+    // Endpoints in turn
+    ROUND_ROBIN,
+    // Endpoint with the fewest requests in flight
+    LEAST_OUTSTANDING,
+    // Endpoint with the lowest latency average weighted by its requests in flight. Latency spikes count right away.
+    PEAK_EWMA,
+};
+
+struct EndpointGroupOptions {
+    LoadBalancingPolicy policy{LoadBalancingPolicy::PEAK_EWMA};
+    /**
+     * Time after which a latency sample has decayed to 1/e of its weight in the PEAK_EWMA average.
+     **/
+    std::chrono::milliseconds decay_time{10000};
+    /**
+     * Consecutive failed requests which eject an endpoint. Zero never ejects endpoints.
+     **/
+    uint32_t max_consecutive_failures{5};
+    /**
+     * How long an ejected endpoint gets no requests. Afterwards a single probe request decides whether it is admitted again.
+     **/
+    std::chrono::milliseconds ejection_duration{30000};
+};
+
+/**
+ * Spreads requests across replicas of a service, e.g. several addresses of the same host or several base URLs.
+ * Each request made by a session with an EndpointGroup goes to the endpoint picked by the load balancing policy.
+ *
+ * An endpoint is either
+ * - an address like "10.0.0.1:8080", "10.0.0.1" or "[::1]:8080", which the request connects to while keeping its URL,
+ *   and thus its Host header and SNI (CURLOPT_CONNECT_TO), or
+ * - a base URL like "https://replica1.example.com:8443", which replaces the scheme and authority of the request URL.
+ *
+ * The latency of an endpoint is taken from Response::elapsed. Endpoints failing too often in a row
+ * (see CircuitBreaker::IsFailure()) get ejected and admitted again after a successful probe. In case all endpoints are
+ * ejected, requests are spread across all of them nevertheless.
+ *
+ * Like the ConnectionPool, copies of an EndpointGroup share the same state and it is thread safe.
+ *
+ * Example:
+ * cpr::EndpointGroup replicas{{"10.0.0.1:443", "10.0.0.2:443", "10.0.0.3:443"}};
+ * cpr::Response r = cpr::Get(cpr::Url{"https://api.example.com/items"}, replicas);
+ **/
+class EndpointGroup {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct EndpointStatus {
+        std::string endpoint;
+        bool ejected{false};
+        size_t outstanding{0};
+        // Zero until the first successful request completed
+        std::chrono::microseconds latency{0};
+        size_t requests{0};
+        size_t failures{0};
+    };
+
+    explicit EndpointGroup(const std::vector<std::string>& endpoints, EndpointGroupOptions options = {});
+    EndpointGroup(const EndpointGroup&) = default;
+    EndpointGroup(EndpointGroup&&) noexcept = default;
+    ~EndpointGroup() = default;
+
+    EndpointGroup& operator=(const EndpointGroup&) = default;
+    EndpointGroup& operator=(EndpointGroup&&) noexcept = default;
+
+    /**
+     * Picks the endpoint for the next request and counts the request as outstanding on it.
+     * Each call has to be followed by either Record() or Release().
+     **/
+    [[nodiscard]] size_t Acquire() const;
+    /**
+     * Records the outcome of a request to the endpoint.
+     **/
+    void Record(size_t index, const Response& response) const;
+    /**
+     * Gives back an endpoint acquired for a request which did not get made.
+     **/
+    void Release(size_t index) const;
+
+    /**
+     * Returns the URL to request from the endpoint, i.e. the URL with the base URL of the endpoint in case it has one.
+     **/
+    [[nodiscard]] std::string GetUrl(size_t index, std::string_view url) const;
+    /**
+     * Returns the CURLOPT_CONNECT_TO entry of the endpoint, or std::nullopt for base URLs.
+     **/
+    [[nodiscard]] const std::optional<std::string>& GetConnectTo(size_t index) const;
+
+    [[nodiscard]] std::vector<EndpointStatus> GetStatus() const;
+
+  private:
+    struct Endpoint {
+        std::string endpoint;
+        std::optional<std::string> connect_to;
+        size_t outstanding{0};
+        // Seconds, zero until the first sample
+        double ewma{0};
+        Clock::time_point last_sample;
+        uint32_t consecutive_failures{0};
+        bool ejected{false};
+        // Set once the ejection passed and the probe request is in flight
+        bool probing{false};
+        Clock::time_point ejected_until;
+        size_t requests{0};
+        size_t failures{0};
+    };
+
+    struct State {
+        std::mutex mutex;
+        EndpointGroupOptions options;
+        // Never resized, so indexes handed out stay valid
+        std::vector<Endpoint> endpoints;
+        size_t next{0};
+
+        [[nodiscard]] bool IsAvailable(const Endpoint& endpoint, Clock::time_point now) const;
+        /**
+         * Returns the cost of sending another request to the endpoint according to the policy. Lower is better.
+         **/
+        [[nodiscard]] double GetCost(const Endpoint& endpoint) const;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
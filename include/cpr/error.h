@@ -81,6 +81,10 @@ enum class ErrorCode {
     SSL_CLIENTCERT,
     UNRECOVERABLE_POLL,
     TOO_LARGE,
+    /**
+     * Not a curl error. The request was not sent since the CircuitBreaker of the host is open.
+     **/
+    CIRCUIT_OPEN,
     /**
      * An unknown error inside curl occurred.
      * Please try to reproduce it and then report it to us.
@@ -155,6 +159,7 @@ inline const std::unordered_map<ErrorCode, std::string>& get_error_code_to_strin
                                                                        {ErrorCode::SSL_CLIENTCERT, "SSL_CLIENTCERT"},
                                                                        {ErrorCode::UNRECOVERABLE_POLL, "UNRECOVERABLE_POLL"},
                                                                        {ErrorCode::TOO_LARGE, "TOO_LARGE"},
+                                                                       {ErrorCode::CIRCUIT_OPEN, "CIRCUIT_OPEN"},
                                                                        {ErrorCode::UNKNOWN_ERROR, "UNKNOWN_ERROR"}};
     return mapping;
 }
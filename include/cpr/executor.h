@@ -0,0 +1,112 @@
+#ifndef CPR_EXECUTOR_H
+#define CPR_EXECUTOR_H
+
+#include <concepts>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace cpr {
+
+/**
+ * Scheduling class of asynchronous work, see ThreadPool.
+ **/
+enum class Priority {
+    // Latency critical requests, e.g. triggered by a user waiting for them
+    Interactive = 0,
+    Normal = 1,
+    // Background transfers, using the capacity left over by the others
+    Bulk = 2,
+};
+
+/**
+ * Runs the asynchronous work of cpr:
+ * - cpr::async() and the cpr::*Async() functions,
+ * - Session::*Async(), Session::*Callback() and Session::Co*Async(),
+ * - the resumption of coroutines awaiting a coroutine::Task or coroutine::SleepFor,
+ * - background refreshes of the DnsCache and HttpCache.
+ *
+ * Implement Execute() (or use a FunctionExecutor) to hand this work to a scheduler of your own instead of having cpr
+ * run a second thread pool next to it. ThreadPool is the default implementation. Set an executor for everything via
+ * SetDefaultExecutor() or for the requests of a single session via Session::SetExecutor().
+ **/
+class Executor {
+  public:
+    using Task = std::function<void()>;
+
+    Executor() = default;
+    Executor(const Executor&) = default;
+    Executor(Executor&&) = default;
+    virtual ~Executor() = default;
+
+    Executor& operator=(const Executor&) = default;
+    Executor& operator=(Executor&&) = default;
+
+    /**
+     * Runs the task, usually on another thread. Tasks continuing after a delay (e.g. retries) get handed over from the
+     * thread of the TimerQueue, so Execute() should not block.
+     **/
+    virtual void Execute(Task task) = 0;
+
+    /**
+     * Runs the task with the given priority. Executors not distinguishing priorities run it via Execute().
+     **/
+    virtual void ExecuteWithPriority(Task task, Priority /*priority*/) {
+        Execute(std::move(task));
+    }
+
+    /**
+     * Return a future, calling future.get() will wait task done and return RetType.
+     * Submit(fn, args...)
+     * Submit(std::bind(&Class::mem_fn, &obj))
+     * Submit(std::mem_fn(&Class::mem_fn, &obj))
+     **/
+    template <class Fn, class... Args>
+    auto Submit(Fn&& fn, Args&&... args) {
+        using RetType = decltype(fn(args...));
+        auto task = std::make_shared<std::packaged_task<RetType()>>([fn = std::forward<Fn>(fn), args...]() mutable { return std::invoke(fn, args...); });
+        std::future<RetType> future = task->get_future();
+        Execute([task] { (*task)(); });
+        return future;
+    }
+};
+
+/**
+ * Types providing the executor for their asynchronous work, e.g. a Session or the promise of a coroutine::Task.
+ **/
+template <typename T>
+concept HasExecutor = requires(T& owner) {
+    { owner.GetExecutor() } -> std::convertible_to<std::shared_ptr<Executor>>;
+};
+
+/**
+ * Runs each task right away on the thread handing it over.
+ * Turns Session::*Async() into blocking calls returning a ready future, which mainly helps with tests and with
+ * callers already running on a thread of their own scheduler.
+ **/
+class InlineExecutor : public Executor {
+  public:
+    void Execute(Task task) override;
+};
+
+/**
+ * Adapts a scheduler of your own by handing each task to the given function.
+ *
+ * Example:
+ * auto executor = std::make_shared<cpr::FunctionExecutor>([&io_context](cpr::Executor::Task task) { asio::post(io_context, std::move(task)); });
+ * cpr::SetDefaultExecutor(executor);
+ **/
+class FunctionExecutor : public Executor {
+  public:
+    explicit FunctionExecutor(std::function<void(Task task)> execute);
+
+    void Execute(Task task) override;
+
+  private:
+    std::function<void(Task task)> execute_;
+};
+
+} // namespace cpr
+
+#endif
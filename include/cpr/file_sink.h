@@ -0,0 +1,124 @@
+#ifndef CPR_FILE_SINK_H
+#define CPR_FILE_SINK_H
+
+#include <cstddef>
+#include <string_view>
+
+#include <curl/curl.h>
+
+#include "cpr/cprtypes.h"
+#include "cpr/filesystem.h"
+
+namespace cpr {
+
+class Session;
+
+struct FileSinkOptions {
+    /**
+     * Size of the staging buffer incoming chunks get coalesced into before they are handed to write(2).
+     * Rounded up to a multiple of the 4 KiB page/sector size so that every flush stays O_DIRECT compatible.
+     **/
+    size_t buffer_size{static_cast<size_t>(1024) * 1024};
+
+    /**
+     * Reserve disk space for the whole body (fallocate) once the Content-Length of the response is known.
+     * Only supported on Linux. Ignored in case the server does not announce a Content-Length.
+     **/
+    bool preallocate{false};
+
+    /**
+     * Bypass the page cache (O_DIRECT) for responses with a Content-Length of at least direct_io_threshold bytes.
+     * Only supported on Linux. Silently falls back to buffered I/O in case the file system rejects O_DIRECT.
+     **/
+    bool direct_io{false};
+    cpr_off_t direct_io_threshold{static_cast<cpr_off_t>(1024) * 1024 * 1024};
+
+    /**
+     * Call fdatasync once the download completed so the data is durable when Download() returns.
+     **/
+    bool sync_on_finish{false};
+};
+
+/**
+ * Download target writing straight to a file descriptor.
+ * In contrast to downloading into a std::ofstream, where every libcurl chunk (usually 16 KiB) results in a
+ * write call, the FileSink coalesces chunks in a page aligned buffer and only issues large aligned writes.
+ *
+ * Example:
+ * cpr::FileSink sink{"big.iso", cpr::FileSinkOptions{.preallocate = true, .sync_on_finish = true}};
+ * cpr::Response r = cpr::Download(sink, cpr::Url{"http://xxx/big.iso"});
+ **/
+class FileSink {
+  public:
+    /**
+     * Creates (or truncates) the file at the given path.
+     * Throws std::system_error in case the file can not be opened.
+     **/
+    explicit FileSink(const fs::path& path, FileSinkOptions options = {});
+    /**
+     * Writes into an already open file descriptor starting at its current offset.
+     * The FileSink does not take ownership of the descriptor.
+     **/
+    explicit FileSink(int fd, FileSinkOptions options = {});
+    FileSink(const FileSink& other) = delete;
+    FileSink(FileSink&& old) = delete;
+    ~FileSink();
+
+    FileSink& operator=(const FileSink& other) = delete;
+    FileSink& operator=(FileSink&& old) = delete;
+
+    /**
+     * Appends the given data. Returns false in case writing to the file failed.
+     **/
+    bool Write(std::string_view data);
+
+    /**
+     * Writes all buffered data to the file.
+     **/
+    bool Flush();
+
+    /**
+     * Flushes and, if requested via FileSinkOptions::sync_on_finish, syncs the file to disk.
+     * Gets called automatically at the end of every download.
+     **/
+    bool Finish();
+
+    /**
+     * Reserves disk space for the given number of bytes starting at the current write offset.
+     **/
+    bool Preallocate(cpr_off_t length);
+
+    [[nodiscard]] bool IsOpen() const;
+    [[nodiscard]] int GetFd() const;
+    [[nodiscard]] cpr_off_t GetBytesWritten() const;
+    [[nodiscard]] bool IsDirectIo() const;
+
+  private:
+    friend Session;
+
+    /**
+     * Resets the per transfer state. The handle is used to query the Content-Length once the first chunk arrives.
+     **/
+    void begin(CURL* handle);
+    void onFirstChunk();
+    bool writeAll(const char* data, size_t size);
+    bool setDirectIo(bool enable);
+
+    FileSinkOptions options_;
+    int fd_{-1};
+    bool owns_fd_{false};
+    bool direct_io_{false};
+    bool failed_{false};
+    bool first_chunk_{true};
+    CURL* handle_{nullptr};
+    char* buffer_{nullptr};
+    size_t buffer_size_{0};
+    size_t buffered_{0};
+    // Offset of fd_ the sink started writing at, bytes_written_ are counted from there
+    cpr_off_t start_offset_{0};
+    cpr_off_t bytes_written_{0};
+};
+
+} // namespace cpr
+
+#endif
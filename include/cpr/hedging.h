@@ -0,0 +1,133 @@
+#ifndef CPR_HEDGING_H
+#define CPR_HEDGING_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cpr/resolve.h"
+
+namespace cpr {
+
+struct HedgeOptions {
+    /**
+     * Time without a response after which a hedge gets sent. Zero derives it from the observed latencies.
+     **/
+    std::chrono::milliseconds delay{0};
+    /**
+     * Percentile of the observed latencies used as delay, e.g. 0.95 sends a hedge for the slowest 5% of the requests.
+     **/
+    double percentile{0.95};
+    /**
+     * Delay used until min_samples latencies have been observed.
+     **/
+    std::chrono::milliseconds initial_delay{100};
+    size_t min_samples{20};
+    /**
+     * Number of most recent latencies the percentile gets derived from.
+     **/
+    size_t max_samples{1000};
+    /**
+     * Upper bound for hedges relative to requests. 0.05 allows at most 5% extra requests.
+     **/
+    double max_extra_load{0.05};
+    /**
+     * Addresses hedges connect to in turn instead of the one the request went to, e.g. other replicas of the backend.
+     * Only the address of an entry is used, the request keeps its host name (CURLOPT_CONNECT_TO). Empty to connect as usual.
+     **/
+    std::vector<Resolve> targets;
+};
+
+/**
+ * Sends a duplicate (hedge) of a GET, HEAD or OPTIONS request in case no response arrived within a delay.
+ * The first successful response wins and the other transfer gets cancelled. Reduces the tail latency caused by
+ * occasionally slow backend replicas for the price of a bounded amount of extra requests.
+ *
+ * Both transfers run on a multi handle owned by the session, driven by the thread making the request. No further threads
+ * are involved. A transfer is successful in case it completed without error and with a status code below 500.
+ * Requests delivering their body to a callback (WriteCallback, ServerSentEventCallback, HeaderCallback or
+ * ChunkAllocator) never get hedged, neither do downloads or requests inside a MultiPerform.
+ *
+ * Like the ConnectionPool, copies of a HedgePolicy share the same state (latencies and budget) and it is thread safe.
+ *
+ * Example:
+ * cpr::HedgePolicy hedge_policy;
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/replicated"}, hedge_policy);
+ **/
+class HedgePolicy {
+  public:
+    struct Metrics {
+        // Requests which could have been hedged
+        size_t requests{0};
+        // Hedges sent
+        size_t hedges{0};
+        // Requests answered by the hedge
+        size_t hedge_wins{0};
+        // Hedges not sent since the budget was used up
+        size_t budget_exhausted{0};
+    };
+
+    explicit HedgePolicy(HedgeOptions options = {});
+    HedgePolicy(const HedgePolicy&) = default;
+    HedgePolicy(HedgePolicy&&) noexcept = default;
+    ~HedgePolicy() = default;
+
+    HedgePolicy& operator=(const HedgePolicy&) = default;
+    HedgePolicy& operator=(HedgePolicy&&) noexcept = default;
+
+    /**
+     * Returns the time without a response after which a hedge gets sent.
+     **/
+    [[nodiscard]] std::chrono::milliseconds GetDelay() const;
+
+    /**
+     * Counts a request which may get hedged.
+     **/
+    void RecordRequest() const;
+    /**
+     * Takes a hedge from the budget. Returns false in case the budget is used up.
+     **/
+    [[nodiscard]] bool TryAcquireHedge() const;
+    /**
+     * Records the latency of a completed request, hedged or not.
+     **/
+    void RecordLatency(std::chrono::milliseconds latency, bool hedge_won) const;
+
+    /**
+     * Returns the CURLOPT_CONNECT_TO entries for the next hedge, empty in case there are no targets.
+     **/
+    [[nodiscard]] std::vector<std::string> GetNextConnectTo() const;
+
+    [[nodiscard]] Metrics GetMetrics() const;
+
+  private:
+    struct State {
+        std::mutex mutex;
+        HedgeOptions options;
+        // Ring buffer of the most recent latencies
+        std::vector<std::chrono::milliseconds> latencies;
+        size_t next_latency{0};
+        // The same latencies in order. Points to the percentile of them, so GetDelay() does not need to sort them.
+        std::multiset<std::chrono::milliseconds> sorted_latencies;
+        std::multiset<std::chrono::milliseconds>::const_iterator percentile_latency{sorted_latencies.end()};
+        size_t percentile_index{0};
+        size_t next_target{0};
+        Metrics metrics;
+
+        void InsertLatency(std::chrono::milliseconds latency);
+        void EraseLatency(std::chrono::milliseconds latency);
+        // Moves percentile_latency to the percentile after the number of latencies changed by one
+        void SeekPercentile();
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
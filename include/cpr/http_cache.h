@@ -0,0 +1,200 @@
+#ifndef CPR_HTTP_CACHE_H
+#define CPR_HTTP_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cpr/cprtypes.h"
+#include "cpr/interceptor.h"
+#include "cpr/multiperform.h"
+#include "cpr/response.h"
+#include "cpr/session.h"
+
+namespace cpr {
+
+constexpr size_t CPR_DEFAULT_HTTP_CACHE_SIZE = static_cast<size_t>(64) * 1024 * 1024;
+constexpr size_t CPR_DEFAULT_HTTP_CACHE_SHARDS = 16;
+
+/**
+ * In memory HTTP cache following the caching rules of RFC 9111 for a private (client side) cache.
+ * - Responses are stored by method, URL and the request header fields listed in their Vary header.
+ * - Freshness is based on Cache-Control (max-age, no-cache, no-store, must-revalidate) or Expires.
+ *   Responses with a Last-Modified header but without explicit freshness get a heuristic lifetime of 10% of their age.
+ * - Stale responses carrying an ETag or Last-Modified get revalidated via If-None-Match/If-Modified-Since.
+ * - Within the stale-while-revalidate window stale responses are served directly while being revalidated in the background.
+ *
+ * The cache is bounded by a byte budget. Least recently used responses get evicted first.
+ * Entries are spread over independently locked shards, so concurrent lookups of different URLs do not contend.
+ *
+ * Use it through a CacheInterceptor (Session) or a CacheInterceptorMulti (MultiPerform).
+ * Both may share the same HttpCache.
+ **/
+class HttpCache {
+  public:
+    using Clock = std::chrono::system_clock;
+
+    enum class Freshness {
+        // May be served without contacting the server
+        FRESH,
+        // Stale, but may be served while being revalidated in the background
+        STALE_WHILE_REVALIDATE,
+        // Has to be revalidated (or fetched again) before use
+        STALE,
+    };
+
+    struct Entry {
+        std::string key;
+        // Request header fields (name, value) this response varies on
+        std::vector<std::pair<std::string, std::string>> vary;
+        // Stored without the handle of the session it was received by, so Response::GetCertInfos() returns nothing
+        Response response;
+        Clock::time_point response_time;
+        std::chrono::seconds initial_age{0};
+        std::chrono::seconds freshness_lifetime{0};
+        std::chrono::seconds stale_while_revalidate{0};
+        std::string etag;
+        std::string last_modified;
+        size_t size{0};
+        // Set while a background revalidation for this entry is running
+        mutable std::atomic_bool revalidating{false};
+
+        [[nodiscard]] Freshness GetFreshness(Clock::time_point now) const;
+        [[nodiscard]] bool HasValidators() const;
+    };
+
+    struct LookupResult {
+        std::shared_ptr<const Entry> entry;
+        Freshness freshness{Freshness::STALE};
+    };
+
+    explicit HttpCache(size_t max_bytes = CPR_DEFAULT_HTTP_CACHE_SIZE, size_t shard_count = CPR_DEFAULT_HTTP_CACHE_SHARDS);
+    HttpCache(const HttpCache& other) = delete;
+    HttpCache(HttpCache&& old) = delete;
+    ~HttpCache() = default;
+
+    HttpCache& operator=(const HttpCache& other) = delete;
+    HttpCache& operator=(HttpCache&& old) = delete;
+
+    /**
+     * Returns the stored response matching the request, if any.
+     * Requests sending "Cache-Control: no-cache" (or max-age=0) always get a STALE result, forcing revalidation.
+     **/
+    [[nodiscard]] std::optional<LookupResult> Lookup(std::string_view method, const std::string& url, const Header& request_header);
+
+    /**
+     * Stores the response in case it is cacheable. Returns true if it got stored.
+     **/
+    bool Store(std::string_view method, const std::string& url, const Header& request_header, const Response& response);
+
+    /**
+     * Updates the given stale entry with the header of a "304 Not Modified" response.
+     * Returns the refreshed entry.
+     **/
+    std::shared_ptr<const Entry> Freshen(const std::shared_ptr<const Entry>& entry, const Response& not_modified);
+
+    /**
+     * Removes all responses stored for the URL (e.g. after a successful unsafe request to it).
+     **/
+    void Invalidate(const std::string& url);
+    void Clear();
+
+    [[nodiscard]] size_t GetSize() const;
+    [[nodiscard]] size_t GetEntryCount() const;
+    [[nodiscard]] size_t GetMaxSize() const;
+
+    /**
+     * Adds If-None-Match/If-Modified-Since based on the validators of the entry to the header.
+     **/
+    static void AddConditionalHeader(Header& header, const Entry& entry);
+    /**
+     * True for requests which must neither be answered from nor stored in the cache (Cache-Control: no-store).
+     **/
+    [[nodiscard]] static bool BypassesCache(const Header& request_header);
+    /**
+     * Remaining freshness of the response based on its Cache-Control, Expires, Age and Last-Modified header fields.
+     * Returns std::nullopt for responses which must not be stored or have neither freshness nor validators.
+     **/
+    [[nodiscard]] static std::optional<std::chrono::seconds> GetTimeToLive(const Response& response);
+    /**
+     * Lower case names of the request header fields listed in the Vary header of the response.
+     * Returns std::nullopt for "Vary: *", since such a response never matches another request.
+     **/
+    [[nodiscard]] static std::optional<std::vector<std::string>> GetVaryFields(const Header& response_header);
+
+    /**
+     * Handles the network response of a request previously looked up in the cache.
+     * Turns a "304 Not Modified" for a stale entry into the refreshed cached response and stores cacheable responses.
+     **/
+    Response HandleResponse(std::string_view method, const std::string& url, const Header& request_header, const std::shared_ptr<const Entry>& stale_entry, Response response);
+
+  private:
+    struct Shard {
+        mutable std::mutex mutex;
+        // Most recently used entries are at the front
+        std::list<std::shared_ptr<Entry>> lru;
+        std::unordered_map<std::string, std::vector<std::list<std::shared_ptr<Entry>>::iterator>> index;
+        size_t size{0};
+    };
+
+    Shard& getShard(const std::string& key);
+    void insert(std::shared_ptr<Entry> entry);
+    void evict(Shard& shard, size_t max_shard_size);
+
+    size_t max_bytes_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+/**
+ * Serves requests of a Session from an HttpCache.
+ *
+ * Example:
+ * auto cache = std::make_shared<cpr::HttpCache>();
+ * cpr::Session session;
+ * session.AddInterceptor(std::make_shared<cpr::CacheInterceptor>(cache));
+ **/
+class CacheInterceptor : public Interceptor {
+  public:
+    /**
+     * Creates the session used for background revalidations (stale-while-revalidate).
+     * The session gets the URL and request header set afterwards. By default a plain Session is used,
+     * so provide a factory in case the requests need further options like authentication or TLS settings.
+     **/
+    using SessionFactory = std::function<std::shared_ptr<Session>()>;
+
+    explicit CacheInterceptor(std::shared_ptr<HttpCache> cache, SessionFactory session_factory = nullptr);
+
+    Response intercept(Session& session) override;
+
+  private:
+    std::shared_ptr<HttpCache> cache_;
+    SessionFactory session_factory_;
+};
+
+/**
+ * Serves requests of a MultiPerform from an HttpCache. Only the sessions missing the cache hit the network.
+ **/
+class CacheInterceptorMulti : public InterceptorMulti {
+  public:
+    explicit CacheInterceptorMulti(std::shared_ptr<HttpCache> cache, CacheInterceptor::SessionFactory session_factory = nullptr);
+
+    std::vector<Response> intercept(MultiPerform& multi) override;
+
+  private:
+    std::shared_ptr<HttpCache> cache_;
+    CacheInterceptor::SessionFactory session_factory_;
+};
+
+} // namespace cpr
+
+#endif
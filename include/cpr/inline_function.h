@@ -0,0 +1,187 @@
+#ifndef CPR_INLINE_FUNCTION_H
+#define CPR_INLINE_FUNCTION_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cpr {
+
+template <typename Signature>
+class InlineFunction;
+
+/**
+ * Copyable, type-erased callable like std::function, used for the callbacks libcurl invokes once per chunk.
+ *
+ * Callables of up to kInlineSize bytes (e.g. lambdas capturing a std::shared_ptr and a std::string) get stored inside
+ * the object instead of on the heap, so constructing and copying them does not allocate. Calling it is a single
+ * indirect call into a trampoline instantiated for the stored type.
+ * Larger callables and the ones that may throw while being moved are kept on the heap.
+ *
+ * Empty in case it got constructed from nullptr, a null function pointer or an empty std::function.
+ * Calling an empty InlineFunction throws std::bad_function_call.
+ **/
+template <typename R, typename... Args>
+class InlineFunction<R(Args...)> {
+  public:
+    static constexpr size_t kInlineSize = 48;
+
+    InlineFunction() noexcept = default;
+    // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, InlineFunction> && std::is_copy_constructible_v<std::decay_t<F>> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions, bugprone-forwarding-reference-overload)
+    InlineFunction(F&& function) {
+        using Stored = std::decay_t<F>;
+        if constexpr (std::is_pointer_v<Stored> || std::is_member_pointer_v<Stored> || IsStdFunction<Stored>::value) {
+            if (!function) {
+                return;
+            }
+        }
+        if constexpr (kStoredInline<Stored>) {
+            ::new (static_cast<void*>(storage_.data())) Stored(std::forward<F>(function));
+        } else {
+            ::new (static_cast<void*>(storage_.data())) Stored*(new Stored(std::forward<F>(function)));
+        }
+        invoke_ = &invoke<Stored>;
+        manage_ = &manage<Stored>;
+    }
+
+    InlineFunction(const InlineFunction& other) : invoke_(other.invoke_), manage_(other.manage_) {
+        if (manage_ != nullptr) {
+            manage_(Operation::COPY, other.storage_.data(), storage_.data());
+        }
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept : invoke_(other.invoke_), manage_(other.manage_) {
+        if (manage_ != nullptr) {
+            manage_(Operation::MOVE, other.storage_.data(), storage_.data());
+            other.invoke_ = &invokeEmpty;
+            other.manage_ = nullptr;
+        }
+    }
+
+    ~InlineFunction() {
+        reset();
+    }
+
+    InlineFunction& operator=(const InlineFunction& other) {
+        if (this != &other) {
+            // Copy first, so this stays unchanged in case copying the callable throws
+            InlineFunction copy{other};
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.manage_ != nullptr) {
+                other.manage_(Operation::MOVE, other.storage_.data(), storage_.data());
+                invoke_ = other.invoke_;
+                manage_ = other.manage_;
+                other.invoke_ = &invokeEmpty;
+                other.manage_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    R operator()(Args... args) const {
+        return invoke_(storage_.data(), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept {
+        return manage_ != nullptr;
+    }
+
+  private:
+    enum class Operation { COPY, MOVE, DESTROY };
+
+    template <typename T>
+    struct IsStdFunction : std::false_type {};
+    template <typename Signature>
+    struct IsStdFunction<std::function<Signature>> : std::true_type {};
+
+    template <typename Stored>
+    static constexpr bool kStoredInline = sizeof(Stored) <= kInlineSize && alignof(Stored) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Stored>;
+
+    template <typename Stored>
+    static Stored& target(std::byte* storage) noexcept {
+        if constexpr (kStoredInline<Stored>) {
+            return *std::launder(reinterpret_cast<Stored*>(storage));
+        } else {
+            return **std::launder(reinterpret_cast<Stored**>(storage));
+        }
+    }
+
+    template <typename Stored>
+    static R invoke(std::byte* storage, Args&&... args) {
+        if constexpr (std::is_void_v<R>) {
+            std::invoke(target<Stored>(storage), std::forward<Args>(args)...);
+        } else {
+            return std::invoke(target<Stored>(storage), std::forward<Args>(args)...);
+        }
+    }
+
+    static R invokeEmpty(std::byte* /*storage*/, Args&&... /*args*/) {
+        throw std::bad_function_call();
+    }
+
+    template <typename Stored>
+    static void manage(Operation operation, std::byte* source, std::byte* destination) {
+        switch (operation) {
+            case Operation::COPY:
+                if constexpr (kStoredInline<Stored>) {
+                    ::new (static_cast<void*>(destination)) Stored(target<Stored>(source));
+                } else {
+                    ::new (static_cast<void*>(destination)) Stored*(new Stored(target<Stored>(source)));
+                }
+                break;
+            case Operation::MOVE:
+                if constexpr (kStoredInline<Stored>) {
+                    ::new (static_cast<void*>(destination)) Stored(std::move(target<Stored>(source)));
+                    target<Stored>(source).~Stored();
+                } else {
+                    // Only the pointer changes hands
+                    ::new (static_cast<void*>(destination)) Stored*(&target<Stored>(source));
+                }
+                break;
+            case Operation::DESTROY:
+                if constexpr (kStoredInline<Stored>) {
+                    target<Stored>(source).~Stored();
+                } else {
+                    delete &target<Stored>(source);
+                }
+                break;
+        }
+    }
+
+    void reset() noexcept {
+        if (manage_ != nullptr) {
+            manage_(Operation::DESTROY, storage_.data(), nullptr);
+            invoke_ = &invokeEmpty;
+            manage_ = nullptr;
+        }
+    }
+
+    // Mutable like the target of a std::function, which may be called through a const reference as well
+    alignas(std::max_align_t) mutable std::array<std::byte, kInlineSize> storage_{};
+    R (*invoke_)(std::byte* storage, Args&&... args){&invokeEmpty};
+    void (*manage_)(Operation operation, std::byte* source, std::byte* destination){nullptr};
+};
+
+} // namespace cpr
+
+#endif
@@ -36,6 +36,7 @@ class Interceptor {
     static Response proceed(Session& session, ProceedHttpMethod httpMethod);
     static Response proceed(Session& session, ProceedHttpMethod httpMethod, std::ofstream& file);
     static Response proceed(Session& session, ProceedHttpMethod httpMethod, const WriteCallback& write);
+    static Response proceed(Session& session, ProceedHttpMethod httpMethod, FileSink& sink);
 };
 
 class InterceptorMulti {
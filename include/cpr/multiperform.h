@@ -3,9 +3,14 @@
 
 #include "cpr/curlmultiholder.h"
 #include "cpr/response.h"
+#include "cpr/deadline.h"
+#include "cpr/rate_limiter.h"
+#include "cpr/retry.h"
 #include "cpr/session.h"
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <stdexcept>
 #include <vector>
@@ -57,6 +62,22 @@ class MultiPerform {
 
     void AddInterceptor(const std::shared_ptr<InterceptorMulti>& pinterceptor);
 
+    /**
+     * Repeat failed requests of all sessions without a RetryPolicy of their own according to the policy.
+     * A failed transfer waits for its next attempt while the others keep running. Downloads are not retried.
+     **/
+    void SetRetryPolicy(const RetryPolicy& retry_policy);
+    /**
+     * Take a token of the rate limiter before starting each transfer of sessions without a RateLimiter of their own.
+     * Transfers waiting for their token do not hold back the others.
+     **/
+    void SetRateLimiter(const RateLimiter& rate_limiter);
+    /**
+     * Bound all transfers including their retries. Sessions with an earlier Deadline of their own keep it.
+     * Transfers which could not be started in time fail with ErrorCode::OPERATION_TIMEDOUT.
+     **/
+    void SetDeadline(const Deadline& deadline);
+
   private:
     // Interceptors should be able to call the private proceed() and PrepareDownloadSessions() functions
     friend InterceptorMulti;
@@ -64,12 +85,15 @@ class MultiPerform {
     void SetHttpMethod(HttpMethod method);
 
     void PrepareSessions();
+    bool PrepareSession(Session& session, HttpMethod method);
     template <typename CurrentDownloadArgType, typename... DownloadArgTypes>
     void PrepareDownloadSessions(size_t sessions_index, CurrentDownloadArgType current_arg, DownloadArgTypes... args);
     template <typename CurrentDownloadArgType>
     void PrepareDownloadSessions(size_t sessions_index, CurrentDownloadArgType current_arg);
     void PrepareDownloadSession(size_t sessions_index, std::ofstream& file);
     void PrepareDownloadSession(size_t sessions_index, const WriteCallback& write);
+    // Pass sinks as std::ref(sink) since download arguments are taken by value
+    void PrepareDownloadSession(size_t sessions_index, FileSink& sink);
 
     void PrepareGet();
     void PrepareDelete();
@@ -86,12 +110,41 @@ class MultiPerform {
     std::vector<Response> MakeRequest();
     std::vector<Response> MakeDownloadRequest();
 
-    void DoMultiPerform();
-    std::vector<Response> ReadMultiInfo(const std::function<Response(Session&, CURLcode)>& complete_function);
+    // State of a session during DoMultiPerform()
+    struct Transfer {
+        std::optional<Response> response;
+        uint32_t retries{0};
+        // Whether the transfer got added to the multi handle already
+        bool started{false};
+        // Set while the transfer waits for its first or next attempt
+        std::optional<std::chrono::steady_clock::time_point> start_time;
+    };
+
+    std::vector<Response> DoMultiPerform(const std::function<Response(Session&, CURLcode)>& complete_function);
+    /**
+     * Completes all finished transfers. Failed ones get a start_time instead in case they should be repeated.
+     **/
+    void ReadMultiInfo(const std::function<Response(Session&, CURLcode)>& complete_function, std::vector<Transfer>& transfers, std::chrono::steady_clock::time_point start);
+    /**
+     * Adds the transfers whose start_time passed, preparing them again in case they ran before.
+     * Returns the number of started transfers.
+     **/
+    size_t StartDueTransfers(std::vector<Transfer>& transfers);
+    /**
+     * Takes a token of the rate limiter applying to the prepared session and returns how long to wait before starting it.
+     **/
+    RateLimiter::Clock::duration ReserveRateLimit(Session& session);
+    /**
+     * Sets the timeout of the session to the remaining budget. Completes the transfer instead in case the deadline passed.
+     **/
+    bool PrepareDeadline(Session& session, Transfer& transfer);
 
     std::vector<std::pair<std::shared_ptr<Session>, HttpMethod>> sessions_;
     std::unique_ptr<CurlMultiHolder> multicurl_;
     bool is_download_multi_perform{false};
+    std::optional<RetryPolicy> retry_policy_;
+    std::optional<RateLimiter> rate_limiter_;
+    std::optional<Deadline> deadline_;
 
     using InterceptorsContainer = std::list<std::shared_ptr<InterceptorMulti>>;
     InterceptorsContainer interceptors_;
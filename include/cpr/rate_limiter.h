@@ -0,0 +1,125 @@
+#ifndef CPR_RATE_LIMITER_H
+#define CPR_RATE_LIMITER_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace cpr {
+
+struct RateLimit {
+    /**
+     * Sustained number of requests per second. Zero means no limit.
+     **/
+    double requests_per_second{0};
+    /**
+     * Number of requests which may be started at once after a quiet period.
+     **/
+    double burst{1};
+};
+
+/**
+ * Client side rate limiter with a token bucket per key (by default the host of the request URL).
+ * Each request takes a token before its transfer starts. In case the bucket is empty, the request waits until its
+ * token got refilled. Tokens are handed out in the order they were asked for.
+ *
+ * Synchronous requests (including the free cpr::*Async() functions) wait on the thread making the request.
+ * Session::*Async(), Session::Co*Async() and MultiPerform queue the request on the TimerQueue instead and do not
+ * occupy a thread while waiting.
+ *
+ * Like the ConnectionPool, copies of a RateLimiter share the same buckets and it is thread safe.
+ *
+ * Example:
+ * // At most 10 requests per second and host, up to 5 at once
+ * cpr::RateLimiter rate_limiter{cpr::RateLimit{10, 5}};
+ * rate_limiter.SetLimit("api.example.com", cpr::RateLimit{2, 1});
+ * cpr::Response r = cpr::Get(cpr::Url{"https://api.example.com/items"}, rate_limiter);
+ **/
+class RateLimiter {
+  public:
+    using Clock = std::chrono::steady_clock;
+    /**
+     * Maps the method and URL of a request to the key of its bucket, e.g. the host or a route.
+     **/
+    using KeyFunction = std::function<std::string(std::string_view method, std::string_view url)>;
+
+    struct Metrics {
+        // Tokens handed out
+        size_t requests{0};
+        // Requests which had to wait for their token
+        size_t delayed{0};
+        // Buckets currently held. Buckets which refilled completely are dropped, they start full when used again.
+        size_t buckets{0};
+    };
+
+    /**
+     * @param default_limit Limit of all keys without a limit of their own.
+     * @param key_function Maps requests to buckets. Defaults to the host (CircuitBreaker::GetHost()).
+     **/
+    explicit RateLimiter(RateLimit default_limit = {}, KeyFunction key_function = nullptr);
+    RateLimiter(const RateLimiter&) = default;
+    RateLimiter(RateLimiter&&) noexcept = default;
+    ~RateLimiter() = default;
+
+    RateLimiter& operator=(const RateLimiter&) = default;
+    RateLimiter& operator=(RateLimiter&&) noexcept = default;
+
+    void SetLimit(const std::string& key, RateLimit limit) const;
+
+    [[nodiscard]] std::string GetKey(std::string_view method, std::string_view url) const;
+
+    /**
+     * Takes a token from the bucket of the key and returns how long to wait until it may be used.
+     * The token is taken in any case, so callers have to wait and may not give up in between.
+     **/
+    [[nodiscard]] Clock::duration Reserve(const std::string& key) const;
+    /**
+     * Takes a token in case one is available right now.
+     **/
+    [[nodiscard]] bool TryAcquire(const std::string& key) const;
+    /**
+     * Takes a token and blocks until it may be used.
+     **/
+    void Acquire(const std::string& key) const;
+
+    [[nodiscard]] Metrics GetMetrics() const;
+
+  private:
+    struct Bucket {
+        RateLimit limit;
+        // May become negative, which means tokens got reserved ahead of time
+        double tokens{0};
+        Clock::time_point last_refill;
+    };
+
+    struct State {
+        std::mutex mutex;
+        RateLimit default_limit;
+        KeyFunction key_function;
+        std::unordered_map<std::string, RateLimit> limits;
+        std::unordered_map<std::string, Bucket> buckets;
+        // Number of buckets at which idle ones get evicted next
+        size_t eviction_threshold{0};
+        Metrics metrics;
+
+        /**
+         * Returns the bucket of the key with its tokens refilled up to now.
+         **/
+        Bucket& GetBucket(const std::string& key, Clock::time_point now);
+        /**
+         * Drops all buckets which refilled completely, since they do not differ from a new one.
+         **/
+        void EvictIdle(Clock::time_point now);
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CPR_RESERVE_SIZE_H
 #define CPR_RESERVE_SIZE_H
 
+#include <cstddef>
 #include <cstdint>
 
 namespace cpr {
@@ -12,6 +13,17 @@ class ReserveSize {
     size_t size = 0;
 };
 
+/**
+ * Upper bound for the memory reserved for the response body based on the Content-Length announced by the server.
+ * Disabled (0) unless set, since the Content-Length is controlled by the server.
+ **/
+class AutoReserveSize {
+  public:
+    AutoReserveSize(const size_t _max_size) : max_size(_max_size) {}
+
+    size_t max_size = 0;
+};
+
 } // namespace cpr
 
 #endif
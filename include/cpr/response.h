@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "cpr/cert_info.h"
+#include "cpr/chunked_body.h"
 #include "cpr/cookies.h"
 #include "cpr/cprtypes.h"
 #include "cpr/error.h"
@@ -29,6 +30,8 @@ class Response {
     // NOLINTNEXTLINE(google-runtime-int)
     long status_code{};
     std::string text{};
+    // Holds the body instead of text in case the request was made with a ChunkAllocator.
+    ChunkedBody chunked_body{};
     Header header{};
     Url url{};
     double elapsed{};
@@ -42,6 +45,8 @@ class Response {
     // Ignored here since libcurl uses a long for this.
     // NOLINTNEXTLINE(google-runtime-int)
     long redirect_count{};
+    // Number of times the request got repeated according to the RetryPolicy of the Session
+    std::uint32_t retry_count{};
     std::string primary_ip{};
     std::uint16_t primary_port{};
 
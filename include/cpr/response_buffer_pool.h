@@ -0,0 +1,78 @@
+#ifndef CPR_RESPONSE_BUFFER_POOL_H
+#define CPR_RESPONSE_BUFFER_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cpr {
+
+constexpr size_t CPR_DEFAULT_RESPONSE_BUFFER_POOL_MAX_BUFFERS = 64;
+constexpr size_t CPR_DEFAULT_RESPONSE_BUFFER_POOL_MAX_CAPACITY = static_cast<size_t>(1024) * 1024;
+
+/**
+ * Pool of response body buffers.
+ * Sessions using a pool draw the std::string their response body gets written into from the pool instead of
+ * allocating a new one for every request. Once the caller is done with Response::text it can hand the string
+ * back, so its capacity gets reused by the next response. This removes most malloc/free/realloc traffic in case
+ * of many small responses.
+ *
+ * Like the ConnectionPool, copies of a ResponseBufferPool share the same underlying buffers and the pool is thread safe.
+ *
+ * Example:
+ * cpr::ResponseBufferPool pool;
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/api"}, pool);
+ * ...
+ * pool.Release(std::move(r.text));
+ **/
+class ResponseBufferPool {
+  public:
+    /**
+     * @param max_buffers Maximum number of idle buffers kept inside the pool. Additional released buffers get freed.
+     * @param max_buffer_capacity Buffers with a larger capacity get freed instead of returned to the pool, so one huge response does not pin its memory forever.
+     **/
+    explicit ResponseBufferPool(size_t max_buffers = CPR_DEFAULT_RESPONSE_BUFFER_POOL_MAX_BUFFERS, size_t max_buffer_capacity = CPR_DEFAULT_RESPONSE_BUFFER_POOL_MAX_CAPACITY);
+    ResponseBufferPool(const ResponseBufferPool&) = default;
+    ResponseBufferPool(ResponseBufferPool&&) noexcept = default;
+    ~ResponseBufferPool() = default;
+
+    ResponseBufferPool& operator=(const ResponseBufferPool&) = default;
+    ResponseBufferPool& operator=(ResponseBufferPool&&) noexcept = default;
+
+    /**
+     * Returns an empty buffer from the pool or a new one in case the pool is empty.
+     **/
+    [[nodiscard]] std::string Acquire() const;
+
+    /**
+     * Hands a buffer (usually Response::text) back to the pool.
+     **/
+    void Release(std::string&& buffer) const;
+
+    /**
+     * Number of idle buffers inside the pool.
+     **/
+    [[nodiscard]] size_t GetIdleCount() const;
+
+    /**
+     * True in case the buffer owns heap memory, i.e. its capacity exceeds the small string buffer.
+     * Only those are worth pooling.
+     **/
+    [[nodiscard]] static bool HasHeapBuffer(const std::string& buffer);
+
+  private:
+    struct State {
+        std::mutex mutex;
+        std::vector<std::string> buffers;
+        size_t max_buffers{0};
+        size_t max_buffer_capacity{0};
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef CPR_RESPONSE_STREAM_H
+#define CPR_RESPONSE_STREAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "cpr/curlmultiholder.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+class Session;
+
+constexpr size_t CPR_DEFAULT_STREAM_BUFFER_SIZE = static_cast<size_t>(256) * 1024;
+
+/**
+ * Pull based access to a response body.
+ * In contrast to a WriteCallback, where data gets pushed to the consumer as fast as the server sends it, the consumer
+ * pulls chunks via Read(). The transfer only makes progress while the consumer reads. Once more than max_buffered_bytes
+ * are waiting to be read, the transfer gets paused (curl_easy_pause) until the consumer drained the buffer and asks
+ * for more again.
+ * This keeps the memory per stream bounded and lets TCP flow control push back on the server.
+ *
+ * The transfer runs on the calling thread inside Read(). No background thread is involved.
+ * Callers that must not block (e.g. coroutines, see Session::CoGetStream()) wait for GetWaitFds() themselves, for
+ * example on the SocketWatcher, and only call Read() once Poll() returned true.
+ * Interceptors of the session are not invoked for streamed requests.
+ *
+ * Example:
+ * auto session = std::make_shared<cpr::Session>();
+ * session->SetUrl(cpr::Url{"http://xxx/big.bin"});
+ * cpr::ResponseStream stream = session->GetStream();
+ * for (const std::string& chunk : stream) {
+ *     ...
+ * }
+ * cpr::Response r = stream.Finish(); // Status, header and error. The body is not part of it.
+ **/
+class ResponseStream {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string*;
+        using reference = const std::string&;
+
+        iterator() = default;
+        explicit iterator(ResponseStream* stream);
+
+        reference operator*() const {
+            return *current_;
+        }
+        pointer operator->() const {
+            return &*current_;
+        }
+        iterator& operator++();
+        bool operator==(const iterator& other) const {
+            return !current_.has_value() && !other.current_.has_value();
+        }
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+      private:
+        ResponseStream* stream_{nullptr};
+        std::optional<std::string> current_;
+    };
+
+    /**
+     * Starts streaming the response of an already prepared session (e.g. session->PrepareGet()).
+     * Prefer Session::GetStream() which takes care of preparing the session.
+     **/
+    explicit ResponseStream(std::shared_ptr<Session> session, size_t max_buffered_bytes = CPR_DEFAULT_STREAM_BUFFER_SIZE);
+    ResponseStream(const ResponseStream& other) = delete;
+    ResponseStream(ResponseStream&& old) noexcept = default;
+    ~ResponseStream();
+
+    ResponseStream& operator=(const ResponseStream& other) = delete;
+    /**
+     * Stops the transfer of this stream first, discarding its remaining body like Finish() does.
+     * A session streams one response at a time, so release a stream before starting the next one on the same session.
+     **/
+    ResponseStream& operator=(ResponseStream&& old) noexcept;
+
+    /**
+     * Returns the next chunk of the body. Blocks until data is available.
+     * Returns std::nullopt once the body has been read completely or the transfer failed.
+     **/
+    std::optional<std::string> Read();
+
+    /**
+     * Makes progress on the transfer without blocking.
+     * Returns true in case Read() returns right away, i.e. a chunk is waiting or the transfer ended.
+     **/
+    bool Poll();
+
+    /**
+     * The sockets the transfer waits on until Poll() makes progress again.
+     * Sockets libcurl cannot report (e.g. above FD_SETSIZE) are missing, GetWaitTimeout() bounds the wait for them.
+     **/
+    [[nodiscard]] std::vector<curl_waitfd> GetWaitFds() const;
+    /**
+     * How long to wait for GetWaitFds() at most before calling Poll() again.
+     **/
+    [[nodiscard]] std::chrono::milliseconds GetWaitTimeout() const;
+
+    /**
+     * Stops the transfer in case it is still running, discarding the remaining body.
+     * Returns the Response holding status, header and error information. Response::text stays empty.
+     **/
+    Response Finish();
+
+    [[nodiscard]] iterator begin();
+    [[nodiscard]] iterator end();
+
+    /**
+     * True once the transfer completed and all chunks have been read.
+     **/
+    [[nodiscard]] bool IsDone() const;
+    /**
+     * True while the transfer is paused because the consumer is not keeping up.
+     **/
+    [[nodiscard]] bool IsPaused() const;
+    /**
+     * Number of bytes received but not yet read.
+     **/
+    [[nodiscard]] size_t GetBufferedBytes() const;
+
+  private:
+    struct State {
+        std::deque<std::string> chunks;
+        size_t buffered_bytes{0};
+        size_t max_buffered_bytes{0};
+        bool paused{false};
+        bool transfer_done{false};
+        CURLcode result{CURLE_OK};
+    };
+
+    static size_t writeFunction(char* ptr, size_t size, size_t nmemb, State* state);
+    void step();
+    void perform();
+    void release();
+
+    std::shared_ptr<Session> session_;
+    std::unique_ptr<CurlMultiHolder> multicurl_;
+    // Lives on the heap since libcurl holds a pointer to it
+    std::unique_ptr<State> state_;
+    std::optional<Response> response_;
+};
+
+} // namespace cpr
+
+#endif
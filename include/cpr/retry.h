@@ -0,0 +1,79 @@
+#ifndef CPR_RETRY_H
+#define CPR_RETRY_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string_view>
+
+#include "cpr/cprtypes.h"
+#include "cpr/error.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+/**
+ * Decides whether and when a failed request gets repeated.
+ * Waits between attempts grow exponentially with full jitter: a random delay between zero and
+ * min(max_delay, base_delay * 2^retry). A Retry-After header on 429 and 503 responses overrides it.
+ *
+ * Set it on a Session (or pass it as an option) and all requests except downloads get retried according to it.
+ * Synchronous requests wait on the calling thread. Session::*Async() and Session::Co*Async() wait on the TimerQueue
+ * without occupying a thread and a MultiPerform keeps driving its other transfers while a failed one waits.
+ * Response::retry_count reports the number of retries made.
+ *
+ * Example:
+ * cpr::RetryPolicy retry_policy;
+ * retry_policy.max_attempts = 5;
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/flaky"}, retry_policy);
+ **/
+struct RetryPolicy {
+    /**
+     * Upper bound for the number of attempts, including the first one.
+     **/
+    uint32_t max_attempts{3};
+    /**
+     * Upper bound for the time from the start of the first attempt until the start of the last one. Zero means no limit.
+     **/
+    std::chrono::milliseconds max_total_time{0};
+    std::chrono::milliseconds base_delay{100};
+    std::chrono::milliseconds max_delay{10000};
+    /**
+     * Wait as long as the server asks for with Retry-After on 429 and 503 responses.
+     * Requests get not retried at all in case it asks for longer than max_retry_after.
+     **/
+    bool respect_retry_after{true};
+    std::chrono::milliseconds max_retry_after{60000};
+    /**
+     * Transport errors worth retrying. COULDNT_RESOLVE_HOST, COULDNT_RESOLVE_PROXY and COULDNT_CONNECT
+     * guarantee the request never reached the server, so they are retried for all methods.
+     **/
+    std::set<ErrorCode> retry_error_codes{ErrorCode::COULDNT_RESOLVE_HOST, ErrorCode::COULDNT_RESOLVE_PROXY, ErrorCode::COULDNT_CONNECT, ErrorCode::OPERATION_TIMEDOUT, ErrorCode::SEND_ERROR, ErrorCode::RECV_ERROR, ErrorCode::GOT_NOTHING, ErrorCode::SSL_CONNECT_ERROR, ErrorCode::HTTP2, ErrorCode::HTTP2_STREAM};
+    /**
+     * Status codes worth retrying.
+     **/
+    // NOLINTNEXTLINE(google-runtime-int) Ignored here since libcurl uses a long for status codes
+    std::set<long> retry_status_codes{408, 429, 502, 503, 504};
+    /**
+     * Only idempotent requests (GET, HEAD, OPTIONS, PUT, DELETE and requests carrying an Idempotency-Key header)
+     * may be repeated once they possibly reached the server. Set to true to retry POST and PATCH requests as well.
+     **/
+    bool retry_non_idempotent{false};
+
+    /**
+     * Returns how long to wait before the next attempt, or std::nullopt in case the request should not be repeated.
+     * @param attempts Number of attempts made so far, including the one which produced the response.
+     * @param elapsed Time since the start of the first attempt.
+     **/
+    [[nodiscard]] std::optional<std::chrono::milliseconds> GetRetryDelay(std::string_view method, const Header& request_header, const Response& response, uint32_t attempts, std::chrono::milliseconds elapsed) const;
+
+    /**
+     * Returns the delay a Retry-After header (delay-seconds or HTTP-date) asks for, or std::nullopt in case there is no valid one.
+     **/
+    [[nodiscard]] static std::optional<std::chrono::milliseconds> ParseRetryAfter(const Header& response_header);
+};
+
+} // namespace cpr
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CPR_SESSION_H
 #define CPR_SESSION_H
 
+#include <chrono>
 #include <cstdint>
 #include <fstream>
 #include <functional>
@@ -8,6 +9,7 @@
 #include <list>
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <variant>
 
 #include "cpr/accept_encoding.h"
@@ -17,11 +19,20 @@
 #include "cpr/body.h"
 #include "cpr/body_view.h"
 #include "cpr/callback.h"
+#include "cpr/chunked_body.h"
+#include "cpr/circuit_breaker.h"
 #include "cpr/connect_timeout.h"
 #include "cpr/connection_pool.h"
 #include "cpr/cookies.h"
 #include "cpr/cprtypes.h"
 #include "cpr/curlholder.h"
+#include "cpr/curlmultiholder.h"
+#include "cpr/deadline.h"
+#include "cpr/dns_cache.h"
+#include "cpr/endpoint_group.h"
+#include "cpr/executor.h"
+#include "cpr/file_sink.h"
+#include "cpr/hedging.h"
 #include "cpr/http_version.h"
 #include "cpr/interface.h"
 #include "cpr/limit_rate.h"
@@ -34,17 +45,28 @@
 #include "cpr/proxies.h"
 #include "cpr/proxyauth.h"
 #include "cpr/range.h"
+#include "cpr/rate_limiter.h"
 #include "cpr/redirect.h"
 #include "cpr/reserve_size.h"
 #include "cpr/resolve.h"
+#include "cpr/retry.h"
+#include "cpr/response_buffer_pool.h"
+#include "cpr/response_stream.h"
+#include "cpr/single_flight.h"
 #include "cpr/response.h"
 #include "cpr/sse.h"
+#include "cpr/ssl_ctx.h"
 #include "cpr/ssl_options.h"
 #include "cpr/timeout.h"
+#include "cpr/tls_session_store.h"
+#include "cpr/tracing.h"
 #include "cpr/unix_socket.h"
 #include "cpr/user_agent.h"
 #include "cpr/util.h"
 #include "cpr/verbose.h"
+#include "cpr/coroutine/async_generator.h"
+#include "cpr/coroutine/stream_ready.h"
+#include "cpr/coroutine/task.h"
 
 namespace cpr {
 
@@ -60,7 +82,7 @@ class Session : public std::enable_shared_from_this<Session> {
     Session(const Session& other) = delete;
     Session(Session&& old) = delete;
 
-    ~Session() = default;
+    ~Session();
 
     Session& operator=(Session&& old) noexcept = delete;
     Session& operator=(const Session& other) = delete;
@@ -74,6 +96,11 @@ class Session : public std::enable_shared_from_this<Session> {
     [[nodiscard]] const Header& GetHeader() const;
     void SetTimeout(const Timeout& timeout);
     void SetConnectTimeout(const ConnectTimeout& timeout);
+    /**
+     * Bound the request including its redirects, retries and the waits in between.
+     * Each attempt gets the remaining budget as its timeout (or the Timeout in case it is shorter).
+     **/
+    void SetDeadline(const Deadline& deadline);
     void SetConnectionPool(const ConnectionPool& pool);
     void SetAuth(const Authentication& auth);
 // Only supported with libcurl >= 7.61.0.
@@ -113,8 +140,67 @@ class Session : public std::enable_shared_from_this<Session> {
     void SetRange(const Range& range);
     void SetResolve(const Resolve& resolve);
     void SetResolves(const std::vector<Resolve>& resolves);
+    /**
+     * Hand the addresses cached by the DnsCache to libcurl before each request, so it does not resolve the host itself.
+     * Hosts set explicitly via SetResolve(s) are not taken from the cache.
+     **/
+    void SetDnsCache(const DnsCache& dns_cache);
+    /**
+     * Offer TLS sessions from the store on new connections and save the sessions servers hand out in it.
+     * Only has an effect with the OpenSSL backend.
+     **/
+    void SetTlsSessionStore(const TlsSessionStore& store);
+    /**
+     * Repeat failed requests according to the policy. Downloads are not retried.
+     * Session::*Async() and Session::Co*Async() wait between attempts without occupying a thread.
+     **/
+    void SetRetryPolicy(const RetryPolicy& retry_policy);
+    /**
+     * Send a duplicate of GET, HEAD and OPTIONS requests taking longer than the delay of the policy.
+     * The first successful response wins.
+     **/
+    void SetHedgePolicy(const HedgePolicy& hedge_policy);
+    /**
+     * Fail requests right away with ErrorCode::CIRCUIT_OPEN while the circuit of their host is open,
+     * and record the outcome of all others.
+     **/
+    void SetCircuitBreaker(const CircuitBreaker& circuit_breaker);
+    /**
+     * Take a token of the rate limiter before each transfer (including retries) and wait until it may be used.
+     * Requests answered by an interceptor (e.g. cache hits) do not take a token.
+     * Session::*Async() and Session::Co*Async() of sessions without interceptors wait without occupying a thread.
+     **/
+    void SetRateLimiter(const RateLimiter& rate_limiter);
+    /**
+     * Send each request to the endpoint of the group picked by its load balancing policy.
+     **/
+    void SetEndpointGroup(const EndpointGroup& endpoint_group);
+    /**
+     * Emit the spans of each request to the sink of the tracer and add the traceparent header to it.
+     **/
+    void SetTracer(const Tracer& tracer);
+    /**
+     * Run the asynchronous work of this session, i.e. *Async(), *Callback() and Co*Async(), on the given executor
+     * instead of the default one (see SetDefaultExecutor()). nullptr restores the default executor.
+     **/
+    void SetExecutor(const std::shared_ptr<Executor>& executor);
+    /**
+     * Priority the asynchronous requests of this session get queued with by the executor, see ThreadPool.
+     **/
+    void SetPriority(Priority priority);
     void SetMultiRange(const MultiRange& multi_range);
     void SetReserveSize(const ReserveSize& reserve_size);
+    void SetAutoReserveSize(const AutoReserveSize& auto_reserve_size);
+    void SetResponseBufferPool(const ResponseBufferPool& pool);
+    /**
+     * Collect the response body as a chain of chunks drawn from the given allocator (Response::chunked_body)
+     * instead of the contiguous Response::text.
+     **/
+    void SetChunkAllocator(const ChunkAllocator& allocator);
+    /**
+     * Share the transfer with identical GET/HEAD/OPTIONS requests of other sessions in flight at the same time.
+     **/
+    void SetSingleFlight(const SingleFlight& single_flight);
     void SetAcceptEncoding(const AcceptEncoding& accept_encoding);
     void SetAcceptEncoding(AcceptEncoding&& accept_encoding);
     void SetLimitRate(const LimitRate& limit_rate);
@@ -140,6 +226,7 @@ class Session : public std::enable_shared_from_this<Session> {
     void SetOption(const Header& header);
     void SetOption(const Timeout& timeout);
     void SetOption(const ConnectTimeout& timeout);
+    void SetOption(const Deadline& deadline);
     void SetOption(const Authentication& auth);
     void SetOption(const ConnectionPool& pool);
 // Only supported with libcurl >= 7.61.0.
@@ -180,10 +267,22 @@ class Session : public std::enable_shared_from_this<Session> {
     void SetOption(const Range& range);
     void SetOption(const MultiRange& multi_range);
     void SetOption(const ReserveSize& reserve_size);
+    void SetOption(const AutoReserveSize& auto_reserve_size);
+    void SetOption(const ResponseBufferPool& pool);
+    void SetOption(const ChunkAllocator& allocator);
+    void SetOption(const SingleFlight& single_flight);
     void SetOption(const AcceptEncoding& accept_encoding);
     void SetOption(AcceptEncoding&& accept_encoding);
     void SetOption(const Resolve& resolve);
     void SetOption(const std::vector<Resolve>& resolves);
+    void SetOption(const DnsCache& dns_cache);
+    void SetOption(const TlsSessionStore& store);
+    void SetOption(const RetryPolicy& retry_policy);
+    void SetOption(const HedgePolicy& hedge_policy);
+    void SetOption(const CircuitBreaker& circuit_breaker);
+    void SetOption(const RateLimiter& rate_limiter);
+    void SetOption(const EndpointGroup& endpoint_group);
+    void SetOption(const Tracer& tracer);
 
     cpr_off_t GetDownloadFileLength();
     /**
@@ -197,9 +296,16 @@ class Session : public std::enable_shared_from_this<Session> {
      * cpr::Response r = session.Get();
      **/
     void ResponseStringReserve(size_t size);
+    /**
+     * Reserve memory for the response string as soon as the server announces the Content-Length of the body.
+     * At most max_size bytes get reserved up front. Disabled (0) by default, since a server could otherwise make the
+     * client allocate max_size bytes per request by announcing a large body it never sends.
+     **/
+    void ResponseStringAutoReserve(size_t max_size);
     Response Delete();
     Response Download(const WriteCallback& write);
     Response Download(std::ofstream& file);
+    Response Download(FileSink& sink);
     Response Get();
     Response Head();
     Response Options();
@@ -211,6 +317,7 @@ class Session : public std::enable_shared_from_this<Session> {
     AsyncResponse DeleteAsync();
     AsyncResponse DownloadAsync(const WriteCallback& write);
     AsyncResponse DownloadAsync(std::ofstream& file);
+    AsyncResponse DownloadAsync(FileSink& sink);
     AsyncResponse HeadAsync();
     AsyncResponse OptionsAsync();
     AsyncResponse PatchAsync();
@@ -222,6 +329,7 @@ class Session : public std::enable_shared_from_this<Session> {
     coroutine::Task<cpr::Response> CoDeleteAsync();
     coroutine::Task<cpr::Response> CoDownloadAsync(const WriteCallback& write);
     coroutine::Task<cpr::Response> CoDownloadAsync(std::ofstream& file);
+    coroutine::Task<cpr::Response> CoDownloadAsync(FileSink& sink);
     coroutine::Task<cpr::Response> CoHeadAsync();
     coroutine::Task<cpr::Response> CoOptionsAsync();
     coroutine::Task<cpr::Response> CoPatchAsync();
@@ -262,6 +370,20 @@ class Session : public std::enable_shared_from_this<Session> {
 
     std::shared_ptr<CurlHolder> GetCurlHolder();
     std::string GetFullRequestUrl();
+    /**
+     * Returns the executor set via SetExecutor() or the default one.
+     **/
+    [[nodiscard]] std::shared_ptr<Executor> GetExecutor() const;
+    [[nodiscard]] Priority GetPriority() const;
+    /**
+     * Returns the HTTP method of the request prepared last, e.g. "GET" or "POST". Downloads are reported as "GET".
+     **/
+    [[nodiscard]] std::string_view GetHttpMethod() const;
+    /**
+     * True in case the request prepared last is a download, whose body goes to the file, FileSink or WriteCallback
+     * passed to Download() instead of Response::text.
+     **/
+    [[nodiscard]] bool IsDownload() const;
 
     void PrepareDelete();
     void PrepareGet();
@@ -272,9 +394,30 @@ class Session : public std::enable_shared_from_this<Session> {
     void PreparePut();
     void PrepareDownload(const WriteCallback& write);
     void PrepareDownload(std::ofstream& file);
+    void PrepareDownload(FileSink& sink);
     Response Complete(CURLcode curl_error);
     Response CompleteDownload(CURLcode curl_error);
 
+    /**
+     * Starts a GET request whose body gets pulled chunk by chunk from the returned stream.
+     * At most about max_buffered_bytes are buffered before the transfer gets paused.
+     * Requires the session to be managed by a std::shared_ptr.
+     **/
+    ResponseStream GetStream(size_t max_buffered_bytes = CPR_DEFAULT_STREAM_BUFFER_SIZE);
+    /**
+     * Coroutine version of GetStream() yielding the chunks of the body as they arrive.
+     * The transfer runs on the executor of the session while the consumer awaits the next chunk and gets paused once
+     * max_buffered_bytes are waiting in between. While waiting for the server no thread of the executor is blocked,
+     * the sockets get watched by the SocketWatcher (see coroutine::StreamReady). In case response is given, it receives status, header and error
+     * once the body got read completely.
+     * Requires the session to be managed by a std::shared_ptr.
+     **/
+    coroutine::AsyncGenerator<std::string> CoGetStream(size_t max_buffered_bytes = CPR_DEFAULT_STREAM_BUFFER_SIZE, Response* response = nullptr);
+    /**
+     * Like CoGetStream(), but yields the Server-Sent Events parsed from the body instead of the raw chunks.
+     **/
+    coroutine::AsyncGenerator<ServerSentEvent> CoGetEventStream(size_t max_buffered_bytes = CPR_DEFAULT_STREAM_BUFFER_SIZE, Response* response = nullptr);
+
     void AddInterceptor(const std::shared_ptr<Interceptor>& pinterceptor);
 
     std::shared_ptr<Session> GetSharedPtrFromThis();
@@ -283,6 +426,7 @@ class Session : public std::enable_shared_from_this<Session> {
     // Interceptors should be able to call the private proceed() function
     friend Interceptor;
     friend MultiPerform;
+    friend ResponseStream;
 
 
     bool chunkedTransferEncoding_{false};
@@ -315,6 +459,57 @@ class Session : public std::enable_shared_from_this<Session> {
     size_t response_string_reserve_size_{0};
     std::string response_string_;
     std::string header_string_;
+    // Header callback target reserving response_string_ based on the Content-Length
+    util::ResponseStringReserveData response_string_reserve_data_{&header_string_, &response_string_, 0};
+    // Pool the response string gets drawn from in case set
+    std::optional<ResponseBufferPool> response_buffer_pool_;
+    // In case set, the response body gets collected in chunked_body_ instead of response_string_
+    std::optional<ChunkAllocator> chunk_allocator_;
+    ChunkedBody chunked_body_;
+    // Identical requests in flight at the same time share one transfer in case set
+    std::optional<SingleFlight> single_flight_;
+    // Resolve entries set explicitly. Kept since they get merged with the ones of the DNS cache before each request.
+    std::vector<Resolve> resolves_;
+    std::optional<DnsCache> dns_cache_;
+    std::optional<TlsSessionStore> tls_session_store_;
+    // Passed to the SSL context callback. Holds the parsed CA buffer of the SslOptions and points to tls_session_store_.
+    SslCtxCallbackData ssl_ctx_data_;
+    // The parts of the SslOptions and VerifySsl in effect that hashTlsOptions() covers. Large buffers are kept as
+    // their hash only.
+    SslOptions tls_options_;
+    // Hash over tls_options_, 0 while the defaults are in use. See SslCtxCallbackData::session_context.
+    uint64_t tls_options_hash_{0};
+    std::optional<RetryPolicy> retry_policy_;
+    std::optional<HedgePolicy> hedge_policy_;
+    // Shared by the handle via CURLOPT_SHARE. Kept since curl_easy_duphandle() does not copy it to the handle of a hedge.
+    std::optional<ConnectionPool> connection_pool_;
+    std::optional<CircuitBreaker> circuit_breaker_;
+    std::optional<RateLimiter> rate_limiter_;
+    // The token of the rate_limiter_ for the next transfer got taken by reserveRateLimitAhead() already
+    bool rate_limit_reserved_{false};
+    // Timeout of a single transfer, the remaining budget of the deadline_ may shorten it
+    std::chrono::milliseconds timeout_{0};
+    std::optional<Deadline> deadline_;
+    std::optional<EndpointGroup> endpoint_group_;
+    // Endpoint of the prepared request. Recorded once it completes, or released when preparing the next one.
+    std::optional<size_t> endpoint_;
+    std::optional<Tracer> tracer_;
+    std::shared_ptr<Executor> executor_;
+    Priority priority_{Priority::Normal};
+    struct TraceState {
+        // Context of the REQUEST span, also sent as traceparent header
+        TraceContext context;
+        std::chrono::system_clock::time_point start;
+        std::chrono::system_clock::time_point prepare_start;
+    };
+    // Trace of the attempt in progress. Begins once it gets prepared and ends once it completes.
+    std::optional<TraceState> trace_;
+    // Set while the next attempt waits for the pool or a timer. Becomes its QUEUED span.
+    std::optional<std::chrono::system_clock::time_point> trace_queued_since_;
+    // Runs hedged requests. Kept across requests so its connections get reused.
+    std::unique_ptr<CurlMultiHolder> hedge_multi_;
+    // File sink of the currently running download. Gets flushed once the download completes.
+    FileSink* file_sink_{nullptr};
     // Container type is required to keep iterator valid on elem insertion. E.g. list but not vector.
     using InterceptorsContainer = std::list<std::shared_ptr<Interceptor>>;
     InterceptorsContainer interceptors_;
@@ -322,6 +517,10 @@ class Session : public std::enable_shared_from_this<Session> {
     InterceptorsContainer::const_iterator current_interceptor_;
     // Interceptor within the chain where to start with each repeated request
     InterceptorsContainer::const_iterator first_interceptor_;
+    // Method of the request prepared last
+    const char* http_method_{"GET"};
+    // The request prepared last is a download (PrepareDownload())
+    bool download_{false};
     bool isUsedInMultiPerform{false};
     bool isCancellable{false};
 
@@ -329,8 +528,94 @@ class Session : public std::enable_shared_from_this<Session> {
     bool sslNoRevoke_{false};
 #endif
 
+    // One of the Prepare*() functions for non download requests, e.g. &Session::PrepareGet
+    using PrepareFunction = void (Session::*)();
+
     Response makeDownloadRequest();
     Response makeRequest();
+    /**
+     * Runs the prepared request once the interceptors and the circuit breaker let it through.
+     **/
+    Response makeTransfer();
+    /**
+     * Responses for requests that never got sent. End the trace of the attempt in case there is one.
+     **/
+    [[nodiscard]] Response makeCircuitOpenResponse(std::string_view host);
+    [[nodiscard]] Response makeDeadlineExceededResponse();
+    /**
+     * Sets the timeout of the next transfer to the budget left until the deadline.
+     * Returns false in case the deadline passed already.
+     **/
+    bool prepareDeadline(const std::optional<Deadline>& deadline);
+    /**
+     * Prepares and makes the request, repeating it according to retry_policy_. Waits on the calling thread in between.
+     **/
+    Response makeRetriedRequest(PrepareFunction prepare);
+    /**
+     * Same as makeRetriedRequest(), but runs the attempts on the executor of the session and waits on the TimerQueue in between.
+     **/
+    AsyncResponse makeRetriedRequestAsync(PrepareFunction prepare);
+    /**
+     * Runs one attempt. In case rate_limited is false, first takes a token of the rate_limiter_ via reserveRateLimitAhead() and waits for it on the TimerQueue.
+     **/
+    void runRetriedRequestAsync(const std::shared_ptr<priv::AsyncPromise<Response>>& promise, PrepareFunction prepare, uint32_t retries, std::chrono::steady_clock::time_point start, bool rate_limited);
+    /**
+     * Same as makeRetriedRequest(), but suspends the coroutine on the TimerQueue in between.
+     **/
+    coroutine::Task<Response> coMakeRetriedRequest(PrepareFunction prepare);
+    /**
+     * Returns the delay before the next attempt according to retry_policy_, or std::nullopt in case there is none.
+     **/
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getRetryDelay(const Response& response, uint32_t retries, std::chrono::steady_clock::time_point start) const;
+    /**
+     * Takes a token of the rate_limiter_ for the prepared request and returns how long to wait before starting it.
+     **/
+    [[nodiscard]] RateLimiter::Clock::duration reserveRateLimit();
+    /**
+     * Same as reserveRateLimit(), but for a request which did not pass the interceptors yet. Only takes the token in
+     * case there are no interceptors and marks it as taken for the next makeRequest(), otherwise returns zero.
+     **/
+    [[nodiscard]] RateLimiter::Clock::duration reserveRateLimitAhead();
+    /**
+     * Takes a token like reserveRateLimit() and waits on the calling thread, unless reserveRateLimitAhead() took it already.
+     **/
+    void waitForRateLimit();
+    /**
+     * Picks the endpoint of the endpoint_group_ for the request to the URL and returns the URL to request from it.
+     **/
+    std::string prepareEndpoint(const std::string& url);
+    void recordEndpoint(const Response& response);
+    /**
+     * Gives back the endpoint_ on leaving the scope, unless recordEndpoint() recorded it already. Covers requests
+     * returning without a transfer of their own, i.e. answered by an interceptor, rejected by the deadline or the
+     * circuit breaker, or served by another request of the SingleFlight.
+     **/
+    class EndpointReleaseScope {
+      public:
+        explicit EndpointReleaseScope(Session& session) : session_(session) {}
+        ~EndpointReleaseScope();
+        EndpointReleaseScope(const EndpointReleaseScope&) = delete;
+        EndpointReleaseScope(EndpointReleaseScope&&) = delete;
+        EndpointReleaseScope& operator=(const EndpointReleaseScope&) = delete;
+        EndpointReleaseScope& operator=(EndpointReleaseScope&&) = delete;
+
+      private:
+        Session& session_;
+    };
+    /**
+     * Begins the trace of the attempt getting prepared, or continues the one prepared before.
+     **/
+    void beginTrace();
+    /**
+     * Emits the spans of the attempt, including the ones derived from the curl timings in case the request got transferred.
+     **/
+    void endTrace(const Response& response, bool transferred);
+    void markTraceQueued();
+    /**
+     * Emits the QUEUED span in case the attempt waited since markTraceQueued().
+     **/
+    void endTraceQueued();
+    void emitTraceSpan(SpanKind kind, const TraceContext& parent, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end) const;
     Response proceed();
     const std::optional<Response> intercept();
     /**
@@ -346,8 +631,35 @@ class Session : public std::enable_shared_from_this<Session> {
      **/
     void prepareCommonDownload();
     void prepareHeader();
+    /**
+     * Builds CURLOPT_RESOLVE from the explicit resolve entries and, in case set, the DNS cache entry for the request URL.
+     **/
+    void prepareResolve();
+    /**
+     * Installs the SSL context callback in case ssl_ctx_data_ has anything to apply.
+     **/
+    void prepareSslCtx();
+    /**
+     * Recomputes tls_options_hash_ after tls_options_ changed.
+     **/
+    void updateTlsOptionsHash();
+    /**
+     * Points CURLOPT_WRITEFUNCTION back to the user provided write or server sent event callback, if any.
+     **/
+    void restoreWriteFunction();
     void prepareProxy();
     CURLcode DoEasyPerform();
+    /**
+     * Runs the prepared request, hedged in case the hedge_policy_ applies to it.
+     **/
+    CURLcode DoPerform();
+    /**
+     * Runs the prepared request on hedge_multi_ and sends a hedge in case it takes longer than the delay of the hedge_policy_.
+     * The hedge gets the connection pool and the cookies of the session, so they are kept in case its handle and
+     * buffers replace the ones of the session once it wins.
+     **/
+    CURLcode DoHedgedPerform();
+    [[nodiscard]] bool canHedge() const;
     void prepareBodyPayloadOrMultipart() const;
     /**
      * Returns true in case content_ is of type cpr::Body or cpr::Payload.
@@ -357,37 +669,37 @@ class Session : public std::enable_shared_from_this<Session> {
 
 template <typename Then>
 auto Session::GetCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Get()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Get()); }, std::move(then));
 }
 
 template <typename Then>
 auto Session::PostCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Post()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Post()); }, std::move(then));
 }
 
 template <typename Then>
 auto Session::PutCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Put()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Put()); }, std::move(then));
 }
 
 template <typename Then>
 auto Session::HeadCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Head()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Head()); }, std::move(then));
 }
 
 template <typename Then>
 auto Session::DeleteCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Delete()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Delete()); }, std::move(then));
 }
 
 template <typename Then>
 auto Session::OptionsCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Options()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Options()); }, std::move(then));
 }
 
 template <typename Then>
 auto Session::PatchCallback(Then then) {
-    return async([shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Patch()); }, std::move(then));
+    return async(*GetExecutor(), priority_, [shared_this = GetSharedPtrFromThis()](Then then_inner) { return then_inner(shared_this->Patch()); }, std::move(then));
 }
 
 // Coroutines
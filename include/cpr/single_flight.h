@@ -0,0 +1,87 @@
+#ifndef CPR_SINGLE_FLIGHT_H
+#define CPR_SINGLE_FLIGHT_H
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cpr/cprtypes.h"
+#include "cpr/response.h"
+
+namespace cpr {
+
+/**
+ * Coalesces identical concurrent requests into a single transfer.
+ * While a GET, HEAD or OPTIONS request is in flight, every further request with the same method, full URL
+ * (Session::GetFullRequestUrl()) and values of the key header fields waits for it instead of starting its own transfer.
+ * All of them get the same Response. This keeps a popular resource which just expired from stampeding the backend.
+ *
+ * Waiters block the thread they run on, no matter whether they are plain calls, AsyncWrapper tasks or coroutines.
+ * Requests delivering their body to a WriteCallback or ServerSentEventCallback, as well as downloads, never get coalesced.
+ * Interceptors run before the coalescing, so e.g. cache hits do not count as transfers.
+ *
+ * Requests are only matched on method, URL and the key header fields. All other options (e.g. Authentication,
+ * Cookies or Proxies) have to be the same for all requests sharing a SingleFlight, or be part of the key.
+ *
+ * Like the ConnectionPool, copies of a SingleFlight share the same state and it is thread safe.
+ *
+ * Example:
+ * cpr::SingleFlight single_flight;
+ * // Issued from many threads at the same time, only one request reaches the server
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/popular"}, single_flight);
+ **/
+class SingleFlight {
+  public:
+    struct Metrics {
+        // Requests which actually went over the network
+        size_t transfers{0};
+        // Requests which got the response of another in flight request
+        size_t coalesced{0};
+        // Transfers currently running
+        size_t in_flight{0};
+    };
+
+    /**
+     * @param key_header_fields Request header fields whose values are part of the key. Requests differing in one of them never share a transfer.
+     **/
+    explicit SingleFlight(std::vector<std::string> key_header_fields = {"Accept", "Accept-Encoding", "Accept-Language", "Authorization", "Cookie"});
+    SingleFlight(const SingleFlight&) = default;
+    SingleFlight(SingleFlight&&) noexcept = default;
+    ~SingleFlight() = default;
+
+    SingleFlight& operator=(const SingleFlight&) = default;
+    SingleFlight& operator=(SingleFlight&&) noexcept = default;
+
+    /**
+     * Returns the key requests get matched on.
+     **/
+    [[nodiscard]] std::string GetKey(std::string_view method, const std::string& url, const Header& header) const;
+
+    /**
+     * Runs the transfer, unless one with the same key is already in flight. In that case waits for it and returns its response.
+     * Exceptions thrown by the transfer get rethrown to all waiters.
+     **/
+    Response Do(const std::string& key, const std::function<Response()>& transfer) const;
+
+    [[nodiscard]] Metrics GetMetrics() const;
+
+  private:
+    struct State {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_future<Response>> calls;
+        std::vector<std::string> key_header_fields;
+        Metrics metrics;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
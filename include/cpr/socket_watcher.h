@@ -0,0 +1,60 @@
+#ifndef CPR_SOCKET_WATCHER_H
+#define CPR_SOCKET_WATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "cpr/curlmultiholder.h"
+#include "cpr/singleton.h"
+
+namespace cpr {
+
+/**
+ * Waits for sockets to become ready, all from a single background thread.
+ * Used to wait for a transfer (e.g. the next chunk of Session::CoGetStream()) without blocking a thread for each waiter.
+ * Tasks should only hand over the actual work, e.g. by handing it to an Executor, since they delay all following tasks.
+ **/
+class SocketWatcher {
+    CPR_SINGLETON_DECL(SocketWatcher)
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    ~SocketWatcher();
+
+    /**
+     * Runs the task on the watcher thread once one of the sockets is ready for the requested events or the timeout
+     * passed, whatever comes first.
+     **/
+    void Watch(std::vector<curl_waitfd> fds, std::chrono::milliseconds timeout, std::function<void()> task);
+
+  protected:
+    SocketWatcher();
+
+  private:
+    struct Watcher {
+        std::vector<curl_waitfd> fds;
+        Clock::time_point due_time;
+        std::function<void()> task;
+    };
+
+    void run();
+    void wakeup();
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Watcher> watchers_;
+    bool stop_{false};
+    // Never holds a transfer, only used to poll the sockets of the watchers and to get woken up
+    CurlMultiHolder multicurl_;
+    std::thread thread_;
+};
+
+} // namespace cpr
+
+#endif
@@ -2,7 +2,75 @@
 #define CPR_SSL_CTX_H
 
 #include "cpr/ssl_options.h"
+#include "cpr/tls_session_store.h"
+#include <cstddef>
+#include <cstdint>
 #include <curl/curl.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// X509 of OpenSSL
+struct x509_st;
+
+namespace cpr {
+
+/**
+ * The certificates of a CA buffer (ssl::CaBuffer), parsed once and shared by all connections using the same buffer.
+ * Adding them to the certificate store of a new connection only takes a reference on each certificate,
+ * instead of parsing the whole PEM buffer again.
+ * Only available with the OpenSSL backend.
+ **/
+class CaCertificates {
+  public:
+    CaCertificates() = default;
+    CaCertificates(const CaCertificates&) = delete;
+    CaCertificates(CaCertificates&&) = delete;
+    ~CaCertificates();
+
+    CaCertificates& operator=(const CaCertificates&) = delete;
+    CaCertificates& operator=(CaCertificates&&) = delete;
+
+    /**
+     * Returns the parsed certificates of the buffer. Buffers with the same content share the same instance
+     * as long as it is in use. A changed buffer gets parsed again.
+     **/
+    static std::shared_ptr<const CaCertificates> Get(const std::string& buffer);
+
+    /**
+     * Adds all certificates to the certificate store of the given SSL_CTX.
+     **/
+    CURLcode AddTo(void* sslctx) const;
+
+    [[nodiscard]] size_t GetCount() const {
+        return certificates_.size();
+    }
+    /**
+     * False in case the buffer contains an invalid certificate. Connections using it get aborted.
+     **/
+    [[nodiscard]] bool IsValid() const {
+        return valid_;
+    }
+
+  private:
+    std::vector<x509_st*> certificates_;
+    bool valid_{true};
+};
+
+/**
+ * Everything the SSL context callback of a Session applies to a new connection.
+ **/
+struct SslCtxCallbackData {
+    // Certificates of the CA buffer (ssl::CaBuffer) to add, or nullptr
+    std::shared_ptr<const CaCertificates> ca_certificates;
+    // Store TLS sessions get offered from and saved to, or nullptr
+    const TlsSessionStore* session_store{nullptr};
+    // Hash of the security relevant options of the connection (CA, verification, client certificate, TLS version,
+    // proxy). Part of the key sessions get stored under, so they only get offered to connections using the same ones.
+    uint64_t session_context{0};
+};
+
+} // namespace cpr
 
 #if SUPPORT_CURLOPT_SSL_CTX_FUNCTION
 
@@ -13,12 +81,20 @@ namespace cpr {
  * just before the initialization of an SSL connection.
  * The raw_cert_buf argument is set with the CURLOPT_SSL_CTX_DATA option and has to be a nul
  * terminated buffer.
+ * The certificates of the most recently used buffers stay parsed in between connections (see CaCertificates).
  *
  * Sources: https://curl.se/libcurl/c/CURLOPT_SSL_CTX_FUNCTION.html
  *         https://curl.se/libcurl/c/CURLOPT_SSL_CTX_DATA.html
  */
 CURLcode sslctx_function_load_ca_cert_from_buffer(CURL* curl, void* sslctx, void* raw_cert_buf);
 
+/**
+ * Applies the SslCtxCallbackData passed via CURLOPT_SSL_CTX_DATA to a new connection.
+ * Loads the CA buffer, and hooks the TLS session store into the handshake. Stored sessions for the
+ * host and port of the request get offered to the server and new sessions handed out by the server get stored.
+ */
+CURLcode sslctx_function(CURL* curl, void* sslctx, void* data);
+
 } // Namespace cpr
 
 #endif
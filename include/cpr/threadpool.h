@@ -1,34 +1,52 @@
 #ifndef CPR_THREAD_POOL_H
 #define CPR_THREAD_POOL_H
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
 #include <utility>
 
+#include "cpr/executor.h"
+
 #define CPR_DEFAULT_THREAD_POOL_MAX_THREAD_NUM std::thread::hardware_concurrency()
 
 constexpr size_t CPR_DEFAULT_THREAD_POOL_MIN_THREAD_NUM = 1;
 constexpr std::chrono::milliseconds CPR_DEFAULT_THREAD_POOL_MAX_IDLE_TIME{250};
+constexpr std::chrono::milliseconds CPR_DEFAULT_THREAD_POOL_MAX_QUEUE_DELAY{1000};
 
 namespace cpr {
 
-class ThreadPool {
+/**
+ * The default Executor, growing from min_threads up to max_threads while tasks are queued and shrinking again once
+ * threads were idle for max_idle_ms.
+ *
+ * Tasks get queued per Priority. Free threads pick the oldest task of the highest priority, so interactive requests do
+ * not wait behind a burst of bulk transfers. A task queued for longer than max_queue_delay goes first regardless of its
+ * priority, so lower priorities do not starve. SetMaxRunning() caps the threads a priority may occupy at the same time,
+ * e.g. keeping some threads free of bulk transfers for interactive requests arriving once all threads got started.
+ *
+ * Example:
+ * pool->SetMaxRunning(cpr::Priority::Bulk, 4);
+ * cpr::async(*pool, cpr::Priority::Bulk, [] { return cpr::Get(cpr::Url{"http://xxx/big.bin"}); });
+ **/
+class ThreadPool : public Executor {
   public:
-    using Task = std::function<void()>;
-
     explicit ThreadPool(size_t min_threads = CPR_DEFAULT_THREAD_POOL_MIN_THREAD_NUM, size_t max_threads = CPR_DEFAULT_THREAD_POOL_MAX_THREAD_NUM, std::chrono::milliseconds max_idle_ms = CPR_DEFAULT_THREAD_POOL_MAX_IDLE_TIME);
     ThreadPool(const ThreadPool& other) = delete;
     ThreadPool(ThreadPool&& old) = delete;
 
-    virtual ~ThreadPool();
+    ~ThreadPool() override;
 
     ThreadPool& operator=(const ThreadPool& other) = delete;
     ThreadPool& operator=(ThreadPool&& old) = delete;
@@ -45,6 +63,18 @@ class ThreadPool {
         max_idle_time = ms;
     }
 
+    void SetMaxQueueDelay(std::chrono::milliseconds ms);
+
+    /**
+     * Limits the number of tasks of the priority running at the same time (at least 1). Unlimited by default.
+     **/
+    void SetMaxRunning(Priority priority, size_t max_running);
+
+    /**
+     * Number of tasks of the priority waiting for a thread.
+     **/
+    size_t GetQueuedTaskNum(Priority priority);
+
     size_t GetCurrentThreadNum() {
         return cur_thread_num;
     }
@@ -68,53 +98,56 @@ class ThreadPool {
     int Wait() const;
 
     /**
-     * Return a future, calling future.get() will wait task done and return RetType.
-     * Submit(fn, args...)
-     * Submit(std::bind(&Class::mem_fn, &obj))
-     * Submit(std::mem_fn(&Class::mem_fn, &obj))
+     * Queues the task with Priority::Normal, starting the pool in case it is stopped.
      **/
-    template <class Fn, class... Args>
-    auto Submit(Fn&& fn, Args&&... args) {
-        if (status == STOP) {
-            Start();
-        }
-        if (idle_thread_num <= 0 && cur_thread_num < max_thread_num) {
-            CreateThread();
-        }
-        using RetType = decltype(fn(args...));
-        auto task = std::make_shared<std::packaged_task<RetType()>>([fn = std::forward<Fn>(fn), args...]() mutable { return std::invoke(fn, args...); });
-        std::future<RetType> future = task->get_future();
-        {
-            std::lock_guard<std::mutex> locker(task_mutex);
-            tasks.emplace([task] { (*task)(); });
-        }
-
-        task_cond.notify_one();
-        return future;
-    }
+    void Execute(Task task) override;
+    /**
+     * Queues the task with the given priority, starting the pool in case it is stopped.
+     **/
+    void ExecuteWithPriority(Task task, Priority priority) override;
 
     // Submits a callback and returns nothing.
     // Mainly used for a callback that would resume some coroutines.
     template <typename Callable>
-    void CoSubmit(Callable&& callable)
+    void CoSubmit(Callable&& callable, Priority priority = Priority::Normal)
     {
         if (status == STOP) {
             Start();
         }
-        if (idle_thread_num <= 0 && cur_thread_num < max_thread_num) {
-            CreateThread();
-        }
-        
+
+        bool capped{false};
         {
             std::lock_guard<std::mutex> locker(task_mutex);
-            tasks.emplace(std::forward<Callable>(callable));
+            Lane& lane = lanes[static_cast<size_t>(priority)];
+            lane.tasks.push(QueuedTask{Task{std::forward<Callable>(callable)}, std::chrono::steady_clock::now()});
+            // A new thread could not run the task before another one of its lane completed
+            capped = lane.running >= lane.max_running;
+        }
+        if (!capped && idle_thread_num <= 0 && cur_thread_num < max_thread_num) {
+            CreateThread();
         }
-        
+
         task_cond.notify_one();
     }
 
   private:
-    bool CreateThread();
+    struct QueuedTask {
+        Task task;
+        std::chrono::steady_clock::time_point queued_at;
+    };
+
+    // Tasks of one priority
+    struct Lane {
+        std::queue<QueuedTask> tasks;
+        size_t running{0};
+        size_t max_running{SIZE_MAX};
+    };
+
+    // Returns the index of the lane to take the next task from, requires task_mutex to be locked
+    std::optional<size_t> NextLane() const;
+    bool HasQueuedTasks() const;
+    // Threads created by Start() count as idle right away, the ones created for a queued task once they completed it
+    bool CreateThread(bool idle = false);
     void AddThread(const std::shared_ptr<std::thread>& thread);
     void DelThread(std::thread::id id);
 
@@ -148,7 +181,10 @@ class ThreadPool {
     std::list<ThreadData> threads{};
     std::mutex thread_mutex{};
 
-    std::queue<Task> tasks{};
+    // Indexed by Priority
+    std::array<Lane, 3> lanes{};
+    // Guarded by task_mutex like the lanes
+    std::chrono::milliseconds max_queue_delay{CPR_DEFAULT_THREAD_POOL_MAX_QUEUE_DELAY};
     std::mutex task_mutex{};
     std::condition_variable task_cond{};
 };
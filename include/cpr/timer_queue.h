@@ -0,0 +1,69 @@
+#ifndef CPR_TIMER_QUEUE_H
+#define CPR_TIMER_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "cpr/singleton.h"
+
+namespace cpr {
+
+/**
+ * Runs tasks once their time has come, all from a single background thread.
+ * Used to wait for something (e.g. the backoff before retrying a request) without blocking a thread for each waiter.
+ * Tasks should only hand over the actual work, e.g. by handing it to an Executor, since they delay all following tasks.
+ **/
+class TimerQueue {
+    CPR_SINGLETON_DECL(TimerQueue)
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    ~TimerQueue();
+
+    /**
+     * Runs the task on the timer thread once due_time passed.
+     **/
+    void Schedule(Clock::time_point due_time, std::function<void()> task);
+
+    /**
+     * Runs the task on the timer thread once the delay passed.
+     **/
+    template <class Rep, class Period>
+    void ScheduleAfter(const std::chrono::duration<Rep, Period>& delay, std::function<void()> task) {
+        Schedule(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay), std::move(task));
+    }
+
+  protected:
+    TimerQueue();
+
+  private:
+    struct Timer {
+        Clock::time_point due_time;
+        // Keeps timers with the same due time in the order they got scheduled
+        size_t sequence;
+        std::function<void()> task;
+
+        bool operator>(const Timer& other) const {
+            return due_time != other.due_time ? due_time > other.due_time : sequence > other.sequence;
+        }
+    };
+
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    size_t next_sequence_{0};
+    bool stop_{false};
+    std::thread thread_;
+};
+
+} // namespace cpr
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef CPR_TLS_SESSION_STORE_H
+#define CPR_TLS_SESSION_STORE_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "cpr/filesystem.h"
+
+namespace cpr {
+
+/**
+ * Process wide store for TLS sessions which can be persisted to disk.
+ * libcurl only caches TLS sessions per handle (or per share, see ConnectionPool), and only in memory.
+ * So every new Session and every restart of the process pays for a full handshake to each host.
+ * Sessions using a TlsSessionStore save the sessions (tickets) they get from servers in it and offer them on later handshakes
+ * to the same host and port, which then only need an abbreviated handshake. Sessions are only offered to connections
+ * using the same CA, verification, client certificate, TLS version and proxy options as the one that got them.
+ * Save() and Load() carry the sessions over to the next start of the process.
+ *
+ * Only supported with the OpenSSL backend. With other backends, sessions simply never get stored.
+ * Sessions are secrets, as they allow resuming the encrypted connection. Protect the file passed to Save() accordingly.
+ *
+ * Like the ConnectionPool, copies of a TlsSessionStore share the same state and it is thread safe.
+ *
+ * Example:
+ * cpr::TlsSessionStore store;
+ * store.Load("tls_sessions.bin");
+ * cpr::Response r = cpr::Get(cpr::Url{"https://example.com"}, store);
+ * store.Save("tls_sessions.bin");
+ **/
+class TlsSessionStore {
+  public:
+    using Clock = std::chrono::system_clock;
+
+    struct Metrics {
+        // Handshakes of sessions using the store
+        size_t handshakes{0};
+        // Handshakes a stored session got offered for
+        size_t offered{0};
+        // Handshakes which resumed a previous session (abbreviated handshakes)
+        size_t resumed{0};
+        // Sessions received from servers and put into the store
+        size_t stored{0};
+    };
+
+    TlsSessionStore();
+    TlsSessionStore(const TlsSessionStore&) = default;
+    TlsSessionStore(TlsSessionStore&&) noexcept = default;
+    ~TlsSessionStore() = default;
+
+    TlsSessionStore& operator=(const TlsSessionStore&) = default;
+    TlsSessionStore& operator=(TlsSessionStore&&) noexcept = default;
+
+    /**
+     * Stores the serialized (DER) session for the given key ("host:port#hash of the TLS options"), replacing the previous one.
+     * Gets called from the TLS backend once a server hands out a new session.
+     **/
+    void Put(const std::string& key, std::string session, Clock::time_point expire_time) const;
+
+    /**
+     * Returns the serialized session for the given key in case there is one which did not expire yet.
+     **/
+    [[nodiscard]] std::optional<std::string> Get(const std::string& key) const;
+
+    /**
+     * Writes all sessions which did not expire yet to the given file. Returns false in case writing failed.
+     * The file gets replaced atomically and, on POSIX systems, is only readable and writable by the owner.
+     **/
+    bool Save(const fs::path& path) const;
+
+    /**
+     * Adds the sessions saved in the given file. Expired sessions get skipped.
+     * Returns false in case the file does not exist or is not a valid session file.
+     **/
+    bool Load(const fs::path& path) const;
+
+    void Clear() const;
+
+    [[nodiscard]] size_t GetEntryCount() const;
+    [[nodiscard]] Metrics GetMetrics() const;
+
+    /**
+     * Updates the handshake counters. Gets called from the TLS backend once a handshake completed.
+     **/
+    void RecordHandshake(bool offered, bool resumed) const;
+
+  private:
+    struct Entry {
+        std::string session;
+        Clock::time_point expire_time;
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        Metrics metrics;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpr
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef CPR_TRACING_H
+#define CPR_TRACING_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cpr {
+
+class Response;
+
+/**
+ * W3C trace context (https://www.w3.org/TR/trace-context/) of a span.
+ **/
+struct TraceContext {
+    std::array<uint8_t, 16> trace_id{};
+    std::array<uint8_t, 8> span_id{};
+    // 0x01 marks the trace as sampled
+    uint8_t flags{0x01};
+
+    /**
+     * Returns the value of the traceparent header, e.g. "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01".
+     **/
+    [[nodiscard]] std::string ToTraceparent() const;
+    /**
+     * Parses the value of a traceparent header. Returns std::nullopt in case it is malformed.
+     **/
+    [[nodiscard]] static std::optional<TraceContext> FromTraceparent(std::string_view traceparent);
+    /**
+     * Returns a context with random ids. Uses the trace id of the parent in case there is one.
+     **/
+    [[nodiscard]] static TraceContext Generate(const std::optional<TraceContext>& parent = std::nullopt);
+};
+
+enum class SpanKind : uint8_t {
+    // One attempt of a request, from being queued or prepared until it completed. Parent of all other spans.
+    REQUEST,
+    // Waiting for a thread of the pool or for the timer of a retry
+    QUEUED,
+    // Setting up the curl handle
+    PREPARE,
+    DNS,
+    CONNECT,
+    TLS,
+    // Sending the request until the first byte of the response arrived
+    FIRST_BYTE,
+    // Receiving the rest of the response and building the Response object
+    COMPLETE,
+    // One interceptor, including everything it proceeded with
+    INTERCEPTOR,
+};
+
+struct Span {
+    SpanKind kind{SpanKind::REQUEST};
+    TraceContext context;
+    // Span id of the parent, all zero for a REQUEST without parent
+    std::array<uint8_t, 8> parent_span_id{};
+    std::chrono::system_clock::time_point start;
+    std::chrono::system_clock::time_point end;
+    // Only set for REQUEST spans
+    std::string_view method;
+    const Response* response{nullptr};
+};
+
+/**
+ * Receives finished spans, e.g. to hand them to an OpenTelemetry exporter.
+ * Gets called on the thread making the request, so implementations have to be thread safe and should not block.
+ **/
+class TraceSink {
+  public:
+    TraceSink() = default;
+    TraceSink(const TraceSink&) = default;
+    TraceSink(TraceSink&&) = default;
+    virtual ~TraceSink() = default;
+
+    TraceSink& operator=(const TraceSink&) = default;
+    TraceSink& operator=(TraceSink&&) = default;
+
+    virtual void OnSpan(const Span& span) = 0;
+};
+
+/**
+ * Emits spans for the lifecycle of each request made by a session (see SpanKind) to the sink and adds the traceparent
+ * header, so the spans of the server join the same trace. Without a Tracer no spans get recorded at all.
+ *
+ * DNS, CONNECT, TLS and FIRST_BYTE are derived from the timings curl reports once the transfer completed and are left
+ * out in case they did not happen, e.g. for reused connections. Each attempt of a retried request is a REQUEST span
+ * of its own. They share a trace in case a parent is set.
+ *
+ * Copies of a Tracer share the same sink.
+ *
+ * Example:
+ * // Continue the trace of the incoming request
+ * cpr::Tracer tracer{sink, cpr::TraceContext::FromTraceparent(incoming_traceparent)};
+ * cpr::Response r = cpr::Get(cpr::Url{"http://xxx/api"}, tracer);
+ **/
+class Tracer {
+  public:
+    explicit Tracer(std::shared_ptr<TraceSink> sink, std::optional<TraceContext> parent = std::nullopt, bool propagate = true);
+
+    [[nodiscard]] const std::optional<TraceContext>& GetParent() const;
+    /**
+     * Whether the traceparent header gets added to requests not setting one themselves.
+     **/
+    [[nodiscard]] bool Propagates() const;
+
+    void Emit(const Span& span) const;
+
+  private:
+    std::shared_ptr<TraceSink> sink_;
+    std::optional<TraceContext> parent_;
+    bool propagate_;
+};
+
+} // namespace cpr
+
+#endif
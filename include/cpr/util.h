@@ -1,14 +1,18 @@
 #ifndef CPR_UTIL_H
 #define CPR_UTIL_H
 
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "cpr/callback.h"
+#include "cpr/chunked_body.h"
 #include "cpr/cookies.h"
 #include "cpr/cprtypes.h"
+#include "cpr/file_sink.h"
 #include "cpr/secure_string.h"
 #include "cpr/sse.h"
 
@@ -19,7 +23,19 @@ Cookies parseCookies(curl_slist* raw_cookies);
 size_t readUserFunction(char* ptr, size_t size, size_t nitems, const ReadCallback* read);
 size_t headerUserFunction(char* ptr, size_t size, size_t nmemb, const HeaderCallback* header);
 size_t writeFunction(char* ptr, size_t size, size_t nmemb, void* data);
+/**
+ * Target of writeHeaderReserveFunction.
+ * Header lines get appended to header. Once a Content-Length header passes by, body reserves up to max_reserve bytes.
+ **/
+struct ResponseStringReserveData {
+    std::string* header{nullptr};
+    std::string* body{nullptr};
+    size_t max_reserve{0};
+};
+size_t writeHeaderReserveFunction(char* ptr, size_t size, size_t nmemb, ResponseStringReserveData* data);
+size_t writeChunkedBodyFunction(char* ptr, size_t size, size_t nmemb, ChunkedBody* body);
 size_t writeFileFunction(char* ptr, size_t size, size_t nmemb, std::ofstream* file);
+size_t writeFileSinkFunction(char* ptr, size_t size, size_t nmemb, FileSink* sink);
 size_t writeUserFunction(char* ptr, size_t size, size_t nmemb, const WriteCallback* write);
 size_t writeSSEFunction(char* ptr, size_t size, size_t nmemb, ServerSentEventCallback* sse);
 
@@ -44,6 +60,12 @@ bool isTrue(const std::string& s);
  **/
 time_t sTimestampToT(const std::string&);
 
+/**
+ * 64 bit FNV-1a hash of the data. Stable across processes and platforms, so it may be persisted, but not cryptographic.
+ * Pass the previous hash to continue hashing over multiple pieces of data.
+ **/
+uint64_t fnv1a(std::string_view data, uint64_t hash = 14695981039346656037ULL);
+
 } // namespace cpr::util
 
 #endif
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Upper bounds for the allocations of each phase. cpr controls OTHER, PREPARE and COMPLETE, while SESSION and TRANSFER
+// mostly consist of curl allocations and therefore get more headroom for differing curl versions and features.
+struct AllocationBounds {
+    uint64_t other;
+    uint64_t session;
+    uint64_t prepare;
+    uint64_t transfer;
+    uint64_t complete;
+};
+
+static void ExpectWithinBounds(const AllocationStats& stats, const AllocationBounds& bounds) {
+    EXPECT_LE(stats[AllocationPhase::OTHER].allocations, bounds.other);
+    EXPECT_LE(stats[AllocationPhase::SESSION].allocations, bounds.session);
+    EXPECT_LE(stats[AllocationPhase::PREPARE].allocations, bounds.prepare);
+    EXPECT_LE(stats[AllocationPhase::TRANSFER].allocations, bounds.transfer);
+    EXPECT_LE(stats[AllocationPhase::COMPLETE].allocations, bounds.complete);
+}
+
+class AllocationTests : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        if (!AllocationRecorder::IsEnabled()) {
+            GTEST_SKIP() << "cpr got built without CPR_ALLOCATION_ACCOUNTING";
+        }
+        // Warm up the one time allocations, e.g. of curl's global state and the connection to the server
+        const Response response = cpr::Get(Url{server->GetBaseUrl() + "/hello.html"});
+        ASSERT_EQ(200, response.status_code);
+    }
+};
+
+TEST_F(AllocationTests, RecorderCountsPhasesOfCallingThread) {
+    AllocationRecorder recorder;
+    std::unique_ptr<int> other = std::make_unique<int>(1);
+    {
+        const AllocationPhaseScope prepare{AllocationPhase::PREPARE};
+        std::unique_ptr<std::string> value = std::make_unique<std::string>(64, 'x');
+        {
+            const AllocationPhaseScope complete{AllocationPhase::COMPLETE};
+            std::unique_ptr<int> nested = std::make_unique<int>(2);
+        }
+    }
+    const AllocationStats stats = recorder.GetStats();
+    EXPECT_EQ(1, stats[AllocationPhase::OTHER].allocations);
+    EXPECT_EQ(sizeof(int), stats[AllocationPhase::OTHER].bytes);
+    EXPECT_EQ(2, stats[AllocationPhase::PREPARE].allocations);
+    EXPECT_EQ(1, stats[AllocationPhase::COMPLETE].allocations);
+    EXPECT_EQ(4, stats.Total().allocations);
+
+    recorder.Reset();
+    EXPECT_EQ(0, recorder.GetStats().Total().allocations);
+}
+
+TEST_F(AllocationTests, Get) {
+    AllocationRecorder recorder;
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/hello.html"});
+    EXPECT_EQ(200, response.status_code);
+    ExpectWithinBounds(recorder.GetStats(), {10, 30, 10, 200, 40});
+}
+
+TEST_F(AllocationTests, GetWithParametersAndHeader) {
+    AllocationRecorder recorder;
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/hello.html"}, Parameters{{"key", "value"}, {"hello", "world wide"}}, Header{{"X-First", "1"}, {"X-Second", "2"}});
+    EXPECT_EQ(200, response.status_code);
+    ExpectWithinBounds(recorder.GetStats(), {20, 30, 35, 200, 40});
+}
+
+TEST_F(AllocationTests, PostPayload) {
+    AllocationRecorder recorder;
+    const Response response = cpr::Post(Url{server->GetBaseUrl() + "/url_post.html"}, Payload{{"x", "5"}, {"y", "7"}});
+    EXPECT_EQ(201, response.status_code);
+    ExpectWithinBounds(recorder.GetStats(), {15, 30, 20, 200, 50});
+}
+
+TEST_F(AllocationTests, ReusedSession) {
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    EXPECT_EQ(200, session.Get().status_code);
+
+    AllocationRecorder recorder;
+    const Response response = session.Get();
+    EXPECT_EQ(200, response.status_code);
+    const AllocationStats stats = recorder.GetStats();
+    EXPECT_EQ(0, stats[AllocationPhase::SESSION].allocations);
+    ExpectWithinBounds(stats, {5, 0, 10, 120, 40});
+}
+
+TEST_F(AllocationTests, Download) {
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    AllocationRecorder recorder;
+    const Response response = session.Download(WriteCallback{[](std::string_view /*data*/, intptr_t /*userdata*/) { return true; }});
+    EXPECT_EQ(200, response.status_code);
+    ExpectWithinBounds(recorder.GetStats(), {5, 0, 10, 200, 40});
+}
+
+TEST_F(AllocationTests, MultiPerformGet) {
+    AllocationRecorder recorder;
+    MultiPerform multiperform;
+    for (size_t i = 0; i < 4; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+        multiperform.AddSession(session);
+    }
+    const std::vector<Response> responses = multiperform.Get();
+    for (const Response& response : responses) {
+        EXPECT_EQ(200, response.status_code);
+    }
+    ExpectWithinBounds(recorder.GetStats(), {80, 120, 40, 600, 160});
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
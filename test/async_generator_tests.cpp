@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+using namespace cpr::coroutine;
+
+static HttpServer* server = new HttpServer();
+
+namespace {
+AsyncGenerator<int> Count(int count, std::atomic_int& produced) {
+    for (int i = 0; i < count; ++i) {
+        ++produced;
+        co_yield i;
+    }
+}
+
+AsyncGenerator<int> CountSlowly(int count) {
+    for (int i = 0; i < count; ++i) {
+        co_await SleepFor(std::chrono::milliseconds{1});
+        co_yield i;
+    }
+}
+
+AsyncGenerator<int> ThrowAfterFirst() {
+    co_yield 1;
+    throw std::runtime_error{"Failed"};
+}
+
+coroutine::Task<std::vector<int>> Collect(AsyncGenerator<int> generator) {
+    std::vector<int> values;
+    while (std::optional<int> value = co_await generator.next()) {
+        values.push_back(*value);
+    }
+    co_return values;
+}
+
+AsyncGenerator<std::string> ReadChunks(ResponseStream& stream) {
+    while (true) {
+        co_await StreamReady{stream};
+        std::optional<std::string> chunk = stream.Read();
+        if (!chunk) {
+            co_return;
+        }
+        co_yield std::move(*chunk);
+    }
+}
+
+coroutine::Task<std::string> ReadBody(std::shared_ptr<Session> session, size_t max_buffered_bytes, Response* response) {
+    AsyncGenerator<std::string> chunks = session->CoGetStream(max_buffered_bytes, response);
+    std::string body;
+    while (std::optional<std::string> chunk = co_await chunks.next()) {
+        body += *chunk;
+    }
+    co_return body;
+}
+
+coroutine::Task<std::vector<ServerSentEvent>> ReadEvents(std::shared_ptr<Session> session) {
+    AsyncGenerator<ServerSentEvent> events = session->CoGetEventStream();
+    std::vector<ServerSentEvent> result;
+    while (std::optional<ServerSentEvent> event = co_await events.next()) {
+        result.push_back(std::move(*event));
+    }
+    co_return result;
+}
+} // namespace
+
+TEST(AsyncGeneratorTests, YieldsAllValues) {
+    std::atomic_int produced{0};
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), sync_wait(Collect(Count(4, produced))));
+    EXPECT_EQ(4, produced);
+}
+
+TEST(AsyncGeneratorTests, OnlyRunsWhenAwaited) {
+    std::atomic_int produced{0};
+    AsyncGenerator<int> generator = Count(10, produced);
+    EXPECT_EQ(0, produced);
+    EXPECT_EQ(0, sync_wait(generator.next()));
+    EXPECT_EQ(1, sync_wait(generator.next()));
+    // Suspended until the next value gets requested, so it does not run ahead of the consumer
+    EXPECT_EQ(2, produced);
+    EXPECT_FALSE(generator.IsDone());
+}
+
+TEST(AsyncGeneratorTests, AwaitsInBetween) {
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), sync_wait(Collect(CountSlowly(3))));
+}
+
+TEST(AsyncGeneratorTests, RethrowsException) {
+    AsyncGenerator<int> generator = ThrowAfterFirst();
+    EXPECT_EQ(1, sync_wait(generator.next()));
+    EXPECT_THROW(sync_wait(generator.next()), std::runtime_error);
+    EXPECT_TRUE(generator.IsDone());
+    EXPECT_FALSE(sync_wait(generator.next()).has_value());
+}
+
+TEST(AsyncGeneratorTests, StreamsBody) {
+    Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(url);
+    Response response;
+    EXPECT_EQ(std::string{"this is a file content."}, sync_wait(ReadBody(session, 1, &response)));
+    EXPECT_EQ(std::string{}, response.text);
+    EXPECT_EQ(url, response.url);
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+
+    // The session is usable as usual afterwards
+    response = session->Get();
+    EXPECT_EQ(std::string{"this is a file content."}, response.text);
+
+    // While the consumer holds on to a chunk, the transfer stays paused with a single buffered byte allowed
+    session->SetUrl(Url{server->GetBaseUrl() + "/chunked.html"});
+    ResponseStream stream = session->GetStream(1);
+    AsyncGenerator<std::string> chunks = ReadChunks(stream);
+    std::optional<std::string> chunk = sync_wait(chunks.next());
+    ASSERT_TRUE(chunk.has_value());
+    EXPECT_TRUE(stream.IsPaused());
+    std::string body = *chunk;
+    while ((chunk = sync_wait(chunks.next()))) {
+        EXPECT_LE(stream.GetBufferedBytes(), size_t{8});
+        body += *chunk;
+    }
+    EXPECT_FALSE(stream.IsPaused());
+    EXPECT_EQ(std::string{"this is a file content."}, body);
+    EXPECT_EQ(ErrorCode::OK, stream.Finish().error.code);
+}
+
+TEST(AsyncGeneratorTests, WaitingStreamDoesNotBlockExecutor) {
+    std::shared_ptr<ThreadPool> executor = std::make_shared<ThreadPool>(1, 1);
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetExecutor(executor);
+    // Sends the body after two seconds
+    session->SetUrl(Url{server->GetBaseUrl() + "/low_speed.html"});
+    std::future<std::string> body = std::async(std::launch::async, [session]() { return sync_wait(ReadBody(session, CPR_DEFAULT_STREAM_BUFFER_SIZE, nullptr)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    // The only thread of the executor is free while the stream waits for the server
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_EQ(42, cpr::async(*executor, []() { return 42; }).get());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{500});
+    EXPECT_EQ(std::string{"Hello world!"}, body.get());
+}
+
+TEST(AsyncGeneratorTests, StopsStreamEarly) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    {
+        AsyncGenerator<std::string> chunks = session->CoGetStream();
+        EXPECT_EQ(std::string{"Hello world!"}, sync_wait(chunks.next()));
+    }
+    Response response = session->Get();
+    EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+}
+
+TEST(AsyncGeneratorTests, StreamsServerSentEvents) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/events.html"});
+    const std::vector<ServerSentEvent> events = sync_wait(ReadEvents(session));
+    ASSERT_EQ(size_t{2}, events.size());
+    EXPECT_EQ(std::string{"message"}, events[0].event);
+    EXPECT_EQ(std::string{"first"}, events[0].data);
+    EXPECT_EQ(std::string{"update"}, events[1].event);
+    EXPECT_EQ(std::string{"second"}, events[1].data);
+    EXPECT_EQ(std::string{"2"}, events[1].id);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
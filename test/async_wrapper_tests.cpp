@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Queues the tasks handed over to it until the test runs them, which makes the order of completions deterministic
+class QueueingExecutor : public Executor {
+  public:
+    void Execute(Task task) override {
+        tasks.push_back(std::move(task));
+    }
+
+    void RunAll() {
+        std::vector<Task> running;
+        running.swap(tasks);
+        for (const Task& task : running) {
+            task();
+        }
+    }
+
+    std::vector<Task> tasks;
+};
+
+TEST(AsyncWrapperContinuationTests, ThenRunsOnCompletingThread) {
+    QueueingExecutor executor;
+    std::thread::id continuation_thread;
+    AsyncWrapper<int> result = async(executor, []() { return 20; }).then([&continuation_thread](int value) {
+        continuation_thread = std::this_thread::get_id();
+        return value + 22;
+    });
+    EXPECT_EQ(std::future_status::timeout, result.wait_for(std::chrono::seconds{0}));
+
+    std::thread completing{[&executor]() { executor.RunAll(); }};
+    const std::thread::id completing_thread = completing.get_id();
+    completing.join();
+    EXPECT_EQ(completing_thread, continuation_thread);
+    EXPECT_EQ(42, result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, ThenOnCompletedWrapperRunsRightAway) {
+    InlineExecutor executor;
+    AsyncWrapper<std::string> result = async(executor, []() { return std::string{"Hello"}; }).then([](const std::string& value) { return value + " world!"; });
+    EXPECT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds{0}));
+    EXPECT_EQ("Hello world!", result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, ThenChainsVoid) {
+    InlineExecutor executor;
+    bool called = false;
+    AsyncWrapper<int> result = async(executor, []() {}).then([&called]() { called = true; }).then([]() { return 1; });
+    EXPECT_TRUE(called);
+    EXPECT_EQ(1, result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, ThenPassesOnExceptions) {
+    QueueingExecutor executor;
+    bool called = false;
+    AsyncWrapper<int> result = async(executor, []() -> int { throw std::runtime_error{"Failed"}; }).then([&called](int value) {
+        called = true;
+        return value;
+    });
+    executor.RunAll();
+    EXPECT_THROW(std::ignore = result.get(), std::runtime_error);
+    EXPECT_FALSE(called);
+
+    AsyncWrapper<int> throwing = async(executor, []() { return 1; }).then([](int /*value*/) -> int { throw std::runtime_error{"Failed"}; });
+    executor.RunAll();
+    EXPECT_THROW(std::ignore = throwing.get(), std::runtime_error);
+}
+
+TEST(AsyncWrapperContinuationTests, ThenUnwrapsReturnedWrapper) {
+    QueueingExecutor executor;
+    AsyncWrapper<int> result = async(executor, []() { return 2; }).then([&executor](int value) { return async(executor, [value]() { return value * 21; }); });
+    // Runs the first task, which hands over the second one
+    executor.RunAll();
+    EXPECT_EQ(std::future_status::timeout, result.wait_for(std::chrono::seconds{0}));
+    executor.RunAll();
+    EXPECT_EQ(42, result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, ThenOnPlainFuture) {
+    std::promise<int> promise;
+    AsyncWrapper<int> result = AsyncWrapper{promise.get_future()}.then([](int value) { return value + 1; });
+    promise.set_value(41);
+    EXPECT_EQ(42, result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, ThenConsumesWrapper) {
+    InlineExecutor executor;
+    AsyncWrapper<int> wrapper = async(executor, []() { return 1; });
+    AsyncWrapper<int> result = wrapper.then([](int value) { return value; });
+    EXPECT_FALSE(wrapper.valid());
+    EXPECT_THROW(std::ignore = wrapper.then([](int value) { return value; }), std::logic_error);
+    EXPECT_EQ(1, result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, CancelPropagatesThroughChain) {
+    std::promise<int> promise;
+    std::shared_ptr<std::atomic_bool> cancelled = std::make_shared<std::atomic_bool>(false);
+    std::shared_ptr<std::atomic_bool> cancelled_copy = cancelled;
+    std::atomic_bool called{false};
+    AsyncWrapper<int, true> result = AsyncWrapper{promise.get_future(), std::move(cancelled_copy)}.then([](int value) { return value; }).then([&called](int value) {
+        called = true;
+        return value;
+    });
+    EXPECT_EQ(CancellationResult::success, result.Cancel());
+    EXPECT_TRUE(cancelled->load());
+    promise.set_value(1);
+    EXPECT_THROW(std::ignore = result.get(), std::logic_error);
+    EXPECT_FALSE(called);
+}
+
+TEST(AsyncWrapperContinuationTests, CancelSkipsPendingContinuation) {
+    QueueingExecutor executor;
+    bool called = false;
+    AsyncWrapper<int, true> result = async<true>(executor, []() { return 1; }).then([&called](int value) {
+        called = true;
+        return value;
+    });
+    EXPECT_EQ(CancellationResult::success, result.Cancel());
+    executor.RunAll();
+    EXPECT_FALSE(called);
+}
+
+TEST(AsyncWrapperContinuationTests, WhenAllKeepsOrder) {
+    QueueingExecutor executor;
+    std::vector<AsyncWrapper<int>> wrappers;
+    for (int i = 0; i < 5; ++i) {
+        wrappers.push_back(async(executor, [i]() { return i; }));
+    }
+    AsyncWrapper<std::vector<int>> result = when_all(std::move(wrappers));
+    // Completes them in reverse order
+    while (!executor.tasks.empty()) {
+        const Executor::Task task = std::move(executor.tasks.back());
+        executor.tasks.pop_back();
+        EXPECT_EQ(std::future_status::timeout, result.wait_for(std::chrono::seconds{0}));
+        task();
+    }
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), result.get());
+}
+
+TEST(AsyncWrapperContinuationTests, WhenAllPassesOnFirstException) {
+    InlineExecutor executor;
+    std::vector<AsyncWrapper<int>> wrappers;
+    wrappers.push_back(async(executor, []() { return 1; }));
+    wrappers.push_back(async(executor, []() -> int { throw std::runtime_error{"Failed"}; }));
+    wrappers.push_back(async(executor, []() -> int { throw std::logic_error{"Failed"}; }));
+    EXPECT_THROW(std::ignore = when_all(std::move(wrappers)).get(), std::runtime_error);
+    EXPECT_TRUE(when_all(std::vector<AsyncWrapper<int>>{}).get().empty());
+}
+
+TEST(AsyncWrapperContinuationTests, WhenAnyCancelsTheOthers) {
+    std::promise<int> slow;
+    std::promise<int> fast;
+    std::shared_ptr<std::atomic_bool> slow_cancelled = std::make_shared<std::atomic_bool>(false);
+    std::shared_ptr<std::atomic_bool> fast_cancelled = std::make_shared<std::atomic_bool>(false);
+    std::vector<AsyncWrapper<int, true>> wrappers;
+    wrappers.emplace_back(slow.get_future(), std::shared_ptr<std::atomic_bool>{slow_cancelled});
+    wrappers.emplace_back(fast.get_future(), std::shared_ptr<std::atomic_bool>{fast_cancelled});
+    AsyncWrapper<WhenAnyResult<int>, true> result = when_any(std::move(wrappers));
+
+    fast.set_value(42);
+    const WhenAnyResult<int> first = result.get();
+    EXPECT_EQ(size_t{1}, first.index);
+    EXPECT_EQ(42, first.value);
+    EXPECT_TRUE(slow_cancelled->load());
+    EXPECT_FALSE(fast_cancelled->load());
+    slow.set_value(0);
+    EXPECT_THROW(std::ignore = when_any(std::vector<AsyncWrapper<int, true>>{}), std::logic_error);
+}
+
+TEST(AsyncWrapperContinuationTests, RequestPipeline) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    std::vector<AsyncResponse> responses;
+    for (size_t i = 0; i < 4; ++i) {
+        responses.push_back(GetAsync(url).then([url](const Response& response) {
+            EXPECT_EQ(200, response.status_code);
+            return GetAsync(url, Parameters{{"previous", response.text}});
+        }));
+    }
+    const std::vector<Response> results = when_all(std::move(responses)).get();
+    ASSERT_EQ(size_t{4}, results.size());
+    for (const Response& response : results) {
+        EXPECT_EQ(200, response.status_code);
+        EXPECT_EQ("Hello world!", response.text);
+    }
+}
+
+TEST(AsyncWrapperContinuationTests, SessionAsyncThen) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    const std::string text = session->GetAsync().then([](const Response& response) { return response.text; }).get();
+    EXPECT_EQ("Hello world!", text);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
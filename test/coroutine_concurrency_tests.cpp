@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+using namespace cpr::coroutine;
+
+static HttpServer* server = new HttpServer();
+
+namespace {
+// Counts the tasks it hands over to a thread pool of its own
+class CountingExecutor : public Executor {
+  public:
+    void Execute(Task task) override {
+        ++count;
+        pool.Execute(std::move(task));
+    }
+
+    std::atomic_size_t count{0};
+    ThreadPool pool;
+};
+
+// Runs its member coroutines on its executor, like a Session does
+class ExecutorOwner {
+  public:
+    explicit ExecutorOwner(std::shared_ptr<Executor> executor) : executor_(std::move(executor)) {}
+
+    [[nodiscard]] std::shared_ptr<Executor> GetExecutor() const {
+        return executor_;
+    }
+
+    coroutine::Task<std::thread::id> GetThread() {
+        co_return std::this_thread::get_id();
+    }
+
+    coroutine::Task<bool> RunsChildOnSameThread() {
+        const std::thread::id id = std::this_thread::get_id();
+        co_return id == co_await GetThread();
+    }
+
+  private:
+    std::shared_ptr<Executor> executor_;
+};
+
+coroutine::Task<int> Delayed(int value, std::chrono::milliseconds delay) {
+    co_await SleepFor(delay);
+    co_return value;
+}
+
+coroutine::Task<int> Failing(std::chrono::milliseconds delay) {
+    co_await SleepFor(delay);
+    throw std::runtime_error{"Failed"};
+}
+
+coroutine::Task<void> Increment(std::atomic_int& counter) {
+    co_await SleepFor(std::chrono::milliseconds{1});
+    ++counter;
+}
+
+coroutine::Task<void> Limited(Semaphore& semaphore, std::atomic_int& active, std::atomic_int& max_active) {
+    const SemaphoreGuard guard = co_await semaphore.ScopedAcquire();
+    const int now_active = ++active;
+    int previous = max_active.load();
+    while (previous < now_active && !max_active.compare_exchange_weak(previous, now_active)) {}
+    co_await SleepFor(std::chrono::milliseconds{20});
+    --active;
+}
+
+coroutine::Task<void> WaitForCancellation(CancellationScope scope) {
+    while (!scope.IsCancelled()) {
+        co_await SleepFor(std::chrono::milliseconds{5});
+    }
+    scope.ThrowIfCancelled();
+}
+
+coroutine::Task<void> Throwing() {
+    co_await SleepFor(std::chrono::milliseconds{10});
+    throw std::runtime_error{"Failed"};
+}
+
+coroutine::Task<std::vector<int>> FanOut(size_t count) {
+    std::vector<coroutine::Task<int>> tasks;
+    for (size_t i = 0; i < count; ++i) {
+        tasks.push_back(Delayed(static_cast<int>(i), std::chrono::milliseconds{static_cast<int>(count - i) * 10}));
+    }
+    co_return co_await when_all(std::move(tasks));
+}
+
+coroutine::Task<size_t> Group(std::atomic_int& counter) {
+    TaskGroup group;
+    for (size_t i = 0; i < 10; ++i) {
+        group.Spawn(Increment(counter));
+    }
+    co_await group.Join();
+    co_return 10;
+}
+
+coroutine::Task<void> FailingGroup() {
+    TaskGroup group;
+    group.Spawn(WaitForCancellation(group.GetScope()));
+    group.Spawn(Throwing());
+    co_await group.Join();
+}
+} // namespace
+
+TEST(CoroutineConcurrencyTests, WhenAllKeepsOrderAndRunsConcurrently) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // The first one takes the longest, so they complete in reverse order
+    const std::vector<int> results = sync_wait(FanOut(5));
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), results);
+    // One after another they would take 150 ms
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{140});
+}
+
+TEST(CoroutineConcurrencyTests, WhenAllRethrowsFirstException) {
+    std::vector<coroutine::Task<int>> tasks;
+    tasks.push_back(Delayed(1, std::chrono::milliseconds{1}));
+    tasks.push_back(Failing(std::chrono::milliseconds{5}));
+    EXPECT_THROW(sync_wait(when_all(std::move(tasks))), std::runtime_error);
+    EXPECT_TRUE(sync_wait(when_all(std::vector<coroutine::Task<int>>{})).empty());
+}
+
+TEST(CoroutineConcurrencyTests, WhenAllVoid) {
+    std::atomic_int counter{0};
+    std::vector<coroutine::Task<void>> tasks;
+    for (size_t i = 0; i < 20; ++i) {
+        tasks.push_back(Increment(counter));
+    }
+    sync_wait(when_all(std::move(tasks)));
+    EXPECT_EQ(20, counter);
+}
+
+TEST(CoroutineConcurrencyTests, WhenAnyReturnsFirstAndCancelsScope) {
+    CancellationScope scope;
+    std::vector<coroutine::Task<int>> tasks;
+    tasks.push_back(Delayed(1, std::chrono::milliseconds{200}));
+    tasks.push_back(Delayed(2, std::chrono::milliseconds{1}));
+    const WhenAnyResult<int> first = sync_wait(when_any(std::move(tasks), scope));
+    EXPECT_EQ(size_t{1}, first.index);
+    EXPECT_EQ(2, first.value);
+    EXPECT_TRUE(scope.IsCancelled());
+    EXPECT_THROW(sync_wait(when_any(std::vector<coroutine::Task<int>>{})), std::logic_error);
+}
+
+TEST(CoroutineConcurrencyTests, SemaphoreLimitsConcurrency) {
+    Semaphore semaphore{3};
+    std::atomic_int active{0};
+    std::atomic_int max_active{0};
+    std::vector<coroutine::Task<void>> tasks;
+    for (size_t i = 0; i < 12; ++i) {
+        tasks.push_back(Limited(semaphore, active, max_active));
+    }
+    sync_wait(when_all(std::move(tasks)));
+    EXPECT_EQ(3, max_active);
+    EXPECT_EQ(0, active);
+    EXPECT_EQ(size_t{3}, semaphore.GetAvailable());
+}
+
+TEST(CoroutineConcurrencyTests, SemaphoreTryAcquire) {
+    Semaphore semaphore{1};
+    EXPECT_TRUE(semaphore.TryAcquire());
+    EXPECT_FALSE(semaphore.TryAcquire());
+    semaphore.Release();
+    EXPECT_TRUE(semaphore.TryAcquire());
+}
+
+TEST(CoroutineConcurrencyTests, CancellationScopeCancelsChildren) {
+    const CancellationScope parent;
+    const CancellationScope child = parent.CreateChild();
+    const CancellationScope grandchild = child.CreateChild();
+    const CancellationScope other_child = parent.CreateChild();
+
+    other_child.Cancel();
+    EXPECT_FALSE(parent.IsCancelled());
+    EXPECT_FALSE(child.IsCancelled());
+
+    parent.Cancel();
+    EXPECT_TRUE(child.IsCancelled());
+    EXPECT_TRUE(grandchild.GetFlag()->load());
+    EXPECT_THROW(grandchild.ThrowIfCancelled(), OperationCancelled);
+    EXPECT_TRUE(parent.CreateChild().IsCancelled());
+}
+
+TEST(CoroutineConcurrencyTests, TaskGroupJoinsAllTasks) {
+    std::atomic_int counter{0};
+    EXPECT_EQ(size_t{10}, sync_wait(Group(counter)));
+    EXPECT_EQ(10, counter);
+}
+
+TEST(CoroutineConcurrencyTests, TaskGroupFailureCancelsOthers) {
+    EXPECT_THROW(sync_wait(FailingGroup()), std::runtime_error);
+}
+
+TEST(CoroutineConcurrencyTests, TaskStartsInlineOnSameExecutor) {
+    std::shared_ptr<CountingExecutor> executor = std::make_shared<CountingExecutor>();
+    ExecutorOwner owner{executor};
+    EXPECT_TRUE(sync_wait(owner.RunsChildOnSameThread()));
+    // Only starting the outer task got handed over to the executor
+    EXPECT_EQ(size_t{1}, executor->count);
+}
+
+TEST(CoroutineConcurrencyTests, WhenAllRequests) {
+    // Tasks start once awaited, so the sessions have to outlive them
+    std::vector<std::shared_ptr<Session>> sessions;
+    std::vector<coroutine::Task<Response>> tasks;
+    for (size_t i = 0; i < 8; ++i) {
+        sessions.push_back(std::make_shared<Session>());
+        sessions.back()->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+        tasks.push_back(sessions.back()->CoGetAsync());
+    }
+    const std::vector<Response> responses = sync_wait(when_all(std::move(tasks)));
+    ASSERT_EQ(size_t{8}, responses.size());
+    for (const Response& response : responses) {
+        EXPECT_EQ("Hello world!", response.text);
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
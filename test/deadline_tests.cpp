@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+static std::chrono::milliseconds getElapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+TEST(DeadlineTests, RemainingBudgetShrinks) {
+    const Deadline deadline{std::chrono::milliseconds{100}};
+    EXPECT_FALSE(deadline.Expired());
+    EXPECT_LE(deadline.Remaining(), std::chrono::milliseconds{100});
+    EXPECT_GT(deadline.Remaining(), std::chrono::milliseconds{50});
+    std::this_thread::sleep_for(std::chrono::milliseconds{110});
+    EXPECT_TRUE(deadline.Expired());
+    EXPECT_EQ(std::chrono::milliseconds::zero(), deadline.Remaining());
+}
+
+TEST(DeadlineTests, EarliestPicksTheEarlierDeadline) {
+    const Deadline early{std::chrono::milliseconds{100}};
+    const Deadline late{std::chrono::milliseconds{200}};
+    EXPECT_EQ(early.time_point, Deadline::Earliest(early, late)->time_point);
+    EXPECT_EQ(early.time_point, Deadline::Earliest(late, early)->time_point);
+    EXPECT_EQ(late.time_point, Deadline::Earliest(std::nullopt, late)->time_point);
+    EXPECT_FALSE(Deadline::Earliest(std::nullopt, std::nullopt).has_value());
+}
+
+TEST(DeadlineTests, ExpiredDeadlineFailsBeforeSending) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    const Response response = cpr::Get(url, Deadline{Deadline::Clock::now() - std::chrono::milliseconds{1}});
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, response.error.code);
+    EXPECT_EQ(0, response.status_code);
+    EXPECT_EQ(url, response.url);
+}
+
+TEST(DeadlineTests, DeadlineBoundsSlowTransfer) {
+    const Url url{server->GetBaseUrl() + "/low_speed_timeout.html"};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const Response response = cpr::Get(url, Deadline{std::chrono::milliseconds{300}});
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, response.error.code);
+    EXPECT_LT(getElapsed(start), std::chrono::milliseconds{1000});
+}
+
+TEST(DeadlineTests, ShorterTimeoutStillApplies) {
+    const Url url{server->GetBaseUrl() + "/low_speed_timeout.html"};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const Response response = cpr::Get(url, Timeout{std::chrono::milliseconds{200}}, Deadline{std::chrono::seconds{10}});
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, response.error.code);
+    EXPECT_LT(getElapsed(start), std::chrono::milliseconds{1000});
+}
+
+TEST(DeadlineTests, DeadlineStopsRetries) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    RetryPolicy retry_policy;
+    retry_policy.max_attempts = 1000;
+    retry_policy.base_delay = std::chrono::milliseconds{20};
+    retry_policy.max_delay = std::chrono::milliseconds{20};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // Retry-After: 0 of the server overrides the backoff, so the retries follow each other right away
+    const Response response = cpr::Get(url, retry_policy, Header{{"X-Retry-Id", "deadline"}, {"X-Fail-Count", "100000"}}, Deadline{std::chrono::milliseconds{200}});
+    EXPECT_LT(getElapsed(start), std::chrono::milliseconds{1000});
+    EXPECT_GT(response.retry_count, 0);
+    EXPECT_LT(response.retry_count, 1000);
+}
+
+TEST(DeadlineTests, AsyncRequestWithExpiredDeadlineFails) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session->SetDeadline(Deadline{Deadline::Clock::now()});
+    const Response response = session->GetAsync().get();
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, response.error.code);
+}
+
+TEST(DeadlineTests, MultiPerformDeadlineBoundsAllTransfers) {
+    MultiPerform multiperform;
+    std::vector<std::shared_ptr<Session>> sessions;
+    for (const char* path : {"/hello.html", "/low_speed_timeout.html", "/low_speed_timeout.html"}) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(Url{server->GetBaseUrl() + path});
+        multiperform.AddSession(session);
+        sessions.push_back(session);
+    }
+    multiperform.SetDeadline(Deadline{std::chrono::milliseconds{300}});
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::vector<Response> responses = multiperform.Get();
+    EXPECT_LT(getElapsed(start), std::chrono::milliseconds{1000});
+    ASSERT_EQ(3, responses.size());
+    EXPECT_EQ(std::string{"Hello world!"}, responses[0].text);
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, responses[1].error.code);
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, responses[2].error.code);
+
+    // The shortened timeout does not stick to the session afterwards
+    multiperform.RemoveSession(sessions[1]);
+    const Response response = sessions[1]->Get();
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+    EXPECT_EQ(200, response.status_code);
+}
+
+TEST(DeadlineTests, MultiPerformWithExpiredDeadlineSendsNothing) {
+    MultiPerform multiperform;
+    for (size_t i = 0; i < 2; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+        session->SetDeadline(Deadline{Deadline::Clock::now()});
+        multiperform.AddSession(session);
+    }
+    for (const Response& response : multiperform.Get()) {
+        EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, response.error.code);
+        EXPECT_EQ(0, response.status_code);
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
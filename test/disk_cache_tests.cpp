@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include "cpr/cpr.h"
+#include "cpr/filesystem.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Counts the requests reaching the network, i.e. passing the cache
+class CountingInterceptor : public Interceptor {
+  public:
+    Response intercept(Session& session) override {
+        ++count;
+        return proceed(session);
+    }
+
+    std::atomic_size_t count{0};
+};
+
+// Creates an empty cache directory for the test and removes it afterwards
+class DiskCacheTests : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        directory = fs::temp_directory_path() / ("cpr_disk_cache_" + std::string{::testing::UnitTest::GetInstance()->current_test_info()->name()});
+        fs::remove_all(directory);
+    }
+
+    void TearDown() override {
+        fs::remove_all(directory);
+    }
+
+    fs::path directory;
+};
+
+Response makeResponse(const std::string& body) {
+    Response response;
+    response.status_code = 200;
+    response.raw_header = "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\n\r\n";
+    response.header = Header{{"Cache-Control", "max-age=60"}};
+    response.text = body;
+    return response;
+}
+
+TEST_F(DiskCacheTests, FreshResponseIsServedFromDisk) {
+    std::shared_ptr<DiskCache> cache = std::make_shared<DiskCache>(directory);
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/cache_max_age.html"});
+    session.AddInterceptor(std::make_shared<DiskCacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    Response response = session.Get();
+    EXPECT_EQ(std::string{"Cached for a minute"}, response.text);
+    EXPECT_EQ(1, cache->GetEntryCount());
+
+    response = session.Get();
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+    EXPECT_EQ(std::string{"Cached for a minute"}, response.text);
+    EXPECT_TRUE(response.chunked_body.empty());
+    EXPECT_EQ(std::string{"max-age=60"}, response.header["Cache-Control"]);
+    EXPECT_EQ(1, counter->count);
+}
+
+TEST_F(DiskCacheTests, DownloadsBypassCache) {
+    std::shared_ptr<DiskCache> cache = std::make_shared<DiskCache>(directory);
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/cache_max_age.html"});
+    session.AddInterceptor(std::make_shared<DiskCacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    // Cached by a regular request first, still every download has to reach its callback
+    EXPECT_EQ(std::string{"Cached for a minute"}, session.Get().text);
+    for (size_t i = 0; i < 2; ++i) {
+        std::string written;
+        Response response = session.Download(WriteCallback{[&written](std::string_view data, intptr_t /*userdata*/) {
+            written += data;
+            return true;
+        }});
+        EXPECT_EQ(ErrorCode::OK, response.error.code);
+        EXPECT_EQ(std::string{"Cached for a minute"}, written);
+        EXPECT_TRUE(response.text.empty());
+    }
+    EXPECT_EQ(3, counter->count);
+    EXPECT_EQ(1, cache->GetEntryCount());
+}
+
+TEST_F(DiskCacheTests, MappedBodiesAreChunked) {
+    const std::string url{"http://example.com/artifact"};
+    DiskCache cache{directory, DiskCacheOptions{.map_bodies = true}};
+    EXPECT_TRUE(cache.Store("GET", url, Header{}, makeResponse("artifact content")));
+    const std::optional<DiskCache::LookupResult> hit = cache.Lookup("GET", url);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_TRUE(hit->response.text.empty());
+    EXPECT_EQ(std::string{"artifact content"}, hit->response.chunked_body.Flatten());
+}
+
+TEST_F(DiskCacheTests, VaryingResponseMatchesRequestHeader) {
+    const std::string url{"http://example.com/artifact"};
+    DiskCache cache{directory};
+    Response response = makeResponse("artifact content");
+    response.raw_header = "HTTP/1.1 200 OK\r\nCache-Control: max-age=60\r\nVary: Accept\r\n\r\n";
+    response.header["Vary"] = "Accept";
+    EXPECT_TRUE(cache.Store("GET", url, Header{{"Accept", "text/plain"}}, response));
+    EXPECT_TRUE(cache.Lookup("GET", url, Header{{"Accept", "text/plain"}}).has_value());
+    EXPECT_FALSE(cache.Lookup("GET", url, Header{{"Accept", "text/html"}}).has_value());
+    EXPECT_FALSE(cache.Lookup("GET", url).has_value());
+
+    response.header["Vary"] = "*";
+    EXPECT_FALSE(cache.Store("GET", url + "/any", Header{}, response));
+}
+
+TEST_F(DiskCacheTests, ResponsesSurviveReopening) {
+    const std::string url{"http://example.com/artifact"};
+    {
+        DiskCache cache{directory};
+        EXPECT_TRUE(cache.Store("GET", url, Header{}, makeResponse("artifact content")));
+    }
+    DiskCache cache{directory};
+    EXPECT_EQ(1, cache.GetEntryCount());
+    const std::optional<DiskCache::LookupResult> hit = cache.Lookup("GET", url);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_TRUE(hit->fresh);
+    EXPECT_EQ(std::string{"artifact content"}, hit->response.text);
+}
+
+TEST_F(DiskCacheTests, DirectoryIsLocked) {
+    DiskCache cache{directory};
+    EXPECT_THROW(DiskCache{directory}, std::system_error);
+}
+
+TEST_F(DiskCacheTests, FailedOpenReleasesLock) {
+    // A directory named like a segment can not be removed when starting over with a new index
+    fs::create_directories(directory / "segment-00000001.dat" / "blocker");
+    EXPECT_THROW(DiskCache{directory}, fs::filesystem_error);
+    fs::remove_all(directory / "segment-00000001.dat");
+    EXPECT_NO_THROW(DiskCache{directory});
+}
+
+TEST_F(DiskCacheTests, TruncatedSegmentIsAMiss) {
+    const std::string url{"http://example.com/artifact"};
+    {
+        DiskCache cache{directory};
+        EXPECT_TRUE(cache.Store("GET", url, Header{}, makeResponse(std::string(4096, 'x'))));
+    }
+    // Simulates a crash in the middle of writing the record
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+        if (entry.path().filename().string().rfind("segment-", 0) == 0) {
+            fs::resize_file(entry.path(), 100);
+        }
+    }
+    DiskCache cache{directory};
+    EXPECT_FALSE(cache.Lookup("GET", url).has_value());
+    EXPECT_EQ(0, cache.GetEntryCount());
+}
+
+TEST_F(DiskCacheTests, UnsyncedCorruptBodyIsAMiss) {
+    const std::string url{"http://example.com/artifact"};
+    const std::string body(4096, 'x');
+    {
+        DiskCache cache{directory, DiskCacheOptions{.sync_writes = false, .verify_checksums = false}};
+        EXPECT_TRUE(cache.Store("GET", url, Header{}, makeResponse(body)));
+    }
+    // Simulates a crash after the index reached the disk, but before the body did
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+        if (entry.path().filename().string().rfind("segment-", 0) == 0) {
+            std::fstream file{entry.path(), std::ios::in | std::ios::out | std::ios::binary};
+            file.seekp(-static_cast<std::streamoff>(body.size()), std::ios::end);
+            file << std::string(body.size(), '\0');
+        }
+    }
+    DiskCache cache{directory, DiskCacheOptions{.sync_writes = false, .verify_checksums = false}};
+    EXPECT_FALSE(cache.Lookup("GET", url).has_value());
+    EXPECT_EQ(0, cache.GetEntryCount());
+}
+
+TEST_F(DiskCacheTests, StaleResponseIsRevalidated) {
+    std::shared_ptr<DiskCache> cache = std::make_shared<DiskCache>(directory);
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/cache_revalidate.html"});
+    session.AddInterceptor(std::make_shared<DiskCacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    EXPECT_EQ(std::string{"Revalidate me"}, session.Get().text);
+    // Answered with a 304, turned into the stored 200
+    Response response = session.Get();
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(std::string{"Revalidate me"}, response.text);
+    EXPECT_EQ(2, counter->count);
+    EXPECT_EQ(session.GetHeader().end(), session.GetHeader().find("If-None-Match"));
+}
+
+TEST_F(DiskCacheTests, UnsafeRequestInvalidates) {
+    std::shared_ptr<DiskCache> cache = std::make_shared<DiskCache>(directory);
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/cache_max_age.html"});
+    session.AddInterceptor(std::make_shared<DiskCacheInterceptor>(cache));
+
+    session.Get();
+    EXPECT_EQ(1, cache->GetEntryCount());
+    session.Post();
+    EXPECT_EQ(0, cache->GetEntryCount());
+}
+
+TEST_F(DiskCacheTests, SizeBoundEvictsOldestSegments) {
+    DiskCache cache{directory, DiskCacheOptions{.max_size = 8192, .segment_size = 2048}};
+    for (size_t i = 0; i < 32; ++i) {
+        EXPECT_TRUE(cache.Store("GET", "http://example.com/" + std::to_string(i), Header{}, makeResponse(std::string(512, 'x'))));
+        EXPECT_LE(cache.GetSize(), cache.GetMaxSize());
+    }
+    EXPECT_FALSE(cache.Lookup("GET", "http://example.com/0").has_value());
+    EXPECT_TRUE(cache.Lookup("GET", "http://example.com/31").has_value());
+    EXPECT_LT(cache.GetEntryCount(), 32);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+/**
+ * Stand-in for a DNS server. Answers every host with the configured address and counts the lookups.
+ **/
+class LocalResolver {
+  public:
+    std::shared_ptr<std::atomic_size_t> calls = std::make_shared<std::atomic_size_t>(0);
+    std::shared_ptr<std::atomic_bool> failing = std::make_shared<std::atomic_bool>(false);
+    std::string address{"127.0.0.1"};
+    std::chrono::seconds ttl{0};
+
+    DnsCache::Resolver Get() const {
+        return [calls = calls, failing = failing, address = address, ttl = ttl](const std::string& /*host*/) -> std::optional<DnsRecord> {
+            ++(*calls);
+            if (*failing) {
+                return std::nullopt;
+            }
+            return DnsRecord{{address}, ttl};
+        };
+    }
+};
+
+static void waitForRefreshes(const DnsCache& dns_cache, size_t resolver_calls, const LocalResolver& resolver) {
+    for (size_t i = 0; i < 1000 && *resolver.calls < resolver_calls; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    // The entry gets updated right after the resolver returned
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(resolver_calls, *resolver.calls);
+    EXPECT_GE(dns_cache.GetMetrics().refreshes, 1);
+}
+
+TEST(DnsCacheTests, LookupsAreCached) {
+    LocalResolver resolver;
+    DnsCache dns_cache{DnsCacheOptions{}, resolver.Get()};
+    EXPECT_EQ(std::vector<std::string>{"127.0.0.1"}, dns_cache.Resolve("example.com"));
+    EXPECT_EQ(std::vector<std::string>{"127.0.0.1"}, dns_cache.Resolve("example.com"));
+    EXPECT_EQ(1, *resolver.calls);
+    EXPECT_EQ(1, dns_cache.GetEntryCount());
+    const DnsCache::Metrics metrics = dns_cache.GetMetrics();
+    EXPECT_EQ(1, metrics.misses);
+    EXPECT_EQ(1, metrics.hits);
+}
+
+TEST(DnsCacheTests, RecordsGetRefreshedBeforeTheyExpire) {
+    LocalResolver resolver;
+    resolver.ttl = std::chrono::seconds{1};
+    DnsCacheOptions options;
+    options.refresh_ratio = 0.0;
+    DnsCache dns_cache{options, resolver.Get()};
+    EXPECT_TRUE(dns_cache.Resolve("example.com"));
+    // Due for refresh right away, but still served from the cache
+    EXPECT_TRUE(dns_cache.Resolve("example.com"));
+    waitForRefreshes(dns_cache, 2, resolver);
+    EXPECT_EQ(1, dns_cache.GetMetrics().misses);
+}
+
+TEST(DnsCacheTests, StaleRecordsGetServedOnResolverFailure) {
+    LocalResolver resolver;
+    DnsCacheOptions options;
+    options.min_ttl = std::chrono::seconds{0};
+    options.default_ttl = std::chrono::seconds{0};
+    DnsCache dns_cache{options, resolver.Get()};
+    EXPECT_TRUE(dns_cache.Resolve("example.com"));
+    *resolver.failing = true;
+    EXPECT_EQ(std::vector<std::string>{"127.0.0.1"}, dns_cache.Resolve("example.com"));
+    EXPECT_FALSE(dns_cache.Resolve("unknown.example.com"));
+    const DnsCache::Metrics metrics = dns_cache.GetMetrics();
+    EXPECT_EQ(1, metrics.stale_hits);
+    EXPECT_EQ(2, metrics.failures);
+    EXPECT_EQ(1, dns_cache.GetEntryCount());
+}
+
+TEST(DnsCacheTests, PrefetchResolvesInTheBackground) {
+    LocalResolver resolver;
+    DnsCache dns_cache{DnsCacheOptions{}, resolver.Get()};
+    dns_cache.Prefetch("example.com");
+    waitForRefreshes(dns_cache, 1, resolver);
+    EXPECT_TRUE(dns_cache.Resolve("example.com"));
+    EXPECT_EQ(0, dns_cache.GetMetrics().misses);
+    dns_cache.Invalidate("example.com");
+    EXPECT_EQ(0, dns_cache.GetEntryCount());
+}
+
+TEST(DnsCacheTests, ResolveEntry) {
+    LocalResolver resolver;
+    resolver.address = "::1";
+    DnsCache dns_cache{DnsCacheOptions{}, resolver.Get()};
+    EXPECT_EQ(std::string{"example.com:443:[::1]"}, dns_cache.GetResolveEntry("https://example.com/index.html"));
+    EXPECT_EQ(std::string{"example.com:8080:[::1]"}, dns_cache.GetResolveEntry("http://example.com:8080"));
+    EXPECT_FALSE(dns_cache.GetResolveEntry("http://127.0.0.1:8080/"));
+    EXPECT_FALSE(dns_cache.GetResolveEntry("http://[::1]:8080/"));
+}
+
+TEST(DnsCacheTests, SessionsUseTheCache) {
+    LocalResolver resolver;
+    DnsCache dns_cache{DnsCacheOptions{}, resolver.Get()};
+    const Url url{"http://www.example.com:" + std::to_string(server->GetPort()) + "/hello.html"};
+    for (size_t i = 0; i < 3; ++i) {
+        Response response = cpr::Get(url, dns_cache);
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+        EXPECT_EQ(200, response.status_code);
+        EXPECT_EQ(ErrorCode::OK, response.error.code);
+    }
+    EXPECT_EQ(1, *resolver.calls);
+}
+
+TEST(DnsCacheTests, ExplicitResolveTakesPrecedence) {
+    LocalResolver resolver;
+    resolver.address = "192.0.2.1";
+    DnsCache dns_cache{DnsCacheOptions{}, resolver.Get()};
+    const Url url{"http://www.example.com:" + std::to_string(server->GetPort()) + "/hello.html"};
+    Response response = cpr::Get(url, dns_cache, Resolve{"www.example.com", "127.0.0.1", {server->GetPort()}});
+    EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    EXPECT_EQ(200, response.status_code);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
@@ -1,7 +1,14 @@
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <gtest/gtest.h>
 
+#include <iostream>
+#include <iterator>
 #include <string>
+#include <vector>
 
 #include "cpr/accept_encoding.h"
 #include "cpr/cpr.h"
@@ -9,9 +16,16 @@
 #include "cpr/api.h"
 #include "cpr/callback.h"
 #include "cpr/cprtypes.h"
+#include "cpr/file_sink.h"
+#include "cpr/filesystem.h"
 #include "cpr/session.h"
 #include "httpServer.hpp"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 static cpr::HttpServer* server = new cpr::HttpServer();
 
@@ -145,6 +159,158 @@ TEST(DownloadTests, GetDownloadFileLength) {
     EXPECT_EQ(strFileData, "this is a file content.");
 }
 
+std::string read_file(const cpr::fs::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST(DownloadTests, DownloadFileSink) {
+    cpr::Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    const cpr::fs::path path = cpr::fs::temp_directory_path() / "cpr_download_file_sink.txt";
+    {
+        cpr::FileSink sink{path};
+        cpr::Session session;
+        session.SetUrl(url);
+        cpr::Response response = session.Download(sink);
+        EXPECT_EQ(url, response.url);
+        EXPECT_EQ(200, response.status_code);
+        EXPECT_EQ(cpr::ErrorCode::OK, response.error.code);
+        EXPECT_EQ(23, sink.GetBytesWritten());
+    }
+    EXPECT_EQ(read_file(path), "this is a file content.");
+    cpr::fs::remove(path);
+}
+
+TEST(DownloadTests, DownloadFileSinkOptions) {
+    cpr::Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    const cpr::fs::path path = cpr::fs::temp_directory_path() / "cpr_download_file_sink_options.txt";
+    cpr::FileSinkOptions options;
+    options.buffer_size = 7;
+    options.preallocate = true;
+    options.direct_io = true;
+    options.direct_io_threshold = 0;
+    options.sync_on_finish = true;
+    cpr::FileSink sink{path, options};
+    cpr::Response response = cpr::Download(sink, url);
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(cpr::ErrorCode::OK, response.error.code);
+    // Everything has to be flushed once the download returns:
+    EXPECT_EQ(read_file(path), "this is a file content.");
+    cpr::fs::remove(path);
+}
+
+#ifndef _WIN32
+TEST(DownloadTests, DownloadFileSinkAtFdOffset) {
+    cpr::Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    const cpr::fs::path path = cpr::fs::temp_directory_path() / "cpr_download_file_sink_offset.txt";
+    {
+        std::ofstream file{path, std::ios::binary};
+        file << "prefix ";
+    }
+    // NOLINTNEXTLINE (cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(7, lseek(fd, 0, SEEK_END));
+    {
+        cpr::FileSinkOptions options;
+        options.preallocate = true;
+        // The offset is not aligned, so the sink has to stay buffered
+        options.direct_io = true;
+        options.direct_io_threshold = 0;
+        cpr::FileSink sink{fd, options};
+        cpr::Response response = cpr::Download(sink, url);
+        EXPECT_EQ(cpr::ErrorCode::OK, response.error.code);
+        EXPECT_EQ(23, sink.GetBytesWritten());
+    }
+    ::close(fd);
+    EXPECT_EQ(read_file(path), "prefix this is a file content.");
+    cpr::fs::remove(path);
+}
+#endif
+
+TEST(DownloadTests, DownloadFileSinkAsync) {
+    cpr::Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    const cpr::fs::path path = cpr::fs::temp_directory_path() / "cpr_download_file_sink_async.txt";
+    cpr::Response response = cpr::DownloadAsync(path, cpr::FileSinkOptions{}, url).get();
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(cpr::ErrorCode::OK, response.error.code);
+    EXPECT_EQ(read_file(path), "this is a file content.");
+    cpr::fs::remove(path);
+}
+
+TEST(DownloadTests, DownloadFileSinkMultiPerform) {
+    cpr::Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    const cpr::fs::path path_1 = cpr::fs::temp_directory_path() / "cpr_download_file_sink_multi_1.txt";
+    const cpr::fs::path path_2 = cpr::fs::temp_directory_path() / "cpr_download_file_sink_multi_2.txt";
+    {
+        cpr::FileSink sink_1{path_1};
+        cpr::FileSink sink_2{path_2};
+        std::shared_ptr<cpr::Session> session_1 = std::make_shared<cpr::Session>();
+        std::shared_ptr<cpr::Session> session_2 = std::make_shared<cpr::Session>();
+        session_1->SetUrl(url);
+        session_2->SetUrl(url);
+        cpr::MultiPerform multiperform;
+        multiperform.AddSession(session_1, cpr::MultiPerform::HttpMethod::DOWNLOAD_REQUEST);
+        multiperform.AddSession(session_2, cpr::MultiPerform::HttpMethod::DOWNLOAD_REQUEST);
+        std::vector<cpr::Response> responses = multiperform.Download(std::ref(sink_1), std::ref(sink_2));
+        ASSERT_EQ(responses.size(), 2);
+        for (const cpr::Response& response : responses) {
+            EXPECT_EQ(200, response.status_code);
+            EXPECT_EQ(cpr::ErrorCode::OK, response.error.code);
+        }
+    }
+    EXPECT_EQ(read_file(path_1), "this is a file content.");
+    EXPECT_EQ(read_file(path_2), "this is a file content.");
+    cpr::fs::remove(path_1);
+    cpr::fs::remove(path_2);
+}
+
+/**
+ * Compares the write path of Download(std::ofstream&) and Download(FileSink&) by feeding both with 16 KiB chunks, the way libcurl does.
+ * Only the sinks are measured: The chunks come from memory, no transfer is involved. It shows the cost of getting the
+ * data to disk, not the throughput of an actual download.
+ * Disabled by default, run with: download_tests --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+ * The transfer size can be set with the CPR_DOWNLOAD_BENCHMARK_BYTES environment variable and defaults to 4 GiB.
+ **/
+TEST(DownloadTests, DISABLED_FileSinkVsOfstreamWriteBenchmark) {
+    cpr::cpr_off_t total = static_cast<cpr::cpr_off_t>(4) * 1024 * 1024 * 1024;
+    // NOLINTNEXTLINE (concurrency-mt-unsafe)
+    if (const char* env = std::getenv("CPR_DOWNLOAD_BENCHMARK_BYTES")) {
+        total = std::stoll(env);
+    }
+    std::vector<char> chunk(static_cast<size_t>(16) * 1024, 'x');
+    const cpr::fs::path path = cpr::fs::temp_directory_path() / "cpr_download_benchmark.bin";
+
+    auto run = [&](const std::function<void(char*, size_t)>& write, const std::function<void()>& finish) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (cpr::cpr_off_t written = 0; written < total; written += static_cast<cpr::cpr_off_t>(chunk.size())) {
+            write(chunk.data(), chunk.size());
+        }
+        finish();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double ofstream_seconds{0};
+    {
+        std::ofstream file{path, std::ios::binary};
+        ofstream_seconds = run([&file](char* data, size_t size) { cpr::util::writeFileFunction(data, size, 1, &file); }, [&file]() { file.flush(); });
+    }
+    cpr::fs::remove(path);
+
+    double sink_seconds{0};
+    {
+        cpr::FileSinkOptions options;
+        options.preallocate = true;
+        cpr::FileSink sink{path, options};
+        sink_seconds = run([&sink](char* data, size_t size) { cpr::util::writeFileSinkFunction(data, size, 1, &sink); }, [&sink]() { sink.Finish(); });
+    }
+    cpr::fs::remove(path);
+
+    const double gib = static_cast<double>(total) / (1024.0 * 1024.0 * 1024.0);
+    std::cout << "std::ofstream: " << ofstream_seconds << "s (" << gib / ofstream_seconds << " GiB/s)\n";
+    std::cout << "cpr::FileSink: " << sink_seconds << "s (" << gib / sink_seconds << " GiB/s)\n";
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::AddGlobalTestEnvironment(server);
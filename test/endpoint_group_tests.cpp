@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+static Response getResponse(long status_code, double elapsed) {
+    Response response;
+    response.status_code = status_code;
+    response.elapsed = elapsed;
+    return response;
+}
+
+static EndpointGroupOptions getOptions(LoadBalancingPolicy policy) {
+    EndpointGroupOptions options;
+    options.policy = policy;
+    options.max_consecutive_failures = 2;
+    options.ejection_duration = std::chrono::milliseconds{50};
+    return options;
+}
+
+TEST(EndpointGroupTests, RoundRobinTakesEndpointsInTurn) {
+    const EndpointGroup group{{"10.0.0.1:80", "10.0.0.2:80", "10.0.0.3:80"}, getOptions(LoadBalancingPolicy::ROUND_ROBIN)};
+    for (size_t i = 0; i < 6; ++i) {
+        const size_t index = group.Acquire();
+        EXPECT_EQ(i % 3, index);
+        group.Record(index, getResponse(200, 0.01));
+    }
+}
+
+TEST(EndpointGroupTests, LeastOutstandingAvoidsBusyEndpoints) {
+    const EndpointGroup group{{"10.0.0.1:80", "10.0.0.2:80", "10.0.0.3:80"}, getOptions(LoadBalancingPolicy::LEAST_OUTSTANDING)};
+    const size_t first = group.Acquire();
+    const size_t second = group.Acquire();
+    const size_t third = group.Acquire();
+    EXPECT_NE(first, second);
+    EXPECT_NE(first, third);
+    EXPECT_NE(second, third);
+    // Only the second one has nothing in flight afterwards
+    group.Record(second, getResponse(200, 0.01));
+    EXPECT_EQ(second, group.Acquire());
+}
+
+TEST(EndpointGroupTests, PeakEwmaPrefersFastEndpoints) {
+    const EndpointGroup group{{"10.0.0.1:80", "10.0.0.2:80"}, getOptions(LoadBalancingPolicy::PEAK_EWMA)};
+    group.Record(group.Acquire(), getResponse(200, 0.5));
+    const size_t fast = group.Acquire();
+    group.Record(fast, getResponse(200, 0.01));
+    for (size_t i = 0; i < 10; ++i) {
+        const size_t index = group.Acquire();
+        EXPECT_EQ(fast, index);
+        group.Record(index, getResponse(200, 0.01));
+    }
+    // A latency spike counts right away
+    group.Record(group.Acquire(), getResponse(200, 1.0));
+    EXPECT_NE(fast, group.Acquire());
+}
+
+TEST(EndpointGroupTests, FailingEndpointGetsEjectedAndProbed) {
+    const EndpointGroup group{{"10.0.0.1:80", "10.0.0.2:80"}, getOptions(LoadBalancingPolicy::ROUND_ROBIN)};
+    group.Record(0, getResponse(200, 0.01));
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(0, group.Acquire());
+        group.Record(0, getResponse(503, 0.01));
+        EXPECT_EQ(1, group.Acquire());
+        group.Record(1, getResponse(200, 0.01));
+    }
+    EXPECT_TRUE(group.GetStatus()[0].ejected);
+    for (size_t i = 0; i < 4; ++i) {
+        const size_t index = group.Acquire();
+        EXPECT_EQ(1, index);
+        group.Record(index, getResponse(200, 0.01));
+    }
+
+    // After the ejection exactly one probe goes through
+    std::this_thread::sleep_for(std::chrono::milliseconds{60});
+    const size_t probe = group.Acquire();
+    EXPECT_EQ(0, probe);
+    EXPECT_EQ(1, group.Acquire());
+    group.Record(1, getResponse(200, 0.01));
+    group.Record(probe, getResponse(200, 0.01));
+    EXPECT_FALSE(group.GetStatus()[0].ejected);
+}
+
+TEST(EndpointGroupTests, FailedProbeEjectsAgain) {
+    const EndpointGroup group{{"10.0.0.1:80", "10.0.0.2:80"}, getOptions(LoadBalancingPolicy::ROUND_ROBIN)};
+    for (size_t i = 0; i < 2; ++i) {
+        group.Record(group.Acquire(), getResponse(502, 0.01));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{60});
+    EXPECT_EQ(0, group.Acquire());
+    group.Record(0, getResponse(502, 0.01));
+    EXPECT_TRUE(group.GetStatus()[0].ejected);
+    EXPECT_EQ(1, group.Acquire());
+}
+
+TEST(EndpointGroupTests, AllEjectedStillSpreadsRequests) {
+    const EndpointGroup group{{"10.0.0.1:80", "10.0.0.2:80"}, getOptions(LoadBalancingPolicy::ROUND_ROBIN)};
+    for (size_t i = 0; i < 4; ++i) {
+        group.Record(group.Acquire(), getResponse(503, 0.01));
+    }
+    EXPECT_TRUE(group.GetStatus()[0].ejected);
+    EXPECT_TRUE(group.GetStatus()[1].ejected);
+    const size_t first = group.Acquire();
+    EXPECT_NE(first, group.Acquire());
+}
+
+TEST(EndpointGroupTests, EndpointsAreAddressesOrBaseUrls) {
+    const EndpointGroup group{{"10.0.0.1:8080", "10.0.0.2", "[::1]:443", "[::1]", "https://replica.example.com:8443/"}};
+    EXPECT_EQ(std::string{"::10.0.0.1:8080"}, *group.GetConnectTo(0));
+    EXPECT_EQ(std::string{"::10.0.0.2:"}, *group.GetConnectTo(1));
+    EXPECT_EQ(std::string{"::[::1]:443"}, *group.GetConnectTo(2));
+    EXPECT_EQ(std::string{"::[::1]:"}, *group.GetConnectTo(3));
+    EXPECT_FALSE(group.GetConnectTo(4).has_value());
+    EXPECT_EQ(std::string{"http://example.com/items?page=2"}, group.GetUrl(0, "http://example.com/items?page=2"));
+    EXPECT_EQ(std::string{"https://replica.example.com:8443/items?page=2"}, group.GetUrl(4, "http://example.com/items?page=2"));
+    EXPECT_EQ(std::string{"https://replica.example.com:8443"}, group.GetUrl(4, "http://example.com"));
+    EXPECT_THROW(EndpointGroup{std::vector<std::string>{}}, std::invalid_argument);
+}
+
+TEST(EndpointGroupTests, UnreachableEndpointGetsEjected) {
+    // Nothing listens on port 1, the request URL itself points nowhere as well
+    const Url url{"http://replicated.invalid:" + std::to_string(server->GetPort()) + "/hello.html"};
+    const EndpointGroup group{{"127.0.0.1:1", "127.0.0.1:" + std::to_string(server->GetPort())}, getOptions(LoadBalancingPolicy::ROUND_ROBIN)};
+    Session session;
+    session.SetUrl(url);
+    session.SetEndpointGroup(group);
+    size_t failures{0};
+    for (size_t i = 0; i < 10; ++i) {
+        const Response response = session.Get();
+        if (response.error) {
+            EXPECT_EQ(ErrorCode::COULDNT_CONNECT, response.error.code);
+            ++failures;
+        } else {
+            EXPECT_EQ(std::string{"Hello world!"}, response.text);
+        }
+    }
+    EXPECT_EQ(2, failures);
+    const std::vector<EndpointGroup::EndpointStatus> status = group.GetStatus();
+    EXPECT_TRUE(status[0].ejected);
+    EXPECT_EQ(0, status[0].outstanding);
+    EXPECT_EQ(8, status[1].requests);
+    EXPECT_GT(status[1].latency.count(), 0);
+}
+
+// Answers every request without proceeding, like a cache hit
+class AnsweringInterceptor : public Interceptor {
+  public:
+    Response intercept(Session& /*session*/) override {
+        Response response;
+        response.status_code = 200;
+        return response;
+    }
+};
+
+TEST(EndpointGroupTests, ProbeAnsweredByInterceptorGetsReleased) {
+    const EndpointGroup group{{"127.0.0.1:1", "127.0.0.1:" + std::to_string(server->GetPort())}, getOptions(LoadBalancingPolicy::ROUND_ROBIN)};
+    for (size_t i = 0; i < 2; ++i) {
+        group.Record(0, getResponse(503, 0.01));
+    }
+    EXPECT_TRUE(group.GetStatus()[0].ejected);
+    std::this_thread::sleep_for(std::chrono::milliseconds{60});
+
+    // Takes the probe of the half open endpoint, but never reaches it
+    Session session;
+    session.SetUrl(Url{"http://replicated.invalid/hello.html"});
+    session.SetEndpointGroup(group);
+    session.AddInterceptor(std::make_shared<AnsweringInterceptor>());
+    EXPECT_EQ(200, session.Get().status_code);
+    EXPECT_EQ(0, group.GetStatus()[0].outstanding);
+
+    // So the next request may probe it
+    EXPECT_EQ(0, group.Acquire());
+}
+
+TEST(EndpointGroupTests, BaseUrlReplacesTheRequestUrl) {
+    const Url url{"http://replicated.invalid/hello.html"};
+    const EndpointGroup group{{server->GetBaseUrl()}};
+    const Response response = cpr::Get(url, group);
+    EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    EXPECT_EQ(Url{server->GetBaseUrl() + "/hello.html"}, response.url);
+}
+
+TEST(EndpointGroupTests, MultiPerformSpreadsTransfers) {
+    const Url url{"http://replicated.invalid:" + std::to_string(server->GetPort()) + "/hello.html"};
+    const EndpointGroup group{{"127.0.0.1", "localhost"}, getOptions(LoadBalancingPolicy::LEAST_OUTSTANDING)};
+    MultiPerform multiperform;
+    for (size_t i = 0; i < 4; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(url);
+        session->SetEndpointGroup(group);
+        multiperform.AddSession(session);
+    }
+    for (const Response& response : multiperform.Get()) {
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    }
+    for (const EndpointGroup::EndpointStatus& status : group.GetStatus()) {
+        EXPECT_EQ(2, status.requests);
+        EXPECT_EQ(0, status.outstanding);
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "cpr/cpr.h"
+#include "cpr/coroutine/sleep.h"
+#include "cpr/coroutine/sync_wait.h"
+#include "cpr/coroutine/task.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Counts the tasks it hands over to a thread pool of its own
+class CountingExecutor : public Executor {
+  public:
+    void Execute(Task task) override {
+        ++count;
+        pool.Execute(std::move(task));
+    }
+
+    std::atomic_size_t count{0};
+    ThreadPool pool;
+};
+
+TEST(ExecutorTests, ThreadPoolSubmitReturnsFuture) {
+    ThreadPool pool;
+    Executor& executor = pool;
+    std::future<int> future = executor.Submit([](int a, int b) { return a + b; }, 2, 3);
+    EXPECT_EQ(5, future.get());
+}
+
+TEST(ExecutorTests, InlineExecutorRunsOnCallingThread) {
+    InlineExecutor executor;
+    std::thread::id id;
+    executor.Execute([&id]() { id = std::this_thread::get_id(); });
+    EXPECT_EQ(std::this_thread::get_id(), id);
+}
+
+TEST(ExecutorTests, FunctionExecutorHandsOverTasks) {
+    size_t handed_over = 0;
+    FunctionExecutor executor{[&handed_over](const Executor::Task& task) {
+        ++handed_over;
+        task();
+    }};
+    std::future<int> future = executor.Submit([]() { return 42; });
+    EXPECT_EQ(1, handed_over);
+    EXPECT_EQ(42, future.get());
+}
+
+TEST(ExecutorTests, DefaultExecutorIsGlobalThreadPool) {
+    EXPECT_EQ(GlobalThreadPool::GetInstance(), GetDefaultExecutor().get());
+
+    std::shared_ptr<CountingExecutor> executor = std::make_shared<CountingExecutor>();
+    SetDefaultExecutor(executor);
+    EXPECT_EQ(executor, GetDefaultExecutor());
+    const Response response = cpr::GetAsync(Url{server->GetBaseUrl() + "/hello.html"}).get();
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(1, executor->count);
+
+    SetDefaultExecutor(nullptr);
+    EXPECT_EQ(GlobalThreadPool::GetInstance(), GetDefaultExecutor().get());
+}
+
+TEST(ExecutorTests, SessionAsyncUsesSessionExecutor) {
+    std::shared_ptr<CountingExecutor> executor = std::make_shared<CountingExecutor>();
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session->SetExecutor(executor);
+    EXPECT_EQ(executor, session->GetExecutor());
+
+    EXPECT_EQ(200, session->GetAsync().get().status_code);
+    EXPECT_EQ(1, executor->count);
+    EXPECT_EQ(200, session->GetCallback([](const Response& response) { return response.status_code; }).get());
+    EXPECT_EQ(2, executor->count);
+
+    session->SetExecutor(nullptr);
+    EXPECT_EQ(GetDefaultExecutor(), session->GetExecutor());
+}
+
+TEST(ExecutorTests, SessionAsyncWithInlineExecutorIsReady) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session->SetExecutor(std::make_shared<InlineExecutor>());
+    AsyncResponse response = session->GetAsync();
+    EXPECT_EQ(std::future_status::ready, response.wait_for(std::chrono::seconds{0}));
+    EXPECT_EQ(200, response.get().status_code);
+}
+
+TEST(ExecutorTests, SessionCoroutineUsesSessionExecutor) {
+    std::shared_ptr<CountingExecutor> executor = std::make_shared<CountingExecutor>();
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session->SetExecutor(executor);
+    const Response response = coroutine::sync_wait(session->CoGetAsync());
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(1, executor->count);
+}
+
+// Runs its member coroutines on its executor, like a Session does
+class ExecutorOwner {
+  public:
+    explicit ExecutorOwner(std::shared_ptr<Executor> executor) : executor_(std::move(executor)) {}
+
+    [[nodiscard]] std::shared_ptr<Executor> GetExecutor() const {
+        return executor_;
+    }
+
+    coroutine::Task<std::thread::id> SleepAndGetThread() {
+        co_await coroutine::SleepFor(std::chrono::milliseconds{1});
+        co_return std::this_thread::get_id();
+    }
+
+  private:
+    std::shared_ptr<Executor> executor_;
+};
+
+TEST(ExecutorTests, SleepResumesOnExecutorOfAwaitingTask) {
+    std::shared_ptr<CountingExecutor> executor = std::make_shared<CountingExecutor>();
+    ExecutorOwner owner{executor};
+    const std::thread::id id = coroutine::sync_wait(owner.SleepAndGetThread());
+    EXPECT_NE(std::this_thread::get_id(), id);
+    // Once to start the coroutine and once to resume it after sleeping
+    EXPECT_EQ(2, executor->count);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
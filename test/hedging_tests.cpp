@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Requests with a new id get a slow answer again on the slow_first endpoint
+static std::string getHedgeId() {
+    static std::atomic_size_t next_id{0};
+    return std::to_string(next_id++);
+}
+
+static HedgeOptions getUnlimitedHedgeOptions() {
+    HedgeOptions options;
+    options.delay = std::chrono::milliseconds{50};
+    options.max_extra_load = 1.0;
+    return options;
+}
+
+TEST(HedgingTests, SlowRequestIsHedged) {
+    const Url url{server->GetBaseUrl() + "/slow_first.html"};
+    const HedgePolicy hedge_policy{getUnlimitedHedgeOptions()};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Response response = cpr::Get(url, hedge_policy, Header{{"X-Hedge-Id", getHedgeId()}});
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{900});
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(std::string{"fast"}, response.text);
+    EXPECT_EQ(url, response.url);
+    const HedgePolicy::Metrics metrics = hedge_policy.GetMetrics();
+    EXPECT_EQ(1, metrics.requests);
+    EXPECT_EQ(1, metrics.hedges);
+    EXPECT_EQ(1, metrics.hedge_wins);
+}
+
+TEST(HedgingTests, FastRequestIsNotHedged) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    HedgeOptions options = getUnlimitedHedgeOptions();
+    options.delay = std::chrono::milliseconds{500};
+    const HedgePolicy hedge_policy{options};
+    Session session;
+    session.SetUrl(url);
+    session.SetHedgePolicy(hedge_policy);
+    for (size_t i = 0; i < 3; ++i) {
+        Response response = session.Get();
+        EXPECT_EQ(200, response.status_code);
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    }
+    const HedgePolicy::Metrics metrics = hedge_policy.GetMetrics();
+    EXPECT_EQ(3, metrics.requests);
+    EXPECT_EQ(0, metrics.hedges);
+}
+
+TEST(HedgingTests, PostIsNotHedged) {
+    const Url url{server->GetBaseUrl() + "/slow_first.html"};
+    const HedgePolicy hedge_policy{getUnlimitedHedgeOptions()};
+    Response response = cpr::Post(url, hedge_policy, Header{{"X-Hedge-Id", getHedgeId()}});
+    EXPECT_EQ(std::string{"slow"}, response.text);
+    EXPECT_EQ(0, hedge_policy.GetMetrics().requests);
+}
+
+TEST(HedgingTests, HedgesAreLimitedByTheBudget) {
+    const Url url{server->GetBaseUrl() + "/slow_first.html"};
+    HedgeOptions options = getUnlimitedHedgeOptions();
+    // The first request may not be hedged, the second one may
+    options.max_extra_load = 0.5;
+    const HedgePolicy hedge_policy{options};
+    EXPECT_EQ(std::string{"slow"}, cpr::Get(url, hedge_policy, Header{{"X-Hedge-Id", getHedgeId()}}).text);
+    EXPECT_EQ(std::string{"fast"}, cpr::Get(url, hedge_policy, Header{{"X-Hedge-Id", getHedgeId()}}).text);
+    const HedgePolicy::Metrics metrics = hedge_policy.GetMetrics();
+    EXPECT_EQ(2, metrics.requests);
+    EXPECT_EQ(1, metrics.hedges);
+    EXPECT_EQ(1, metrics.budget_exhausted);
+}
+
+TEST(HedgingTests, DelayIsDerivedFromObservedLatencies) {
+    HedgeOptions options;
+    options.initial_delay = std::chrono::milliseconds{123};
+    options.min_samples = 20;
+    const HedgePolicy hedge_policy{options};
+    EXPECT_EQ(std::chrono::milliseconds{123}, hedge_policy.GetDelay());
+    for (int64_t latency = 1; latency <= 100; ++latency) {
+        hedge_policy.RecordLatency(std::chrono::milliseconds{latency}, false);
+    }
+    EXPECT_EQ(std::chrono::milliseconds{96}, hedge_policy.GetDelay());
+}
+
+TEST(HedgingTests, DelayFollowsTheMostRecentLatencies) {
+    HedgeOptions options;
+    options.percentile = 0.5;
+    options.min_samples = 1;
+    options.max_samples = 10;
+    const HedgePolicy hedge_policy{options};
+    for (int64_t latency = 100; latency >= 1; --latency) {
+        hedge_policy.RecordLatency(std::chrono::milliseconds{latency}, false);
+    }
+    // Only 1 to 10 are left
+    EXPECT_EQ(std::chrono::milliseconds{6}, hedge_policy.GetDelay());
+    for (size_t i = 0; i < 9; ++i) {
+        hedge_policy.RecordLatency(std::chrono::milliseconds{50}, false);
+    }
+    EXPECT_EQ(std::chrono::milliseconds{50}, hedge_policy.GetDelay());
+    hedge_policy.RecordLatency(std::chrono::milliseconds{7}, false);
+    EXPECT_EQ(std::chrono::milliseconds{50}, hedge_policy.GetDelay());
+}
+
+TEST(HedgingTests, SessionKeepsCookiesAndPoolAfterHedgeWon) {
+    const HedgePolicy hedge_policy{getUnlimitedHedgeOptions()};
+    const ConnectionPool pool;
+    Session session;
+    session.SetHedgePolicy(hedge_policy);
+    session.SetConnectionPool(pool);
+    session.SetUrl(Url{server->GetBaseUrl() + "/slow_first.html"});
+    const std::string first_id = getHedgeId();
+    session.SetHeader(Header{{"X-Hedge-Id", first_id}});
+    server->ResetConnectionCount();
+    EXPECT_EQ(std::string{"fast"}, session.Get().text);
+    // The second hedge gets duplicated from the handle of the first one
+    const std::string second_id = getHedgeId();
+    session.SetHeader(Header{{"X-Hedge-Id", second_id}});
+    EXPECT_EQ(std::string{"fast"}, session.Get().text);
+    EXPECT_EQ(2, hedge_policy.GetMetrics().hedge_wins);
+    // The second request reuses the connection of the first hedge, only the hedges need new ones
+    EXPECT_EQ(3, server->GetConnectionCount());
+
+    // Both cookies are kept by the handle of the session, which is the one of the second hedge now
+    session.SetHeader(Header{});
+    session.SetUrl(Url{server->GetBaseUrl() + "/cookies_reflect.html"});
+    const std::string cookies = session.Get().text;
+    EXPECT_NE(std::string::npos, cookies.find("hedge_" + first_id + "=fast")) << cookies;
+    EXPECT_NE(std::string::npos, cookies.find("hedge_" + second_id + "=fast")) << cookies;
+
+    // The connection of the winning hedge went to the pool, so another session of the pool reuses it
+    Response response = cpr::Get(Url{server->GetBaseUrl() + "/hello.html"}, pool);
+    EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    EXPECT_EQ(3, server->GetConnectionCount());
+}
+
+TEST(HedgingTests, TargetsAreUsedInTurn) {
+    HedgeOptions options;
+    options.targets = {Resolve{"example.com", "192.0.2.1", {80}}, Resolve{"example.com", "2001:db8::1", {443}}};
+    const HedgePolicy hedge_policy{options};
+    EXPECT_EQ(std::vector<std::string>{"example.com:80:192.0.2.1:80"}, hedge_policy.GetNextConnectTo());
+    EXPECT_EQ(std::vector<std::string>{"example.com:443:[2001:db8::1]:443"}, hedge_policy.GetNextConnectTo());
+    EXPECT_EQ(std::vector<std::string>{"example.com:80:192.0.2.1:80"}, hedge_policy.GetNextConnectTo());
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
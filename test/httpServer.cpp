@@ -3,6 +3,7 @@
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <map>
 #include <sstream>
 #include <string>
 #include <system_error>
@@ -882,6 +883,88 @@ void HttpServer::OnRequestGetDownloadFileLength(mg_connection* conn, mg_http_mes
     }
 }
 
+void HttpServer::OnRequestCacheMaxAge(mg_connection* conn, mg_http_message* /*msg*/) {
+    std::string response{"Cached for a minute"};
+    std::string headers = "Content-Type: text/plain\r\nCache-Control: max-age=60\r\n";
+    mg_http_reply(conn, 200, headers.c_str(), response.c_str());
+}
+
+void HttpServer::OnRequestCacheRevalidate(mg_connection* conn, mg_http_message* msg) {
+    // Always stale, but may be revalidated using the ETag
+    mg_str* if_none_match = mg_http_get_header(msg, "If-None-Match");
+    if (if_none_match != nullptr && std::string_view{if_none_match->ptr, if_none_match->len} == "\"v1\"") {
+        std::string headers = "ETag: \"v1\"\r\nX-Revalidated: true\r\n";
+        mg_http_reply(conn, 304, headers.c_str(), "");
+        return;
+    }
+    std::string response{"Revalidate me"};
+    std::string headers = "Content-Type: text/plain\r\nCache-Control: no-cache\r\nETag: \"v1\"\r\n";
+    mg_http_reply(conn, 200, headers.c_str(), response.c_str());
+}
+
+void HttpServer::OnRequestCacheVary(mg_connection* conn, mg_http_message* msg) {
+    mg_str* language = mg_http_get_header(msg, "Accept-Language");
+    std::string response = language == nullptr ? "none" : std::string{language->ptr, language->len};
+    std::string headers = "Content-Type: text/plain\r\nCache-Control: max-age=60\r\nVary: Accept-Language\r\n";
+    mg_http_reply(conn, 200, headers.c_str(), response.c_str());
+}
+
+void HttpServer::OnRequestEvents(mg_connection* conn, mg_http_message* /*msg*/) {
+    std::string response{"data: first\n\nevent: update\ndata: second\nid: 2\n\n"};
+    std::string headers = "Content-Type: text/event-stream\r\n";
+    mg_http_reply(conn, 200, headers.c_str(), response.c_str());
+}
+
+void HttpServer::OnRequestChunked(mg_connection* conn, mg_http_message* /*msg*/) {
+    // All chunks get sent at once, so the client receives them within a single read
+    mg_printf(conn, "%s",
+              "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n"
+              "5\r\nthis \r\n3\r\nis \r\n2\r\na \r\n5\r\nfile \r\n8\r\ncontent.\r\n0\r\n\r\n");
+}
+
+void HttpServer::OnRequestRetry(mg_connection* conn, mg_http_message* msg) {
+    // Fails the first X-Fail-Count requests carrying the same X-Retry-Id with 503 and asks to retry right away
+    static std::map<std::string, int> request_counts;
+    mg_str* retry_id = mg_http_get_header(msg, "X-Retry-Id");
+    mg_str* fail_count = mg_http_get_header(msg, "X-Fail-Count");
+    const int request_count = ++request_counts[retry_id == nullptr ? "" : std::string{retry_id->ptr, retry_id->len}];
+    if (fail_count != nullptr && request_count <= std::stoi(std::string{fail_count->ptr, fail_count->len})) {
+        std::string headers = "Content-Type: text/plain\r\nRetry-After: 0\r\n";
+        mg_http_reply(conn, 503, headers.c_str(), "Service Unavailable");
+        return;
+    }
+    std::string response = std::to_string(request_count);
+    std::string headers = "Content-Type: text/plain\r\n";
+    mg_http_reply(conn, 200, headers.c_str(), response.c_str());
+}
+
+// Answers the first request carrying the same X-Hedge-Id after a second with "slow" and all others right away with "fast"
+// The fast answer sets the cookie hedge_<X-Hedge-Id>=fast
+void HttpServer::OnRequestSlowFirst(mg_connection* conn, mg_http_message* msg, TimerArg* timer_arg) {
+    static std::map<std::string, int> request_counts;
+    mg_str* hedge_id = mg_http_get_header(msg, "X-Hedge-Id");
+    const std::string id = hedge_id == nullptr ? "" : std::string{hedge_id->ptr, hedge_id->len};
+    const int request_count = ++request_counts[id];
+    if (request_count > 1) {
+        std::string headers = "Content-Type: text/plain\r\nSet-Cookie: hedge_" + id + "=fast\r\n";
+        mg_http_reply(conn, 200, headers.c_str(), "fast");
+        return;
+    }
+    mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 4\r\n\r\n");
+    timer_arg->connection_id = conn->id;
+    mg_timer_init(
+            &timer_arg->mgr->timers, &timer_arg->timer, 1000, MG_TIMER_REPEAT,
+            // Sends the body once, unless the client gave up on the connection in the meantime
+            [](void* arg) {
+                TimerArg* timer_arg = static_cast<TimerArg*>(arg);
+                if (timer_arg->counter == 0 && IsConnectionActive(timer_arg->mgr, timer_arg->connection) && timer_arg->connection->id == timer_arg->connection_id) {
+                    mg_send(timer_arg->connection, "slow", 4);
+                }
+                timer_arg->counter = 1;
+            },
+            timer_arg);
+}
+
 void HttpServer::OnRequest(mg_connection* conn, mg_http_message* msg) {
     std::string uri = std::string(msg->uri.ptr, msg->uri.len);
 
@@ -961,6 +1044,21 @@ void HttpServer::OnRequest(mg_connection* conn, mg_http_message* msg) {
         OnRequestCheckExpect100Continue(conn, msg);
     } else if (uri == "/get_download_file_length.html") {
         OnRequestGetDownloadFileLength(conn, msg);
+    } else if (uri == "/cache_max_age.html") {
+        OnRequestCacheMaxAge(conn, msg);
+    } else if (uri == "/cache_revalidate.html") {
+        OnRequestCacheRevalidate(conn, msg);
+    } else if (uri == "/cache_vary.html") {
+        OnRequestCacheVary(conn, msg);
+    } else if (uri == "/events.html") {
+        OnRequestEvents(conn, msg);
+    } else if (uri == "/chunked.html") {
+        OnRequestChunked(conn, msg);
+    } else if (uri == "/retry.html") {
+        OnRequestRetry(conn, msg);
+    } else if (uri == "/slow_first.html") {
+        timer_args.emplace_back(std::make_unique<TimerArg>(&mgr, conn, mg_timer{}));
+        OnRequestSlowFirst(conn, msg, timer_args.back().get());
     } else {
         OnRequestNotFound(conn, msg);
     }
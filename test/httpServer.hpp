@@ -66,6 +66,13 @@ class HttpServer : public AbstractServer {
     static void OnRequestCheckAcceptEncoding(mg_connection* conn, mg_http_message* msg);
     static void OnRequestCheckExpect100Continue(mg_connection* conn, mg_http_message* msg);
     static void OnRequestGetDownloadFileLength(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestCacheMaxAge(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestCacheRevalidate(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestCacheVary(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestEvents(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestChunked(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestRetry(mg_connection* conn, mg_http_message* msg);
+    static void OnRequestSlowFirst(mg_connection* conn, mg_http_message* msg, TimerArg* timer_arg);
 
   protected:
     mg_connection* initServer(mg_mgr* mgr, mg_event_handler_t event_handler) override;
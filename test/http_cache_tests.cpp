@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Counts the requests reaching the network, i.e. passing the cache
+class CountingInterceptor : public Interceptor {
+  public:
+    Response intercept(Session& session) override {
+        ++count;
+        return proceed(session);
+    }
+
+    std::atomic_size_t count{0};
+};
+
+class CountingInterceptorMulti : public InterceptorMulti {
+  public:
+    std::vector<Response> intercept(MultiPerform& multi) override {
+        count += multi.GetSessions().size();
+        return proceed(multi);
+    }
+
+    std::atomic_size_t count{0};
+};
+
+TEST(HttpCacheTests, FreshResponseIsServedFromCache) {
+    Url url{server->GetBaseUrl() + "/cache_max_age.html"};
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(url);
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    for (size_t i = 0; i < 3; ++i) {
+        Response response = session.Get();
+        EXPECT_EQ(std::string{"Cached for a minute"}, response.text);
+        EXPECT_EQ(200, response.status_code);
+        EXPECT_EQ(ErrorCode::OK, response.error.code);
+    }
+    EXPECT_EQ(1, counter->count);
+    EXPECT_EQ(1, cache->GetEntryCount());
+    EXPECT_GT(cache->GetSize(), 0);
+}
+
+TEST(HttpCacheTests, EntriesDoNotKeepTheSessionHandle) {
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::weak_ptr<CurlHolder> curl_holder;
+    {
+        Session session;
+        session.SetUrl(Url{server->GetBaseUrl() + "/cache_max_age.html"});
+        session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+        curl_holder = session.GetCurlHolder();
+        session.Get();
+    }
+    EXPECT_EQ(1, cache->GetEntryCount());
+    EXPECT_TRUE(curl_holder.expired());
+}
+
+TEST(HttpCacheTests, DownloadsBypassCache) {
+    Url url{server->GetBaseUrl() + "/cache_max_age.html"};
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(url);
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    // Cached by a regular request first, still every download has to reach its callback
+    EXPECT_EQ(std::string{"Cached for a minute"}, session.Get().text);
+    for (size_t i = 0; i < 2; ++i) {
+        std::string written;
+        Response response = session.Download(WriteCallback{[&written](std::string_view data, intptr_t /*userdata*/) {
+            written += data;
+            return true;
+        }});
+        EXPECT_EQ(ErrorCode::OK, response.error.code);
+        EXPECT_EQ(std::string{"Cached for a minute"}, written);
+        EXPECT_TRUE(response.text.empty());
+    }
+    EXPECT_EQ(3, counter->count);
+    EXPECT_EQ(1, cache->GetEntryCount());
+}
+
+TEST(HttpCacheTests, NoStoreRequestBypassesCache) {
+    Url url{server->GetBaseUrl() + "/cache_max_age.html"};
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(url);
+    session.SetHeader(Header{{"Cache-Control", "no-store"}});
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    session.Get();
+    session.Get();
+    EXPECT_EQ(2, counter->count);
+    EXPECT_EQ(0, cache->GetEntryCount());
+}
+
+TEST(HttpCacheTests, StaleResponseIsRevalidated) {
+    Url url{server->GetBaseUrl() + "/cache_revalidate.html"};
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(url);
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    Response response = session.Get();
+    EXPECT_EQ(std::string{"Revalidate me"}, response.text);
+    EXPECT_EQ(200, response.status_code);
+
+    // Answered with a 304, turned into the cached 200 with the updated header
+    response = session.Get();
+    EXPECT_EQ(std::string{"Revalidate me"}, response.text);
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(std::string{"true"}, response.header["X-Revalidated"]);
+    EXPECT_EQ(2, counter->count);
+    // The conditional header does not stick to the session
+    EXPECT_EQ(session.GetHeader().end(), session.GetHeader().find("If-None-Match"));
+}
+
+TEST(HttpCacheTests, VaryCreatesVariants) {
+    Url url{server->GetBaseUrl() + "/cache_vary.html"};
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::shared_ptr<CountingInterceptor> counter = std::make_shared<CountingInterceptor>();
+    Session session;
+    session.SetUrl(url);
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+    session.AddInterceptor(counter);
+
+    session.SetHeader(Header{{"Accept-Language", "de"}});
+    EXPECT_EQ(std::string{"de"}, session.Get().text);
+    session.SetHeader(Header{{"Accept-Language", "en"}});
+    EXPECT_EQ(std::string{"en"}, session.Get().text);
+    session.SetHeader(Header{{"Accept-Language", "de"}});
+    EXPECT_EQ(std::string{"de"}, session.Get().text);
+    EXPECT_EQ(2, counter->count);
+    EXPECT_EQ(2, cache->GetEntryCount());
+}
+
+TEST(HttpCacheTests, UnsafeRequestInvalidates) {
+    Url url{server->GetBaseUrl() + "/cache_max_age.html"};
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    Session session;
+    session.SetUrl(url);
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+
+    session.Get();
+    EXPECT_EQ(1, cache->GetEntryCount());
+    session.Post();
+    EXPECT_EQ(0, cache->GetEntryCount());
+}
+
+TEST(HttpCacheTests, ByteBudgetEvictsLeastRecentlyUsed) {
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>(2048, 1);
+    Session session;
+    session.AddInterceptor(std::make_shared<CacheInterceptor>(cache));
+
+    session.SetUrl(Url{server->GetBaseUrl() + "/cache_vary.html"});
+    for (const char* language : {"a", "b", "c", "d", "e", "f", "g", "h"}) {
+        session.SetHeader(Header{{"Accept-Language", language}});
+        session.Get();
+        EXPECT_LE(cache->GetSize(), cache->GetMaxSize());
+    }
+    EXPECT_GT(cache->GetEntryCount(), 0);
+    EXPECT_LT(cache->GetEntryCount(), 8);
+}
+
+TEST(HttpCacheTests, MultiPerformServesHitsFromCache) {
+    std::shared_ptr<HttpCache> cache = std::make_shared<HttpCache>();
+    std::shared_ptr<CountingInterceptorMulti> counter = std::make_shared<CountingInterceptorMulti>();
+    std::shared_ptr<Session> cached_session = std::make_shared<Session>();
+    cached_session->SetUrl(Url{server->GetBaseUrl() + "/cache_max_age.html"});
+    std::shared_ptr<Session> uncached_session = std::make_shared<Session>();
+    uncached_session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+
+    MultiPerform multi;
+    multi.AddSession(cached_session);
+    multi.AddSession(uncached_session);
+    multi.AddInterceptor(std::make_shared<CacheInterceptorMulti>(cache));
+    multi.AddInterceptor(counter);
+
+    for (size_t i = 0; i < 2; ++i) {
+        std::vector<Response> responses = multi.Get();
+        ASSERT_EQ(2, responses.size());
+        EXPECT_EQ(std::string{"Cached for a minute"}, responses.at(0).text);
+        EXPECT_EQ(std::string{"Hello world!"}, responses.at(1).text);
+    }
+    // Second round only the uncached session went over the network
+    EXPECT_EQ(3, counter->count);
+    EXPECT_EQ(2, multi.GetSessions().size());
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "cpr/callback.h"
+#include "cpr/inline_function.h"
+#include "cpr/util.h"
+
+using namespace cpr;
+
+namespace {
+// Counts the living instances to check InlineFunction destroys what it stores
+template <size_t Size>
+struct CountingFunctor {
+    explicit CountingFunctor(int* p_alive) : alive(p_alive) {
+        ++*alive;
+    }
+    CountingFunctor(const CountingFunctor& other) : alive(other.alive), padding(other.padding) {
+        ++*alive;
+    }
+    CountingFunctor(CountingFunctor&& other) noexcept : alive(other.alive), padding(other.padding) {
+        ++*alive;
+    }
+    CountingFunctor& operator=(const CountingFunctor&) = delete;
+    CountingFunctor& operator=(CountingFunctor&&) = delete;
+    ~CountingFunctor() {
+        --*alive;
+    }
+
+    int operator()(int value) const {
+        return value + static_cast<int>(padding.size());
+    }
+
+    int* alive;
+    std::array<char, Size> padding{};
+};
+
+bool freeFunction(std::string_view data, intptr_t userdata) {
+    return static_cast<intptr_t>(data.size()) == userdata;
+}
+} // namespace
+
+TEST(InlineFunctionTests, EmptyFunctions) {
+    const InlineFunction<int(int)> empty;
+    EXPECT_FALSE(empty);
+    EXPECT_THROW(empty(1), std::bad_function_call);
+
+    EXPECT_FALSE(InlineFunction<int(int)>{nullptr});
+    int (*null_pointer)(int) = nullptr;
+    EXPECT_FALSE(InlineFunction<int(int)>{null_pointer});
+    EXPECT_FALSE(InlineFunction<int(int)>{std::function<int(int)>{}});
+}
+
+TEST(InlineFunctionTests, CallsLambdaWithCaptures) {
+    const std::string prefix = "Hello ";
+    const std::shared_ptr<int> calls = std::make_shared<int>(0);
+    const InlineFunction<std::string(const std::string&)> function{[prefix, calls](const std::string& name) {
+        ++*calls;
+        return prefix + name;
+    }};
+    ASSERT_TRUE(function);
+    EXPECT_EQ("Hello world", function("world"));
+    EXPECT_EQ(1, *calls);
+}
+
+TEST(InlineFunctionTests, PassesReferences) {
+    const InlineFunction<void(size_t&)> function{[](size_t& size) { size = 42; }};
+    size_t size = 0;
+    function(size);
+    EXPECT_EQ(42, size);
+}
+
+TEST(InlineFunctionTests, CopiesAreIndependent) {
+    InlineFunction<int()> counter{[count = 0]() mutable { return ++count; }};
+    EXPECT_EQ(1, counter());
+    InlineFunction<int()> copy{counter};
+    EXPECT_EQ(2, counter());
+    EXPECT_EQ(2, copy());
+    counter = copy;
+    EXPECT_EQ(3, counter());
+    EXPECT_EQ(3, copy());
+}
+
+TEST(InlineFunctionTests, MoveEmptiesSource) {
+    InlineFunction<int(int)> source{[](int value) { return value * 2; }};
+    InlineFunction<int(int)> moved{std::move(source)};
+    // NOLINTNEXTLINE(bugprone-use-after-move, hicpp-invalid-access-moved, clang-analyzer-cplusplus.Move)
+    EXPECT_FALSE(source);
+    EXPECT_EQ(4, moved(2));
+
+    InlineFunction<int(int)> assigned;
+    assigned = std::move(moved);
+    // NOLINTNEXTLINE(bugprone-use-after-move, hicpp-invalid-access-moved, clang-analyzer-cplusplus.Move)
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(6, assigned(3));
+
+    assigned = nullptr;
+    EXPECT_FALSE(assigned);
+}
+
+TEST(InlineFunctionTests, DestroysInlineCallables) {
+    int alive = 0;
+    {
+        InlineFunction<int(int)> function{CountingFunctor<8>{&alive}};
+        EXPECT_EQ(1, alive);
+        InlineFunction<int(int)> copy{function};
+        EXPECT_EQ(2, alive);
+        InlineFunction<int(int)> moved{std::move(function)};
+        EXPECT_EQ(2, alive);
+        EXPECT_EQ(9, moved(1));
+        copy = nullptr;
+        EXPECT_EQ(1, alive);
+    }
+    EXPECT_EQ(0, alive);
+}
+
+TEST(InlineFunctionTests, DestroysHeapCallables) {
+    int alive = 0;
+    {
+        // Too large to fit into the inline storage
+        InlineFunction<int(int)> function{CountingFunctor<InlineFunction<int(int)>::kInlineSize>{&alive}};
+        EXPECT_EQ(1, alive);
+        InlineFunction<int(int)> copy{function};
+        EXPECT_EQ(2, alive);
+        InlineFunction<int(int)> moved{std::move(function)};
+        EXPECT_EQ(2, alive);
+        EXPECT_EQ(static_cast<int>(InlineFunction<int(int)>::kInlineSize) + 1, moved(1));
+        copy = moved;
+        EXPECT_EQ(2, alive);
+    }
+    EXPECT_EQ(0, alive);
+}
+
+TEST(InlineFunctionTests, WriteCallbackFromFunctionPointerAndStdFunction) {
+    const WriteCallback from_pointer{freeFunction, 5};
+    EXPECT_TRUE(from_pointer("Hello"));
+    EXPECT_FALSE(from_pointer("Hi"));
+
+    const WriteCallback from_std_function{std::function<bool(std::string_view, intptr_t)>{freeFunction}, 2};
+    EXPECT_TRUE(from_std_function("Hi"));
+
+    const WriteCallback from_empty_std_function{std::function<bool(std::string_view, intptr_t)>{}};
+    EXPECT_FALSE(from_empty_std_function.callback);
+    EXPECT_TRUE(from_empty_std_function("Ignored"));
+}
+
+TEST(InlineFunctionTests, DebugCallbackGetsDataWithoutCopy) {
+    std::string data = "GET / HTTP/1.1";
+    const char* received = nullptr;
+    size_t received_size = 0;
+    const DebugCallback debug{[&received, &received_size](DebugCallback::InfoType type, std::string_view view, intptr_t /*userdata*/) {
+        EXPECT_EQ(DebugCallback::InfoType::HEADER_OUT, type);
+        received = view.data();
+        received_size = view.size();
+    }};
+    EXPECT_EQ(0, util::debugUserFunction(nullptr, CURLINFO_HEADER_OUT, data.data(), data.size(), &debug));
+    EXPECT_EQ(data.data(), received);
+    EXPECT_EQ(data.size(), received_size);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
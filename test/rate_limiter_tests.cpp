@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "cpr/coroutine/sync_wait.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// 20 requests per second, so each token takes 50ms to refill
+static const RateLimit kLimit{20, 2};
+static const std::chrono::milliseconds kTokenInterval{50};
+
+// Answers every request itself, like a cache hit
+class AnsweringInterceptor : public Interceptor {
+  public:
+    Response intercept(Session& /*session*/) override {
+        Response response;
+        response.status_code = 200;
+        response.text = "From the interceptor";
+        return response;
+    }
+};
+
+static std::chrono::milliseconds getElapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+TEST(RateLimiterTests, BurstIsAvailableRightAway) {
+    const RateLimiter rate_limiter{kLimit};
+    EXPECT_EQ(RateLimiter::Clock::duration::zero(), rate_limiter.Reserve("example.com"));
+    EXPECT_EQ(RateLimiter::Clock::duration::zero(), rate_limiter.Reserve("example.com"));
+    const RateLimiter::Clock::duration delay = rate_limiter.Reserve("example.com");
+    EXPECT_GT(delay, std::chrono::milliseconds{40});
+    EXPECT_LE(delay, kTokenInterval);
+    // Reservations queue up behind each other
+    EXPECT_GT(rate_limiter.Reserve("example.com"), std::chrono::milliseconds{90});
+
+    const RateLimiter::Metrics metrics = rate_limiter.GetMetrics();
+    EXPECT_EQ(4, metrics.requests);
+    EXPECT_EQ(2, metrics.delayed);
+}
+
+TEST(RateLimiterTests, TryAcquireDoesNotTakeTokensInAdvance) {
+    const RateLimiter rate_limiter{kLimit};
+    EXPECT_TRUE(rate_limiter.TryAcquire("example.com"));
+    EXPECT_TRUE(rate_limiter.TryAcquire("example.com"));
+    EXPECT_FALSE(rate_limiter.TryAcquire("example.com"));
+    std::this_thread::sleep_for(kTokenInterval + std::chrono::milliseconds{10});
+    EXPECT_TRUE(rate_limiter.TryAcquire("example.com"));
+    EXPECT_FALSE(rate_limiter.TryAcquire("example.com"));
+}
+
+TEST(RateLimiterTests, KeysHaveBucketsOfTheirOwn) {
+    const RateLimiter rate_limiter{kLimit};
+    rate_limiter.SetLimit("slow.example.com", RateLimit{1, 1});
+    EXPECT_TRUE(rate_limiter.TryAcquire("slow.example.com"));
+    EXPECT_FALSE(rate_limiter.TryAcquire("slow.example.com"));
+    EXPECT_TRUE(rate_limiter.TryAcquire("example.com"));
+    EXPECT_TRUE(rate_limiter.TryAcquire("example.org"));
+}
+
+TEST(RateLimiterTests, ZeroRateIsUnlimited) {
+    const RateLimiter rate_limiter;
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(RateLimiter::Clock::duration::zero(), rate_limiter.Reserve("example.com"));
+    }
+    EXPECT_EQ(0, rate_limiter.GetMetrics().delayed);
+}
+
+TEST(RateLimiterTests, IdleBucketsAreEvicted) {
+    const RateLimiter rate_limiter{RateLimit{1000, 1}};
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(rate_limiter.TryAcquire("host" + std::to_string(i)));
+    }
+    // All of them refilled in the meantime
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    for (size_t i = 100; i < 200; ++i) {
+        EXPECT_TRUE(rate_limiter.TryAcquire("host" + std::to_string(i)));
+    }
+    EXPECT_LT(rate_limiter.GetMetrics().buckets, 150);
+    EXPECT_EQ(200, rate_limiter.GetMetrics().requests);
+}
+
+TEST(RateLimiterTests, KeyFunctionSelectsTheBucket) {
+    const RateLimiter by_host{kLimit};
+    EXPECT_EQ("example.com:8080", by_host.GetKey("GET", "http://example.com:8080/items?page=2"));
+    const RateLimiter by_route{kLimit, [](std::string_view method, std::string_view url) { return std::string{method} + ' ' + std::string{url.substr(0, url.find('?'))}; }};
+    EXPECT_EQ("POST http://example.com/items", by_route.GetKey("POST", "http://example.com/items?page=2"));
+}
+
+TEST(RateLimiterTests, SessionsShareTheLimiter) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    const RateLimiter rate_limiter{kLimit};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 4; ++i) {
+        Response response = cpr::Get(url, rate_limiter);
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    }
+    // Two requests of the burst, two waiting for a token each
+    EXPECT_GE(getElapsed(start), 2 * kTokenInterval - std::chrono::milliseconds{5});
+    EXPECT_EQ(2, rate_limiter.GetMetrics().delayed);
+}
+
+TEST(RateLimiterTests, InterceptedRequestsTakeNoToken) {
+    const RateLimiter rate_limiter{kLimit};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session->SetRateLimiter(rate_limiter);
+    session->AddInterceptor(std::make_shared<AnsweringInterceptor>());
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(std::string{"From the interceptor"}, session->Get().text);
+        EXPECT_EQ(std::string{"From the interceptor"}, session->GetAsync().get().text);
+        EXPECT_EQ(std::string{"From the interceptor"}, cpr::coroutine::sync_wait(session->CoGetAsync()).text);
+    }
+    EXPECT_LT(getElapsed(start), kTokenInterval);
+    EXPECT_EQ(0, rate_limiter.GetMetrics().requests);
+}
+
+TEST(RateLimiterTests, AsyncRequestsAreQueued) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    const RateLimiter rate_limiter{kLimit};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<AsyncResponse> responses;
+    for (size_t i = 0; i < 6; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(url);
+        session->SetRateLimiter(rate_limiter);
+        responses.emplace_back(session->GetAsync());
+    }
+    for (AsyncResponse& future : responses) {
+        Response response = future.get();
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    }
+    EXPECT_GE(getElapsed(start), 4 * kTokenInterval - std::chrono::milliseconds{5});
+    EXPECT_EQ(4, rate_limiter.GetMetrics().delayed);
+}
+
+TEST(RateLimiterTests, CoroutineRequestsAreQueued) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    const RateLimiter rate_limiter{kLimit};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(url);
+    session->SetRateLimiter(rate_limiter);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 3; ++i) {
+        Response response = cpr::coroutine::sync_wait(session->CoGetAsync());
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    }
+    EXPECT_GE(getElapsed(start), kTokenInterval - std::chrono::milliseconds{5});
+    EXPECT_EQ(1, rate_limiter.GetMetrics().delayed);
+}
+
+TEST(RateLimiterTests, MultiPerformDefersTransfers) {
+    const Url url{server->GetBaseUrl() + "/hello.html"};
+    const RateLimiter rate_limiter{kLimit};
+    MultiPerform multiperform;
+    multiperform.SetRateLimiter(rate_limiter);
+    for (size_t i = 0; i < 5; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(url);
+        multiperform.AddSession(session);
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<Response> responses = multiperform.Get();
+    EXPECT_GE(getElapsed(start), 3 * kTokenInterval - std::chrono::milliseconds{5});
+    ASSERT_EQ(5, responses.size());
+    for (const Response& response : responses) {
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    }
+    EXPECT_EQ(3, rate_limiter.GetMetrics().delayed);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
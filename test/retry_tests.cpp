@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "cpr/coroutine/sync_wait.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+// Requests with a new id start failing again on the retry endpoint
+static std::string getRetryId() {
+    static std::atomic_size_t next_id{0};
+    return std::to_string(next_id++);
+}
+
+static RetryPolicy getFastRetryPolicy() {
+    RetryPolicy retry_policy;
+    retry_policy.base_delay = std::chrono::milliseconds{1};
+    retry_policy.max_delay = std::chrono::milliseconds{10};
+    return retry_policy;
+}
+
+static Response getResponse(long status_code, const Header& header = {}) {
+    Response response;
+    response.status_code = status_code;
+    response.header = header;
+    return response;
+}
+
+TEST(RetryPolicyTests, BackoffStaysWithinCap) {
+    RetryPolicy retry_policy;
+    retry_policy.max_attempts = 100;
+    retry_policy.base_delay = std::chrono::milliseconds{100};
+    retry_policy.max_delay = std::chrono::milliseconds{1000};
+    for (uint32_t attempts = 1; attempts < 40; ++attempts) {
+        const std::optional<std::chrono::milliseconds> delay = retry_policy.GetRetryDelay("GET", {}, getResponse(502), attempts, std::chrono::milliseconds{0});
+        ASSERT_TRUE(delay.has_value());
+        EXPECT_GE(delay->count(), 0);
+        EXPECT_LE(delay->count(), std::min<int64_t>(1000, int64_t{100} << std::min<uint32_t>(attempts - 1, 30)));
+    }
+}
+
+TEST(RetryPolicyTests, AttemptsAndTotalTimeAreLimited) {
+    RetryPolicy retry_policy;
+    retry_policy.max_attempts = 2;
+    EXPECT_TRUE(retry_policy.GetRetryDelay("GET", {}, getResponse(503), 1, std::chrono::milliseconds{0}).has_value());
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(503), 2, std::chrono::milliseconds{0}).has_value());
+
+    retry_policy.max_attempts = 10;
+    retry_policy.max_total_time = std::chrono::milliseconds{1000};
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(503, Header{{"Retry-After", "2"}}), 1, std::chrono::milliseconds{0}).has_value());
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(503, Header{{"Retry-After", "0"}}), 1, std::chrono::milliseconds{1001}).has_value());
+}
+
+TEST(RetryPolicyTests, ResponsesAreClassified) {
+    const RetryPolicy retry_policy;
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(200), 1, std::chrono::milliseconds{0}).has_value());
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(404), 1, std::chrono::milliseconds{0}).has_value());
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(500), 1, std::chrono::milliseconds{0}).has_value());
+    EXPECT_TRUE(retry_policy.GetRetryDelay("GET", {}, getResponse(429), 1, std::chrono::milliseconds{0}).has_value());
+
+    Response response;
+    response.error = Error{CURLE_OPERATION_TIMEDOUT, "timeout"};
+    EXPECT_TRUE(retry_policy.GetRetryDelay("GET", {}, response, 1, std::chrono::milliseconds{0}).has_value());
+    response.error = Error{CURLE_URL_MALFORMAT, "malformed"};
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, response, 1, std::chrono::milliseconds{0}).has_value());
+}
+
+TEST(RetryPolicyTests, NonIdempotentRequestsAreOnlyRetriedBeforeReachingTheServer) {
+    RetryPolicy retry_policy;
+    EXPECT_FALSE(retry_policy.GetRetryDelay("POST", {}, getResponse(503), 1, std::chrono::milliseconds{0}).has_value());
+    EXPECT_TRUE(retry_policy.GetRetryDelay("POST", Header{{"Idempotency-Key", "42"}}, getResponse(503), 1, std::chrono::milliseconds{0}).has_value());
+
+    Response response;
+    response.error = Error{CURLE_RECV_ERROR, "recv"};
+    EXPECT_FALSE(retry_policy.GetRetryDelay("PATCH", {}, response, 1, std::chrono::milliseconds{0}).has_value());
+    response.error = Error{CURLE_COULDNT_CONNECT, "connect"};
+    EXPECT_TRUE(retry_policy.GetRetryDelay("PATCH", {}, response, 1, std::chrono::milliseconds{0}).has_value());
+
+    retry_policy.retry_non_idempotent = true;
+    EXPECT_TRUE(retry_policy.GetRetryDelay("POST", {}, getResponse(503), 1, std::chrono::milliseconds{0}).has_value());
+}
+
+TEST(RetryPolicyTests, RetryAfterIsHonoured) {
+    RetryPolicy retry_policy;
+    EXPECT_EQ(std::chrono::milliseconds{3000}, retry_policy.GetRetryDelay("GET", {}, getResponse(429, Header{{"Retry-After", "3"}}), 1, std::chrono::milliseconds{0}));
+    EXPECT_FALSE(retry_policy.GetRetryDelay("GET", {}, getResponse(503, Header{{"Retry-After", "3600"}}), 1, std::chrono::milliseconds{0}).has_value());
+
+    EXPECT_EQ(std::chrono::milliseconds{0}, RetryPolicy::ParseRetryAfter(Header{{"Retry-After", "Wed, 21 Oct 2015 07:28:00 GMT"}}));
+    EXPECT_FALSE(RetryPolicy::ParseRetryAfter(Header{{"Retry-After", "soon"}}).has_value());
+    EXPECT_FALSE(RetryPolicy::ParseRetryAfter(Header{}).has_value());
+}
+
+TEST(RetryTests, GetIsRetriedUntilSuccess) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    Response response = cpr::Get(url, getFastRetryPolicy(), Header{{"X-Retry-Id", getRetryId()}, {"X-Fail-Count", "2"}});
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(std::string{"3"}, response.text);
+    EXPECT_EQ(2, response.retry_count);
+}
+
+TEST(RetryTests, LastResponseIsReturnedOnceAttemptsAreUsedUp) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    Response response = cpr::Get(url, getFastRetryPolicy(), Header{{"X-Retry-Id", getRetryId()}, {"X-Fail-Count", "5"}});
+    EXPECT_EQ(503, response.status_code);
+    EXPECT_EQ(2, response.retry_count);
+}
+
+TEST(RetryTests, PostIsNotRetried) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    Response response = cpr::Post(url, getFastRetryPolicy(), Header{{"X-Retry-Id", getRetryId()}, {"X-Fail-Count", "1"}});
+    EXPECT_EQ(503, response.status_code);
+    EXPECT_EQ(0, response.retry_count);
+}
+
+TEST(RetryTests, AsyncGetIsRetriedUntilSuccess) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    std::vector<AsyncResponse> responses;
+    for (size_t i = 0; i < 10; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(url);
+        session->SetRetryPolicy(getFastRetryPolicy());
+        session->SetHeader(Header{{"X-Retry-Id", getRetryId()}, {"X-Fail-Count", "2"}});
+        responses.emplace_back(session->GetAsync());
+    }
+    for (AsyncResponse& future : responses) {
+        Response response = future.get();
+        EXPECT_EQ(200, response.status_code);
+        EXPECT_EQ(2, response.retry_count);
+    }
+}
+
+TEST(RetryTests, CoroutineGetIsRetriedUntilSuccess) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(url);
+    session->SetRetryPolicy(getFastRetryPolicy());
+    session->SetHeader(Header{{"X-Retry-Id", getRetryId()}, {"X-Fail-Count", "2"}});
+    Response response = cpr::coroutine::sync_wait(session->CoGetAsync());
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(2, response.retry_count);
+}
+
+TEST(RetryTests, MultiPerformRetriesFailedTransfersOnly) {
+    const Url url{server->GetBaseUrl() + "/retry.html"};
+    MultiPerform multiperform;
+    multiperform.SetRetryPolicy(getFastRetryPolicy());
+    for (const char* fail_count : {"0", "1", "2", "5"}) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(url);
+        session->SetHeader(Header{{"X-Retry-Id", getRetryId()}, {"X-Fail-Count", fail_count}});
+        multiperform.AddSession(session);
+    }
+    std::vector<Response> responses = multiperform.Get();
+    ASSERT_EQ(4, responses.size());
+    EXPECT_EQ(200, responses[0].status_code);
+    EXPECT_EQ(0, responses[0].retry_count);
+    EXPECT_EQ(200, responses[1].status_code);
+    EXPECT_EQ(1, responses[1].retry_count);
+    EXPECT_EQ(200, responses[2].status_code);
+    EXPECT_EQ(2, responses[2].retry_count);
+    EXPECT_EQ(503, responses[3].status_code);
+    EXPECT_EQ(2, responses[3].retry_count);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
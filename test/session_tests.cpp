@@ -4,8 +4,10 @@
 #include <cstdlib>
 #include <gtest/gtest.h>
 
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include "cpr/cpr.h"
 #include <curl/curl.h>
@@ -1267,6 +1269,200 @@ TEST(BasicTests, ReserveResponseString) {
     EXPECT_EQ(ErrorCode::OK, response.error.code);
 }
 
+TEST(BasicTests, AutoReserveResponseString) {
+    Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    Session session;
+    session.SetUrl(url);
+    session.SetAutoReserveSize(4096);
+    Response response = session.Get();
+    std::string expected_text{"this is a file content."};
+    EXPECT_EQ(expected_text, response.text);
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+
+    // HEAD responses announce a Content-Length without a body
+    Response head_response = session.Head();
+    EXPECT_EQ(std::string{}, head_response.text);
+    EXPECT_FALSE(ResponseBufferPool::HasHeapBuffer(head_response.text));
+    EXPECT_EQ(200, head_response.status_code);
+}
+
+TEST(BasicTests, ResponseBufferPoolReuse) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    ResponseBufferPool pool;
+    std::string buffer;
+    buffer.reserve(4096);
+    pool.Release(std::move(buffer));
+    EXPECT_EQ(1, pool.GetIdleCount());
+
+    Session session;
+    session.SetUrl(url);
+    session.SetResponseBufferPool(pool);
+    Response response = session.Get();
+    std::string expected_text{"Hello world!"};
+    EXPECT_EQ(expected_text, response.text);
+    EXPECT_GE(response.text.capacity(), 4096);
+    EXPECT_EQ(0, pool.GetIdleCount());
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+
+    pool.Release(std::move(response.text));
+    EXPECT_EQ(1, pool.GetIdleCount());
+    response = cpr::Get(url, pool);
+    EXPECT_EQ(expected_text, response.text);
+    EXPECT_GE(response.text.capacity(), 4096);
+    EXPECT_EQ(0, pool.GetIdleCount());
+}
+
+TEST(BasicTests, ResponseBufferPoolLimits) {
+    ResponseBufferPool pool{1, 1024};
+    std::string small;
+    small.reserve(512);
+    std::string large;
+    large.reserve(2048);
+    pool.Release(std::move(large));
+    EXPECT_EQ(0, pool.GetIdleCount());
+    pool.Release(std::move(small));
+    EXPECT_EQ(1, pool.GetIdleCount());
+    std::string other;
+    other.reserve(512);
+    pool.Release(std::move(other));
+    EXPECT_EQ(1, pool.GetIdleCount());
+    EXPECT_GE(pool.Acquire().capacity(), 512);
+    EXPECT_EQ(0, pool.GetIdleCount());
+}
+
+TEST(BasicTests, ChunkedBodyResponse) {
+    Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    ChunkAllocator allocator{4};
+    Session session;
+    session.SetUrl(url);
+    session.SetChunkAllocator(allocator);
+    Response response = session.Get();
+    std::string expected_text{"this is a file content."};
+    EXPECT_EQ(std::string{}, response.text);
+    EXPECT_EQ(expected_text.size(), response.chunked_body.size());
+    EXPECT_EQ(6, response.chunked_body.chunk_count());
+    EXPECT_EQ(expected_text, response.chunked_body.Flatten());
+    std::string joined;
+    for (std::string_view chunk : response.chunked_body) {
+        EXPECT_LE(chunk.size(), allocator.GetChunkSize());
+        joined += chunk;
+    }
+    EXPECT_EQ(expected_text, joined);
+    std::ostringstream stream;
+    EXPECT_TRUE(response.chunked_body.WriteTo(stream));
+    EXPECT_EQ(expected_text, stream.str());
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+
+    // Chunks return to the allocator once the last response referencing them is gone
+    response = Response{};
+    EXPECT_EQ(6, allocator.GetFreeCount());
+    response = session.Get();
+    EXPECT_EQ(expected_text, response.chunked_body.Flatten());
+    EXPECT_EQ(0, allocator.GetFreeCount());
+}
+
+TEST(BasicTests, ChunkedBodyAppend) {
+    ChunkedBody body{ChunkAllocator{8}};
+    EXPECT_TRUE(body.empty());
+    body.Append("0123456");
+    body.Append("789abcdefghij");
+    EXPECT_EQ(20, body.size());
+    EXPECT_EQ(3, body.chunk_count());
+    EXPECT_EQ(std::string_view{"01234567"}, body.chunk(0));
+    EXPECT_EQ(std::string_view{"89abcdef"}, body.chunk(1));
+    EXPECT_EQ(std::string_view{"ghij"}, body.chunk(2));
+    size_t calls{0};
+    EXPECT_FALSE(body.WriteTo([&calls](std::string_view /*data*/) { return ++calls < 2; }));
+    EXPECT_EQ(2, calls);
+    body.clear();
+    EXPECT_TRUE(body.empty());
+    EXPECT_EQ(body.begin(), body.end());
+}
+
+TEST(BasicTests, GetStreamTest) {
+    Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(url);
+    ResponseStream stream = session->GetStream(1);
+    std::string body;
+    for (const std::string& chunk : stream) {
+        EXPECT_LE(stream.GetBufferedBytes(), chunk.size() + CURL_MAX_WRITE_SIZE);
+        body += chunk;
+    }
+    EXPECT_TRUE(stream.IsDone());
+    EXPECT_FALSE(stream.Read().has_value());
+    Response response = stream.Finish();
+    EXPECT_EQ(std::string{"this is a file content."}, body);
+    EXPECT_EQ(std::string{}, response.text);
+    EXPECT_EQ(url, response.url);
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+
+    // The session is usable as usual afterwards
+    response = session->Get();
+    EXPECT_EQ(std::string{"this is a file content."}, response.text);
+    EXPECT_EQ(ErrorCode::OK, response.error.code);
+}
+
+TEST(BasicTests, GetStreamFinishEarlyTest) {
+    Url url{server->GetBaseUrl() + "/get_download_file_length.html"};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(url);
+    ResponseStream stream = session->GetStream();
+    Response response = stream.Finish();
+    EXPECT_EQ(ErrorCode::ABORTED_BY_CALLBACK, response.error.code);
+    EXPECT_TRUE(stream.IsDone());
+    EXPECT_FALSE(stream.Read().has_value());
+}
+
+TEST(BasicTests, GetStreamWriteCallbackRestoredTest) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(url);
+    std::string written;
+    session->SetWriteCallback(WriteCallback{[&written](std::string_view data, intptr_t /*userdata*/) {
+        written += data;
+        return true;
+    }});
+    ResponseStream stream = session->GetStream();
+    std::optional<std::string> chunk = stream.Read();
+    ASSERT_TRUE(chunk.has_value());
+    EXPECT_EQ(std::string{"Hello world!"}, *chunk);
+    stream.Finish();
+    EXPECT_TRUE(written.empty());
+
+    session->Get();
+    EXPECT_EQ(std::string{"Hello world!"}, written);
+}
+
+TEST(BasicTests, GetStreamMoveAssignmentTest) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    std::string written;
+    session->SetWriteCallback(WriteCallback{[&written](std::string_view data, intptr_t /*userdata*/) {
+        written += data;
+        return true;
+    }});
+    std::shared_ptr<Session> other_session = std::make_shared<Session>();
+    other_session->SetUrl(Url{server->GetBaseUrl() + "/get_download_file_length.html"});
+
+    ResponseStream stream = session->GetStream();
+    // Stops the first transfer and hands the session its write callback back
+    stream = other_session->GetStream();
+    std::string body;
+    for (const std::string& chunk : stream) {
+        body += chunk;
+    }
+    EXPECT_EQ(std::string{"this is a file content."}, body);
+    EXPECT_EQ(ErrorCode::OK, stream.Finish().error.code);
+
+    session->Get();
+    EXPECT_EQ(std::string{"Hello world!"}, written);
+}
+
 std::vector<std::string> Split(const std::string& s) {
     std::vector<std::string> encodings;
     std::stringstream ss(s);
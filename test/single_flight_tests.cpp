@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+TEST(SingleFlightTests, ConcurrentCallsShareOneTransfer) {
+    SingleFlight single_flight;
+    std::atomic_size_t transfers{0};
+    const size_t waiter_count{8};
+
+    std::vector<std::thread> threads;
+    std::vector<Response> responses(waiter_count);
+    // The leader only finishes once all others are waiting for it
+    threads.emplace_back([&]() {
+        responses[0] = single_flight.Do("key", [&]() {
+            ++transfers;
+            while (single_flight.GetMetrics().coalesced < waiter_count - 1) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Response response;
+            response.text = "shared";
+            return response;
+        });
+    });
+    while (single_flight.GetMetrics().in_flight == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (size_t i = 1; i < waiter_count; ++i) {
+        threads.emplace_back([&, i]() {
+            responses[i] = single_flight.Do("key", [&]() {
+                ++transfers;
+                return Response{};
+            });
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(1, transfers);
+    for (const Response& response : responses) {
+        EXPECT_EQ(std::string{"shared"}, response.text);
+    }
+    const SingleFlight::Metrics metrics = single_flight.GetMetrics();
+    EXPECT_EQ(1, metrics.transfers);
+    EXPECT_EQ(waiter_count - 1, metrics.coalesced);
+    EXPECT_EQ(0, metrics.in_flight);
+}
+
+TEST(SingleFlightTests, ExceptionsReachAllWaiters) {
+    SingleFlight single_flight;
+    EXPECT_THROW(single_flight.Do("key", []() -> Response { throw std::runtime_error("failed"); }), std::runtime_error);
+    // The failed call is not in flight anymore
+    EXPECT_EQ(std::string{"next"}, single_flight.Do("key", []() {
+                                                      Response response;
+                                                      response.text = "next";
+                                                      return response;
+                                                  }).text);
+    EXPECT_EQ(0, single_flight.GetMetrics().in_flight);
+}
+
+TEST(SingleFlightTests, KeyContainsSelectedHeaderFields) {
+    SingleFlight single_flight{{"Authorization"}};
+    const std::string url{"http://example.com/"};
+    EXPECT_EQ(single_flight.GetKey("GET", url, Header{{"X-Other", "1"}}), single_flight.GetKey("GET", url, Header{{"X-Other", "2"}}));
+    EXPECT_NE(single_flight.GetKey("GET", url, Header{{"Authorization", "a"}}), single_flight.GetKey("GET", url, Header{{"Authorization", "b"}}));
+    EXPECT_NE(single_flight.GetKey("GET", url, Header{}), single_flight.GetKey("GET", url, Header{{"Authorization", ""}}));
+    EXPECT_NE(single_flight.GetKey("GET", url, Header{}), single_flight.GetKey("HEAD", url, Header{}));
+}
+
+TEST(SingleFlightTests, AsyncGetsGetTheSameResponse) {
+    Url url{server->GetBaseUrl() + "/timeout.html"};
+    SingleFlight single_flight;
+    std::vector<AsyncResponse> futures;
+    for (size_t i = 0; i < 8; ++i) {
+        futures.push_back(GetAsync(url, single_flight));
+    }
+    for (AsyncResponse& future : futures) {
+        Response response = future.get();
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+        EXPECT_EQ(200, response.status_code);
+    }
+    const SingleFlight::Metrics metrics = single_flight.GetMetrics();
+    EXPECT_EQ(8, metrics.transfers + metrics.coalesced);
+    EXPECT_EQ(0, metrics.in_flight);
+}
+
+TEST(SingleFlightTests, SequentialAndUnsafeRequestsAreNotCoalesced) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    SingleFlight single_flight;
+    Session session;
+    session.SetUrl(url);
+    session.SetSingleFlight(single_flight);
+    EXPECT_EQ(std::string{"Hello world!"}, session.Get().text);
+    EXPECT_EQ(std::string{"Hello world!"}, session.Get().text);
+    session.Post();
+    EXPECT_EQ(2, single_flight.GetMetrics().transfers);
+    EXPECT_EQ(0, single_flight.GetMetrics().coalesced);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
@@ -1,16 +1,25 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "cpr/cprtypes.h"
 #include "cpr/filesystem.h"
+#include "cpr/ssl_ctx.h"
 #include "cpr/ssl_options.h"
+#include "cpr/tls_session_store.h"
 
 #include "httpsServer.hpp"
 
+#if SUPPORT_CURLOPT_SSL_CTX_FUNCTION && defined(OPENSSL_BACKEND_USED)
+#include <openssl/ssl.h>
+#endif
+
 
 using namespace cpr;
 
@@ -221,6 +230,182 @@ TEST(SslTests, CaInfoBlobTestSimpel) {
 }
 #endif
 
+TEST(SslTests, TlsSessionStoreSaveAndLoad) {
+    const TlsSessionStore::Clock::time_point now = TlsSessionStore::Clock::now();
+    TlsSessionStore store;
+    store.Put("example.com:443", std::string{"session\0data", 12}, now + std::chrono::hours{1});
+    store.Put("expired.com:443", "expired", now - std::chrono::seconds{1});
+    EXPECT_FALSE(store.Get("expired.com:443"));
+
+    const fs::path path = fs::temp_directory_path() / "cpr_tls_sessions.bin";
+    EXPECT_TRUE(store.Save(path));
+#ifndef _WIN32
+    EXPECT_EQ(fs::perms::owner_read | fs::perms::owner_write, fs::status(path).permissions());
+#endif
+    EXPECT_FALSE(fs::exists(fs::path{path} += ".tmp"));
+    TlsSessionStore loaded;
+    EXPECT_TRUE(loaded.Load(path));
+    EXPECT_EQ(1, loaded.GetEntryCount());
+    EXPECT_EQ((std::string{"session\0data", 12}), loaded.Get("example.com:443"));
+    fs::remove(path);
+    EXPECT_FALSE(loaded.Load(path));
+}
+
+#if SUPPORT_CURLOPT_SSL_CTX_FUNCTION && defined(OPENSSL_BACKEND_USED)
+TEST(SslTests, CaCertificatesGetParsedOncePerBuffer) {
+    std::string crtPath{server->getBaseDirPath() + "certificates/"};
+    const std::string bundle = loadFileContent(crtPath + "ca-bundle.crt");
+    const std::shared_ptr<const CaCertificates> certificates = CaCertificates::Get(bundle);
+    EXPECT_TRUE(certificates->IsValid());
+    EXPECT_EQ(2, certificates->GetCount());
+    EXPECT_EQ(certificates, CaCertificates::Get(std::string{bundle}));
+
+    // A changed buffer gets parsed again
+    const std::shared_ptr<const CaCertificates> root = CaCertificates::Get(loadFileContent(crtPath + "root-ca.crt"));
+    EXPECT_NE(certificates, root);
+    EXPECT_EQ(1, root->GetCount());
+
+    EXPECT_FALSE(CaCertificates::Get("-----BEGIN CERTIFICATE-----\ninvalid\n-----END CERTIFICATE-----\n")->IsValid());
+    // Also in case valid certificates precede the malformed one
+    EXPECT_FALSE(CaCertificates::Get(loadFileContent(crtPath + "root-ca.crt") + "-----BEGIN CERTIFICATE-----\ninvalid\n-----END CERTIFICATE-----\n" + loadFileContent(crtPath + "sub-ca.crt"))->IsValid());
+}
+
+TEST(SslTests, LegacyCaBufferCallbackKeepsCertificatesParsed) {
+    std::string crtPath{server->getBaseDirPath() + "certificates/"};
+    const std::string bundle = loadFileContent(crtPath + "ca-bundle.crt") + "\n# Legacy\n";
+    SSL_CTX* sslctx = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(nullptr, sslctx);
+    EXPECT_EQ(CURLE_OK, sslctx_function_load_ca_cert_from_buffer(nullptr, sslctx, const_cast<char*>(bundle.c_str())));
+    // Nothing else holds on to them, still the next handshake does not have to parse the buffer again
+    const std::weak_ptr<const CaCertificates> parsed = CaCertificates::Get(bundle);
+    EXPECT_FALSE(parsed.expired());
+    EXPECT_EQ(CURLE_OK, sslctx_function_load_ca_cert_from_buffer(nullptr, sslctx, const_cast<char*>(bundle.c_str())));
+    EXPECT_EQ(parsed.lock(), CaCertificates::Get(bundle));
+    SSL_CTX_free(sslctx);
+}
+
+static SslOptions GetTlsSessionStoreSslOptions() {
+    std::string baseDirPath{server->getBaseDirPath()};
+    std::string crtPath{baseDirPath + "certificates/"};
+    std::string keyPath{baseDirPath + "keys/"};
+    return Ssl(ssl::CaInfo{crtPath + "ca-bundle.crt"}, ssl::CertFile{crtPath + "client.crt"}, ssl::KeyFile{keyPath + "client.key"}, ssl::VerifyPeer{true}, ssl::VerifyHost{true}, ssl::VerifyStatus{false});
+}
+
+TEST(SslTests, TlsSessionStoreOffersSavedSessions) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    const fs::path path = fs::temp_directory_path() / "cpr_tls_sessions_offered.bin";
+    {
+        TlsSessionStore store;
+        Response response = cpr::Get(url, GetTlsSessionStoreSslOptions(), store, Timeout{5000});
+        EXPECT_EQ(std::string{"Hello world!"}, response.text);
+        EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+        EXPECT_EQ(1, store.GetEntryCount());
+        EXPECT_GE(store.GetMetrics().stored, 1);
+        EXPECT_EQ(0, store.GetMetrics().offered);
+        EXPECT_TRUE(store.Save(path));
+    }
+
+    // Like after a restart of the process
+    TlsSessionStore store;
+    EXPECT_TRUE(store.Load(path));
+    fs::remove(path);
+    Response response = cpr::Get(url, GetTlsSessionStoreSslOptions(), store, Timeout{5000});
+    EXPECT_EQ(std::string{"Hello world!"}, response.text);
+    EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+    const TlsSessionStore::Metrics metrics = store.GetMetrics();
+    EXPECT_EQ(1, metrics.handshakes);
+    EXPECT_EQ(1, metrics.offered);
+}
+
+TEST(SslTests, TlsSessionStoreSeparatesSslOptions) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    TlsSessionStore store;
+    Response response = cpr::Get(url, GetTlsSessionStoreSslOptions(), store, Timeout{5000});
+    EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+    EXPECT_EQ(1, store.GetEntryCount());
+
+    // Same host and port, but without verifying the host, so the session must not be offered
+    SslOptions options = GetTlsSessionStoreSslOptions();
+    options.SetOption(ssl::VerifyHost{false});
+    response = cpr::Get(url, options, store, Timeout{5000});
+    EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+    EXPECT_EQ(0, store.GetMetrics().offered);
+    EXPECT_EQ(2, store.GetEntryCount());
+
+    response = cpr::Get(url, GetTlsSessionStoreSslOptions(), store, Timeout{5000});
+    EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+    EXPECT_EQ(1, store.GetMetrics().offered);
+}
+
+TEST(SslTests, TlsSessionStoreSeparatesVerifySsl) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    TlsSessionStore store;
+    {
+        Session session;
+        session.SetUrl(url);
+        session.SetSslOptions(GetTlsSessionStoreSslOptions());
+        session.SetVerifySsl(VerifySsl{false});
+        session.SetTlsSessionStore(store);
+        session.SetTimeout(Timeout{5000});
+        Response response = session.Get();
+        EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+        EXPECT_EQ(1, store.GetEntryCount());
+    }
+
+    // The session of the unverified connection must not be offered to a verifying one
+    Response response = cpr::Get(url, GetTlsSessionStoreSslOptions(), store, Timeout{5000});
+    EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+    EXPECT_EQ(0, store.GetMetrics().offered);
+    EXPECT_EQ(2, store.GetEntryCount());
+
+    // Setting the same options again does not change where sessions get stored
+    Session session;
+    session.SetUrl(url);
+    session.SetSslOptions(GetTlsSessionStoreSslOptions());
+    session.SetSslOptions(GetTlsSessionStoreSslOptions());
+    session.SetTlsSessionStore(store);
+    session.SetTimeout(Timeout{5000});
+    response = session.Get();
+    EXPECT_EQ(ErrorCode::OK, response.error.code) << response.error.message;
+    EXPECT_EQ(1, store.GetMetrics().offered);
+}
+
+/**
+ * Compares the TLS handshake time (CURLINFO_APPCONNECT_TIME) of new sessions with and without a TlsSessionStore.
+ * Disabled by default, run with: ssl_tests --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+ * Note that only servers keeping their session ticket keys across connections allow resuming sessions.
+ **/
+TEST(SslTests, DISABLED_TlsSessionStoreHandshakeBenchmark) {
+    Url url{server->GetBaseUrl() + "/hello.html"};
+    const size_t rounds{200};
+    auto run = [&](const std::optional<TlsSessionStore>& store) {
+        double total{0};
+        for (size_t i = 0; i < rounds; ++i) {
+            Session session;
+            session.SetUrl(url);
+            session.SetSslOptions(GetTlsSessionStoreSslOptions());
+            if (store) {
+                session.SetTlsSessionStore(*store);
+            }
+            session.Get();
+            double appconnect{0};
+            curl_easy_getinfo(session.GetCurlHolder()->handle, CURLINFO_APPCONNECT_TIME, &appconnect);
+            double connect{0};
+            curl_easy_getinfo(session.GetCurlHolder()->handle, CURLINFO_CONNECT_TIME, &connect);
+            total += appconnect - connect;
+        }
+        return total / static_cast<double>(rounds) * 1000.0;
+    };
+
+    const double full_ms = run(std::nullopt);
+    TlsSessionStore store;
+    const double store_ms = run(store);
+    const TlsSessionStore::Metrics metrics = store.GetMetrics();
+    std::cout << "Full handshake: " << full_ms << "ms\n";
+    std::cout << "With TlsSessionStore: " << store_ms << "ms (" << metrics.resumed << " of " << metrics.handshakes << " handshakes resumed)\n";
+}
+#endif
+
 fs::path GetBasePath(const std::string& execPath) {
     return fs::path(fs::path{execPath}.parent_path().string() + "/").make_preferred();
 }
@@ -1,8 +1,14 @@
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <future>
 #include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
 
 
+#include "cpr/async.h"
 #include "cpr/threadpool.h"
 
 TEST(ThreadPoolTests, DISABLED_BasicWorkOneThread) {
@@ -99,6 +105,131 @@ TEST(ThreadPoolTests, DISABLED_PauseResumeMultipleThreads) {
     }
 }
 
+TEST(ThreadPoolTests, HigherPriorityRunsFirst) {
+    cpr::ThreadPool tp{1, 1};
+    tp.Start(0);
+
+    // Keeps the only thread busy while queueing
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    tp.Execute([released]() { released.wait(); });
+
+    std::mutex order_mutex;
+    std::string order;
+    auto append = [&order_mutex, &order](char c) {
+        return [&order_mutex, &order, c]() {
+            const std::lock_guard<std::mutex> lock(order_mutex);
+            order += c;
+        };
+    };
+    tp.ExecuteWithPriority(append('b'), cpr::Priority::Bulk);
+    tp.ExecuteWithPriority(append('n'), cpr::Priority::Normal);
+    tp.ExecuteWithPriority(append('i'), cpr::Priority::Interactive);
+    tp.ExecuteWithPriority(append('b'), cpr::Priority::Bulk);
+    tp.ExecuteWithPriority(append('i'), cpr::Priority::Interactive);
+    EXPECT_EQ(size_t{2}, tp.GetQueuedTaskNum(cpr::Priority::Bulk));
+
+    release.set_value();
+    tp.Wait();
+    EXPECT_EQ(std::string{"iinbb"}, order);
+}
+
+TEST(ThreadPoolTests, StarvedTaskGoesFirst) {
+    cpr::ThreadPool tp{1, 1};
+    tp.SetMaxQueueDelay(std::chrono::milliseconds{10});
+    tp.Start(0);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    tp.Execute([released]() { released.wait(); });
+
+    std::mutex order_mutex;
+    std::string order;
+    tp.ExecuteWithPriority(
+            [&order_mutex, &order]() {
+                const std::lock_guard<std::mutex> lock(order_mutex);
+                order += 'b';
+            },
+            cpr::Priority::Bulk);
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    tp.ExecuteWithPriority(
+            [&order_mutex, &order]() {
+                const std::lock_guard<std::mutex> lock(order_mutex);
+                order += 'i';
+            },
+            cpr::Priority::Interactive);
+
+    release.set_value();
+    tp.Wait();
+    EXPECT_EQ(std::string{"bi"}, order);
+}
+
+TEST(ThreadPoolTests, MaxRunningPerPriority) {
+    cpr::ThreadPool tp{4, 4};
+    tp.SetMaxRunning(cpr::Priority::Bulk, 1);
+    tp.Start(4);
+
+    std::atomic_int running{0};
+    std::atomic_int max_running{0};
+    for (size_t i = 0; i < 8; ++i) {
+        tp.ExecuteWithPriority(
+                [&running, &max_running]() {
+                    const int now_running = ++running;
+                    int previous = max_running.load();
+                    while (previous < now_running && !max_running.compare_exchange_weak(previous, now_running)) {}
+                    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+                    --running;
+                },
+                cpr::Priority::Bulk);
+    }
+    // Does not wait behind the bulk tasks, the other threads are kept free for it
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    cpr::async(tp, cpr::Priority::Interactive, []() { return 42; }).wait();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{30});
+
+    tp.Wait();
+    EXPECT_EQ(1, max_running);
+}
+
+TEST(ThreadPoolTests, CappedPriorityDoesNotGrowPool) {
+    cpr::ThreadPool tp{1, 4, std::chrono::milliseconds{20}};
+    tp.SetMaxRunning(cpr::Priority::Bulk, 1);
+    tp.Start(0);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> started;
+    tp.ExecuteWithPriority(
+            [&started, released]() {
+                started.set_value();
+                released.wait();
+            },
+            cpr::Priority::Bulk);
+    started.get_future().wait();
+    for (size_t i = 0; i < 4; ++i) {
+        tp.ExecuteWithPriority([]() {}, cpr::Priority::Bulk);
+    }
+    // None of the queued bulk tasks could run on an additional thread before the first one completed
+    EXPECT_EQ(size_t{1}, tp.GetCurrentThreadNum());
+
+    // Other priorities still get a thread of their own
+    cpr::async(tp, cpr::Priority::Interactive, []() { return 42; }).wait();
+    EXPECT_EQ(size_t{2}, tp.GetCurrentThreadNum());
+
+    release.set_value();
+    tp.Wait();
+    // The additional thread shrinks away again and keeps the idle count in line
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    EXPECT_EQ(size_t{1}, tp.GetCurrentThreadNum());
+    EXPECT_EQ(tp.GetCurrentThreadNum(), tp.GetIdleThreadNum());
+    tp.Wait();
+}
+
+TEST(ThreadPoolTests, AsyncWithPriority) {
+    EXPECT_EQ(42, cpr::async(cpr::Priority::Interactive, [](int value) { return value; }, 42).get());
+    EXPECT_EQ(43, cpr::async(cpr::Priority::Bulk, []() { return 43; }).get());
+}
+
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cpr/cpr.h"
+#include "httpServer.hpp"
+
+using namespace cpr;
+
+static HttpServer* server = new HttpServer();
+
+class CollectingTraceSink : public TraceSink {
+  public:
+    struct Record {
+        SpanKind kind;
+        TraceContext context;
+        std::array<uint8_t, 8> parent_span_id;
+        std::string method;
+        long status_code{0};
+    };
+
+    void OnSpan(const Span& span) override {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_LE(span.start, span.end);
+        records_.push_back(Record{span.kind, span.context, span.parent_span_id, std::string{span.method}, span.response ? span.response->status_code : 0});
+    }
+
+    std::vector<Record> GetRecords() {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return records_;
+    }
+
+    std::vector<Record> GetRecords(SpanKind kind) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Record> records;
+        std::copy_if(records_.begin(), records_.end(), std::back_inserter(records), [kind](const Record& record) { return record.kind == kind; });
+        return records;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<Record> records_;
+};
+
+class ProceedingInterceptor : public Interceptor {
+  public:
+    Response intercept(Session& session) override {
+        return proceed(session);
+    }
+};
+
+TEST(TracingTests, TraceparentRoundTrip) {
+    const std::string traceparent{"00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"};
+    const std::optional<TraceContext> context = TraceContext::FromTraceparent(traceparent);
+    ASSERT_TRUE(context.has_value());
+    EXPECT_EQ(0x4b, context->trace_id[0]);
+    EXPECT_EQ(0xb7, context->span_id[7]);
+    EXPECT_EQ(0x01, context->flags);
+    EXPECT_EQ(traceparent, context->ToTraceparent());
+
+    const TraceContext generated = TraceContext::Generate();
+    EXPECT_EQ(generated.ToTraceparent(), TraceContext::FromTraceparent(generated.ToTraceparent())->ToTraceparent());
+}
+
+TEST(TracingTests, InvalidTraceparentIsRejected) {
+    EXPECT_FALSE(TraceContext::FromTraceparent("").has_value());
+    // Uppercase hex digits
+    EXPECT_FALSE(TraceContext::FromTraceparent("00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01").has_value());
+    // All zero trace id and span id
+    EXPECT_FALSE(TraceContext::FromTraceparent("00-00000000000000000000000000000000-00f067aa0ba902b7-01").has_value());
+    EXPECT_FALSE(TraceContext::FromTraceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01").has_value());
+    // Invalid version and trailing data for version 00
+    EXPECT_FALSE(TraceContext::FromTraceparent("ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01").has_value());
+    EXPECT_FALSE(TraceContext::FromTraceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-00").has_value());
+    // Later versions may append fields
+    EXPECT_TRUE(TraceContext::FromTraceparent("01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00-future").has_value());
+}
+
+TEST(TracingTests, RequestEmitsLifecycleSpans) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/hello.html"}, Tracer{sink});
+    EXPECT_EQ(200, response.status_code);
+
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    ASSERT_EQ(1, requests.size());
+    EXPECT_EQ(std::string{"GET"}, requests[0].method);
+    EXPECT_EQ(200, requests[0].status_code);
+    EXPECT_EQ((std::array<uint8_t, 8>{}), requests[0].parent_span_id);
+    // The REQUEST span ends last
+    EXPECT_EQ(SpanKind::REQUEST, sink->GetRecords().back().kind);
+
+    for (const SpanKind kind : {SpanKind::PREPARE, SpanKind::CONNECT, SpanKind::FIRST_BYTE, SpanKind::COMPLETE}) {
+        const std::vector<CollectingTraceSink::Record> spans = sink->GetRecords(kind);
+        ASSERT_EQ(1, spans.size());
+        EXPECT_EQ(requests[0].context.trace_id, spans[0].context.trace_id);
+        EXPECT_EQ(requests[0].context.span_id, spans[0].parent_span_id);
+    }
+    EXPECT_TRUE(sink->GetRecords(SpanKind::TLS).empty());
+}
+
+TEST(TracingTests, TraceparentHeaderGetsSent) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/header_reflect.html"}, Tracer{sink});
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    ASSERT_EQ(1, requests.size());
+    EXPECT_EQ(requests[0].context.ToTraceparent(), response.header.at("traceparent"));
+}
+
+TEST(TracingTests, ParentContextGetsContinued) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    const std::optional<TraceContext> parent = TraceContext::FromTraceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/header_reflect.html"}, Tracer{sink, parent});
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    ASSERT_EQ(1, requests.size());
+    EXPECT_EQ(parent->trace_id, requests[0].context.trace_id);
+    EXPECT_EQ(parent->span_id, requests[0].parent_span_id);
+    EXPECT_NE(parent->span_id, requests[0].context.span_id);
+    EXPECT_EQ(0, response.header.at("traceparent").find("00-4bf92f3577b34da6a3ce929d0e0e4736-"));
+}
+
+TEST(TracingTests, ExplicitTraceparentHeaderIsKept) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    const std::string traceparent{"00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"};
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/header_reflect.html"}, Header{{"traceparent", traceparent}}, Tracer{sink});
+    EXPECT_EQ(traceparent, response.header.at("traceparent"));
+}
+
+TEST(TracingTests, NoPropagationWithoutHeader) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/header_reflect.html"}, Tracer{sink, std::nullopt, false});
+    EXPECT_EQ(response.header.end(), response.header.find("traceparent"));
+    EXPECT_EQ(1, sink->GetRecords(SpanKind::REQUEST).size());
+}
+
+TEST(TracingTests, NoTracerNoHeader) {
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/header_reflect.html"});
+    EXPECT_EQ(200, response.status_code);
+    EXPECT_EQ(response.header.end(), response.header.find("traceparent"));
+}
+
+TEST(TracingTests, AsyncRequestEmitsQueuedSpan) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session->SetTracer(Tracer{sink});
+    const Response response = session->GetAsync().get();
+    EXPECT_EQ(200, response.status_code);
+
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    const std::vector<CollectingTraceSink::Record> queued = sink->GetRecords(SpanKind::QUEUED);
+    ASSERT_EQ(1, requests.size());
+    ASSERT_EQ(1, queued.size());
+    EXPECT_EQ(requests[0].context.span_id, queued[0].parent_span_id);
+}
+
+TEST(TracingTests, RetriesAreSeparateRequestSpans) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    RetryPolicy retry_policy;
+    retry_policy.max_attempts = 3;
+    retry_policy.base_delay = std::chrono::milliseconds{10};
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/retry.html"}, retry_policy, Header{{"X-Retry-Id", "tracing"}, {"X-Fail-Count", "2"}}, Tracer{sink});
+    EXPECT_EQ(200, response.status_code);
+
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    ASSERT_EQ(3, requests.size());
+    EXPECT_EQ(503, requests[0].status_code);
+    EXPECT_EQ(200, requests[2].status_code);
+    // The backoff before each retry
+    EXPECT_EQ(2, sink->GetRecords(SpanKind::QUEUED).size());
+}
+
+TEST(TracingTests, InterceptorSpanBelongsToRequest) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    Session session;
+    session.SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+    session.SetTracer(Tracer{sink});
+    session.AddInterceptor(std::make_shared<ProceedingInterceptor>());
+    const Response response = session.Get();
+    EXPECT_EQ(200, response.status_code);
+
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    const std::vector<CollectingTraceSink::Record> interceptors = sink->GetRecords(SpanKind::INTERCEPTOR);
+    ASSERT_EQ(1, requests.size());
+    ASSERT_EQ(1, interceptors.size());
+    EXPECT_EQ(requests[0].context.span_id, interceptors[0].parent_span_id);
+}
+
+TEST(TracingTests, UnsentRequestIsTraced) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    const Response response = cpr::Get(Url{server->GetBaseUrl() + "/hello.html"}, Deadline{Deadline::Clock::now()}, Tracer{sink});
+    EXPECT_EQ(ErrorCode::OPERATION_TIMEDOUT, response.error.code);
+    EXPECT_EQ(1, sink->GetRecords(SpanKind::REQUEST).size());
+    EXPECT_TRUE(sink->GetRecords(SpanKind::CONNECT).empty());
+}
+
+TEST(TracingTests, MultiPerformTracesEachSession) {
+    std::shared_ptr<CollectingTraceSink> sink = std::make_shared<CollectingTraceSink>();
+    MultiPerform multiperform;
+    for (size_t i = 0; i < 3; ++i) {
+        std::shared_ptr<Session> session = std::make_shared<Session>();
+        session->SetUrl(Url{server->GetBaseUrl() + "/hello.html"});
+        session->SetTracer(Tracer{sink});
+        multiperform.AddSession(session);
+    }
+    for (const Response& response : multiperform.Get()) {
+        EXPECT_EQ(200, response.status_code);
+    }
+    const std::vector<CollectingTraceSink::Record> requests = sink->GetRecords(SpanKind::REQUEST);
+    ASSERT_EQ(3, requests.size());
+    EXPECT_NE(requests[0].context.trace_id, requests[1].context.trace_id);
+    EXPECT_EQ(3, sink->GetRecords(SpanKind::FIRST_BYTE).size());
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(server);
+    return RUN_ALL_TESTS();
+}
@@ -219,6 +219,37 @@ TEST(UtilIsTrueTests, FalseTest) {
     }
 }
 
+TEST(UtilWriteHeaderReserveTests, ReservesContentLength) {
+    std::string header;
+    std::string body;
+    util::ResponseStringReserveData data{&header, &body, 4096};
+    std::string line{"Content-Length: 1000\r\n"};
+    EXPECT_EQ(line.size(), util::writeHeaderReserveFunction(line.data(), 1, line.size(), &data));
+    EXPECT_EQ(line, header);
+    EXPECT_GE(body.capacity(), 1000);
+    EXPECT_LT(body.capacity(), 4096);
+}
+
+TEST(UtilWriteHeaderReserveTests, CapsReservedSize) {
+    std::string header;
+    std::string body;
+    util::ResponseStringReserveData data{&header, &body, 512};
+    std::string line{"content-length: 1000000\r\n"};
+    util::writeHeaderReserveFunction(line.data(), 1, line.size(), &data);
+    EXPECT_GE(body.capacity(), 512);
+    EXPECT_LT(body.capacity(), 1000);
+}
+
+TEST(UtilWriteHeaderReserveTests, ZeroDisablesReserving) {
+    std::string header;
+    std::string body;
+    const size_t initial_capacity = body.capacity();
+    util::ResponseStringReserveData data{&header, &body, 0};
+    std::string line{"Content-Length: 1000\r\n"};
+    util::writeHeaderReserveFunction(line.data(), 1, line.size(), &data);
+    EXPECT_EQ(initial_capacity, body.capacity());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();